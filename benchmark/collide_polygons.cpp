@@ -0,0 +1,141 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Micro-benchmark for b2CollidePolygons over random polygon pairs. The checksum
+// covers every manifold so runs with and without B2_NO_SIMD can be compared.
+
+#include <box2d/box2d.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static std::uint32_t s_seed = 12345;
+
+// Deterministic random number in [lo, hi].
+static float RandomFloat(float lo, float hi)
+{
+    s_seed = 1664525u * s_seed + 1013904223u;
+    float r = float(s_seed >> 8) / float(1 << 24);
+    return lo + r * (hi - lo);
+}
+
+static void HashBytes(std::uint64_t* hash, const void* data, std::size_t size)
+{
+    // FNV-1a
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        *hash ^= bytes[i];
+        *hash *= 0x100000001b3ull;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::int32_t pairCount = 10000;
+    std::int32_t iterations = 100;
+    if (argc > 1)
+    {
+        pairCount = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        iterations = atoi(argv[2]);
+    }
+
+    // Random convex polygons with 3 to b2_maxPolygonVertices vertices.
+    const std::int32_t shapeCount = 256;
+    std::vector<b2PolygonShape> shapes(shapeCount);
+    for (b2PolygonShape& shape : shapes)
+    {
+        std::int32_t count = 3 + int(RandomFloat(0.0f, b2_maxPolygonVertices - 3 + 0.99f));
+        b2Vec2 points[b2_maxPolygonVertices];
+        float scale = RandomFloat(0.25f, 1.0f);
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            float angle = 2.0f * b2_pi * (i + RandomFloat(0.0f, 0.5f)) / count;
+            points[i].Set(scale * cosf(angle), scale * sinf(angle));
+        }
+        shape.Set(points, count);
+    }
+
+    // Random nearby poses so that most pairs are touching.
+    struct Pair
+    {
+        const b2PolygonShape* shapeA;
+        const b2PolygonShape* shapeB;
+        b2Transform xfA;
+        b2Transform xfB;
+    };
+
+    std::vector<Pair> pairs(pairCount);
+    for (Pair& pair : pairs)
+    {
+        pair.shapeA = &shapes[int(RandomFloat(0.0f, shapeCount - 0.01f))];
+        pair.shapeB = &shapes[int(RandomFloat(0.0f, shapeCount - 0.01f))];
+        pair.xfA.Set(b2Vec2(RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f)), RandomFloat(-b2_pi, b2_pi));
+        b2Vec2 offset(RandomFloat(-1.5f, 1.5f), RandomFloat(-1.5f, 1.5f));
+        pair.xfB.Set(pair.xfA.p + offset, RandomFloat(-b2_pi, b2_pi));
+    }
+
+    std::vector<b2Manifold> manifolds(pairCount);
+
+    b2Timer timer;
+    for (std::int32_t k = 0; k < iterations; ++k)
+    {
+        for (std::int32_t i = 0; i < pairCount; ++i)
+        {
+            const Pair& pair = pairs[i];
+            b2CollidePolygons(&manifolds[i], pair.shapeA, pair.xfA, pair.shapeB, pair.xfB);
+        }
+    }
+    float ms = timer.GetMilliseconds();
+
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    std::int32_t touchingCount = 0;
+    for (const b2Manifold& manifold : manifolds)
+    {
+        HashBytes(&hash, &manifold.pointCount, sizeof(manifold.pointCount));
+        if (manifold.pointCount == 0)
+        {
+            continue;
+        }
+
+        ++touchingCount;
+        HashBytes(&hash, &manifold.type, sizeof(manifold.type));
+        HashBytes(&hash, &manifold.localNormal, sizeof(manifold.localNormal));
+        HashBytes(&hash, &manifold.localPoint, sizeof(manifold.localPoint));
+        for (std::int32_t i = 0; i < manifold.pointCount; ++i)
+        {
+            HashBytes(&hash, &manifold.points[i].localPoint, sizeof(b2Vec2));
+            HashBytes(&hash, &manifold.points[i].id.key, sizeof(std::uint32_t));
+        }
+    }
+
+    double nsPerPair = 1.0e6 * ms / (double(pairCount) * iterations);
+    printf("pairs %d iterations %d touching %d\n", pairCount, iterations, touchingCount);
+    printf("time %.2f ms, %.1f ns per pair\n", ms, nsPerPair);
+    printf("checksum %016llx\n", (unsigned long long)hash);
+    return 0;
+}
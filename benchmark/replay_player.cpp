@@ -0,0 +1,188 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Headless player for recordings of b2ReplayRecorder. Each step of the recording is
+// replayed and timed, and the slowest steps are reported with their profile, so a
+// spike seen in the field can be reproduced and profiled offline.
+//
+// replay_player <file>            play a recording
+// replay_player --record <file>   write a recording of a falling pyramid
+
+#include <box2d/box2d.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct StepTime
+{
+    std::int32_t step;
+    float time;
+    b2Profile profile;
+};
+
+static bool Record(const char* path)
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+    b2ReplayRecorder recorder;
+    recorder.Begin(&world);
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    const std::int32_t rowCount = 20;
+    for (std::int32_t row = 0; row < rowCount; ++row)
+    {
+        for (std::int32_t i = row; i < rowCount; ++i)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(-0.5f * rowCount + i - 0.5f * row, 0.5f + 1.0f * row);
+            world.CreateBody(&bodyDef)->CreateFixture(&box, 5.0f);
+        }
+    }
+
+    for (std::int32_t i = 0; i < 600; ++i)
+    {
+        // Drop a heavy ball every second.
+        if (i % 60 == 0)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.bullet = true;
+            bodyDef.position.Set(-5.0f + 0.02f * i, 30.0f);
+            b2Body* ball = world.CreateBody(&bodyDef);
+            b2CircleShape circle;
+            circle.m_radius = 1.0f;
+            ball->CreateFixture(&circle, 50.0f);
+            ball->ApplyLinearImpulseToCenter(b2Vec2(0.0f, -20000.0f), true);
+        }
+
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    recorder.End();
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    fwrite(recorder.GetData(), 1, recorder.GetSize(), file);
+    fclose(file);
+    printf("recorded %d steps, %d bytes\n", recorder.GetStepCount(), int(recorder.GetSize()));
+    return true;
+}
+
+static bool Play(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    std::size_t size = std::size_t(ftell(file));
+    fseek(file, 0, SEEK_SET);
+
+    // The player reads in place from four byte aligned storage.
+    std::vector<std::uint32_t> data((size + 3) / 4);
+    std::size_t count = fread(data.data(), 1, size, file);
+    fclose(file);
+    if (count != size)
+    {
+        return false;
+    }
+
+    b2World world(b2Vec2_zero);
+    b2ReplayPlayer player;
+    if (player.Begin(&world, data.data(), size) == false)
+    {
+        printf("%s is not a recording\n", path);
+        return false;
+    }
+
+    std::vector<StepTime> steps;
+    float totalTime = 0.0f;
+    while (player.Step())
+    {
+        StepTime step;
+        step.step = player.GetStepCount() - 1;
+        step.time = player.GetStepTime();
+        step.profile = world.GetProfile();
+        steps.push_back(step);
+        totalTime += step.time;
+    }
+
+    if (player.IsDone() == false)
+    {
+        printf("bad data after step %d\n", player.GetStepCount());
+    }
+
+    std::int32_t stepCount = std::int32_t(steps.size());
+    printf("steps %d bodies %d contacts %d\n", stepCount, world.GetBodyCount(), world.GetContactCount());
+    if (stepCount == 0)
+    {
+        return player.IsDone();
+    }
+
+    printf("total %.2f ms, average %.3f ms\n", totalTime, totalTime / stepCount);
+
+    std::sort(steps.begin(), steps.end(), [](const StepTime& a, const StepTime& b) { return a.time > b.time; });
+    std::int32_t reportCount = std::min(stepCount, 10);
+    printf("slowest steps:\n");
+    for (std::int32_t i = 0; i < reportCount; ++i)
+    {
+        const StepTime& step = steps[i];
+        printf("step %5d %.3f ms: collide %.3f solve %.3f [init %.3f velocity %.3f position %.3f] toi %.3f\n",
+            step.step, step.time, step.profile.collide, step.profile.solve, step.profile.solveInit,
+            step.profile.solveVelocity, step.profile.solvePosition, step.profile.solveTOI);
+    }
+
+    return player.IsDone();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--record") == 0)
+    {
+        return Record(argv[2]) ? 0 : 1;
+    }
+
+    if (argc == 2)
+    {
+        return Play(argv[1]) ? 0 : 1;
+    }
+
+    printf("usage: replay_player <file>\n");
+    printf("       replay_player --record <file>\n");
+    return 1;
+}
@@ -0,0 +1,146 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Query benchmark for static proxies. The same proxies are queried in a
+// b2DynamicTree and in a b2QuantizedTree built from it. Memory use, query
+// time and ray cast time are reported for both.
+
+#include <box2d/box2d.h>
+#include <box2d/b2_dynamic_tree.h>
+#include <box2d/b2_quantized_tree.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static std::uint32_t s_seed = 12345;
+
+// Deterministic random number in [lo, hi].
+static float RandomFloat(float lo, float hi)
+{
+    s_seed = 1664525u * s_seed + 1013904223u;
+    float r = float(s_seed >> 8) / float(1 << 24);
+    return lo + r * (hi - lo);
+}
+
+static b2AABB RandomAABB(const b2Vec2& center, float size)
+{
+    b2Vec2 extent(RandomFloat(0.2f, size), RandomFloat(0.2f, size));
+    b2AABB aabb;
+    aabb.lowerBound = center - extent;
+    aabb.upperBound = center + extent;
+    return aabb;
+}
+
+struct Counter
+{
+    bool QueryCallback(std::int32_t proxyId)
+    {
+        sum += proxyId;
+        ++count;
+        return true;
+    }
+
+    float RayCastCallback(const b2RayCastInput& input, std::int32_t proxyId)
+    {
+        sum += proxyId;
+        ++count;
+        return input.maxFraction;
+    }
+
+    std::int64_t sum = 0;
+    std::int32_t count = 0;
+};
+
+template <typename T>
+static void Measure(const char* name, const T& tree, std::int32_t queryCount, float worldSize)
+{
+    Counter queryCounter;
+    s_seed = 777;
+    b2Timer timer;
+    for (std::int32_t i = 0; i < queryCount; ++i)
+    {
+        b2Vec2 center(RandomFloat(0.0f, worldSize), RandomFloat(0.0f, worldSize));
+        tree.Query(&queryCounter, RandomAABB(center, 4.0f));
+    }
+    float queryTime = timer.GetMilliseconds();
+
+    Counter rayCounter;
+    s_seed = 999;
+    timer.Reset();
+    for (std::int32_t i = 0; i < queryCount / 10; ++i)
+    {
+        b2RayCastInput input;
+        input.p1.Set(RandomFloat(0.0f, worldSize), RandomFloat(0.0f, worldSize));
+        input.p2 = input.p1 + b2Vec2(RandomFloat(-20.0f, 20.0f), RandomFloat(-20.0f, 20.0f));
+        input.maxFraction = 1.0f;
+        tree.RayCast(&rayCounter, input);
+    }
+    float rayTime = timer.GetMilliseconds();
+
+    printf("%-10s query %8.2f ms (%d hits) ray cast %8.2f ms (%d hits)\n", name, queryTime,
+        queryCounter.count, rayTime, rayCounter.count);
+}
+
+int main(int argc, char** argv)
+{
+    std::int32_t proxyCount = 500000;
+    std::int32_t queryCount = 200000;
+    if (argc > 1)
+    {
+        proxyCount = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        queryCount = atoi(argv[2]);
+    }
+
+    // Keep the density constant.
+    float worldSize = 4.0f * sqrtf(float(proxyCount));
+
+    b2DynamicTree tree;
+    for (std::int32_t i = 0; i < proxyCount; ++i)
+    {
+        b2Vec2 center(RandomFloat(0.0f, worldSize), RandomFloat(0.0f, worldSize));
+        tree.CreateProxy(RandomAABB(center, 1.0f), nullptr);
+    }
+    tree.Rebuild();
+
+    b2Timer timer;
+    b2QuantizedTree quantizedTree;
+    quantizedTree.Build(tree);
+    float buildTime = timer.GetMilliseconds();
+
+    // A tree with n leaves has 2n - 1 nodes.
+    std::int32_t dynamicBytes = (2 * proxyCount - 1) * std::int32_t(sizeof(b2TreeNode));
+    std::int32_t quantizedBytes = quantizedTree.GetByteCount();
+
+    printf("proxies %d queries %d\n", proxyCount, queryCount);
+    printf("dynamic   %8.2f MB\n", dynamicBytes / (1024.0f * 1024.0f));
+    printf("quantized %8.2f MB build %.2f ms ratio %.2f\n", quantizedBytes / (1024.0f * 1024.0f), buildTime,
+        float(quantizedBytes) / float(dynamicBytes));
+
+    Measure("dynamic", tree, queryCount, worldSize);
+    Measure("quantized", quantizedTree, queryCount, worldSize);
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Churn benchmark for b2DynamicTree. Proxies random walk, teleport, and are
+// destroyed and re-created. The average tree quality (b2DynamicTree::GetAreaRatio)
+// and query time are reported with and without the incremental optimizer
+// (b2DynamicTree::Optimize).
+
+#include <box2d/box2d.h>
+#include <box2d/b2_dynamic_tree.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static std::uint32_t s_seed = 12345;
+
+// Deterministic random number in [lo, hi].
+static float RandomFloat(float lo, float hi)
+{
+    s_seed = 1664525u * s_seed + 1013904223u;
+    float r = float(s_seed >> 8) / float(1 << 24);
+    return lo + r * (hi - lo);
+}
+
+static b2AABB RandomAABB(const b2Vec2& center)
+{
+    b2Vec2 extent(RandomFloat(0.2f, 1.0f), RandomFloat(0.2f, 1.0f));
+    b2AABB aabb;
+    aabb.lowerBound = center - extent;
+    aabb.upperBound = center + extent;
+    return aabb;
+}
+
+struct QueryCounter
+{
+    bool QueryCallback(std::int32_t proxyId)
+    {
+        (void)proxyId;
+        ++count;
+        return true;
+    }
+
+    std::int32_t count = 0;
+};
+
+struct Proxy
+{
+    std::int32_t id;
+    b2AABB aabb;
+};
+
+static void Run(std::int32_t proxyCount, std::int32_t stepCount, std::int32_t budget)
+{
+    s_seed = 12345;
+    const float worldSize = 400.0f;
+
+    b2DynamicTree tree;
+    std::vector<Proxy> proxies(proxyCount);
+    for (Proxy& proxy : proxies)
+    {
+        b2Vec2 center(RandomFloat(0.0f, worldSize), RandomFloat(0.0f, worldSize));
+        proxy.aabb = RandomAABB(center);
+        proxy.id = tree.CreateProxy(proxy.aabb, nullptr);
+    }
+
+    printf("budget %d\n", budget);
+
+    std::int32_t rotationCount = 0;
+    float optimizeTime = 0.0f;
+    float areaRatio = 0.0f;
+    float queryTime = 0.0f;
+    std::int32_t sampleCount = 0;
+    for (std::int32_t step = 1; step <= stepCount; ++step)
+    {
+        for (Proxy& proxy : proxies)
+        {
+            float r = RandomFloat(0.0f, 1.0f);
+            if (r < 0.01f)
+            {
+                // Destroy and create elsewhere
+                tree.DestroyProxy(proxy.id);
+                b2Vec2 center(RandomFloat(0.0f, worldSize), RandomFloat(0.0f, worldSize));
+                proxy.aabb = RandomAABB(center);
+                proxy.id = tree.CreateProxy(proxy.aabb, nullptr);
+            }
+            else if (r < 0.02f)
+            {
+                // Teleport
+                b2Vec2 center(RandomFloat(0.0f, worldSize), RandomFloat(0.0f, worldSize));
+                b2Vec2 d = center - proxy.aabb.GetCenter();
+                proxy.aabb.lowerBound += d;
+                proxy.aabb.upperBound += d;
+                tree.MoveProxy(proxy.id, proxy.aabb, b2Vec2_zero);
+            }
+            else if (r < 0.3f)
+            {
+                // Random walk
+                b2Vec2 d(RandomFloat(-0.2f, 0.2f), RandomFloat(-0.2f, 0.2f));
+                proxy.aabb.lowerBound += d;
+                proxy.aabb.upperBound += d;
+                tree.MoveProxy(proxy.id, proxy.aabb, d);
+            }
+        }
+
+        if (budget > 0)
+        {
+            b2Timer timer;
+            rotationCount += tree.Optimize(budget);
+            optimizeTime += timer.GetMilliseconds();
+        }
+
+        if (step % 20 == 0)
+        {
+            // Query time on the current tree.
+            QueryCounter counter;
+            b2Timer timer;
+            for (std::int32_t i = 0; i < 1000; ++i)
+            {
+                b2Vec2 center(RandomFloat(0.0f, worldSize), RandomFloat(0.0f, worldSize));
+                tree.Query(&counter, RandomAABB(center));
+            }
+            queryTime += timer.GetMilliseconds();
+            areaRatio += tree.GetAreaRatio();
+            ++sampleCount;
+        }
+
+        if (step % (stepCount / 5) == 0)
+        {
+            printf("step %5d area ratio %.2f query %.2f ms rotations %d optimize %.2f ms\n", step,
+                areaRatio / sampleCount, queryTime, rotationCount, optimizeTime);
+            areaRatio = 0.0f;
+            queryTime = 0.0f;
+            sampleCount = 0;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::int32_t proxyCount = 10000;
+    std::int32_t stepCount = 5000;
+    std::int32_t budget = 256;
+    if (argc > 1)
+    {
+        proxyCount = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        stepCount = atoi(argv[2]);
+    }
+    if (argc > 3)
+    {
+        budget = atoi(argv[3]);
+    }
+
+    printf("proxies %d steps %d\n", proxyCount, stepCount);
+    Run(proxyCount, stepCount, 0);
+    Run(proxyCount, stepCount, budget);
+    return 0;
+}
@@ -0,0 +1,127 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_settings.h>
+
+/// Implement this to give a world its own memory, for example an arena that is
+/// released at once when the world is gone. Memory must be aligned like malloc.
+/// A world calls this from the thread that uses the world.
+class B2_API b2Allocator
+{
+public:
+    virtual ~b2Allocator() {}
+
+    /// Allocate memory. Must not return nullptr.
+    virtual void* Allocate(std::size_t size) = 0;
+
+    /// Free memory from Allocate. The size is the size of the allocation.
+    virtual void Free(void* mem, std::size_t size) = 0;
+};
+
+/// The subsystems of a world that use the heap.
+enum b2AllocationCategory
+{
+    b2_blockAllocation = 0,     ///< b2BlockAllocator chunks and large blocks
+    b2_stackAllocation,         ///< b2StackAllocator arena and overflow
+    b2_treeAllocation,          ///< dynamic tree nodes and traversal stacks
+    b2_broadPhaseAllocation,    ///< broad-phase move and pair buffers
+    b2_contactAllocation,       ///< contact array and pair set
+    b2_bodyAllocation,          ///< body simulation arrays
+    b2_handleAllocation,        ///< body, fixture and joint handle pools
+    b2_allocationCategoryCount
+};
+
+/// Heap use of one allocation category.
+struct B2_API b2AllocationCounter
+{
+    std::int32_t allocationCount;   ///< number of allocations so far
+    std::int32_t freeCount;         ///< number of frees so far
+    std::size_t bytes;              ///< bytes in use
+    std::size_t peakBytes;          ///< maximum of bytes in use
+    std::size_t totalBytes;         ///< bytes allocated so far
+};
+
+/// Heap use of a world, see b2World::GetAllocationStats.
+struct B2_API b2AllocationStats
+{
+    b2AllocationCounter categories[b2_allocationCategoryCount];
+
+    /// Number of allocations made while checking, see b2World::SetStepAllocationCheck.
+    std::int32_t checkedAllocationCount;
+};
+
+/// Routes the heap allocations of the subsystems of a world to a b2Allocator, or
+/// b2Alloc and b2Free if there is none, and counts them by category. Subsystems
+/// without a tracker use b2Alloc directly.
+class B2_API b2AllocationTracker
+{
+public:
+    explicit b2AllocationTracker(b2Allocator* allocator = nullptr);
+
+    /// Get the allocator that backs the tracker, nullptr for b2Alloc.
+    b2Allocator* GetAllocator() const { return m_allocator; }
+
+    /// Allocate memory on behalf of a subsystem.
+    void* Allocate(std::size_t size, b2AllocationCategory category);
+
+    /// Free memory from Allocate. The size and category must match the allocation.
+    void Free(void* mem, std::size_t size, b2AllocationCategory category);
+
+    /// Get the counters.
+    const b2AllocationStats& GetStats() const { return m_stats; }
+
+    /// While checking, every allocation asserts and is counted in
+    /// b2AllocationStats::checkedAllocationCount.
+    void SetCheck(bool flag) { m_check = flag; }
+    bool GetCheck() const { return m_check; }
+
+private:
+    b2Allocator* m_allocator;
+    b2AllocationStats m_stats;
+    bool m_check;
+};
+
+/// Allocate using a tracker if there is one.
+inline void* b2TrackedAlloc(b2AllocationTracker* tracker, std::size_t size, b2AllocationCategory category)
+{
+    if (tracker)
+    {
+        return tracker->Allocate(size, category);
+    }
+
+    return b2Alloc(size);
+}
+
+/// Free memory from b2TrackedAlloc.
+inline void b2TrackedFree(b2AllocationTracker* tracker, void* mem, std::size_t size, b2AllocationCategory category)
+{
+    if (tracker)
+    {
+        tracker->Free(mem, size, category);
+        return;
+    }
+
+    b2Free(mem);
+}
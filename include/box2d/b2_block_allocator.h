@@ -23,6 +23,7 @@
 #pragma once
 
 #include <box2d/b2_api.h>
+#include <box2d/b2_allocation_tracker.h>
 #include <box2d/b2_settings.h>
 
 #include <array>
@@ -32,13 +33,45 @@ const std::int32_t b2_blockSizeCount = 14;
 struct b2Block;
 struct b2Chunk;
 
+/// Use of one block size of a b2BlockAllocator.
+struct B2_API b2BlockSizeStats
+{
+    std::int32_t blockSize;         ///< bytes per block
+    std::int32_t chunkCount;        ///< chunks holding blocks of this size
+    std::int32_t liveBlockCount;    ///< allocated blocks
+    std::int32_t freeBlockCount;    ///< blocks on the free list
+    std::int32_t freeChunkCount;    ///< chunks without live blocks, see b2BlockAllocator::Trim
+
+    /// Fraction of the blocks that are free but cannot be released because their
+    /// chunk has live blocks.
+    float fragmentation;
+};
+
+/// Use of a b2BlockAllocator, see b2BlockAllocator::GetStats.
+struct B2_API b2BlockAllocatorStats
+{
+    b2BlockSizeStats sizes[b2_blockSizeCount];
+    std::int32_t chunkCount;
+
+    /// Chunks kept by Reset for reuse by any block size.
+    std::int32_t spareChunkCount;
+
+    /// Bytes of all chunks, including the spare chunks.
+    std::size_t chunkBytes;
+
+    /// Allocations too large for a block, these use the heap directly.
+    std::int32_t largeCount;
+    std::size_t largeBytes;
+};
+
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
 /// See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
 class B2_API b2BlockAllocator
 {
 public:
-    b2BlockAllocator();
+    /// The tracker receives the heap allocations, see b2AllocationTracker.
+    explicit b2BlockAllocator(b2AllocationTracker* tracker = nullptr);
     ~b2BlockAllocator();
 
     /// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
@@ -52,15 +85,51 @@ public:
 
     void Clear();
 
+    /// Discard all blocks at once but keep the chunks for reuse. The memory of the
+    /// blocks must not be used afterwards. This is much faster than freeing each
+    /// block. Large allocations must have been freed.
+    void Reset();
+
+    /// Make sure that count objects of the given size can be allocated without
+    /// allocating chunks. Use this to warm up before spawning many objects.
+    void Reserve(std::size_t size, std::int32_t count);
+
+    /// Template version of Reserve.
+    template <typename T>
+    void Reserve(std::int32_t count) { Reserve(sizeof(T), count); }
+
+    /// Release the chunks that have no live blocks and the spare chunks, for example
+    /// after many objects were destroyed.
+    /// @return the number of chunks released.
+    std::int32_t Trim();
+
+    /// Compute the use of the allocator. This walks the free lists, so it is not free.
+    void GetStats(b2BlockAllocatorStats* stats) const;
+
 private:
+    friend class b2SharedBlockAllocator;
+
     void* HandleAllocate(std::size_t size);
     void HandleFree(void* p, std::size_t size);
 
+    void AllocateChunk(std::int32_t index);
+    void FormatChunk(b2Chunk* chunk, std::int32_t index);
+    std::int32_t* CountFreeBlocks() const;
+
+    b2AllocationTracker* m_tracker;
+
     b2Chunk* m_chunks;
     std::int32_t m_chunkCount;
     std::size_t m_chunkSpace;
 
+    // Chunks without a block size, stored after the used chunks.
+    std::int32_t m_spareChunkCount;
+
     std::array<b2Block*, b2_blockSizeCount> m_freeLists;
+    std::array<std::int32_t, b2_blockSizeCount> m_freeCounts;
+
+    std::int32_t m_largeCount;
+    std::size_t m_largeBytes;
 };
 
 template <typename T>
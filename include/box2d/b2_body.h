@@ -23,6 +23,7 @@
 #pragma once
 
 #include <box2d/b2_api.h>
+#include <box2d/b2_id.h>
 #include <box2d/b2_math.h>
 #include <box2d/b2_shape.h>
 
@@ -30,6 +31,8 @@ class b2Fixture;
 class b2Joint;
 class b2Contact;
 class b2Controller;
+class b2ReplayPlayer;
+class b2ReplayRecorder;
 class b2World;
 struct b2FixtureDef;
 struct b2JointEdge;
@@ -123,6 +126,34 @@ struct B2_API b2BodyDef
     float gravityScale;
 };
 
+/// The simulation state of a body that is touched every time step. These are stored
+/// in a dense array owned by b2World so that the solver and broad-phase synchronization
+/// don't pull the rest of the body into cache. The client does not interact with this directly.
+struct B2_API b2BodySim
+{
+    b2Transform xf;     // the body origin transform
+    b2Sweep sweep;      // the swept motion for CCD
+
+    b2Vec2 linearVelocity;
+    float angularVelocity;
+
+    b2Vec2 force;
+    float torque;
+
+    float mass, invMass;
+
+    // Inverse rotational inertia about the center of mass.
+    float invI;
+
+    float linearDamping;
+    float angularDamping;
+    float gravityScale;
+
+    float sleepTime;
+
+    std::uint16_t flags;
+};
+
 /// A rigid body. These are created via b2World::CreateBody.
 class B2_API b2Body
 {
@@ -161,23 +192,24 @@ public:
     /// @param angle the world rotation in radians.
     void SetTransform(const b2Vec2& position, float angle);
 
-    /// Get the body transform for the body's origin.
+    /// Get the body transform for the body's origin. This is a copy, because the world
+    /// moves the simulation state of bodies when bodies are created or destroyed.
     /// @return the world transform of the body's origin.
-    const b2Transform& GetTransform() const;
+    b2Transform GetTransform() const;
 
-    /// Get the world body origin position.
+    /// Get the world body origin position. This is a copy, see GetTransform.
     /// @return the world position of the body's origin.
-    const b2Vec2& GetPosition() const;
+    b2Vec2 GetPosition() const;
 
     /// Get the angle in radians.
     /// @return the current world rotation angle in radians.
     float GetAngle() const;
 
     /// Get the world position of the center of mass.
-    const b2Vec2& GetWorldCenter() const;
+    b2Vec2 GetWorldCenter() const;
 
     /// Get the local position of the center of mass.
-    const b2Vec2& GetLocalCenter() const;
+    b2Vec2 GetLocalCenter() const;
 
     /// Set the linear velocity of the center of mass.
     /// @param v the new linear velocity of the center of mass.
@@ -185,7 +217,7 @@ public:
 
     /// Get the linear velocity of the center of mass.
     /// @return the linear velocity of the center of mass.
-    const b2Vec2& GetLinearVelocity() const;
+    b2Vec2 GetLinearVelocity() const;
 
     /// Set the angular velocity.
     /// @param omega the new angular velocity in radians/second.
@@ -382,6 +414,10 @@ public:
     b2World* GetWorld();
     const b2World* GetWorld() const;
 
+    /// Get a handle to this body that can be checked after the body is destroyed.
+    /// @see b2World::GetBody
+    b2BodyId GetId() const;
+
     /// Dump this body to a file
     void Dump();
 
@@ -392,6 +428,8 @@ private:
     friend class b2ContactManager;
     friend class b2ContactSolver;
     friend class b2Contact;
+    friend class b2ReplayPlayer;
+    friend class b2ReplayRecorder;
 
     friend class b2DistanceJoint;
     friend class b2FrictionJoint;
@@ -404,7 +442,7 @@ private:
     friend class b2WeldJoint;
     friend class b2WheelJoint;
 
-    // m_flags
+    // b2BodySim::flags
     enum
     {
         e_islandFlag        = 0x0001,
@@ -416,7 +454,7 @@ private:
         e_toiFlag           = 0x0040
     };
 
-    b2Body(const b2BodyDef* bd, b2World* world);
+    b2Body(const b2BodyDef* bd, b2World* world, b2BodySim* sim);
     ~b2Body();
 
     void SynchronizeFixtures();
@@ -428,20 +466,15 @@ private:
 
     void Advance(float t);
 
-    b2BodyType m_type;
+    // Hot simulation state, stored densely in the world. The world
+    // updates this pointer when the state array is relocated.
+    b2BodySim* m_sim;
 
-    std::uint16_t m_flags;
+    b2BodyType m_type;
 
     std::int32_t m_islandIndex;
 
-    b2Transform m_xf; // the body origin transform
-    b2Sweep m_sweep;  // the swept motion for CCD
-
-    b2Vec2 m_linearVelocity;
-    float m_angularVelocity;
-
-    b2Vec2 m_force;
-    float m_torque;
+    b2BodyId m_id;
 
     b2World* m_world;
     b2Body* m_prev;
@@ -450,19 +483,19 @@ private:
     b2Fixture* m_fixtureList;
     std::int32_t m_fixtureCount;
 
+    // The transform at the last fixture synchronization and how far a point of the body
+    // may move from it before the proxies need to be synchronized again.
+    b2Transform m_syncTransform;
+    float m_syncSlack;
+
+    // The largest distance from the body origin to the fixture bounds.
+    float m_fixtureExtent;
+
     b2JointEdge* m_jointList;
     b2ContactEdge* m_contactList;
 
-    float m_mass, m_invMass;
-
     // Rotational inertia about the center of mass.
-    float m_I, m_invI;
-
-    float m_linearDamping;
-    float m_angularDamping;
-    float m_gravityScale;
-
-    float m_sleepTime;
+    float m_I;
 
     b2BodyUserData m_userData;
 };
@@ -472,29 +505,29 @@ inline b2BodyType b2Body::GetType() const
     return m_type;
 }
 
-inline const b2Transform& b2Body::GetTransform() const
+inline b2Transform b2Body::GetTransform() const
 {
-    return m_xf;
+    return m_sim->xf;
 }
 
-inline const b2Vec2& b2Body::GetPosition() const
+inline b2Vec2 b2Body::GetPosition() const
 {
-    return m_xf.p;
+    return m_sim->xf.p;
 }
 
 inline float b2Body::GetAngle() const
 {
-    return m_sweep.a;
+    return m_sim->sweep.a;
 }
 
-inline const b2Vec2& b2Body::GetWorldCenter() const
+inline b2Vec2 b2Body::GetWorldCenter() const
 {
-    return m_sweep.c;
+    return m_sim->sweep.c;
 }
 
-inline const b2Vec2& b2Body::GetLocalCenter() const
+inline b2Vec2 b2Body::GetLocalCenter() const
 {
-    return m_sweep.localCenter;
+    return m_sim->sweep.localCenter;
 }
 
 inline void b2Body::SetLinearVelocity(const b2Vec2& v)
@@ -509,12 +542,12 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
         SetAwake(true);
     }
 
-    m_linearVelocity = v;
+    m_sim->linearVelocity = v;
 }
 
-inline const b2Vec2& b2Body::GetLinearVelocity() const
+inline b2Vec2 b2Body::GetLinearVelocity() const
 {
-    return m_linearVelocity;
+    return m_sim->linearVelocity;
 }
 
 inline void b2Body::SetAngularVelocity(float w)
@@ -529,56 +562,56 @@ inline void b2Body::SetAngularVelocity(float w)
         SetAwake(true);
     }
 
-    m_angularVelocity = w;
+    m_sim->angularVelocity = w;
 }
 
 inline float b2Body::GetAngularVelocity() const
 {
-    return m_angularVelocity;
+    return m_sim->angularVelocity;
 }
 
 inline float b2Body::GetMass() const
 {
-    return m_mass;
+    return m_sim->mass;
 }
 
 inline float b2Body::GetInertia() const
 {
-    return m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
+    return m_I + m_sim->mass * b2Dot(m_sim->sweep.localCenter, m_sim->sweep.localCenter);
 }
 
 inline b2MassData b2Body::GetMassData() const
 {
     b2MassData data;
-    data.mass = m_mass;
-    data.I = m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
-    data.center = m_sweep.localCenter;
+    data.mass = m_sim->mass;
+    data.I = m_I + m_sim->mass * b2Dot(m_sim->sweep.localCenter, m_sim->sweep.localCenter);
+    data.center = m_sim->sweep.localCenter;
     return data;
 }
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
 {
-    return b2Mul(m_xf, localPoint);
+    return b2Mul(m_sim->xf, localPoint);
 }
 
 inline b2Vec2 b2Body::GetWorldVector(const b2Vec2& localVector) const
 {
-    return b2Mul(m_xf.q, localVector);
+    return b2Mul(m_sim->xf.q, localVector);
 }
 
 inline b2Vec2 b2Body::GetLocalPoint(const b2Vec2& worldPoint) const
 {
-    return b2MulT(m_xf, worldPoint);
+    return b2MulT(m_sim->xf, worldPoint);
 }
 
 inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 {
-    return b2MulT(m_xf.q, worldVector);
+    return b2MulT(m_sim->xf.q, worldVector);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
-    return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
+    return m_sim->linearVelocity + b2Cross(m_sim->angularVelocity, worldPoint - m_sim->sweep.c);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint) const
@@ -588,49 +621,49 @@ inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint)
 
 inline float b2Body::GetLinearDamping() const
 {
-    return m_linearDamping;
+    return m_sim->linearDamping;
 }
 
 inline void b2Body::SetLinearDamping(float linearDamping)
 {
-    m_linearDamping = linearDamping;
+    m_sim->linearDamping = linearDamping;
 }
 
 inline float b2Body::GetAngularDamping() const
 {
-    return m_angularDamping;
+    return m_sim->angularDamping;
 }
 
 inline void b2Body::SetAngularDamping(float angularDamping)
 {
-    m_angularDamping = angularDamping;
+    m_sim->angularDamping = angularDamping;
 }
 
 inline float b2Body::GetGravityScale() const
 {
-    return m_gravityScale;
+    return m_sim->gravityScale;
 }
 
 inline void b2Body::SetGravityScale(float scale)
 {
-    m_gravityScale = scale;
+    m_sim->gravityScale = scale;
 }
 
 inline void b2Body::SetBullet(bool flag)
 {
     if (flag)
     {
-        m_flags |= e_bulletFlag;
+        m_sim->flags |= e_bulletFlag;
     }
     else
     {
-        m_flags &= ~e_bulletFlag;
+        m_sim->flags &= ~e_bulletFlag;
     }
 }
 
 inline bool b2Body::IsBullet() const
 {
-    return (m_flags & e_bulletFlag) == e_bulletFlag;
+    return (m_sim->flags & e_bulletFlag) == e_bulletFlag;
 }
 
 inline void b2Body::SetAwake(bool flag)
@@ -642,51 +675,51 @@ inline void b2Body::SetAwake(bool flag)
 
     if (flag)
     {
-        m_flags |= e_awakeFlag;
-        m_sleepTime = 0.0f;
+        m_sim->flags |= e_awakeFlag;
+        m_sim->sleepTime = 0.0f;
     }
     else
     {
-        m_flags &= ~e_awakeFlag;
-        m_sleepTime = 0.0f;
-        m_linearVelocity.SetZero();
-        m_angularVelocity = 0.0f;
-        m_force.SetZero();
-        m_torque = 0.0f;
+        m_sim->flags &= ~e_awakeFlag;
+        m_sim->sleepTime = 0.0f;
+        m_sim->linearVelocity.SetZero();
+        m_sim->angularVelocity = 0.0f;
+        m_sim->force.SetZero();
+        m_sim->torque = 0.0f;
     }
 }
 
 inline bool b2Body::IsAwake() const
 {
-    return (m_flags & e_awakeFlag) == e_awakeFlag;
+    return (m_sim->flags & e_awakeFlag) == e_awakeFlag;
 }
 
 inline bool b2Body::IsEnabled() const
 {
-    return (m_flags & e_enabledFlag) == e_enabledFlag;
+    return (m_sim->flags & e_enabledFlag) == e_enabledFlag;
 }
 
 inline bool b2Body::IsFixedRotation() const
 {
-    return (m_flags & e_fixedRotationFlag) == e_fixedRotationFlag;
+    return (m_sim->flags & e_fixedRotationFlag) == e_fixedRotationFlag;
 }
 
 inline void b2Body::SetSleepingAllowed(bool flag)
 {
     if (flag)
     {
-        m_flags |= e_autoSleepFlag;
+        m_sim->flags |= e_autoSleepFlag;
     }
     else
     {
-        m_flags &= ~e_autoSleepFlag;
+        m_sim->flags &= ~e_autoSleepFlag;
         SetAwake(true);
     }
 }
 
 inline bool b2Body::IsSleepingAllowed() const
 {
-    return (m_flags & e_autoSleepFlag) == e_autoSleepFlag;
+    return (m_sim->flags & e_autoSleepFlag) == e_autoSleepFlag;
 }
 
 inline b2Fixture* b2Body::GetFixtureList()
@@ -746,16 +779,16 @@ inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point, bool wa
         return;
     }
 
-    if (wake && (m_flags & e_awakeFlag) == 0)
+    if (wake && (m_sim->flags & e_awakeFlag) == 0)
     {
         SetAwake(true);
     }
 
     // Don't accumulate a force if the body is sleeping.
-    if (m_flags & e_awakeFlag)
+    if (m_sim->flags & e_awakeFlag)
     {
-        m_force += force;
-        m_torque += b2Cross(point - m_sweep.c, force);
+        m_sim->force += force;
+        m_sim->torque += b2Cross(point - m_sim->sweep.c, force);
     }
 }
 
@@ -766,15 +799,15 @@ inline void b2Body::ApplyForceToCenter(const b2Vec2& force, bool wake)
         return;
     }
 
-    if (wake && (m_flags & e_awakeFlag) == 0)
+    if (wake && (m_sim->flags & e_awakeFlag) == 0)
     {
         SetAwake(true);
     }
 
     // Don't accumulate a force if the body is sleeping
-    if (m_flags & e_awakeFlag)
+    if (m_sim->flags & e_awakeFlag)
     {
-        m_force += force;
+        m_sim->force += force;
     }
 }
 
@@ -785,15 +818,15 @@ inline void b2Body::ApplyTorque(float torque, bool wake)
         return;
     }
 
-    if (wake && (m_flags & e_awakeFlag) == 0)
+    if (wake && (m_sim->flags & e_awakeFlag) == 0)
     {
         SetAwake(true);
     }
 
     // Don't accumulate a force if the body is sleeping
-    if (m_flags & e_awakeFlag)
+    if (m_sim->flags & e_awakeFlag)
     {
-        m_torque += torque;
+        m_sim->torque += torque;
     }
 }
 
@@ -804,16 +837,16 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
         return;
     }
 
-    if (wake && (m_flags & e_awakeFlag) == 0)
+    if (wake && (m_sim->flags & e_awakeFlag) == 0)
     {
         SetAwake(true);
     }
 
     // Don't accumulate velocity if the body is sleeping
-    if (m_flags & e_awakeFlag)
+    if (m_sim->flags & e_awakeFlag)
     {
-        m_linearVelocity += m_invMass * impulse;
-        m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+        m_sim->linearVelocity += m_sim->invMass * impulse;
+        m_sim->angularVelocity += m_sim->invI * b2Cross(point - m_sim->sweep.c, impulse);
     }
 }
 
@@ -824,15 +857,15 @@ inline void b2Body::ApplyLinearImpulseToCenter(const b2Vec2& impulse, bool wake)
         return;
     }
 
-    if (wake && (m_flags & e_awakeFlag) == 0)
+    if (wake && (m_sim->flags & e_awakeFlag) == 0)
     {
         SetAwake(true);
     }
 
     // Don't accumulate velocity if the body is sleeping
-    if (m_flags & e_awakeFlag)
+    if (m_sim->flags & e_awakeFlag)
     {
-        m_linearVelocity += m_invMass * impulse;
+        m_sim->linearVelocity += m_sim->invMass * impulse;
     }
 }
 
@@ -843,32 +876,37 @@ inline void b2Body::ApplyAngularImpulse(float impulse, bool wake)
         return;
     }
 
-    if (wake && (m_flags & e_awakeFlag) == 0)
+    if (wake && (m_sim->flags & e_awakeFlag) == 0)
     {
         SetAwake(true);
     }
 
     // Don't accumulate velocity if the body is sleeping
-    if (m_flags & e_awakeFlag)
+    if (m_sim->flags & e_awakeFlag)
     {
-        m_angularVelocity += m_invI * impulse;
+        m_sim->angularVelocity += m_sim->invI * impulse;
     }
 }
 
 inline void b2Body::SynchronizeTransform()
 {
-    m_xf.q.Set(m_sweep.a);
-    m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+    m_sim->xf.q.Set(m_sim->sweep.a);
+    m_sim->xf.p = m_sim->sweep.c - b2Mul(m_sim->xf.q, m_sim->sweep.localCenter);
 }
 
 inline void b2Body::Advance(float alpha)
 {
     // Advance to the new safe time. This doesn't sync the broad-phase.
-    m_sweep.Advance(alpha);
-    m_sweep.c = m_sweep.c0;
-    m_sweep.a = m_sweep.a0;
-    m_xf.q.Set(m_sweep.a);
-    m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+    m_sim->sweep.Advance(alpha);
+    m_sim->sweep.c = m_sim->sweep.c0;
+    m_sim->sweep.a = m_sim->sweep.a0;
+    m_sim->xf.q.Set(m_sim->sweep.a);
+    m_sim->xf.p = m_sim->sweep.c - b2Mul(m_sim->xf.q, m_sim->sweep.localCenter);
+}
+
+inline b2BodyId b2Body::GetId() const
+{
+    return m_id;
 }
 
 inline b2World* b2Body::GetWorld()
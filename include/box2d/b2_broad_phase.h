@@ -45,7 +45,8 @@ public:
         e_nullProxy = -1
     };
 
-    b2BroadPhase();
+    /// The tracker receives the heap allocations, see b2AllocationTracker.
+    explicit b2BroadPhase(b2AllocationTracker* tracker = nullptr);
     ~b2BroadPhase();
 
     /// Create a proxy with an initial AABB. Pairs are not reported until
@@ -57,7 +58,8 @@ public:
 
     /// Call MoveProxy as many times as you like, then when you are done
     /// call UpdatePairs to finalized the proxy pairs (for your time step).
-    void MoveProxy(std::int32_t proxyId, const b2AABB& aabb, const b2Vec2& displacement);
+    /// @return true if the proxy was enlarged and buffered for pair updates.
+    bool MoveProxy(std::int32_t proxyId, const b2AABB& aabb, const b2Vec2& displacement);
 
     /// Call to trigger a re-processing of it's pairs on the next call to UpdatePairs.
     void TouchProxy(std::int32_t proxyId);
@@ -65,6 +67,12 @@ public:
     /// Get the fat AABB for a proxy.
     const b2AABB& GetFatAABB(std::int32_t proxyId) const;
 
+    /// Get the margin used to fatten the AABB of a proxy on its next move.
+    float GetMargin(std::int32_t proxyId) const;
+
+    /// Get how far the fat AABB of a proxy may outgrow its next fat AABB before it is shrunk.
+    float GetHugeExtension(std::int32_t proxyId) const;
+
     /// Get user data from a proxy. Returns nullptr if the id is invalid.
     void* GetUserData(std::int32_t proxyId) const;
 
@@ -74,6 +82,10 @@ public:
     /// Get the number of proxies.
     std::int32_t GetProxyCount() const;
 
+    /// Get the number of proxies re-inserted into the tree by MoveProxy since the last reset.
+    std::int32_t GetReinsertionCount() const;
+    void ResetReinsertionCount();
+
     /// Update the pairs. This results in pair callbacks. This can only add pairs.
     template <typename T>
     void UpdatePairs(T* callback);
@@ -102,11 +114,31 @@ public:
     /// Get the quality metric of the embedded tree.
     float GetTreeQuality() const;
 
+    /// Validate the embedded tree. For testing.
+    void ValidateTree() const;
+
+    /// Incrementally optimize the embedded tree, see b2DynamicTree::Optimize.
+    /// @return the number of rotations performed.
+    std::int32_t OptimizeTree(std::int32_t budget);
+
+    /// Enable/disable refit mode of the embedded tree, see b2DynamicTree::SetRefit.
+    /// UpdatePairs refits the tree before looking for pairs.
+    void SetTreeRefit(bool flag);
+    bool GetTreeRefit() const;
+
+    /// Create many proxies at once and build the tree in one pass at the end, see
+    /// b2DynamicTree::BeginBulkInsert. Pairs are found by the next UpdatePairs as usual.
+    void BeginBulkInsert();
+    void EndBulkInsert();
+
     /// Shift the world origin. Useful for large worlds.
     /// The shift formula is: position -= newOrigin
     /// @param newOrigin the new origin with respect to the old origin
     void ShiftOrigin(const b2Vec2& newOrigin);
 
+    /// Remove all proxies at once. The buffers keep their capacity.
+    void Reset();
+
 private:
 
     friend class b2DynamicTree;
@@ -118,7 +150,10 @@ private:
 
     b2DynamicTree m_tree;
 
+    b2AllocationTracker* m_tracker;
+
     std::int32_t m_proxyCount;
+    std::int32_t m_reinsertionCount;
 
     std::int32_t* m_moveBuffer;
     std::int32_t m_moveCapacity;
@@ -148,11 +183,31 @@ inline const b2AABB& b2BroadPhase::GetFatAABB(std::int32_t proxyId) const
     return m_tree.GetFatAABB(proxyId);
 }
 
+inline float b2BroadPhase::GetMargin(std::int32_t proxyId) const
+{
+    return m_tree.GetMargin(proxyId);
+}
+
+inline float b2BroadPhase::GetHugeExtension(std::int32_t proxyId) const
+{
+    return m_tree.GetHugeExtension(proxyId);
+}
+
 inline std::int32_t b2BroadPhase::GetProxyCount() const
 {
     return m_proxyCount;
 }
 
+inline std::int32_t b2BroadPhase::GetReinsertionCount() const
+{
+    return m_reinsertionCount;
+}
+
+inline void b2BroadPhase::ResetReinsertionCount()
+{
+    m_reinsertionCount = 0;
+}
+
 inline std::int32_t b2BroadPhase::GetTreeHeight() const
 {
     return m_tree.GetHeight();
@@ -168,9 +223,42 @@ inline float b2BroadPhase::GetTreeQuality() const
     return m_tree.GetAreaRatio();
 }
 
+inline void b2BroadPhase::ValidateTree() const
+{
+    m_tree.Validate();
+}
+
+inline std::int32_t b2BroadPhase::OptimizeTree(std::int32_t budget)
+{
+    return m_tree.Optimize(budget);
+}
+
+inline void b2BroadPhase::SetTreeRefit(bool flag)
+{
+    m_tree.SetRefit(flag);
+}
+
+inline bool b2BroadPhase::GetTreeRefit() const
+{
+    return m_tree.GetRefit();
+}
+
+inline void b2BroadPhase::BeginBulkInsert()
+{
+    m_tree.BeginBulkInsert();
+}
+
+inline void b2BroadPhase::EndBulkInsert()
+{
+    m_tree.EndBulkInsert();
+}
+
 template <typename T>
 void b2BroadPhase::UpdatePairs(T* callback)
 {
+    // Tighten the tree after proxies moved in place.
+    m_tree.Refit();
+
     // Reset pair buffer
     m_pairCount = 0;
 
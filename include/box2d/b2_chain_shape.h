@@ -27,6 +27,20 @@
 
 class b2EdgeShape;
 
+/// A node in the segment tree of a chain shape. Nodes are stored depth first, so the
+/// first child of an internal node immediately follows it.
+struct B2_API b2ChainTreeNode
+{
+    /// Local bounds of the segments under this node, including the radius.
+    b2AABB aabb;
+
+    /// The index of the second child, or -1 for a leaf.
+    std::int32_t child2;
+
+    /// The segment index of a leaf.
+    std::int32_t segment;
+};
+
 /// A chain shape is a free form sequence of line segments.
 /// The chain has one-sided collision, with the surface normal pointing to the right of the edge.
 /// This provides a counter-clockwise winding like the polygon shape.
@@ -56,6 +70,16 @@ public:
     void CreateChain(const b2Vec2* vertices, std::int32_t count,
         const b2Vec2& prevVertex, const b2Vec2& nextVertex);
 
+    /// Use a single broad-phase proxy for the whole chain. This builds a static tree over
+    /// the segments so contacts are only created for the segments that overlap other
+    /// proxies. Use this for long chains such as level outlines. Call this after creating
+    /// the chain and before creating the fixture.
+    /// @param flag true to use a single proxy, false to use a proxy per segment
+    void SetSingleProxy(bool flag);
+
+    /// Does this chain use a single broad-phase proxy?
+    bool IsSingleProxy() const;
+
     /// Implement b2Shape. Vertices are cloned using b2Alloc.
     b2Shape* Clone(b2BlockAllocator* allocator) const override;
 
@@ -80,6 +104,17 @@ public:
     /// @see b2Shape::ComputeMass
     void ComputeMass(b2MassData* massData, float density) const override;
 
+    /// True in single proxy mode.
+    /// @see b2Shape::SharesProxy
+    bool SharesProxy() const override;
+
+    /// @see b2Shape::ComputeProxyAABB
+    void ComputeProxyAABB(b2AABB* aabb, const b2Transform& transform) const override;
+
+    /// Reports the segments under the AABB using the segment tree in single proxy mode.
+    /// @see b2Shape::QueryChildren
+    void QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& transform) const override;
+
     /// The vertices. Owned by this class.
     b2Vec2* m_vertices;
 
@@ -87,6 +122,12 @@ public:
     std::int32_t m_count;
 
     b2Vec2 m_prevVertex, m_nextVertex;
+
+    /// The segment tree, only used in single proxy mode. Owned by this class.
+    b2ChainTreeNode* m_nodes;
+
+    /// The node count. Zero unless in single proxy mode.
+    std::int32_t m_nodeCount;
 };
 
 inline b2ChainShape::b2ChainShape()
@@ -95,4 +136,11 @@ inline b2ChainShape::b2ChainShape()
     m_radius = b2_polygonRadius;
     m_vertices = nullptr;
     m_count = 0;
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+}
+
+inline bool b2ChainShape::IsSingleProxy() const
+{
+    return m_nodes != nullptr;
 }
@@ -33,6 +33,7 @@
 /// queries, and TOI queries.
 
 class b2Shape;
+class b2CapsuleShape;
 class b2CircleShape;
 class b2EdgeShape;
 class b2PolygonShape;
@@ -246,6 +247,26 @@ B2_API void b2CollideEdgeAndPolygon(b2Manifold* manifold,
                                const b2EdgeShape* edgeA, const b2Transform& xfA,
                                const b2PolygonShape* circleB, const b2Transform& xfB);
 
+/// Compute the collision manifold between two capsules.
+B2_API void b2CollideCapsules(b2Manifold* manifold,
+                       const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+                       const b2CapsuleShape* capsuleB, const b2Transform& xfB);
+
+/// Compute the collision manifold between a capsule and a circle.
+B2_API void b2CollideCapsuleAndCircle(b2Manifold* manifold,
+                               const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+                               const b2CircleShape* circleB, const b2Transform& xfB);
+
+/// Compute the collision manifold between a capsule and a polygon.
+B2_API void b2CollideCapsuleAndPolygon(b2Manifold* manifold,
+                               const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+                               const b2PolygonShape* polygonB, const b2Transform& xfB);
+
+/// Compute the collision manifold between an edge and a capsule.
+B2_API void b2CollideEdgeAndCapsule(b2Manifold* manifold,
+                               const b2EdgeShape* edgeA, const b2Transform& xfA,
+                               const b2CapsuleShape* capsuleB, const b2Transform& xfB);
+
 /// Clipping for contact manifolds.
 B2_API std::int32_t b2ClipSegmentToLine(std::array<b2ClipVertex, 2>& vOut, const std::array<b2ClipVertex, 2>& vIn,
                             const b2Vec2& normal, float offset, std::int32_t vertexIndexA);
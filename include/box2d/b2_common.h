@@ -45,7 +45,8 @@
 #define b2_maxManifoldPoints    2
 
 /// This is used to fatten AABBs in the dynamic tree. This allows proxies
-/// to move by a small amount without triggering a tree adjustment.
+/// to move by a small amount without triggering a tree adjustment. This is
+/// the margin of moving proxies, see b2_aabbMinExtension.
 /// This is in meters.
 #define b2_aabbExtension        (0.1f * b2_lengthUnitsPerMeter)
 
@@ -54,6 +55,19 @@
 /// This is a dimensionless multiplier.
 #define b2_aabbMultiplier       4.0f
 
+/// The AABB margin of a proxy follows its recent displacement per move, between this
+/// and b2_aabbExtension. Resting proxies get thin AABBs that generate few pairs.
+/// This is in meters.
+#define b2_aabbMinExtension     (0.25f * b2_aabbExtension)
+
+/// The recent displacement of a proxy decays by this factor per move.
+/// This is a dimensionless multiplier.
+#define b2_aabbMotionDecay      0.5f
+
+/// The default number of dynamic tree nodes the world optimizer visits per time step.
+/// See b2World::SetTreeOptimizationBudget.
+#define b2_treeOptimizationBudget   64
+
 /// A small length used as a collision and constraint tolerance. Usually it is
 /// chosen to be numerically significant, but visually insignificant. In meters.
 #define b2_linearSlop           (0.005f * b2_lengthUnitsPerMeter)
@@ -70,6 +84,14 @@
 /// Maximum number of sub-steps per contact in continuous physics simulation.
 #define b2_maxSubSteps          8
 
+/// When manifold reuse is enabled, a contact keeps its manifold while the relative
+/// position of the two bodies has moved less than this since the last evaluation. In meters.
+#define b2_manifoldReuseLinearTolerance     (0.1f * b2_linearSlop)
+
+/// When manifold reuse is enabled, a contact keeps its manifold while the relative
+/// rotation of the two bodies has changed less than this since the last evaluation. In radians.
+#define b2_manifoldReuseAngularTolerance    (0.1f * b2_angularSlop)
+
 
 // Dynamics
 
@@ -0,0 +1,129 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_shape.h>
+
+/// A node in the child tree of a compound shape. Nodes are stored depth first, so the
+/// first child of an internal node immediately follows it.
+struct B2_API b2CompoundTreeNode
+{
+    /// Local bounds of the children under this node.
+    b2AABB aabb;
+
+    /// The index of the second child, or -1 for a leaf.
+    std::int32_t child2;
+
+    /// The child shape index of a leaf.
+    std::int32_t child;
+};
+
+/// A compound shape is a rigid group of convex shapes that share one fixture. The
+/// compound uses a single broad-phase proxy and a small tree over its children, so a
+/// body made of many parts only moves one proxy per step and contacts are only created
+/// for the children that overlap other proxies. The children share the fixture's
+/// friction, restitution, density and filter.
+/// Circles, polygons and capsules may be used as children.
+class B2_API b2CompoundShape : public b2Shape
+{
+public:
+    b2CompoundShape();
+
+    /// The destructor frees the children using b2Free.
+    ~b2CompoundShape();
+
+    /// Clear all data.
+    void Clear();
+
+    /// Create the compound and build the child tree.
+    /// @param children the child shapes in the coordinates of the body, these are copied
+    /// @param count the child count
+    void Create(const b2Shape* const* children, std::int32_t count);
+
+    /// Get a child shape.
+    const b2Shape* GetChild(std::int32_t index) const;
+
+    /// Implement b2Shape. Children are cloned using b2Alloc.
+    b2Shape* Clone(b2BlockAllocator* allocator) const override;
+
+    /// @see b2Shape::GetChildCount
+    std::int32_t GetChildCount() const override;
+
+    /// Test the point against each child.
+    /// @see b2Shape::TestPoint
+    bool TestPoint(const b2Transform& transform, const b2Vec2& p) const override;
+
+    /// Implement b2Shape.
+    bool RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+                    const b2Transform& transform, std::int32_t childIndex) const override;
+
+    /// @see b2Shape::ComputeAABB
+    void ComputeAABB(b2AABB* aabb, const b2Transform& transform, std::int32_t childIndex) const override;
+
+    /// The mass is the sum of the child masses.
+    /// @see b2Shape::ComputeMass
+    void ComputeMass(b2MassData* massData, float density) const override;
+
+    /// @see b2Shape::GetChildRadius
+    float GetChildRadius(std::int32_t childIndex) const override;
+
+    /// This always returns true.
+    /// @see b2Shape::SharesProxy
+    bool SharesProxy() const override;
+
+    /// @see b2Shape::ComputeProxyAABB
+    void ComputeProxyAABB(b2AABB* aabb, const b2Transform& transform) const override;
+
+    /// Reports the children under the AABB using the child tree.
+    /// @see b2Shape::QueryChildren
+    void QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& transform) const override;
+
+    /// The child shapes. Owned by this class.
+    b2Shape** m_children;
+
+    /// The child count.
+    std::int32_t m_count;
+
+    /// The child tree. Owned by this class.
+    b2CompoundTreeNode* m_nodes;
+
+    /// The node count.
+    std::int32_t m_nodeCount;
+};
+
+inline b2CompoundShape::b2CompoundShape()
+{
+    m_type = e_compound;
+    m_radius = 0.0f;
+    m_children = nullptr;
+    m_count = 0;
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+}
+
+inline const b2Shape* b2CompoundShape::GetChild(std::int32_t index) const
+{
+    assert(0 <= index && index < m_count);
+    return m_children[index];
+}
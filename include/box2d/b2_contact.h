@@ -25,6 +25,7 @@
 #include <box2d/b2_api.h>
 #include <box2d/b2_collision.h>
 #include <box2d/b2_fixture.h>
+#include <box2d/b2_hash_set.h>
 #include <box2d/b2_math.h>
 #include <box2d/b2_shape.h>
 
@@ -35,6 +36,7 @@ class b2World;
 class b2BlockAllocator;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactManager;
 
 /// Friction mixing law. The idea is to allow either fixture to drive the friction to zero.
 /// For example, anything slides on ice.
@@ -190,7 +192,10 @@ protected:
         e_bulletHitFlag     = 0x0010,
 
         // This contact has a valid TOI in m_toi
-        e_toiFlag           = 0x0020
+        e_toiFlag           = 0x0020,
+
+        // This contact has a manifold evaluated at m_relativeXf
+        e_manifoldCacheFlag = 0x0040
     };
 
     /// Flag this contact for filtering. Filtering will occur the next time step.
@@ -207,7 +212,8 @@ protected:
     b2Contact(b2Fixture* fixtureA, std::int32_t indexA, b2Fixture* fixtureB, std::int32_t indexB);
     virtual ~b2Contact() {}
 
-    void Update(b2ContactListener* listener);
+    void Update(b2ContactManager* manager);
+    bool CanReuseManifold(const b2Transform& xfA, const b2Transform& xfB) const;
 
     static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
     static bool s_initialized;
@@ -218,6 +224,12 @@ protected:
     b2Contact* m_prev;
     b2Contact* m_next;
 
+    // Index in the contact manager's dense contact array.
+    std::int32_t m_contactIndex;
+
+    // Key in the contact manager's pair set.
+    b2PairKey m_pairKey;
+
     // Nodes for connecting bodies.
     b2ContactEdge m_nodeA;
     b2ContactEdge m_nodeB;
@@ -230,6 +242,9 @@ protected:
 
     b2Manifold m_manifold;
 
+    // Relative transform of body B in body A at the last manifold evaluation.
+    b2Transform m_relativeXf;
+
     std::int32_t m_toiCount;
     float m_toi;
 
@@ -257,7 +272,8 @@ inline void b2Contact::GetWorldManifold(b2WorldManifold* worldManifold) const
     const b2Shape* shapeA = m_fixtureA->GetShape();
     const b2Shape* shapeB = m_fixtureB->GetShape();
 
-    worldManifold->Initialize(&m_manifold, bodyA->GetTransform(), shapeA->m_radius, bodyB->GetTransform(), shapeB->m_radius);
+    worldManifold->Initialize(&m_manifold, bodyA->GetTransform(), shapeA->GetChildRadius(m_indexA),
+                              bodyB->GetTransform(), shapeB->GetChildRadius(m_indexB));
 }
 
 inline void b2Contact::SetEnabled(bool flag)
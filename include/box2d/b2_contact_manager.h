@@ -24,17 +24,21 @@
 
 #include <box2d/b2_api.h>
 #include <box2d/b2_broad_phase.h>
+#include <box2d/b2_hash_set.h>
 
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2Fixture;
+struct b2FixtureProxy;
 
 // Delegate of b2World.
 class B2_API b2ContactManager
 {
 public:
-    b2ContactManager();
+    explicit b2ContactManager(b2AllocationTracker* tracker = nullptr);
+    ~b2ContactManager();
 
     // Broad-phase callback.
     void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -45,9 +49,31 @@ public:
 
     void Collide();
 
+    bool TestOverlap(b2Fixture* fixtureA, std::int32_t indexA, b2Fixture* fixtureB, std::int32_t indexB) const;
+    void AddChildPair(b2FixtureProxy* proxyA, std::int32_t indexA, b2FixtureProxy* proxyB, std::int32_t indexB);
+
+    b2AllocationTracker* m_tracker;
+
     b2BroadPhase m_broadPhase;
     b2Contact* m_contactList;
+
+    // Dense array of all contacts for linear iteration. Contacts are swap-removed
+    // on destruction and b2Contact::m_contactIndex tracks the slot.
+    b2Contact** m_contacts;
+    std::int32_t m_contactCapacity;
     std::int32_t m_contactCount;
+
+    // Child pairs that have a contact, see b2PairKey.
+    b2HashSet m_pairSet;
+
+    // Manifold reuse setting and the counters for the current step.
+    bool m_manifoldReuse;
+    std::int32_t m_manifoldReuseCount;
+    std::int32_t m_manifoldUpdateCount;
+
+    // Contacts updated in the current step whose shapes do not touch.
+    std::int32_t m_falsePairCount;
+
     b2ContactFilter* m_contactFilter;
     b2ContactListener* m_contactListener;
     b2BlockAllocator* m_allocator;
@@ -122,6 +122,19 @@ struct B2_API b2ShapeCastOutput
 /// @returns true if hit, false if there is no hit or an initial overlap
 B2_API bool b2ShapeCast(b2ShapeCastOutput* output, const b2ShapeCastInput* input);
 
+/// Output for b2SegmentDistance.
+struct B2_API b2SegmentDistanceResult
+{
+    b2Vec2 closest1;        ///< closest point on the first segment
+    b2Vec2 closest2;        ///< closest point on the second segment
+    float fraction1;        ///< barycentric coordinate of closest1, exactly 0 or 1 at a vertex
+    float fraction2;        ///< barycentric coordinate of closest2, exactly 0 or 1 at a vertex
+    float distanceSquared;
+};
+
+/// Compute the closest points between segments p1-q1 and p2-q2.
+B2_API b2SegmentDistanceResult b2SegmentDistance(const b2Vec2& p1, const b2Vec2& q1, const b2Vec2& p2, const b2Vec2& q2);
+
 //////////////////////////////////////////////////////////////////////////
 
 inline std::int32_t b2DistanceProxy::GetVertexCount() const
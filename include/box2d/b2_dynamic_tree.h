@@ -23,6 +23,7 @@
 #pragma once
 
 #include <box2d/b2_api.h>
+#include <box2d/b2_allocation_tracker.h>
 #include <box2d/b2_collision.h>
 #include <box2d/b2_growable_stack.h>
 
@@ -54,21 +55,29 @@ struct B2_API b2TreeNode
     std::int32_t height;
 
     bool moved;
+
+    /// Internal node: the AABB may be larger than its children, see b2DynamicTree::Refit.
+    bool enlarged;
+
+    /// Leaf: recent displacement per move, decaying over time. Sets the AABB margin.
+    float motion;
 };
 
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
-/// with an AABB. In the tree we expand the proxy AABB by b2_fatAABBFactor
+/// with an AABB. In the tree we expand the proxy AABB by a margin
 /// so that the proxy AABB is bigger than the client object. This allows the client
-/// object to move by small amounts without triggering a tree update.
+/// object to move by small amounts without triggering a tree update. The margin of
+/// each proxy adapts to its recent motion, see GetMargin.
 ///
 /// Nodes are pooled and relocatable, so we use node indices rather than pointers.
 class B2_API b2DynamicTree
 {
 public:
-    /// Constructing the tree initializes the node pool.
-    b2DynamicTree();
+    /// Constructing the tree initializes the node pool. The tracker receives the heap
+    /// allocations, see b2AllocationTracker.
+    explicit b2DynamicTree(b2AllocationTracker* tracker = nullptr);
 
     /// Destroy the tree, freeing the node pool.
     ~b2DynamicTree();
@@ -95,6 +104,14 @@ public:
     /// Get the fat AABB for a proxy.
     const b2AABB& GetFatAABB(std::int32_t proxyId) const;
 
+    /// Get the margin used to fatten the AABB of a proxy on its next move. This follows
+    /// the recent displacement of the proxy, between b2_aabbMinExtension and b2_aabbExtension.
+    float GetMargin(std::int32_t proxyId) const;
+
+    /// Get how far the fat AABB of a proxy may extend beyond the fat AABB of its next
+    /// move before it is considered huge and the proxy is re-inserted.
+    float GetHugeExtension(std::int32_t proxyId) const;
+
     /// Query an AABB for overlapping proxies. The callback class
     /// is called for each proxy that overlaps the supplied AABB.
     template <typename T>
@@ -127,20 +144,60 @@ public:
     /// Build an optimal tree. Very expensive. For testing.
     void RebuildBottomUp();
 
+    /// Rebuild the tree with a top-down surface area heuristic. Much faster than
+    /// RebuildBottomUp and proxy ids are kept.
+    void Rebuild();
+
+    /// Start adding many proxies at once. Until EndBulkInsert, CreateProxy only allocates
+    /// the leaves and the tree must not be queried or changed otherwise.
+    void BeginBulkInsert();
+
+    /// Build the tree over all proxies in one top-down pass. This is much faster than
+    /// inserting the proxies one by one and gives a better tree.
+    void EndBulkInsert();
+
+    /// Enable/disable refit mode. In refit mode MoveProxy updates a leaf in place and
+    /// enlarges its ancestors rather than re-inserting it. This is much cheaper when
+    /// most proxies move. Call Refit once all proxies have moved. Off by default.
+    void SetRefit(bool flag);
+    bool GetRefit() const { return m_refit; }
+
+    /// Shrink the enlarged internal nodes to fit their children in one bottom-up pass.
+    /// The structure does not change, so this also rebuilds the tree once its area
+    /// ratio has grown too much since the last rebuild.
+    void Refit();
+
+    /// Incrementally improve the tree with rotations that reduce the surface area
+    /// heuristic. Each call visits up to the given number of internal nodes, resuming
+    /// where the previous call stopped, so a small budget per step keeps a long-lived
+    /// tree from degrading under churn. In refit mode the enlarged nodes are refit first,
+    /// because rotations only keep the bounds of the nodes they touch tight.
+    /// @return the number of rotations performed.
+    std::int32_t Optimize(std::int32_t budget);
+
     /// Shift the world origin. Useful for large worlds.
     /// The shift formula is: position -= newOrigin
     /// @param newOrigin the new origin with respect to the old origin
     void ShiftOrigin(const b2Vec2& newOrigin);
 
+    /// Remove all proxies at once. The node pool keeps its capacity.
+    void Reset();
+
 private:
 
+    friend class b2QuantizedTree;
+
     std::int32_t AllocateNode();
     void FreeNode(std::int32_t node);
 
     void InsertLeaf(std::int32_t node);
     void RemoveLeaf(std::int32_t node);
 
-    std::int32_t Balance(std::int32_t index);
+    std::int32_t BuildSubtree(std::int32_t* leaves, std::int32_t count);
+    void RefitNode(std::int32_t index);
+
+    bool Rotate(std::int32_t index);
+    void SwapNodes(std::int32_t parent1, std::int32_t child1, std::int32_t parent2, std::int32_t child2);
 
     std::int32_t ComputeHeight() const;
     std::int32_t ComputeHeight(std::int32_t nodeId) const;
@@ -148,6 +205,8 @@ private:
     void ValidateStructure(std::int32_t index) const;
     void ValidateMetrics(std::int32_t index) const;
 
+    b2AllocationTracker* m_tracker;
+
     std::int32_t m_root;
 
     b2TreeNode* m_nodes;
@@ -157,6 +216,19 @@ private:
     std::int32_t m_freeList;
 
     std::int32_t m_insertionCount;
+
+    std::int32_t m_optimizeCursor;
+
+    bool m_refit;
+    std::int32_t m_refitCount;
+
+    // Leaves created since BeginBulkInsert are not linked into the tree.
+    bool m_bulkInsert;
+    float m_rebuildAreaRatio;
+
+    // Scratch space for Rebuild.
+    std::int32_t* m_leafBuffer;
+    std::int32_t m_leafBufferCapacity;
 };
 
 inline void* b2DynamicTree::GetUserData(std::int32_t proxyId) const
@@ -183,10 +255,21 @@ inline const b2AABB& b2DynamicTree::GetFatAABB(std::int32_t proxyId) const
     return m_nodes[proxyId].aabb;
 }
 
+inline float b2DynamicTree::GetMargin(std::int32_t proxyId) const
+{
+    assert(0 <= proxyId && proxyId < m_nodeCapacity);
+    return b2Clamp(m_nodes[proxyId].motion, b2_aabbMinExtension, b2_aabbExtension);
+}
+
+inline float b2DynamicTree::GetHugeExtension(std::int32_t proxyId) const
+{
+    return 4.0f * GetMargin(proxyId) + b2_aabbMultiplier * m_nodes[proxyId].motion;
+}
+
 template <typename T>
 inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 {
-    b2GrowableStack<std::int32_t, 256> stack;
+    b2GrowableStack<std::int32_t, 256> stack(m_tracker, b2_treeAllocation);
     stack.Push(m_root);
 
     while (stack.GetCount() > 0)
@@ -244,7 +327,7 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
         segmentAABB.upperBound = b2Max(p1, t);
     }
 
-    b2GrowableStack<std::int32_t, 256> stack;
+    b2GrowableStack<std::int32_t, 256> stack(m_tracker, b2_treeAllocation);
     stack.Push(m_root);
 
     while (stack.GetCount() > 0)
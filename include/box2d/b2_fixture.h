@@ -158,6 +158,10 @@ public:
     b2FixtureUserData& GetUserData();
     const b2FixtureUserData& GetUserData() const;
 
+    /// Get a handle to this fixture that can be checked after the fixture is destroyed.
+    /// @see b2World::GetFixture
+    b2FixtureId GetId() const;
+
     /// Test a point for containment in this fixture.
     /// @param p a point in world coordinates.
     bool TestPoint(const b2Vec2& p) const;
@@ -203,7 +207,8 @@ public:
 
     /// Get the fixture's AABB. This AABB may be enlarge and/or stale.
     /// If you need a more accurate AABB, compute it using the shape and
-    /// the body transform.
+    /// the body transform. If the shape shares a proxy, this returns the
+    /// AABB of the shared proxy for any child index.
     const b2AABB& GetAABB(std::int32_t childIndex) const;
 
     /// Dump this fixture to the log file.
@@ -227,7 +232,9 @@ protected:
     void CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf);
     void DestroyProxies(b2BroadPhase* broadPhase);
 
-    void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
+    // Move the proxies to cover the swept shape. Returns how far a point of the fixture
+    // may move from xf2 before the proxies need to be synchronized again.
+    float Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
 
     float m_density;
 
@@ -243,11 +250,20 @@ protected:
     b2FixtureProxy* m_proxies;
     std::int32_t m_proxyCount;
 
+    // The largest distance from the body origin to the shape bounds.
+    float m_extent;
+
+    // For a shape that shares a proxy: the body transform when the children were last
+    // paired.
+    b2Transform m_pairTransform;
+
     b2Filter m_filter;
 
     bool m_isSensor;
 
     b2FixtureUserData m_userData;
+
+    b2FixtureId m_id;
 };
 
 inline b2Shape::Type b2Fixture::GetType() const
@@ -275,6 +291,11 @@ inline const b2Filter& b2Fixture::GetFilterData() const
     return m_filter;
 }
 
+inline b2FixtureId b2Fixture::GetId() const
+{
+    return m_id;
+}
+
 inline b2FixtureUserData& b2Fixture::GetUserData()
 {
     return m_userData;
@@ -363,6 +384,7 @@ inline void b2Fixture::GetMassData(b2MassData* massData) const
 
 inline const b2AABB& b2Fixture::GetAABB(std::int32_t childIndex) const
 {
-    assert(0 <= childIndex && childIndex < m_proxyCount);
-    return m_proxies[childIndex].aabb;
+    std::int32_t proxyIndex = m_shape->SharesProxy() ? 0 : childIndex;
+    assert(0 <= proxyIndex && proxyIndex < m_proxyCount);
+    return m_proxies[proxyIndex].aabb;
 }
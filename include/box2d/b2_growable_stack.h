@@ -25,6 +25,7 @@
 #include <cstring>
 #include <array>
 
+#include <box2d/b2_allocation_tracker.h>
 #include <box2d/b2_settings.h>
 
 /// This is a growable LIFO stack with an initial capacity of N.
@@ -34,8 +35,11 @@ template <typename T, std::int32_t N>
 class b2GrowableStack
 {
 public:
-    b2GrowableStack()
+    /// The tracker receives the heap allocations, see b2AllocationTracker.
+    explicit b2GrowableStack(b2AllocationTracker* tracker = nullptr, b2AllocationCategory category = b2_treeAllocation)
     {
+        m_tracker = tracker;
+        m_category = category;
         m_stack = m_array.data();
         m_count = 0;
         m_capacity = N;
@@ -45,7 +49,7 @@ public:
     {
         if (m_stack != m_array.data())
         {
-            b2Free(m_stack);
+            b2TrackedFree(m_tracker, m_stack, m_capacity * sizeof(T), m_category);
             m_stack = nullptr;
         }
     }
@@ -56,11 +60,11 @@ public:
         {
             T* old = m_stack;
             m_capacity *= 2;
-            m_stack = (T*)b2Alloc(m_capacity * sizeof(T));
+            m_stack = (T*)b2TrackedAlloc(m_tracker, m_capacity * sizeof(T), m_category);
             memcpy(m_stack, old, m_count * sizeof(T));
             if (old != m_array.data())
             {
-                b2Free(old);
+                b2TrackedFree(m_tracker, old, m_count * sizeof(T), m_category);
             }
         }
 
@@ -80,9 +84,17 @@ public:
         return m_count;
     }
 
+    const T& Get(std::int32_t index) const
+    {
+        assert(0 <= index && index < m_count);
+        return m_stack[index];
+    }
+
 private:
     T* m_stack;
     std::array<T,N> m_array;
     std::int32_t m_count;
     std::int32_t m_capacity;
+    b2AllocationTracker* m_tracker;
+    b2AllocationCategory m_category;
 };
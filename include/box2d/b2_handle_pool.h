@@ -0,0 +1,121 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_allocation_tracker.h>
+#include <box2d/b2_settings.h>
+
+#include <cstdint>
+
+/// Dense array of slots that maps handles to objects. Each slot has a generation
+/// that is bumped when its object is freed, so a stale handle is detected with
+/// one array lookup. Free slots are reused in LIFO order. Generations start at
+/// one, so a zero generation is never valid.
+class B2_API b2HandlePool
+{
+public:
+    /// The tracker receives the heap allocations, see b2AllocationTracker.
+    explicit b2HandlePool(b2AllocationTracker* tracker = nullptr);
+    ~b2HandlePool();
+
+    b2HandlePool(const b2HandlePool&) = delete;
+    b2HandlePool& operator=(const b2HandlePool&) = delete;
+
+    /// Store an object in a free slot.
+    /// @return the slot index.
+    std::int32_t Allocate(void* object);
+
+    /// Free a slot. This invalidates all handles to it.
+    void Free(std::int32_t index);
+
+    /// Free all slots at once but keep the storage.
+    void Reset();
+
+    /// Get the object of a handle or nullptr if the handle is stale.
+    void* Get(std::int32_t index, std::uint32_t generation) const;
+
+    /// Point a slot at an object that was moved in memory.
+    void Relocate(std::int32_t index, void* object);
+
+    /// Get the current generation of a used slot.
+    std::uint32_t GetGeneration(std::int32_t index) const;
+
+    /// Get the number of used slots.
+    std::int32_t GetCount() const;
+
+    std::int32_t GetCapacity() const;
+
+private:
+
+    struct b2HandleSlot
+    {
+        void* object;
+        std::uint32_t generation;
+        std::int32_t next;
+    };
+
+    void Grow();
+
+    b2AllocationTracker* m_tracker;
+
+    b2HandleSlot* m_slots;
+    std::int32_t m_capacity;
+    std::int32_t m_count;
+    std::int32_t m_freeList;
+};
+
+inline void* b2HandlePool::Get(std::int32_t index, std::uint32_t generation) const
+{
+    if (index < 0 || index >= m_capacity)
+    {
+        return nullptr;
+    }
+
+    const b2HandleSlot& slot = m_slots[index];
+    return slot.generation == generation ? slot.object : nullptr;
+}
+
+inline void b2HandlePool::Relocate(std::int32_t index, void* object)
+{
+    assert(0 <= index && index < m_capacity);
+    assert(m_slots[index].object != nullptr && object != nullptr);
+    m_slots[index].object = object;
+}
+
+inline std::uint32_t b2HandlePool::GetGeneration(std::int32_t index) const
+{
+    assert(0 <= index && index < m_capacity);
+    assert(m_slots[index].object != nullptr);
+    return m_slots[index].generation;
+}
+
+inline std::int32_t b2HandlePool::GetCount() const
+{
+    return m_count;
+}
+
+inline std::int32_t b2HandlePool::GetCapacity() const
+{
+    return m_capacity;
+}
@@ -0,0 +1,97 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_allocation_tracker.h>
+#include <box2d/b2_settings.h>
+
+#include <cstdint>
+
+/// Identifies a shape child in the broad-phase by its proxy id and child index.
+/// Never zero.
+inline std::uint64_t b2ChildId(std::int32_t proxyId, std::int32_t childIndex)
+{
+    return ((std::uint64_t(static_cast<std::uint32_t>(proxyId)) + 1) << 32) | static_cast<std::uint32_t>(childIndex);
+}
+
+/// Key for an unordered pair of shape children, see b2ChildId.
+struct B2_API b2PairKey
+{
+    std::uint64_t id1;
+    std::uint64_t id2;
+};
+
+inline b2PairKey b2MakePairKey(std::uint64_t childIdA, std::uint64_t childIdB)
+{
+    return childIdA < childIdB ? b2PairKey{childIdA, childIdB} : b2PairKey{childIdB, childIdA};
+}
+
+inline bool operator == (const b2PairKey& a, const b2PairKey& b)
+{
+    return a.id1 == b.id1 && a.id2 == b.id2;
+}
+
+// Open addressing hash set of pair keys with linear probing. A zero id1
+// marks an empty slot. Removal uses backward shift deletion so
+// no tombstones are left behind.
+class B2_API b2HashSet
+{
+public:
+    /// The tracker receives the heap allocations, see b2AllocationTracker.
+    explicit b2HashSet(b2AllocationTracker* tracker = nullptr, b2AllocationCategory category = b2_contactAllocation);
+    ~b2HashSet();
+
+    b2HashSet(const b2HashSet&) = delete;
+    b2HashSet& operator=(const b2HashSet&) = delete;
+
+    /// Add a key. Returns true if the key was already present.
+    bool Add(const b2PairKey& key);
+
+    /// Remove a key. Returns true if the key was found.
+    bool Remove(const b2PairKey& key);
+
+    bool Contains(const b2PairKey& key) const;
+
+    /// Remove all keys but keep the storage.
+    void Clear();
+
+    std::int32_t GetCount() const;
+
+private:
+
+    std::int32_t FindSlot(const b2PairKey& key) const;
+    void Grow();
+
+    b2AllocationTracker* m_tracker;
+    b2AllocationCategory m_category;
+
+    b2PairKey* m_keys;
+    std::int32_t m_capacity;
+    std::int32_t m_count;
+};
+
+inline std::int32_t b2HashSet::GetCount() const
+{
+    return m_count;
+}
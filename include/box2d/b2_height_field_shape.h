@@ -0,0 +1,120 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_shape.h>
+
+class b2EdgeShape;
+
+/// A height field is a terrain surface sampled at regular intervals along the local
+/// x-axis, starting at the origin. Each column between two samples is a one-sided
+/// segment with the surface normal pointing up. Neighboring samples are used to create
+/// smooth collisions, like a chain.
+/// A height field uses a single broad-phase proxy. Contacts are created only for the
+/// columns that overlap other proxies.
+class B2_API b2HeightFieldShape : public b2Shape
+{
+public:
+    b2HeightFieldShape();
+
+    /// The destructor frees the heights using b2Free.
+    ~b2HeightFieldShape();
+
+    /// Clear all data.
+    void Clear();
+
+    /// Create the height field.
+    /// @param heights an array of heights, these are copied
+    /// @param count the number of samples, at least two
+    /// @param spacing the horizontal distance between samples
+    void Create(const float* heights, std::int32_t count, float spacing);
+
+    /// Implement b2Shape. Heights are cloned using b2Alloc.
+    b2Shape* Clone(b2BlockAllocator* allocator) const override;
+
+    /// The number of columns.
+    /// @see b2Shape::GetChildCount
+    std::int32_t GetChildCount() const override;
+
+    /// Get the edge of a column.
+    void GetChildEdge(b2EdgeShape* edge, std::int32_t index) const;
+
+    /// Get a sample point in local coordinates.
+    b2Vec2 GetVertex(std::int32_t index) const;
+
+    /// This always return false.
+    /// @see b2Shape::TestPoint
+    bool TestPoint(const b2Transform& transform, const b2Vec2& p) const override;
+
+    /// Implement b2Shape.
+    bool RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+                    const b2Transform& transform, std::int32_t childIndex) const override;
+
+    /// @see b2Shape::ComputeAABB
+    void ComputeAABB(b2AABB* aabb, const b2Transform& transform, std::int32_t childIndex) const override;
+
+    /// Height fields have zero mass.
+    /// @see b2Shape::ComputeMass
+    void ComputeMass(b2MassData* massData, float density) const override;
+
+    /// This always returns true.
+    /// @see b2Shape::SharesProxy
+    bool SharesProxy() const override;
+
+    /// @see b2Shape::ComputeProxyAABB
+    void ComputeProxyAABB(b2AABB* aabb, const b2Transform& transform) const override;
+
+    /// Reports the columns under the AABB without visiting the others.
+    /// @see b2Shape::QueryChildren
+    void QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& transform) const override;
+
+    /// The heights. Owned by this class.
+    float* m_heights;
+
+    /// The sample count.
+    std::int32_t m_count;
+
+    /// The horizontal distance between samples.
+    float m_spacing;
+
+    /// The height range, used for bounding boxes.
+    float m_minHeight, m_maxHeight;
+};
+
+inline b2HeightFieldShape::b2HeightFieldShape()
+{
+    m_type = e_heightField;
+    m_radius = b2_polygonRadius;
+    m_heights = nullptr;
+    m_count = 0;
+    m_spacing = 1.0f;
+    m_minHeight = 0.0f;
+    m_maxHeight = 0.0f;
+}
+
+inline b2Vec2 b2HeightFieldShape::GetVertex(std::int32_t index) const
+{
+    assert(0 <= index && index < m_count);
+    return b2Vec2(index * m_spacing, m_heights[index]);
+}
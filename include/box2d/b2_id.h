@@ -0,0 +1,80 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+
+#include <cstdint>
+
+/// A handle to a body. Unlike a pointer, a handle can be kept after the body is
+/// destroyed: b2World::GetBody then returns nullptr. A zero initialized
+/// handle never refers to a body.
+struct B2_API b2BodyId
+{
+    std::int32_t index;
+    std::uint32_t generation;
+};
+
+/// A handle to a fixture, see b2BodyId.
+struct B2_API b2FixtureId
+{
+    std::int32_t index;
+    std::uint32_t generation;
+};
+
+/// A handle to a joint, see b2BodyId.
+struct B2_API b2JointId
+{
+    std::int32_t index;
+    std::uint32_t generation;
+};
+
+inline bool operator == (const b2BodyId& a, const b2BodyId& b)
+{
+    return a.index == b.index && a.generation == b.generation;
+}
+
+inline bool operator == (const b2FixtureId& a, const b2FixtureId& b)
+{
+    return a.index == b.index && a.generation == b.generation;
+}
+
+inline bool operator == (const b2JointId& a, const b2JointId& b)
+{
+    return a.index == b.index && a.generation == b.generation;
+}
+
+inline bool operator != (const b2BodyId& a, const b2BodyId& b)
+{
+    return !(a == b);
+}
+
+inline bool operator != (const b2FixtureId& a, const b2FixtureId& b)
+{
+    return !(a == b);
+}
+
+inline bool operator != (const b2JointId& a, const b2JointId& b)
+{
+    return !(a == b);
+}
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <box2d/b2_api.h>
+#include <box2d/b2_id.h>
 #include <box2d/b2_math.h>
 
 class b2Body;
@@ -138,6 +139,10 @@ public:
     b2JointUserData& GetUserData();
     const b2JointUserData& GetUserData() const;
 
+    /// Get a handle to this joint that can be checked after the joint is destroyed.
+    /// @see b2World::GetJoint
+    b2JointId GetId() const;
+
     /// Short-cut function to determine if either body is enabled.
     bool IsEnabled() const;
 
@@ -173,6 +178,9 @@ protected:
     // This returns true if the position errors are within tolerance.
     virtual bool SolvePositionConstraints(const b2SolverData& data) = 0;
 
+    // Record a setter call if the world is recorded, see b2ReplayJointInput.
+    void RecordInput(std::int32_t input, float a, float b = 0.0f);
+
     b2JointType m_type;
     b2Joint* m_prev;
     b2Joint* m_next;
@@ -183,6 +191,8 @@ protected:
 
     std::int32_t m_index;
 
+    b2JointId m_id;
+
     bool m_islandFlag;
     bool m_collideConnected;
 
@@ -214,6 +224,11 @@ inline const b2Joint* b2Joint::GetNext() const
     return m_next;
 }
 
+inline b2JointId b2Joint::GetId() const
+{
+    return m_id;
+}
+
 inline b2JointUserData& b2Joint::GetUserData()
 {
     return m_userData;
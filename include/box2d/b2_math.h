@@ -604,6 +604,15 @@ inline b2Transform b2MulT(const b2Transform& A, const b2Transform& B)
     return C;
 }
 
+/// Bound how far a point within the given distance of the local origin moves when the
+/// transform changes from A to B.
+inline float b2MotionBound(const b2Transform& A, const b2Transform& B, float extent)
+{
+    b2Vec2 dp = B.p - A.p;
+    b2Vec2 dq(B.q.c - A.q.c, B.q.s - A.q.s);
+    return dp.Length() + dq.Length() * extent;
+}
+
 template <typename T>
 inline T b2Abs(T a)
 {
@@ -31,6 +31,8 @@
 /// the left of each edge.
 /// Polygons have a maximum number of vertices equal to b2_maxPolygonVertices.
 /// In most cases you should not need many vertices for a convex polygon.
+/// A radius larger than b2_polygonRadius rounds the polygon. The vertices then describe
+/// the core polygon and the surface is offset from it by the radius.
 class B2_API b2PolygonShape : public b2Shape
 {
 public:
@@ -61,6 +63,13 @@ public:
     /// @param angle the rotation of the box in local coordinates.
     void SetAsBox(float hx, float hy, const b2Vec2& center, float angle);
 
+    /// Build vertices to represent an axis-aligned box with rounded corners, centered on the
+    /// local origin. The rounded box extends by the radius beyond the core box.
+    /// @param hx the half-width of the core box.
+    /// @param hy the half-height of the core box.
+    /// @param radius the corner radius, this replaces m_radius.
+    void SetAsRoundedBox(float hx, float hy, float radius);
+
     /// @see b2Shape::TestPoint
     bool TestPoint(const b2Transform& transform, const b2Vec2& p) const override;
 
@@ -92,4 +101,8 @@ inline b2PolygonShape::b2PolygonShape()
     m_radius = b2_polygonRadius;
     m_count = 0;
     m_centroid.SetZero();
+
+    // Unused entries are read by the SIMD collision path.
+    m_vertices.fill(b2Vec2(0.0f, 0.0f));
+    m_normals.fill(b2Vec2(0.0f, 0.0f));
 }
@@ -89,6 +89,12 @@ public:
     b2Vec2 GetReactionForce(float inv_dt) const override;
     float GetReactionTorque(float inv_dt) const override;
 
+    /// The local anchor point relative to bodyA's origin.
+    const b2Vec2& GetLocalAnchorA() const { return m_localAnchorA; }
+
+    /// The local anchor point relative to bodyB's origin.
+    const b2Vec2& GetLocalAnchorB() const  { return m_localAnchorB; }
+
     /// Get the first ground anchor.
     b2Vec2 GetGroundAnchorA() const;
 
@@ -0,0 +1,276 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_collision.h>
+#include <box2d/b2_growable_stack.h>
+
+class b2DynamicTree;
+
+/// An internal node of b2QuantizedTree. The bounds of both children are stored
+/// relative to the bounds of this node using 16 bits per coordinate. The lower bound
+/// is the distance up from the lower bound of this node and the upper bound is the
+/// distance down from the upper bound of this node, in steps of 1/65535 of the extent.
+struct B2_API b2QuantizedNode
+{
+    std::uint16_t lowerX[2];
+    std::uint16_t lowerY[2];
+    std::uint16_t upperX[2];
+    std::uint16_t upperY[2];
+
+    /// Internal node index or ~leaf index.
+    std::int32_t children[2];
+};
+
+/// A compressed, read-only AABB tree for proxies that rarely change, such as static
+/// level geometry. The tree is built from a snapshot of a b2DynamicTree and keeps its
+/// structure. Leaves have no node and internal nodes use quantized child bounds, so
+/// the tree takes less than half the memory of the source tree, about 42 percent, and
+/// queries touch fewer cache lines. The decoded bounds always contain the source bounds.
+///
+/// Queries report leaf ids of this tree, see GetProxyId and GetUserData.
+class B2_API b2QuantizedTree
+{
+public:
+    b2QuantizedTree();
+    ~b2QuantizedTree();
+
+    /// Build from the current state of a dynamic tree. Rebuild the dynamic tree first
+    /// for the best quality. Any previous content is discarded.
+    void Build(const b2DynamicTree& tree);
+
+    /// Remove all leaves and free the memory.
+    void Clear();
+
+    /// Get the number of leaves.
+    std::int32_t GetLeafCount() const { return m_leafCount; }
+
+    /// Get the proxy id of a leaf in the source dynamic tree.
+    std::int32_t GetProxyId(std::int32_t leafId) const;
+
+    /// Get the user data of a leaf.
+    void* GetUserData(std::int32_t leafId) const;
+
+    /// Get the bounds of the whole tree.
+    const b2AABB& GetBounds() const { return m_bounds; }
+
+    /// Get the number of bytes used by the nodes and leaves.
+    std::int32_t GetByteCount() const;
+
+    /// Query an AABB for overlapping leaves. The callback class
+    /// is called for each leaf that overlaps the supplied AABB.
+    template <typename T>
+    void Query(T* callback, const b2AABB& aabb) const;
+
+    /// Ray-cast against the leaves in the tree, see b2DynamicTree::RayCast.
+    template <typename T>
+    void RayCast(T* callback, const b2RayCastInput& input) const;
+
+private:
+
+    struct Leaf
+    {
+        void* userData;
+        std::int32_t proxyId;
+    };
+
+    struct StackEntry
+    {
+        b2AABB aabb;
+        std::int32_t nodeId;
+    };
+
+    std::int32_t BuildNode(const b2DynamicTree& tree, std::int32_t sourceId, const b2AABB& aabb);
+    void Decode(const b2QuantizedNode* node, std::int32_t child, const b2AABB& aabb, b2AABB* childAABB) const;
+
+    b2QuantizedNode* m_nodes;
+    std::int32_t m_nodeCount;
+
+    Leaf* m_leaves;
+    std::int32_t m_leafCount;
+
+    b2AABB m_bounds;
+
+    // Internal node index or ~leaf index. Only valid if there are leaves.
+    std::int32_t m_root;
+};
+
+inline std::int32_t b2QuantizedTree::GetProxyId(std::int32_t leafId) const
+{
+    assert(0 <= leafId && leafId < m_leafCount);
+    return m_leaves[leafId].proxyId;
+}
+
+inline void* b2QuantizedTree::GetUserData(std::int32_t leafId) const
+{
+    assert(0 <= leafId && leafId < m_leafCount);
+    return m_leaves[leafId].userData;
+}
+
+inline void b2QuantizedTree::Decode(const b2QuantizedNode* node, std::int32_t child, const b2AABB& aabb, b2AABB* childAABB) const
+{
+    // The build uses this exact arithmetic, so the result contains the source bounds.
+    const float scale = 1.0f / 65535.0f;
+    b2Vec2 step = scale * (aabb.upperBound - aabb.lowerBound);
+    childAABB->lowerBound.x = aabb.lowerBound.x + float(node->lowerX[child]) * step.x;
+    childAABB->lowerBound.y = aabb.lowerBound.y + float(node->lowerY[child]) * step.y;
+    childAABB->upperBound.x = aabb.upperBound.x - float(node->upperX[child]) * step.x;
+    childAABB->upperBound.y = aabb.upperBound.y - float(node->upperY[child]) * step.y;
+}
+
+template <typename T>
+inline void b2QuantizedTree::Query(T* callback, const b2AABB& aabb) const
+{
+    if (m_leafCount == 0 || b2TestOverlap(m_bounds, aabb) == false)
+    {
+        return;
+    }
+
+    if (m_root < 0)
+    {
+        callback->QueryCallback(~m_root);
+        return;
+    }
+
+    b2GrowableStack<StackEntry, 64> stack;
+    stack.Push({m_bounds, m_root});
+
+    while (stack.GetCount() > 0)
+    {
+        StackEntry entry = stack.Pop();
+        const b2QuantizedNode* node = m_nodes + entry.nodeId;
+
+        for (std::int32_t i = 0; i < 2; ++i)
+        {
+            b2AABB childAABB;
+            Decode(node, i, entry.aabb, &childAABB);
+            if (b2TestOverlap(childAABB, aabb) == false)
+            {
+                continue;
+            }
+
+            std::int32_t childId = node->children[i];
+            if (childId < 0)
+            {
+                bool proceed = callback->QueryCallback(~childId);
+                if (proceed == false)
+                {
+                    return;
+                }
+            }
+            else
+            {
+                stack.Push({childAABB, childId});
+            }
+        }
+    }
+}
+
+template <typename T>
+inline void b2QuantizedTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+    if (m_leafCount == 0)
+    {
+        return;
+    }
+
+    b2Vec2 p1 = input.p1;
+    b2Vec2 p2 = input.p2;
+    b2Vec2 r = p2 - p1;
+    assert(r.LengthSquared() > 0.0f);
+    r.Normalize();
+
+    // v is perpendicular to the segment.
+    b2Vec2 v = b2Cross(1.0f, r);
+    b2Vec2 abs_v = b2Abs(v);
+
+    float maxFraction = input.maxFraction;
+
+    // Build a bounding box for the segment.
+    b2AABB segmentAABB;
+    {
+        b2Vec2 t = p1 + maxFraction * (p2 - p1);
+        segmentAABB.lowerBound = b2Min(p1, t);
+        segmentAABB.upperBound = b2Max(p1, t);
+    }
+
+    b2GrowableStack<StackEntry, 64> stack;
+    stack.Push({m_bounds, m_root});
+
+    while (stack.GetCount() > 0)
+    {
+        StackEntry entry = stack.Pop();
+
+        if (b2TestOverlap(entry.aabb, segmentAABB) == false)
+        {
+            continue;
+        }
+
+        // Separating axis for segment (Gino, p80).
+        // |dot(v, p1 - c)| > dot(|v|, h)
+        b2Vec2 c = entry.aabb.GetCenter();
+        b2Vec2 h = entry.aabb.GetExtents();
+        float separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+        if (separation > 0.0f)
+        {
+            continue;
+        }
+
+        if (entry.nodeId < 0)
+        {
+            b2RayCastInput subInput;
+            subInput.p1 = input.p1;
+            subInput.p2 = input.p2;
+            subInput.maxFraction = maxFraction;
+
+            float value = callback->RayCastCallback(subInput, ~entry.nodeId);
+
+            if (value == 0.0f)
+            {
+                // The client has terminated the ray cast.
+                return;
+            }
+
+            if (value > 0.0f)
+            {
+                // Update segment bounding box.
+                maxFraction = value;
+                b2Vec2 t = p1 + maxFraction * (p2 - p1);
+                segmentAABB.lowerBound = b2Min(p1, t);
+                segmentAABB.upperBound = b2Max(p1, t);
+            }
+        }
+        else
+        {
+            const b2QuantizedNode* node = m_nodes + entry.nodeId;
+            for (std::int32_t i = 0; i < 2; ++i)
+            {
+                StackEntry childEntry;
+                Decode(node, i, entry.aabb, &childEntry.aabb);
+                childEntry.nodeId = node->children[i];
+                stack.Push(childEntry);
+            }
+        }
+    }
+}
@@ -0,0 +1,324 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_math.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/// @file
+/// Replay recording, written by b2ReplayRecorder and played by b2ReplayPlayer.
+///
+/// A recording is a b2ReplayHeader followed by events. Each event is a
+/// b2ReplayEventType followed by its data, see the event types. Objects are referenced
+/// by their index in the recording: the bodies, fixtures and joints are numbered in the
+/// order they enter the recording, starting with the objects of the snapshot.
+/// Shapes, fixtures and joints use the records of b2_scene.h.
+///
+/// All values are four bytes in host byte order, so a recording can be read in place
+/// from a memory-mapped file.
+
+struct b2SceneReader;
+struct b2SceneWriter;
+class b2Body;
+class b2Fixture;
+class b2Joint;
+class b2World;
+
+/// "B2RP" in little endian.
+constexpr std::uint32_t b2_replayMagic = 0x50523242;
+
+/// Bumped on any change of the layout.
+constexpr std::uint32_t b2_replayVersion = 1;
+
+struct B2_API b2ReplayHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+};
+
+/// Event types of a recording. Bodies, fixtures and joints are std::int32_t indices
+/// and flags are std::uint32_t.
+enum b2ReplayEventType
+{
+    b2_replayScene = 1,                     ///< std::uint32_t byteCount, then a scene of that size
+    b2_replayStep,                          ///< float dt, std::int32_t velocityIterations, positionIterations
+    b2_replayClear,                         ///< no data
+    b2_replaySetGravity,                    ///< b2Vec2 gravity
+    b2_replayCreateBody,                    ///< b2SceneBody without fixtures
+    b2_replayDestroyBody,                   ///< body
+    b2_replayCreateFixture,                 ///< body, b2SceneFixture and the shape
+    b2_replayDestroyFixture,                ///< fixture
+    b2_replayCreateJoint,                   ///< b2SceneJoint and the joint definition
+    b2_replayDestroyJoint,                  ///< joint
+    b2_replaySetTransform,                  ///< body, b2Vec2 position, float angle
+    b2_replayBodyState,                     ///< body, b2ReplayBodyState
+    b2_replaySetType,                       ///< body, std::int32_t type
+    b2_replaySetEnabled,                    ///< body, flag
+    b2_replaySetFixedRotation,              ///< body, flag
+    b2_replayWorldSettings,                 ///< b2ReplayWorldSettings
+    b2_replaySetFilter,                     ///< fixture, std::uint32_t categoryBits, maskBits, std::int32_t groupIndex
+    b2_replaySetSensor,                     ///< fixture, flag
+    b2_replayJointInput                     ///< joint, b2ReplayJointInput, float a, b
+};
+
+/// Flags of b2ReplayWorldSettings.
+enum b2ReplayWorldFlags
+{
+    b2_replayAllowSleep = 0x0001,
+    b2_replayWarmStarting = 0x0002,
+    b2_replayContinuousPhysics = 0x0004,
+    b2_replaySubStepping = 0x0008,
+    b2_replayAutoClearForces = 0x0010,
+    b2_replayTreeRefit = 0x0020,
+    b2_replayManifoldReuse = 0x0040
+};
+
+/// The settings of a world. The recording holds them after the snapshot and again
+/// before the first event that follows a change.
+struct B2_API b2ReplayWorldSettings
+{
+    std::uint32_t flags;
+    std::int32_t treeOptimizationBudget;
+};
+
+/// The joint setters of a b2_replayJointInput event with their arguments a and b.
+enum b2ReplayJointInput
+{
+    b2_replayEnableLimit = 1,               ///< a is 1 or 0
+    b2_replaySetLimits,                     ///< lower, upper
+    b2_replayEnableMotor,                   ///< a is 1 or 0
+    b2_replaySetMotorSpeed,                 ///< speed
+    b2_replaySetMaxMotorForce,              ///< SetMaxMotorForce or SetMaxMotorTorque
+    b2_replaySetMaxForce,                   ///< force
+    b2_replaySetMaxTorque,                  ///< torque
+    b2_replaySetLength,                     ///< length
+    b2_replaySetMinLength,                  ///< length
+    b2_replaySetMaxLength,                  ///< length
+    b2_replaySetRatio,                      ///< ratio
+    b2_replaySetCorrectionFactor,           ///< factor
+    b2_replaySetLinearOffset,               ///< x, y
+    b2_replaySetAngularOffset,              ///< angle
+    b2_replaySetStiffness,                  ///< stiffness
+    b2_replaySetDamping                     ///< damping
+};
+
+/// The state of a body that the inline inputs between time steps change: velocities
+/// from the setters and impulses, accumulated forces, damping, gravity scale and the
+/// sleep and bullet flags. Instead of each input the recording holds this state before
+/// a time step for the bodies where it changed.
+struct B2_API b2ReplayBodyState
+{
+    b2Vec2 linearVelocity;
+    float angularVelocity;
+    b2Vec2 force;
+    float torque;
+    float linearDamping;
+    float angularDamping;
+    float gravityScale;
+    float sleepTime;
+
+    /// b2_sceneAwake, b2_sceneAllowSleep and b2_sceneBullet of b2SceneBodyFlags.
+    std::uint32_t flags;
+};
+
+/// Maps the handle index of a body, fixture or joint to its index in a recording.
+struct B2_API b2ReplayIndexMap
+{
+    std::int32_t* indices;
+    std::int32_t capacity;
+};
+
+/// Records a world for later playback with b2ReplayPlayer. The recording starts with a
+/// snapshot of the world and its settings, followed by the inputs: time steps, the
+/// creation and destruction of bodies, fixtures and joints, changes of the world
+/// settings, the body setters SetTransform, SetType, SetEnabled and SetFixedRotation,
+/// the fixture filters and sensor flags, the joint setters and the body states that the
+/// bodies have before each time step. Playing the recording into a new world repeats
+/// the simulation, so an instability or a slow step seen in the field can be reproduced
+/// and profiled.
+///
+/// Not recorded are:
+/// - changes made inside a time step, such as from a contact listener
+/// - mouse joints
+/// - b2Body::SetMassData
+/// - the friction, restitution, restitution threshold and density of a fixture after
+///   creation
+/// - the inline joint setters SetStiffness and SetDamping of the distance and weld joints
+/// - b2Contact::SetEnabled, SetFriction, SetRestitution and SetTangentSpeed, which only
+///   last for one time step when called outside of a contact listener
+class B2_API b2ReplayRecorder
+{
+public:
+    b2ReplayRecorder();
+    ~b2ReplayRecorder();
+
+    b2ReplayRecorder(const b2ReplayRecorder&) = delete;
+    b2ReplayRecorder& operator=(const b2ReplayRecorder&) = delete;
+
+    /// Start recording a world. This discards the previous recording and writes a
+    /// snapshot of the world. Start on a new world to record the full history, because a
+    /// snapshot does not keep contacts and joint impulses. A world has one recorder at
+    /// most.
+    /// @warning this should be called outside of a time step.
+    void Begin(b2World* world);
+
+    /// Stop recording. The recording is kept until the next Begin.
+    void End();
+
+    /// Is a world being recorded?
+    bool IsRecording() const;
+
+    /// Get the recording. It is four byte aligned.
+    const void* GetData() const;
+
+    /// Get the size of the recording in bytes.
+    std::size_t GetSize() const;
+
+    /// Get the number of recorded time steps.
+    std::int32_t GetStepCount() const;
+
+private:
+
+    friend class b2World;
+    friend class b2Body;
+    friend class b2Fixture;
+    friend class b2Joint;
+
+    void RecordScene(const void* scene, std::uint32_t byteCount);
+    void RecordStep(float dt, std::int32_t velocityIterations, std::int32_t positionIterations);
+    void EndStep();
+    void RecordClear();
+    void RecordGravity(const b2Vec2& gravity);
+    void RecordCreateBody(b2Body* body);
+    void RecordDestroyBody(b2Body* body);
+    void RecordCreateFixture(b2Fixture* fixture);
+    void RecordDestroyFixture(b2Fixture* fixture);
+    void RecordCreateJoint(b2Joint* joint);
+    void RecordDestroyJoint(b2Joint* joint);
+    void RecordInput(b2Body* body, std::int32_t type, const b2Vec2& a, float value, bool flag);
+    void RecordFixtureInput(b2Fixture* fixture, std::int32_t type);
+    void RecordJointInput(b2Joint* joint, std::int32_t input, float a, float b);
+
+    void AddScene(std::int32_t bodyCount, std::int32_t fixtureCount, std::int32_t jointCount);
+    void AddBody(b2Body* body, std::int32_t index);
+    void GetBodyState(const b2Body* body, b2ReplayBodyState* state) const;
+    void GetWorldSettings(b2ReplayWorldSettings* settings) const;
+    void AddFixture(b2Fixture* fixture, std::int32_t index);
+    void AddJoint(b2Joint* joint, std::int32_t index);
+
+    void BeginEvent(b2SceneWriter* writer, std::int32_t type);
+    void EndEvent(const b2SceneWriter* writer);
+
+    b2World* m_world;
+
+    char* m_data;
+    std::size_t m_capacity;
+    std::size_t m_size;
+
+    // Recording indices by handle index, -1 for objects that are not recorded.
+    b2ReplayIndexMap m_bodyMap;
+    b2ReplayIndexMap m_fixtureMap;
+    b2ReplayIndexMap m_jointMap;
+
+    // The world settings as last recorded.
+    b2ReplayWorldSettings m_settings;
+
+    // The body states after the last time step by recording index.
+    b2ReplayBodyState* m_bodyStates;
+    std::int32_t m_bodyStateCapacity;
+
+    std::int32_t m_bodyCount;
+    std::int32_t m_fixtureCount;
+    std::int32_t m_jointCount;
+    std::int32_t m_stepCount;
+};
+
+/// Plays a recording of b2ReplayRecorder into a world, one time step at a time. This
+/// needs no rendering, so it can run headless to profile the steps of a recording.
+class B2_API b2ReplayPlayer
+{
+public:
+    b2ReplayPlayer();
+    ~b2ReplayPlayer();
+
+    b2ReplayPlayer(const b2ReplayPlayer&) = delete;
+    b2ReplayPlayer& operator=(const b2ReplayPlayer&) = delete;
+
+    /// Start playing a recording into a world, usually a new one. The recording is read
+    /// in place, so it must stay valid while playing and be four byte aligned.
+    /// @return false if the data is not a recording
+    bool Begin(b2World* world, const void* data, std::size_t size);
+
+    /// Apply the recorded inputs up to the next time step and take the step.
+    /// @return false at the end of the recording or at bad data
+    bool Step();
+
+    /// Is the whole recording played? After Step returns false this tells the end of
+    /// the recording from bad data.
+    bool IsDone() const;
+
+    /// Get the duration of the last time step in milliseconds.
+    float GetStepTime() const;
+
+    /// Get the number of played time steps.
+    std::int32_t GetStepCount() const;
+
+private:
+
+    bool ReadEvent(b2SceneReader* reader, std::int32_t type);
+    bool ReadJointInput(b2SceneReader* reader);
+    void AddScene(std::int32_t bodyCount, std::int32_t fixtureCount, std::int32_t jointCount);
+    void AddBody(b2Body* body, std::int32_t index);
+    void AddFixture(b2Fixture* fixture, std::int32_t index);
+    void AddJoint(b2Joint* joint, std::int32_t index);
+    void RemoveBody(std::int32_t index);
+    b2Body* GetBody(std::int32_t index) const;
+
+    b2World* m_world;
+
+    const char* m_data;
+    std::size_t m_size;
+    std::size_t m_offset;
+
+    // Objects by recording index, nullptr once destroyed.
+    b2Body** m_bodies;
+    b2Fixture** m_fixtures;
+    b2Joint** m_joints;
+    std::int32_t m_bodyCapacity;
+    std::int32_t m_fixtureCapacity;
+    std::int32_t m_jointCapacity;
+    std::int32_t m_bodyCount;
+    std::int32_t m_fixtureCount;
+    std::int32_t m_jointCount;
+
+    // Recording indices by handle index, to forget the objects destroyed with a body.
+    b2ReplayIndexMap m_fixtureMap;
+    b2ReplayIndexMap m_jointMap;
+
+    std::int32_t m_stepCount;
+    float m_stepTime;
+    bool m_done;
+};
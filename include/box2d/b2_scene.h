@@ -0,0 +1,119 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_math.h>
+
+#include <cstdint>
+
+/// @file
+/// Binary scene format, written by b2World::SaveScene and read by b2World::LoadScene.
+///
+/// A scene is a b2SceneHeader followed by the bodies and then the joints. Each body is a
+/// b2SceneBody followed by its fixtures. Each fixture is a b2SceneFixture followed by
+/// the shape data:
+/// - circle: b2Vec2 p
+/// - edge: b2Vec2 vertex0, vertex1, vertex2, vertex3, std::uint32_t oneSided
+/// - polygon: std::int32_t count, b2Vec2 centroid, b2Vec2 vertices[count], b2Vec2 normals[count]
+/// - chain: std::int32_t count, std::uint32_t singleProxy, b2Vec2 prevVertex, nextVertex,
+///   b2Vec2 vertices[count]
+/// - capsule: b2Vec2 vertex1, vertex2
+/// - height field: std::int32_t count, float spacing, float heights[count]
+/// - compound: std::int32_t count, then per child a std::int32_t shape type, float radius
+///   and the circle, polygon or capsule data
+///
+/// Each joint is a b2SceneJoint followed by the fields of its joint definition in
+/// declaration order. Booleans are std::uint32_t and a gear joint stores the scene
+/// indices of its two joints, which come first. Bodies and joints are referenced by
+/// their index in the scene. Mouse joints are not saved.
+///
+/// All values are four bytes in host byte order, so a scene can be read in place from a
+/// memory-mapped file. A scene saved on a host with the other byte order fails the
+/// magic check.
+
+/// "B2SC" in little endian.
+constexpr std::uint32_t b2_sceneMagic = 0x43533242;
+
+/// Bumped on any change of the layout.
+constexpr std::uint32_t b2_sceneVersion = 1;
+
+struct B2_API b2SceneHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+
+    /// The size of the whole scene including this header.
+    std::uint32_t byteCount;
+
+    std::int32_t bodyCount;
+    std::int32_t fixtureCount;
+    std::int32_t jointCount;
+    b2Vec2 gravity;
+};
+
+/// Flags of b2SceneBody.
+enum b2SceneBodyFlags
+{
+    b2_sceneAwake = 0x0001,
+    b2_sceneAllowSleep = 0x0002,
+    b2_sceneFixedRotation = 0x0004,
+    b2_sceneBullet = 0x0008,
+    b2_sceneEnabled = 0x0010
+};
+
+struct B2_API b2SceneBody
+{
+    std::int32_t type;
+    b2Vec2 position;
+    float angle;
+    b2Vec2 linearVelocity;
+    float angularVelocity;
+    float linearDamping;
+    float angularDamping;
+    float gravityScale;
+    std::uint32_t flags;
+    std::int32_t fixtureCount;
+};
+
+struct B2_API b2SceneFixture
+{
+    float friction;
+    float restitution;
+    float restitutionThreshold;
+    float density;
+    std::uint16_t categoryBits;
+    std::uint16_t maskBits;
+    std::int16_t groupIndex;
+    std::uint16_t isSensor;
+    std::int32_t shapeType;
+    float radius;
+};
+
+struct B2_API b2SceneJoint
+{
+    std::int32_t type;
+    std::int32_t bodyA;
+    std::int32_t bodyB;
+    std::uint32_t collideConnected;
+};
@@ -41,6 +41,17 @@ struct B2_API b2MassData
     float I;
 };
 
+/// Callback class for b2Shape::QueryChildren.
+class B2_API b2ChildQueryCallback
+{
+public:
+    virtual ~b2ChildQueryCallback() {}
+
+    /// Called for each child that may overlap the query AABB.
+    /// @return false to terminate the query.
+    virtual bool ReportChild(std::int32_t childIndex) = 0;
+};
+
 /// A shape is used for collision detection. You can create a shape however you like.
 /// Shapes used for simulation in b2World are created automatically when a b2Fixture
 /// is created. Shapes may encapsulate a one or more child shapes.
@@ -54,7 +65,10 @@ public:
         e_edge = 1,
         e_polygon = 2,
         e_chain = 3,
-        e_typeCount = 4
+        e_heightField = 4,
+        e_capsule = 5,
+        e_compound = 6,
+        e_typeCount = 7
     };
 
     virtual ~b2Shape() {}
@@ -94,10 +108,32 @@ public:
     /// @param density the density in kilograms per meter squared.
     virtual void ComputeMass(b2MassData* massData, float density) const = 0;
 
+    /// Get the radius used by the contact solver for a child. This is m_radius except for
+    /// shapes whose children have their own radius.
+    /// @param childIndex the child shape
+    virtual float GetChildRadius(std::int32_t childIndex) const;
+
+    /// Does this shape use a single broad-phase proxy for all of its children? Contacts
+    /// are still created for each child that overlaps another proxy.
+    virtual bool SharesProxy() const { return false; }
+
+    /// Given a transform, compute the bounding box of all children. This is the AABB
+    /// of the broad-phase proxy when the shape shares a proxy.
+    /// @param aabb returns the axis aligned box.
+    /// @param xf the world transform of the shape.
+    virtual void ComputeProxyAABB(b2AABB* aabb, const b2Transform& xf) const;
+
+    /// Report the children whose AABB may overlap the given AABB. The default
+    /// implementation tests every child.
+    /// @param callback receives the child indices.
+    /// @param aabb the query box in world coordinates.
+    /// @param xf the world transform of the shape.
+    virtual void QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& xf) const;
+
     Type m_type;
 
-    /// Radius of a shape. For polygonal shapes this must be b2_polygonRadius. There is no support for
-    /// making rounded polygons.
+    /// Radius of a shape. For polygonal shapes this is b2_polygonRadius by default. A larger
+    /// radius makes a rounded polygon.
     float m_radius;
 };
 
@@ -105,3 +141,35 @@ inline b2Shape::Type b2Shape::GetType() const
 {
     return m_type;
 }
+
+inline float b2Shape::GetChildRadius(std::int32_t childIndex) const
+{
+    (void)childIndex;
+    return m_radius;
+}
+
+inline void b2Shape::ComputeProxyAABB(b2AABB* aabb, const b2Transform& xf) const
+{
+    ComputeAABB(aabb, xf, 0);
+    std::int32_t childCount = GetChildCount();
+    for (std::int32_t i = 1; i < childCount; ++i)
+    {
+        b2AABB childAABB;
+        ComputeAABB(&childAABB, xf, i);
+        aabb->Combine(childAABB);
+    }
+}
+
+inline void b2Shape::QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& xf) const
+{
+    std::int32_t childCount = GetChildCount();
+    for (std::int32_t i = 0; i < childCount; ++i)
+    {
+        b2AABB childAABB;
+        ComputeAABB(&childAABB, xf, i);
+        if (b2TestOverlap(childAABB, aabb) && callback->ReportChild(i) == false)
+        {
+            return;
+        }
+    }
+}
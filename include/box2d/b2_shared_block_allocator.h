@@ -0,0 +1,105 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_block_allocator.h>
+
+#include <array>
+#include <mutex>
+
+/// A thread-safe small object allocator. The blocks live in a shared pool guarded by
+/// a mutex. Each thread allocates and frees through its own b2BlockCache, which moves
+/// blocks from and to the pool in batches, so most calls do not lock. A block may be
+/// freed by another thread than the one that allocated it.
+class B2_API b2SharedBlockAllocator
+{
+public:
+    /// The tracker receives the heap allocations. It is only used under the lock.
+    explicit b2SharedBlockAllocator(b2AllocationTracker* tracker = nullptr);
+    ~b2SharedBlockAllocator();
+
+    b2SharedBlockAllocator(const b2SharedBlockAllocator&) = delete;
+    b2SharedBlockAllocator& operator=(const b2SharedBlockAllocator&) = delete;
+
+private:
+    friend class b2BlockCache;
+
+    // Take count blocks of a size class. Returns a list linked with b2Block::next.
+    b2Block* Acquire(std::int32_t index, std::int32_t count);
+
+    // Give back a list of blocks of a size class.
+    void Release(std::int32_t index, b2Block* list);
+
+    void* AllocateLarge(std::size_t size);
+    void FreeLarge(void* p, std::size_t size);
+
+    std::mutex m_mutex;
+    b2BlockAllocator m_allocator;
+};
+
+/// A per thread cache of a b2SharedBlockAllocator. Not thread-safe, use one per thread.
+/// Destroying the cache returns its blocks to the pool.
+class B2_API b2BlockCache
+{
+public:
+    explicit b2BlockCache(b2SharedBlockAllocator* allocator);
+    ~b2BlockCache();
+
+    b2BlockCache(const b2BlockCache&) = delete;
+    b2BlockCache& operator=(const b2BlockCache&) = delete;
+
+    /// Allocate memory. Objects larger than the largest block come from the pool under the lock.
+    template <typename T>
+    [[nodiscard]] T* Allocate(std::size_t count = 1);
+
+    /// Free memory from any cache of the same pool.
+    template <typename T>
+    void Free(T* ptr, std::size_t count = 1);
+
+    /// Return all cached blocks to the pool.
+    void Flush();
+
+private:
+    void* HandleAllocate(std::size_t size);
+    void HandleFree(void* p, std::size_t size);
+
+    b2SharedBlockAllocator* m_allocator;
+
+    std::array<b2Block*, b2_blockSizeCount> m_freeLists;
+    std::array<std::int32_t, b2_blockSizeCount> m_counts;
+};
+
+template <typename T>
+T* b2BlockCache::Allocate(std::size_t count)
+{
+    assert(count > 0);
+    return (T*)HandleAllocate(sizeof(T) * count);
+}
+
+template <typename T>
+void b2BlockCache::Free(T* ptr, std::size_t count)
+{
+    assert(count > 0);
+    HandleFree(static_cast<void*>(ptr), sizeof(T) * count);
+}
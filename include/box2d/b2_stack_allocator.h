@@ -23,10 +23,12 @@
 #pragma once
 
 #include <box2d/b2_api.h>
+#include <box2d/b2_allocation_tracker.h>
 #include <box2d/b2_settings.h>
 
 #include <array>
 
+/// Initial capacity of the stack arena.
 constexpr std::size_t b2_stackSize = 100 * 1024; // 100k
 constexpr std::size_t b2_maxStackEntries = 32;
 
@@ -40,10 +42,14 @@ struct B2_API b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// Allocations that do not fit in the arena fall back to b2Alloc. Once the
+// stack is empty again the arena grows to the high water mark, so a repeated
+// workload, such as a simulation step, stops hitting the heap.
 class B2_API b2StackAllocator
 {
 public:
-    b2StackAllocator();
+    /// The tracker receives the heap allocations, see b2AllocationTracker.
+    explicit b2StackAllocator(b2AllocationTracker* tracker = nullptr);
     ~b2StackAllocator();
 
     template<typename T> 
@@ -54,12 +60,24 @@ public:
 
     std::size_t GetMaxAllocation() const;
 
+    /// Grow the arena to hold at least the given number of bytes. The stack must be empty.
+    void Reserve(std::size_t size);
+
+    /// Get the size of the arena in bytes.
+    std::size_t GetCapacity() const { return m_capacity; }
+
+    /// Get the number of allocations that did not fit in the arena.
+    std::int32_t GetHeapAllocationCount() const { return m_heapAllocationCount; }
+
 private:
 
     void* HandleAllocate(std::size_t size);
     void HandleFree(void* p);
 
-    std::array<char, b2_stackSize> m_data;
+    b2AllocationTracker* m_tracker;
+
+    char* m_data;
+    std::size_t m_capacity;
     std::size_t m_index;
 
     std::size_t m_allocation;
@@ -67,6 +85,8 @@ private:
 
     std::array<b2StackEntry, b2_maxStackEntries> m_entries;
     std::size_t m_entryCount;
+
+    std::int32_t m_heapAllocationCount;
 };
 
 template<typename T>
@@ -22,9 +22,12 @@
 
 #pragma once
 
+#include <box2d/b2_allocation_tracker.h>
 #include <box2d/b2_api.h>
 #include <box2d/b2_block_allocator.h>
 #include <box2d/b2_contact_manager.h>
+#include <box2d/b2_handle_pool.h>
+#include <box2d/b2_id.h>
 #include <box2d/b2_math.h>
 #include <box2d/b2_stack_allocator.h>
 #include <box2d/b2_time_step.h>
@@ -32,12 +35,17 @@
 
 struct b2AABB;
 struct b2BodyDef;
+struct b2BodySim;
 struct b2Color;
 struct b2JointDef;
+struct b2SceneHeader;
+struct b2SceneReader;
 class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2ReplayRecorder;
+class b2Shape;
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -47,7 +55,9 @@ class B2_API b2World
 public:
     /// Construct a world object.
     /// @param gravity the world gravity vector.
-    b2World(const b2Vec2& gravity);
+    /// @param allocator optional allocator for the memory of the world. It must outlive
+    /// the world. By default the world uses b2Alloc.
+    b2World(const b2Vec2& gravity, b2Allocator* allocator = nullptr);
 
     /// Destruct the world. All physics entities are destroyed and all heap memory is released.
     ~b2World();
@@ -73,12 +83,15 @@ public:
     /// Create a rigid body given a definition. No reference to the definition
     /// is retained.
     /// @warning This function is locked during callbacks.
+    /// @note This may move the simulation state of existing bodies in memory, which is why
+    /// b2Body getters such as GetPosition return copies.
     b2Body* CreateBody(const b2BodyDef* def);
 
     /// Destroy a rigid body given a definition. No reference to the definition
     /// is retained. This function is locked during callbacks.
     /// @warning This automatically deletes all associated shapes and joints.
     /// @warning This function is locked during callbacks.
+    /// @note Like CreateBody, this may move the simulation state of other bodies.
     void DestroyBody(b2Body* body);
 
     /// Create a joint to constrain bodies together. No reference to the definition
@@ -90,6 +103,26 @@ public:
     /// @warning This function is locked during callbacks.
     void DestroyJoint(b2Joint* joint);
 
+    /// Get a body from its handle.
+    /// @return the body or nullptr if the body was destroyed.
+    b2Body* GetBody(b2BodyId id);
+    const b2Body* GetBody(b2BodyId id) const;
+
+    /// Get a fixture from its handle.
+    /// @return the fixture or nullptr if the fixture was destroyed.
+    b2Fixture* GetFixture(b2FixtureId id);
+    const b2Fixture* GetFixture(b2FixtureId id) const;
+
+    /// Get a joint from its handle.
+    /// @return the joint or nullptr if the joint was destroyed.
+    b2Joint* GetJoint(b2JointId id);
+    const b2Joint* GetJoint(b2JointId id) const;
+
+    /// Does the handle refer to a live object?
+    bool IsValid(b2BodyId id) const;
+    bool IsValid(b2FixtureId id) const;
+    bool IsValid(b2JointId id) const;
+
     /// Take a time step. This performs collision detection, integration,
     /// and constraint solution.
     /// @param timeStep the amount of time to simulate, this should not vary.
@@ -161,9 +194,76 @@ public:
     void SetSubStepping(bool flag) { m_subStepping = flag; }
     bool GetSubStepping() const { return m_subStepping; }
 
+    /// Enable/disable manifold reuse. When enabled, contacts skip the narrow-phase
+    /// while the relative transform of their bodies stays within b2_manifoldReuseLinearTolerance
+    /// and b2_manifoldReuseAngularTolerance of the last evaluation. Off by default.
+    /// @warning shapes must not be modified while they have contacts.
+    void SetManifoldReuse(bool flag) { m_contactManager.m_manifoldReuse = flag; }
+    bool GetManifoldReuse() const { return m_contactManager.m_manifoldReuse; }
+
+    /// Get the number of contact updates in the last time step that reused the
+    /// cached manifold.
+    std::int32_t GetManifoldReuseCount() const { return m_contactManager.m_manifoldReuseCount; }
+
+    /// Get the number of contact updates in the last time step that evaluated the
+    /// narrow-phase. Sensors are not counted.
+    std::int32_t GetManifoldUpdateCount() const { return m_contactManager.m_manifoldUpdateCount; }
+
+    /// Set the number of dynamic tree nodes visited per time step by the incremental
+    /// tree optimizer. Each visit may rotate the node to reduce the tree surface area,
+    /// which keeps queries fast in long running worlds. Zero disables the optimizer.
+    void SetTreeOptimizationBudget(std::int32_t budget) { m_treeOptimizationBudget = budget; }
+    std::int32_t GetTreeOptimizationBudget() const { return m_treeOptimizationBudget; }
+
+    /// Enable/disable dynamic tree refitting. When enabled, moving proxies update the
+    /// tree in place and the tree is refit once per time step, then rebuilt when its
+    /// quality drops. This is faster when most bodies move every step. Off by default.
+    void SetTreeRefit(bool flag) { m_contactManager.m_broadPhase.SetTreeRefit(flag); }
+    bool GetTreeRefit() const { return m_contactManager.m_broadPhase.GetTreeRefit(); }
+
+    /// Reserve memory for the per step stack allocations, in bytes. The stack grows
+    /// to the peak use of earlier time steps on its own, so this only avoids heap
+    /// allocations in the first time steps of a large world.
+    void ReserveStack(std::size_t size);
+
+    /// Make sure that count objects of the given size can be created without allocating
+    /// block memory, see b2BlockAllocator::Reserve. For example sizeof(b2Body).
+    void ReserveBlocks(std::size_t size, std::int32_t count);
+
+    /// Release block memory that holds no objects, see b2BlockAllocator::Trim.
+    /// @return the number of chunks released.
+    std::int32_t TrimBlocks();
+
+    /// Compute the use of the block memory, see b2BlockAllocator::GetStats.
+    void GetBlockStats(b2BlockAllocatorStats* stats) const { m_blockAllocator.GetStats(stats); }
+
+    /// Get the size of the per step stack in bytes.
+    std::size_t GetStackCapacity() const { return m_stackAllocator.GetCapacity(); }
+
+    /// Get the allocator of this world, nullptr if the world uses b2Alloc.
+    b2Allocator* GetAllocator() const { return m_allocationTracker.GetAllocator(); }
+
+    /// Get the heap use of this world by subsystem.
+    const b2AllocationStats& GetAllocationStats() const { return m_allocationTracker.GetStats(); }
+
+    /// Check that time steps do not use the heap once the given number of time steps
+    /// have run. Each heap allocation during a checked time step asserts and is counted
+    /// in b2AllocationStats::checkedAllocationCount. A negative count disables the check.
+    /// Off by default.
+    void SetStepAllocationCheck(std::int32_t warmUpStepCount) { m_allocationCheckStepCount = warmUpStepCount; }
+    std::int32_t GetStepAllocationCheck() const { return m_allocationCheckStepCount; }
+
     /// Get the number of broad-phase proxies.
     std::int32_t GetProxyCount() const;
 
+    /// Get the number of broad-phase proxies re-inserted into the dynamic tree in the
+    /// last time step.
+    std::int32_t GetProxyReinsertionCount() const { return m_contactManager.m_broadPhase.GetReinsertionCount(); }
+
+    /// Get the number of contacts updated in the last time step whose fat AABBs overlap
+    /// but whose shapes do not touch.
+    std::int32_t GetFalsePositivePairCount() const { return m_contactManager.m_falsePairCount; }
+
     /// Get the number of bodies.
     std::int32_t GetBodyCount() const;
 
@@ -203,6 +303,13 @@ public:
     /// @param newOrigin the new origin with respect to the old origin
     void ShiftOrigin(const b2Vec2& newOrigin);
 
+    /// Remove all bodies, joints and contacts at once. This is much faster than destroying
+    /// them one by one because the block allocator and the broad-phase are reset wholesale
+    /// and keep their capacity for the next scene. Gravity, settings and listeners are kept.
+    /// @warning the destruction listener is not called and all body, fixture and joint
+    /// pointers become invalid.
+    void Clear();
+
     /// Get the contact manager for testing.
     const b2ContactManager& GetContactManager() const;
 
@@ -213,26 +320,73 @@ public:
     /// @warning this should be called outside of a time step.
     void Dump();
 
+    /// Write the bodies, fixtures and joints to a binary scene, see b2_scene.h. Mouse
+    /// joints and user data are not saved.
+    /// @param buffer receives the scene, may be nullptr to only compute the size
+    /// @param capacity the size of the buffer in bytes
+    /// @return the size of the scene in bytes. Nothing is written if this exceeds the capacity.
+    /// @warning this should be called outside of a time step.
+    std::size_t SaveScene(void* buffer, std::size_t capacity);
+
+    /// Add the bodies, fixtures and joints of a binary scene to the world and take its
+    /// gravity, see b2_scene.h. The data is read in place, for example from a memory-mapped
+    /// file, and must be four byte aligned. The objects are created in bulk and the
+    /// broad-phase tree is built in one pass. The scene is validated first, so a bad scene
+    /// leaves the world unchanged. Validation rejects floats that are not finite and polygons
+    /// that b2PolygonShape::Set would not make.
+    /// @param bodies optional array of b2SceneHeader::bodyCount that receives the bodies in scene order
+    /// @param joints optional array of b2SceneHeader::jointCount that receives the joints in scene order
+    /// @return false if the data is not a valid scene
+    /// @warning this should be called outside of a time step.
+    bool LoadScene(const void* data, std::size_t size, b2Body** bodies = nullptr, b2Joint** joints = nullptr);
+
 private:
 
     friend class b2Body;
     friend class b2Fixture;
+    friend class b2Joint;
     friend class b2ContactManager;
     friend class b2Controller;
+    friend class b2ReplayPlayer;
+    friend class b2ReplayRecorder;
 
     void Solve(const b2TimeStep& step);
     void SolveTOI(const b2TimeStep& step);
 
-    void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
+    void DrawShape(const b2Shape* shape, const b2Transform& xf, const b2Color& color);
+
+    b2BodySim* AllocateBodySim(b2Body* body);
+    void FreeBodySim(b2Body* body);
+    void ReserveBodySims(std::int32_t capacity);
+
+    bool ReadScene(b2SceneReader* reader, const b2SceneHeader* header, bool create, b2Body** bodies, b2Joint** joints);
+    bool ReadSceneFixture(b2SceneReader* reader, b2Body* body, bool deferMass, b2Fixture** fixture);
+    bool ReadSceneJoint(b2SceneReader* reader, bool create, b2Body* const* bodies, std::int32_t bodyCount,
+        b2Joint* const* joints, const std::int32_t* jointTypes, std::int32_t jointCount, b2Joint** joint,
+        std::int32_t* type);
+
+    // Declared first, the other members allocate through it.
+    b2AllocationTracker m_allocationTracker;
 
     b2BlockAllocator m_blockAllocator;
     b2StackAllocator m_stackAllocator;
 
     b2ContactManager m_contactManager;
 
+    // Handle slots of the bodies, fixtures and joints.
+    b2HandlePool m_bodyHandles;
+    b2HandlePool m_fixtureHandles;
+    b2HandlePool m_jointHandles;
+
     b2Body* m_bodyList;
     b2Joint* m_jointList;
 
+    // Dense body simulation state. Index i is owned by m_bodySimOwners[i].
+    // There are m_bodyCount live entries.
+    b2BodySim* m_bodySims;
+    b2Body** m_bodySimOwners;
+    std::int32_t m_bodySimCapacity;
+
     std::int32_t m_bodyCount;
     std::int32_t m_jointCount;
 
@@ -242,6 +396,9 @@ private:
     b2DestructionListener* m_destructionListener;
     b2Draw* m_debugDraw;
 
+    // Receives the inputs while the world is recorded.
+    b2ReplayRecorder* m_recorder;
+
     // This is used to compute the time step ratio to
     // support a variable time step.
     float m_inv_dt0;
@@ -257,6 +414,11 @@ private:
 
     bool m_stepComplete;
 
+    std::int32_t m_treeOptimizationBudget;
+
+    std::int32_t m_stepCount;
+    std::int32_t m_allocationCheckStepCount;
+
     b2Profile m_profile;
 };
 
@@ -305,9 +467,49 @@ inline std::int32_t b2World::GetContactCount() const
     return m_contactManager.m_contactCount;
 }
 
-inline void b2World::SetGravity(const b2Vec2& gravity)
+inline b2Body* b2World::GetBody(b2BodyId id)
+{
+    return (b2Body*)m_bodyHandles.Get(id.index, id.generation);
+}
+
+inline const b2Body* b2World::GetBody(b2BodyId id) const
+{
+    return (const b2Body*)m_bodyHandles.Get(id.index, id.generation);
+}
+
+inline b2Fixture* b2World::GetFixture(b2FixtureId id)
+{
+    return (b2Fixture*)m_fixtureHandles.Get(id.index, id.generation);
+}
+
+inline const b2Fixture* b2World::GetFixture(b2FixtureId id) const
+{
+    return (const b2Fixture*)m_fixtureHandles.Get(id.index, id.generation);
+}
+
+inline b2Joint* b2World::GetJoint(b2JointId id)
+{
+    return (b2Joint*)m_jointHandles.Get(id.index, id.generation);
+}
+
+inline const b2Joint* b2World::GetJoint(b2JointId id) const
+{
+    return (const b2Joint*)m_jointHandles.Get(id.index, id.generation);
+}
+
+inline bool b2World::IsValid(b2BodyId id) const
+{
+    return m_bodyHandles.Get(id.index, id.generation) != nullptr;
+}
+
+inline bool b2World::IsValid(b2FixtureId id) const
+{
+    return m_fixtureHandles.Get(id.index, id.generation) != nullptr;
+}
+
+inline bool b2World::IsValid(b2JointId id) const
 {
-    m_gravity = gravity;
+    return m_jointHandles.Get(id.index, id.generation) != nullptr;
 }
 
 inline b2Vec2 b2World::GetGravity() const
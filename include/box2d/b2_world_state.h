@@ -0,0 +1,144 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_api.h>
+#include <box2d/b2_math.h>
+
+#include <cstddef>
+#include <cstdint>
+
+class b2Body;
+
+/// Quantization of a b2WorldState. The server and its clients must use the same.
+struct B2_API b2StateQuantization
+{
+    b2StateQuantization()
+    {
+        positionScale = 1024.0f;
+        velocityScale = 256.0f;
+    }
+
+    /// Position steps per meter.
+    float positionScale;
+
+    /// Velocity steps per meter per second and per radian per second.
+    float velocityScale;
+};
+
+/// Flags of b2QuantizedBody.
+enum b2QuantizedBodyFlags
+{
+    b2_quantizedPresent = 0x0001,   ///< the body exists
+    b2_quantizedAwake = 0x0002,     ///< the body is awake
+    b2_quantizedChanged = 0x0004    ///< the body changed in the last b2WorldState::DecodeDelta
+};
+
+/// Quantized state of a body in a b2WorldState. Angles use 16 bits for a full turn.
+struct B2_API b2QuantizedBody
+{
+    std::int32_t x, y;
+    std::int32_t angle;
+    std::int32_t vx, vy;
+    std::int32_t w;
+    std::uint32_t flags;
+};
+
+/// Quantized transforms, velocities and sleep states of an array of bodies, for network
+/// replication. The server captures a state every tick and encodes the delta from the
+/// last state a client has received. The delta holds only the bodies that changed, so
+/// sleeping bodies cost nothing. The client decodes the delta against the same baseline
+/// and applies the result to its own bodies.
+///
+/// Bodies are identified by their index in the array, so the server and the clients
+/// must use the same order, for example the scene order of b2World::LoadScene. The
+/// encoding is independent of the byte order.
+class B2_API b2WorldState
+{
+public:
+    explicit b2WorldState(const b2StateQuantization& quantization = b2StateQuantization());
+    ~b2WorldState();
+
+    b2WorldState(const b2WorldState&) = delete;
+    b2WorldState& operator=(const b2WorldState&) = delete;
+
+    /// Capture the state of the bodies. Null entries are captured as missing bodies.
+    void Capture(b2Body* const* bodies, std::int32_t count);
+
+    /// Copy another state, for example to keep it as the next baseline.
+    void Copy(const b2WorldState& other);
+
+    /// Encode the changes from a baseline.
+    /// @param baseline the state the receiver has, or nullptr to encode everything
+    /// @param buffer the destination, or nullptr to get the size
+    /// @return the size of the delta in bytes, which may be larger than the capacity
+    std::size_t EncodeDelta(const b2WorldState* baseline, void* buffer, std::size_t capacity) const;
+
+    /// Decode a delta against the baseline it was encoded from, or nullptr.
+    /// @param maxBodyCount the largest body count to accept, usually the size of the
+    /// body array given to Apply. This bounds the memory a bad packet can claim.
+    /// @return false for bad data, the state is then empty
+    bool DecodeDelta(const b2WorldState* baseline, const void* data, std::size_t size, std::int32_t maxBodyCount);
+
+    /// Apply the bodies that changed in the last DecodeDelta to a world in one pass. The
+    /// bodies are moved like b2Body::SetTransform, get their velocities and are put to
+    /// sleep or woken.
+    /// @warning this should be called outside of a time step.
+    void Apply(b2Body* const* bodies, std::int32_t count) const;
+
+    /// Get the number of bodies.
+    std::int32_t GetBodyCount() const;
+
+    /// Get the number of bodies that changed in the last DecodeDelta.
+    std::int32_t GetChangeCount() const;
+
+    /// Get the quantized state of a body.
+    const b2QuantizedBody& GetBody(std::int32_t index) const;
+
+private:
+
+    void Reserve(std::int32_t count);
+
+    b2StateQuantization m_quantization;
+
+    b2QuantizedBody* m_bodies;
+    std::int32_t m_count;
+    std::int32_t m_capacity;
+    std::int32_t m_changeCount;
+};
+
+inline std::int32_t b2WorldState::GetBodyCount() const
+{
+    return m_count;
+}
+
+inline std::int32_t b2WorldState::GetChangeCount() const
+{
+    return m_changeCount;
+}
+
+inline const b2QuantizedBody& b2WorldState::GetBody(std::int32_t index) const
+{
+    assert(0 <= index && index < m_count);
+    return m_bodies[index];
+}
@@ -28,19 +28,26 @@
 #include <box2d/b2_draw.h>
 #include <box2d/b2_timer.h>
 
+#include <box2d/b2_capsule_shape.h>
 #include <box2d/b2_chain_shape.h>
 #include <box2d/b2_circle_shape.h>
+#include <box2d/b2_compound_shape.h>
 #include <box2d/b2_edge_shape.h>
+#include <box2d/b2_height_field_shape.h>
 #include <box2d/b2_polygon_shape.h>
 
 #include <box2d/b2_broad_phase.h>
 #include <box2d/b2_dynamic_tree.h>
+#include <box2d/b2_quantized_tree.h>
 
 #include <box2d/b2_body.h>
 #include <box2d/b2_contact.h>
 #include <box2d/b2_fixture.h>
+#include <box2d/b2_replay.h>
+#include <box2d/b2_scene.h>
 #include <box2d/b2_time_step.h>
 #include <box2d/b2_world.h>
+#include <box2d/b2_world_state.h>
 #include <box2d/b2_world_callbacks.h>
 
 #include <box2d/b2_distance_joint.h>
@@ -23,23 +23,26 @@
 #include <box2d/b2_broad_phase.h>
 #include <cstring>
 
-b2BroadPhase::b2BroadPhase()
+b2BroadPhase::b2BroadPhase(b2AllocationTracker* tracker)
+    : m_tree(tracker)
 {
+    m_tracker = tracker;
     m_proxyCount = 0;
+    m_reinsertionCount = 0;
 
     m_pairCapacity = 16;
     m_pairCount = 0;
-    m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+    m_pairBuffer = (b2Pair*)b2TrackedAlloc(m_tracker, m_pairCapacity * sizeof(b2Pair), b2_broadPhaseAllocation);
 
     m_moveCapacity = 16;
     m_moveCount = 0;
-    m_moveBuffer = (std::int32_t*)b2Alloc(m_moveCapacity * sizeof(std::int32_t));
+    m_moveBuffer = (std::int32_t*)b2TrackedAlloc(m_tracker, m_moveCapacity * sizeof(std::int32_t), b2_broadPhaseAllocation);
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
-    b2Free(m_moveBuffer);
-    b2Free(m_pairBuffer);
+    b2TrackedFree(m_tracker, m_moveBuffer, m_moveCapacity * sizeof(std::int32_t), b2_broadPhaseAllocation);
+    b2TrackedFree(m_tracker, m_pairBuffer, m_pairCapacity * sizeof(b2Pair), b2_broadPhaseAllocation);
 }
 
 std::int32_t b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
@@ -57,13 +60,15 @@ void b2BroadPhase::DestroyProxy(std::int32_t proxyId)
     m_tree.DestroyProxy(proxyId);
 }
 
-void b2BroadPhase::MoveProxy(std::int32_t proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+bool b2BroadPhase::MoveProxy(std::int32_t proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
     bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
     if (buffer)
     {
+        ++m_reinsertionCount;
         BufferMove(proxyId);
     }
+    return buffer;
 }
 
 void b2BroadPhase::TouchProxy(std::int32_t proxyId)
@@ -76,10 +81,11 @@ void b2BroadPhase::BufferMove(std::int32_t proxyId)
     if (m_moveCount == m_moveCapacity)
     {
         std::int32_t* oldBuffer = m_moveBuffer;
+        std::int32_t oldCapacity = m_moveCapacity;
         m_moveCapacity *= 2;
-        m_moveBuffer = (std::int32_t*)b2Alloc(m_moveCapacity * sizeof(std::int32_t));
+        m_moveBuffer = (std::int32_t*)b2TrackedAlloc(m_tracker, m_moveCapacity * sizeof(std::int32_t), b2_broadPhaseAllocation);
         memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(std::int32_t));
-        b2Free(oldBuffer);
+        b2TrackedFree(m_tracker, oldBuffer, oldCapacity * sizeof(std::int32_t), b2_broadPhaseAllocation);
     }
 
     m_moveBuffer[m_moveCount] = proxyId;
@@ -117,10 +123,11 @@ bool b2BroadPhase::QueryCallback(std::int32_t proxyId)
     if (m_pairCount == m_pairCapacity)
     {
         b2Pair* oldBuffer = m_pairBuffer;
+        std::int32_t oldCapacity = m_pairCapacity;
         m_pairCapacity = m_pairCapacity + (m_pairCapacity >> 1);
-        m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+        m_pairBuffer = (b2Pair*)b2TrackedAlloc(m_tracker, m_pairCapacity * sizeof(b2Pair), b2_broadPhaseAllocation);
         memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
-        b2Free(oldBuffer);
+        b2TrackedFree(m_tracker, oldBuffer, oldCapacity * sizeof(b2Pair), b2_broadPhaseAllocation);
     }
 
     m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
@@ -129,3 +136,12 @@ bool b2BroadPhase::QueryCallback(std::int32_t proxyId)
 
     return true;
 }
+
+void b2BroadPhase::Reset()
+{
+    m_tree.Reset();
+    m_proxyCount = 0;
+    m_reinsertionCount = 0;
+    m_moveCount = 0;
+    m_pairCount = 0;
+}
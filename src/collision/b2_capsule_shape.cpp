@@ -0,0 +1,187 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_capsule_shape.h>
+#include <box2d/b2_block_allocator.h>
+
+#include <new>
+
+void b2CapsuleShape::Set(const b2Vec2& v1, const b2Vec2& v2, float radius)
+{
+    assert(b2DistanceSquared(v1, v2) > b2_linearSlop * b2_linearSlop);
+    assert(radius > 0.0f);
+    m_vertex1 = v1;
+    m_vertex2 = v2;
+    m_radius = radius;
+}
+
+b2Shape* b2CapsuleShape::Clone(b2BlockAllocator* allocator) const
+{
+    auto* mem = allocator->Allocate<b2CapsuleShape>();
+    b2CapsuleShape* clone = new (mem) b2CapsuleShape;
+    *clone = *this;
+    return clone;
+}
+
+std::int32_t b2CapsuleShape::GetChildCount() const
+{
+    return 1;
+}
+
+bool b2CapsuleShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
+{
+    b2Vec2 pLocal = b2MulT(xf, p);
+
+    // Find the closest point on the segment.
+    b2Vec2 e = m_vertex2 - m_vertex1;
+    float t = b2Clamp(b2Dot(pLocal - m_vertex1, e) / b2Dot(e, e), 0.0f, 1.0f);
+    b2Vec2 d = pLocal - (m_vertex1 + t * e);
+    return b2Dot(d, d) <= m_radius * m_radius;
+}
+
+// Ray cast against a circle in local coordinates. Returns the fraction of the entry point
+// or FLT_MAX on a miss.
+static float b2RayCastCircle(const b2Vec2& p1, const b2Vec2& d, const b2Vec2& center, float radius, float maxFraction)
+{
+    b2Vec2 s = p1 - center;
+    float b = b2Dot(s, s) - radius * radius;
+    float c = b2Dot(s, d);
+    float rr = b2Dot(d, d);
+    float sigma = c * c - rr * b;
+    if (sigma < 0.0f || rr < FLT_EPSILON)
+    {
+        return FLT_MAX;
+    }
+
+    float a = -(c + std::sqrt(sigma));
+    if (0.0f <= a && a <= maxFraction * rr)
+    {
+        return a / rr;
+    }
+
+    return FLT_MAX;
+}
+
+// The capsule is the union of two circles and a rectangle, so the ray enters it at the
+// first entry point of these. The rectangle ends lie inside the circles, so only the
+// rectangle sides need to be tested.
+bool b2CapsuleShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+    const b2Transform& xf, std::int32_t childIndex) const
+{
+    (void)childIndex;
+
+    // Put the ray into the capsule's frame of reference.
+    b2Vec2 p1 = b2MulT(xf.q, input.p1 - xf.p);
+    b2Vec2 p2 = b2MulT(xf.q, input.p2 - xf.p);
+    b2Vec2 d = p2 - p1;
+
+    b2Vec2 e = m_vertex2 - m_vertex1;
+    float length = e.Normalize();
+    b2Vec2 normal(e.y, -e.x);
+
+    float fraction = FLT_MAX;
+    b2Vec2 localNormal(0.0f, 0.0f);
+
+    // Test the side facing the ray origin.
+    float offset = b2Dot(normal, p1 - m_vertex1);
+    if (offset < 0.0f)
+    {
+        normal = -normal;
+        offset = -offset;
+    }
+
+    float denominator = b2Dot(normal, d);
+    if (offset > m_radius && denominator < 0.0f)
+    {
+        // dot(normal, p1 + t * d - v1) = radius
+        float t = (m_radius - offset) / denominator;
+        if (t <= input.maxFraction)
+        {
+            float s = b2Dot(p1 + t * d - m_vertex1, e);
+            if (0.0f <= s && s <= length)
+            {
+                fraction = t;
+                localNormal = normal;
+            }
+        }
+    }
+
+    const b2Vec2* vertices = &m_vertex1;
+    for (std::int32_t i = 0; i < 2; ++i)
+    {
+        float t = b2RayCastCircle(p1, d, vertices[i], m_radius, input.maxFraction);
+        if (t < fraction)
+        {
+            fraction = t;
+            localNormal = p1 + t * d - vertices[i];
+            localNormal.Normalize();
+        }
+    }
+
+    if (fraction == FLT_MAX)
+    {
+        return false;
+    }
+
+    output->fraction = fraction;
+    output->normal = b2Mul(xf.q, localNormal);
+    return true;
+}
+
+void b2CapsuleShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, std::int32_t childIndex) const
+{
+    (void)childIndex;
+
+    b2Vec2 v1 = b2Mul(xf, m_vertex1);
+    b2Vec2 v2 = b2Mul(xf, m_vertex2);
+
+    b2Vec2 lower = b2Min(v1, v2);
+    b2Vec2 upper = b2Max(v1, v2);
+
+    b2Vec2 r(m_radius, m_radius);
+    aabb->lowerBound = lower - r;
+    aabb->upperBound = upper + r;
+}
+
+void b2CapsuleShape::ComputeMass(b2MassData* massData, float density) const
+{
+    float rr = m_radius * m_radius;
+    float length = b2Distance(m_vertex1, m_vertex2);
+
+    // A rectangle and two half circles, which add up to a full circle.
+    float circleMass = density * b2_pi * rr;
+    float boxMass = density * 2.0f * m_radius * length;
+
+    massData->mass = circleMass + boxMass;
+    massData->center = 0.5f * (m_vertex1 + m_vertex2);
+
+    // The half circle centroids are offset by lc from the rectangle ends. Shifting each
+    // half circle from its centroid to the capsule center with the parallel axis theorem
+    // gives m * ((h + lc)^2 - lc^2) = m * (h^2 + 2 * h * lc).
+    float lc = 4.0f * m_radius / (3.0f * b2_pi);
+    float h = 0.5f * length;
+    float circleInertia = circleMass * (0.5f * rr + h * h + 2.0f * h * lc);
+    float boxInertia = boxMass * (4.0f * rr + length * length) / 12.0f;
+
+    // inertia about the local origin
+    massData->I = circleInertia + boxInertia + massData->mass * b2Dot(massData->center, massData->center);
+}
@@ -24,6 +24,7 @@
 #include <box2d/b2_edge_shape.h>
 
 #include <box2d/b2_block_allocator.h>
+#include <box2d/b2_growable_stack.h>
 
 #include <new>
 #include <cstring>
@@ -38,6 +39,69 @@ void b2ChainShape::Clear()
     b2Free(m_vertices);
     m_vertices = nullptr;
     m_count = 0;
+
+    b2Free(m_nodes);
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+}
+
+// Build the subtree over the segments [first, first + count) at the given node and return
+// the node that follows the subtree. Chain segments are connected, so splitting the segment
+// range in half keeps the children spatially coherent without sorting.
+static std::int32_t b2BuildChainTree(b2ChainTreeNode* nodes, std::int32_t nodeIndex, const b2AABB* segmentAABBs,
+    std::int32_t first, std::int32_t count)
+{
+    b2ChainTreeNode* node = nodes + nodeIndex;
+    if (count == 1)
+    {
+        node->aabb = segmentAABBs[first];
+        node->child2 = -1;
+        node->segment = first;
+        return nodeIndex + 1;
+    }
+
+    std::int32_t half = count / 2;
+    std::int32_t child1 = nodeIndex + 1;
+    std::int32_t child2 = b2BuildChainTree(nodes, child1, segmentAABBs, first, half);
+    std::int32_t next = b2BuildChainTree(nodes, child2, segmentAABBs, first + half, count - half);
+
+    node->aabb.Combine(nodes[child1].aabb, nodes[child2].aabb);
+    node->child2 = child2;
+    node->segment = -1;
+    return next;
+}
+
+void b2ChainShape::SetSingleProxy(bool flag)
+{
+    assert(m_count >= 2);
+
+    b2Free(m_nodes);
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+
+    if (flag == false)
+    {
+        return;
+    }
+
+    std::int32_t segmentCount = m_count - 1;
+    b2AABB* segmentAABBs = (b2AABB*)b2Alloc(segmentCount * sizeof(b2AABB));
+    b2Vec2 r(m_radius, m_radius);
+    for (std::int32_t i = 0; i < segmentCount; ++i)
+    {
+        b2Vec2 v1 = m_vertices[i];
+        b2Vec2 v2 = m_vertices[i + 1];
+        segmentAABBs[i].lowerBound = b2Min(v1, v2) - r;
+        segmentAABBs[i].upperBound = b2Max(v1, v2) + r;
+    }
+
+    m_nodeCount = 2 * segmentCount - 1;
+    m_nodes = (b2ChainTreeNode*)b2Alloc(m_nodeCount * sizeof(b2ChainTreeNode));
+    std::int32_t next = b2BuildChainTree(m_nodes, 0, segmentAABBs, 0, segmentCount);
+    assert(next == m_nodeCount);
+    (void)next;
+
+    b2Free(segmentAABBs);
 }
 
 void b2ChainShape::CreateLoop(const b2Vec2* vertices, std::int32_t count)
@@ -88,6 +152,12 @@ b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
     auto* mem = allocator->Allocate<b2ChainShape>();
     b2ChainShape* clone = new (mem) b2ChainShape;
     clone->CreateChain(m_vertices, m_count, m_prevVertex, m_nextVertex);
+    if (m_nodes != nullptr)
+    {
+        clone->m_nodeCount = m_nodeCount;
+        clone->m_nodes = (b2ChainTreeNode*)b2Alloc(m_nodeCount * sizeof(b2ChainTreeNode));
+        memcpy(clone->m_nodes, m_nodes, m_nodeCount * sizeof(b2ChainTreeNode));
+    }
     return clone;
 }
 
@@ -183,3 +253,74 @@ void b2ChainShape::ComputeMass(b2MassData* massData, float density) const
     massData->center.SetZero();
     massData->I = 0.0f;
 }
+
+bool b2ChainShape::SharesProxy() const
+{
+    return m_nodes != nullptr;
+}
+
+void b2ChainShape::ComputeProxyAABB(b2AABB* aabb, const b2Transform& xf) const
+{
+    if (m_nodes == nullptr)
+    {
+        b2Shape::ComputeProxyAABB(aabb, xf);
+        return;
+    }
+
+    // Transform the root bounds. The segment radius is already included.
+    const b2AABB& root = m_nodes[0].aabb;
+    b2Vec2 v1 = b2Mul(xf, root.lowerBound);
+    b2Vec2 v2 = b2Mul(xf, b2Vec2(root.upperBound.x, root.lowerBound.y));
+    b2Vec2 v3 = b2Mul(xf, root.upperBound);
+    b2Vec2 v4 = b2Mul(xf, b2Vec2(root.lowerBound.x, root.upperBound.y));
+
+    aabb->lowerBound = b2Min(b2Min(v1, v2), b2Min(v3, v4));
+    aabb->upperBound = b2Max(b2Max(v1, v2), b2Max(v3, v4));
+}
+
+void b2ChainShape::QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& xf) const
+{
+    if (m_nodes == nullptr)
+    {
+        b2Shape::QueryChildren(callback, aabb, xf);
+        return;
+    }
+
+    // Bound the query box in local coordinates.
+    b2Vec2 v1 = b2MulT(xf, aabb.lowerBound);
+    b2Vec2 v2 = b2MulT(xf, b2Vec2(aabb.upperBound.x, aabb.lowerBound.y));
+    b2Vec2 v3 = b2MulT(xf, aabb.upperBound);
+    b2Vec2 v4 = b2MulT(xf, b2Vec2(aabb.lowerBound.x, aabb.upperBound.y));
+
+    b2AABB box;
+    box.lowerBound = b2Min(b2Min(v1, v2), b2Min(v3, v4));
+    box.upperBound = b2Max(b2Max(v1, v2), b2Max(v3, v4));
+
+    b2GrowableStack<std::int32_t, 256> stack;
+    stack.Push(0);
+
+    while (stack.GetCount() > 0)
+    {
+        std::int32_t nodeIndex = stack.Pop();
+        const b2ChainTreeNode* node = m_nodes + nodeIndex;
+
+        if (b2TestOverlap(node->aabb, box) == false)
+        {
+            continue;
+        }
+
+        if (node->child2 == -1)
+        {
+            if (callback->ReportChild(node->segment) == false)
+            {
+                return;
+            }
+        }
+        else
+        {
+            // Push the second child first so segments are reported in chain order.
+            stack.Push(node->child2);
+            stack.Push(nodeIndex + 1);
+        }
+    }
+}
@@ -0,0 +1,488 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_collision.h>
+#include <box2d/b2_capsule_shape.h>
+#include <box2d/b2_circle_shape.h>
+#include <box2d/b2_distance.h>
+#include <box2d/b2_edge_shape.h>
+#include <box2d/b2_polygon_shape.h>
+
+// Collide two rounded segments. Segment A is in frame A and segment B is in frame B.
+static void b2CollideSegments(b2Manifold* manifold,
+    const b2Vec2& vA1, const b2Vec2& vA2, float radiusA, const b2Transform& xfA,
+    const b2Vec2& vB1, const b2Vec2& vB2, float radiusB, const b2Transform& xfB)
+{
+    manifold->pointCount = 0;
+
+    // Work in frame A
+    b2Transform xf = b2MulT(xfA, xfB);
+    b2Vec2 p1 = vA1;
+    b2Vec2 q1 = vA2;
+    b2Vec2 p2 = b2Mul(xf, vB1);
+    b2Vec2 q2 = b2Mul(xf, vB2);
+
+    b2SegmentDistanceResult result = b2SegmentDistance(p1, q1, p2, q2);
+
+    float radius = radiusA + radiusB;
+    if (result.distanceSquared > radius * radius)
+    {
+        return;
+    }
+
+    float distance = std::sqrt(result.distanceSquared);
+
+    b2Vec2 u1 = q1 - p1;
+    float length1 = u1.Normalize();
+    b2Vec2 u2 = q2 - p2;
+    u2.Normalize();
+
+    // The normal of segment A, pointing towards segment B.
+    b2Vec2 normalA(-u1.y, u1.x);
+    if (distance > FLT_EPSILON && b2Dot(normalA, result.closest2 - result.closest1) < 0.0f)
+    {
+        normalA = -normalA;
+    }
+
+    // Use the face of segment A if the closest point is inside it or the segments are
+    // nearly parallel. The second case gives two points for stacked capsules.
+    const float k_parallelTol = 0.005f;
+    bool interior1 = 0.0f < result.fraction1 && result.fraction1 < 1.0f;
+    if (interior1 || b2Abs(b2Cross(u1, u2)) < k_parallelTol)
+    {
+        // Clip segment B to the extent of segment A
+        float fp2 = b2Dot(p2 - p1, u1);
+        float fq2 = b2Dot(q2 - p1, u1);
+        bool outside = (fp2 <= 0.0f && fq2 <= 0.0f) || (fp2 >= length1 && fq2 >= length1);
+
+        if (outside == false)
+        {
+            b2Vec2 vLower, vUpper;
+            if (fp2 < 0.0f && fq2 - fp2 > FLT_EPSILON)
+            {
+                vLower = p2 + ((0.0f - fp2) / (fq2 - fp2)) * (q2 - p2);
+            }
+            else if (fq2 < 0.0f && fp2 - fq2 > FLT_EPSILON)
+            {
+                vLower = q2 + ((0.0f - fq2) / (fp2 - fq2)) * (p2 - q2);
+            }
+            else
+            {
+                vLower = fp2 < fq2 ? p2 : q2;
+            }
+
+            if (fp2 > length1 && fp2 - fq2 > FLT_EPSILON)
+            {
+                vUpper = p2 + ((fp2 - length1) / (fp2 - fq2)) * (q2 - p2);
+            }
+            else if (fq2 > length1 && fq2 - fp2 > FLT_EPSILON)
+            {
+                vUpper = q2 + ((fq2 - length1) / (fq2 - fp2)) * (p2 - q2);
+            }
+            else
+            {
+                vUpper = fp2 < fq2 ? q2 : p2;
+            }
+
+            b2Vec2 clipPoints[2] = { vLower, vUpper };
+            std::int32_t pointCount = 0;
+            for (std::int32_t i = 0; i < 2; ++i)
+            {
+                float separation = b2Dot(normalA, clipPoints[i] - p1);
+                if (separation <= radius)
+                {
+                    b2ManifoldPoint* cp = manifold->points + pointCount;
+                    cp->localPoint = b2MulT(xf, clipPoints[i]);
+                    cp->id.cf.indexA = 0;
+                    cp->id.cf.indexB = static_cast<std::uint8_t>(i);
+                    cp->id.cf.typeA = b2ContactFeature::e_face;
+                    cp->id.cf.typeB = b2ContactFeature::e_vertex;
+                    ++pointCount;
+                }
+            }
+
+            if (pointCount > 0)
+            {
+                manifold->type = b2Manifold::e_faceA;
+                manifold->localNormal = normalA;
+                manifold->localPoint = p1;
+                manifold->pointCount = pointCount;
+                return;
+            }
+        }
+    }
+
+    manifold->pointCount = 1;
+    manifold->points[0].id.key = 0;
+
+    bool interior2 = 0.0f < result.fraction2 && result.fraction2 < 1.0f;
+    if (interior2)
+    {
+        // The closest point on segment A is a vertex touching the face of segment B
+        b2Vec2 normalB(-u2.y, u2.x);
+        if (b2Dot(normalB, result.closest1 - result.closest2) < 0.0f)
+        {
+            normalB = -normalB;
+        }
+
+        manifold->type = b2Manifold::e_faceB;
+        manifold->localNormal = b2MulT(xf.q, normalB);
+        manifold->localPoint = b2MulT(xf, result.closest2);
+        manifold->points[0].localPoint = result.closest1;
+        return;
+    }
+
+    // Vertex-vertex
+    manifold->type = b2Manifold::e_circles;
+    manifold->localNormal.SetZero();
+    manifold->localPoint = result.closest1;
+    manifold->points[0].localPoint = b2MulT(xf, result.closest2);
+}
+
+void b2CollideCapsules(b2Manifold* manifold,
+    const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+    const b2CapsuleShape* capsuleB, const b2Transform& xfB)
+{
+    b2CollideSegments(manifold,
+        capsuleA->m_vertex1, capsuleA->m_vertex2, capsuleA->m_radius, xfA,
+        capsuleB->m_vertex1, capsuleB->m_vertex2, capsuleB->m_radius, xfB);
+}
+
+void b2CollideCapsuleAndCircle(b2Manifold* manifold,
+    const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+    const b2CircleShape* circleB, const b2Transform& xfB)
+{
+    manifold->pointCount = 0;
+
+    // Compute circle in frame of capsule
+    b2Vec2 c = b2MulT(xfA, b2Mul(xfB, circleB->m_p));
+
+    b2Vec2 v1 = capsuleA->m_vertex1;
+    b2Vec2 v2 = capsuleA->m_vertex2;
+    b2Vec2 e = v2 - v1;
+
+    // Closest point on the segment
+    float t = b2Dot(c - v1, e) / b2Dot(e, e);
+    t = b2Clamp(t, 0.0f, 1.0f);
+    b2Vec2 p = v1 + t * e;
+
+    float radius = capsuleA->m_radius + circleB->m_radius;
+    if (b2DistanceSquared(c, p) > radius * radius)
+    {
+        return;
+    }
+
+    manifold->pointCount = 1;
+    manifold->points[0].id.key = 0;
+    manifold->points[0].localPoint = circleB->m_p;
+
+    if (t == 0.0f || t == 1.0f)
+    {
+        // Region v1 or v2
+        manifold->type = b2Manifold::e_circles;
+        manifold->localNormal.SetZero();
+        manifold->localPoint = p;
+        manifold->points[0].id.cf.indexA = static_cast<std::uint8_t>(t == 0.0f ? 0 : 1);
+        manifold->points[0].id.cf.typeA = b2ContactFeature::e_vertex;
+        return;
+    }
+
+    // Region AB
+    b2Vec2 n(-e.y, e.x);
+    if (b2Dot(n, c - v1) < 0.0f)
+    {
+        n.Set(-n.x, -n.y);
+    }
+    n.Normalize();
+
+    manifold->type = b2Manifold::e_faceA;
+    manifold->localNormal = n;
+    manifold->localPoint = v1;
+    manifold->points[0].id.cf.typeA = b2ContactFeature::e_face;
+}
+
+// The capsule and polygon are rounded, so the separating axis test only gives a lower
+// bound on the distance when the closest features are two vertices. That case is
+// handled with a single point along the vertex-vertex direction.
+void b2CollideCapsuleAndPolygon(b2Manifold* manifold,
+    const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+    const b2PolygonShape* polygonB, const b2Transform& xfB)
+{
+    manifold->pointCount = 0;
+
+    // Work in frame B
+    b2Transform xf = b2MulT(xfB, xfA);
+    b2Vec2 capsule[2] = { b2Mul(xf, capsuleA->m_vertex1), b2Mul(xf, capsuleA->m_vertex2) };
+
+    std::int32_t count = polygonB->m_count;
+    const b2Vec2* vertices = polygonB->m_vertices.data();
+    const b2Vec2* normals = polygonB->m_normals.data();
+
+    float radius = capsuleA->m_radius + polygonB->m_radius;
+
+    // Find the polygon face with the largest separation from the capsule segment.
+    std::int32_t edgeB = 0;
+    float separationB = -FLT_MAX;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        float s1 = b2Dot(normals[i], capsule[0] - vertices[i]);
+        float s2 = b2Dot(normals[i], capsule[1] - vertices[i]);
+        float s = b2Min(s1, s2);
+        if (s > separationB)
+        {
+            separationB = s;
+            edgeB = i;
+        }
+    }
+
+    if (separationB > radius)
+    {
+        return;
+    }
+
+    // Find the capsule side with the largest separation from the polygon.
+    b2Vec2 axis = capsule[1] - capsule[0];
+    axis.Normalize();
+    b2Vec2 normalA(axis.y, -axis.x);
+    float separationA = -FLT_MAX;
+    {
+        float sPos = FLT_MAX;
+        float sNeg = FLT_MAX;
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            float s = b2Dot(normalA, vertices[i] - capsule[0]);
+            sPos = b2Min(sPos, s);
+            sNeg = b2Min(sNeg, -s);
+        }
+
+        if (sPos >= sNeg)
+        {
+            separationA = sPos;
+        }
+        else
+        {
+            separationA = sNeg;
+            normalA = -normalA;
+        }
+    }
+
+    if (separationA > radius)
+    {
+        return;
+    }
+
+    // Prefer the polygon face, like b2CollidePolygons.
+    const float k_tol = 0.1f * b2_linearSlop;
+    bool flip = separationA > separationB + k_tol;
+
+    // The reference segment and the incident segment, both in frame B.
+    b2Vec2 r1, r2, refNormal;
+    std::array<b2ClipVertex, 2> incidentEdge;
+    std::int32_t iv1, iv2;
+    if (flip)
+    {
+        // The capsule side is the reference face. Find the polygon edge most anti-parallel to it.
+        std::int32_t edge = 0;
+        float minDot = FLT_MAX;
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            float dot = b2Dot(normalA, normals[i]);
+            if (dot < minDot)
+            {
+                minDot = dot;
+                edge = i;
+            }
+        }
+
+        iv1 = 0;
+        iv2 = 1;
+        r1 = capsule[0];
+        r2 = capsule[1];
+        refNormal = normalA;
+
+        std::int32_t i1 = edge;
+        std::int32_t i2 = i1 + 1 < count ? i1 + 1 : 0;
+
+        incidentEdge[0].v = vertices[i1];
+        incidentEdge[0].id.cf.indexA = 0;
+        incidentEdge[0].id.cf.indexB = static_cast<std::uint8_t>(i1);
+        incidentEdge[0].id.cf.typeA = b2ContactFeature::e_face;
+        incidentEdge[0].id.cf.typeB = b2ContactFeature::e_vertex;
+
+        incidentEdge[1].v = vertices[i2];
+        incidentEdge[1].id.cf.indexA = 0;
+        incidentEdge[1].id.cf.indexB = static_cast<std::uint8_t>(i2);
+        incidentEdge[1].id.cf.typeA = b2ContactFeature::e_face;
+        incidentEdge[1].id.cf.typeB = b2ContactFeature::e_vertex;
+    }
+    else
+    {
+        // The polygon face is the reference face and the capsule segment is incident.
+        iv1 = edgeB;
+        iv2 = edgeB + 1 < count ? edgeB + 1 : 0;
+        r1 = vertices[iv1];
+        r2 = vertices[iv2];
+        refNormal = normals[edgeB];
+
+        incidentEdge[0].v = capsule[0];
+        incidentEdge[0].id.cf.indexA = static_cast<std::uint8_t>(edgeB);
+        incidentEdge[0].id.cf.indexB = 0;
+        incidentEdge[0].id.cf.typeA = b2ContactFeature::e_face;
+        incidentEdge[0].id.cf.typeB = b2ContactFeature::e_vertex;
+
+        incidentEdge[1].v = capsule[1];
+        incidentEdge[1].id.cf.indexA = static_cast<std::uint8_t>(edgeB);
+        incidentEdge[1].id.cf.indexB = 1;
+        incidentEdge[1].id.cf.typeA = b2ContactFeature::e_face;
+        incidentEdge[1].id.cf.typeB = b2ContactFeature::e_vertex;
+    }
+
+    // Handle the rounded corners. If the cores are separated and the closest features
+    // are two vertices, the contact normal is the direction between those vertices.
+    b2SegmentDistanceResult result = b2SegmentDistance(r1, r2, incidentEdge[0].v, incidentEdge[1].v);
+    bool vertex1 = result.fraction1 == 0.0f || result.fraction1 == 1.0f;
+    bool vertex2 = result.fraction2 == 0.0f || result.fraction2 == 1.0f;
+    const float k_linearTol = 0.1f * b2_linearSlop;
+    if (vertex1 && vertex2 && result.distanceSquared > k_linearTol * k_linearTol)
+    {
+        if (result.distanceSquared > radius * radius)
+        {
+            return;
+        }
+
+        std::int32_t referenceVertex = result.fraction1 == 0.0f ? iv1 : iv2;
+        std::int32_t incidentVertex = result.fraction2 == 0.0f ? incidentEdge[0].id.cf.indexB : incidentEdge[1].id.cf.indexB;
+
+        b2Vec2 capsulePoint = flip ? result.closest1 : result.closest2;
+        b2Vec2 polygonPoint = flip ? result.closest2 : result.closest1;
+
+        manifold->type = b2Manifold::e_circles;
+        manifold->localNormal.SetZero();
+        manifold->localPoint = b2MulT(xf, capsulePoint);
+        manifold->pointCount = 1;
+
+        b2ManifoldPoint* cp = manifold->points + 0;
+        cp->localPoint = polygonPoint;
+        cp->id.cf.indexA = static_cast<std::uint8_t>(flip ? referenceVertex : incidentVertex);
+        cp->id.cf.indexB = static_cast<std::uint8_t>(flip ? incidentVertex : referenceVertex);
+        cp->id.cf.typeA = b2ContactFeature::e_vertex;
+        cp->id.cf.typeB = b2ContactFeature::e_vertex;
+        return;
+    }
+
+    // Clip the incident segment against the side planes of the reference segment.
+    b2Vec2 tangent = r2 - r1;
+    tangent.Normalize();
+
+    b2Vec2 sideNormal1 = -tangent;
+    float sideOffset1 = b2Dot(sideNormal1, r1);
+    b2Vec2 sideNormal2 = tangent;
+    float sideOffset2 = b2Dot(sideNormal2, r2);
+
+    std::array<b2ClipVertex, 2> clipPoints1;
+    std::array<b2ClipVertex, 2> clipPoints2;
+    std::int32_t np;
+
+    np = b2ClipSegmentToLine(clipPoints1, incidentEdge, sideNormal1, sideOffset1, iv1);
+    if (np < 2)
+    {
+        return;
+    }
+
+    np = b2ClipSegmentToLine(clipPoints2, clipPoints1, sideNormal2, sideOffset2, iv2);
+    if (np < 2)
+    {
+        return;
+    }
+
+    if (flip)
+    {
+        manifold->type = b2Manifold::e_faceA;
+        manifold->localNormal = b2MulT(xf.q, refNormal);
+        manifold->localPoint = capsuleA->m_vertex1;
+    }
+    else
+    {
+        manifold->type = b2Manifold::e_faceB;
+        manifold->localNormal = refNormal;
+        manifold->localPoint = r1;
+    }
+
+    std::int32_t pointCount = 0;
+    for (std::int32_t i = 0; i < b2_maxManifoldPoints; ++i)
+    {
+        float separation = b2Dot(refNormal, clipPoints2[i].v - r1);
+        if (separation <= radius)
+        {
+            b2ManifoldPoint* cp = manifold->points + pointCount;
+
+            if (flip)
+            {
+                cp->localPoint = clipPoints2[i].v;
+                cp->id = clipPoints2[i].id;
+            }
+            else
+            {
+                // Swap features
+                cp->localPoint = b2MulT(xf, clipPoints2[i].v);
+                cp->id.cf.indexA = clipPoints2[i].id.cf.indexB;
+                cp->id.cf.indexB = clipPoints2[i].id.cf.indexA;
+                cp->id.cf.typeA = clipPoints2[i].id.cf.typeB;
+                cp->id.cf.typeB = clipPoints2[i].id.cf.typeA;
+            }
+
+            ++pointCount;
+        }
+    }
+
+    manifold->pointCount = pointCount;
+}
+
+void b2CollideEdgeAndCapsule(b2Manifold* manifold,
+    const b2EdgeShape* edgeA, const b2Transform& xfA,
+    const b2CapsuleShape* capsuleB, const b2Transform& xfB)
+{
+    if (edgeA->m_oneSided == false)
+    {
+        b2CollideSegments(manifold,
+            edgeA->m_vertex1, edgeA->m_vertex2, edgeA->m_radius, xfA,
+            capsuleB->m_vertex1, capsuleB->m_vertex2, capsuleB->m_radius, xfB);
+        return;
+    }
+
+    // One-sided edges need smooth collision, so treat the capsule as a rounded polygon
+    // with two vertices.
+    b2PolygonShape polygonB;
+    polygonB.m_count = 2;
+    polygonB.m_radius = capsuleB->m_radius;
+    polygonB.m_vertices[0] = capsuleB->m_vertex1;
+    polygonB.m_vertices[1] = capsuleB->m_vertex2;
+    polygonB.m_centroid = 0.5f * (capsuleB->m_vertex1 + capsuleB->m_vertex2);
+
+    b2Vec2 e = capsuleB->m_vertex2 - capsuleB->m_vertex1;
+    b2Vec2 n(e.y, -e.x);
+    n.Normalize();
+    polygonB.m_normals[0] = n;
+    polygonB.m_normals[1] = -n;
+
+    b2CollideEdgeAndPolygon(manifold, edgeA, xfA, &polygonB, xfB);
+}
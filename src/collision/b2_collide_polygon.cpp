@@ -21,8 +21,89 @@
 // SOFTWARE.
 
 #include <box2d/b2_collision.h>
+#include <box2d/b2_distance.h>
 #include <box2d/b2_polygon_shape.h>
 
+// SSE2 is part of the x86-64 baseline. Define B2_NO_SIMD to use the scalar version.
+// The SIMD version reads polygon vertices in blocks of four.
+#if !defined(B2_NO_SIMD) && (b2_maxPolygonVertices % 4) == 0 && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define B2_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(B2_SIMD_SSE2)
+
+// Find the max separation between poly1 and poly2 using edge normals from poly1.
+// The normals of poly1 are processed four at a time, transposed to SoA form on load.
+// Lanes past the vertex count read unused entries and are ignored. Each lane performs
+// the same float operations as the scalar version so the results are identical.
+static float b2FindMaxSeparation(std::int32_t* edgeIndex,
+                                 const b2PolygonShape* poly1, const b2Transform& xf1,
+                                 const b2PolygonShape* poly2, const b2Transform& xf2)
+{
+    std::int32_t count1 = poly1->m_count;
+    std::int32_t count2 = poly2->m_count;
+    const b2Vec2* n1s = poly1->m_normals.data();
+    const b2Vec2* v1s = poly1->m_vertices.data();
+    const b2Vec2* v2s = poly2->m_vertices.data();
+    b2Transform xf = b2MulT(xf2, xf1);
+
+    __m128 c = _mm_set1_ps(xf.q.c);
+    __m128 s = _mm_set1_ps(xf.q.s);
+    __m128 px = _mm_set1_ps(xf.p.x);
+    __m128 py = _mm_set1_ps(xf.p.y);
+
+    alignas(16) float separations[b2_maxPolygonVertices];
+    for (std::int32_t i = 0; i < count1; i += 4)
+    {
+        // Get poly1 normals and vertices in frame2.
+        __m128 a0 = _mm_loadu_ps(&n1s[i].x);
+        __m128 a1 = _mm_loadu_ps(&n1s[i + 2].x);
+        __m128 x = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(c, x), _mm_mul_ps(s, y));
+        __m128 ny = _mm_add_ps(_mm_mul_ps(s, x), _mm_mul_ps(c, y));
+
+        a0 = _mm_loadu_ps(&v1s[i].x);
+        a1 = _mm_loadu_ps(&v1s[i + 2].x);
+        x = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0));
+        y = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 vx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c, x), _mm_mul_ps(s, y)), px);
+        __m128 vy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s, x), _mm_mul_ps(c, y)), py);
+
+        // Find deepest point for each normal.
+        __m128 si = _mm_set1_ps(FLT_MAX);
+        for (std::int32_t j = 0; j < count2; ++j)
+        {
+            __m128 dx = _mm_sub_ps(_mm_set1_ps(v2s[j].x), vx);
+            __m128 dy = _mm_sub_ps(_mm_set1_ps(v2s[j].y), vy);
+            __m128 sij = _mm_add_ps(_mm_mul_ps(nx, dx), _mm_mul_ps(ny, dy));
+
+            // Same as (sij < si ? sij : si)
+            si = _mm_min_ps(sij, si);
+        }
+
+        _mm_store_ps(separations + i, si);
+    }
+
+    std::int32_t bestIndex = 0;
+    float maxSeparation = -FLT_MAX;
+    for (std::int32_t i = 0; i < count1; ++i)
+    {
+        if (separations[i] > maxSeparation)
+        {
+            maxSeparation = separations[i];
+            bestIndex = i;
+        }
+    }
+
+    *edgeIndex = bestIndex;
+    return maxSeparation;
+}
+
+#else
+
 // Find the max separation between poly1 and poly2 using edge normals from poly1.
 static float b2FindMaxSeparation(std::int32_t* edgeIndex,
                                  const b2PolygonShape* poly1, const b2Transform& xf1,
@@ -65,6 +146,8 @@ static float b2FindMaxSeparation(std::int32_t* edgeIndex,
     return maxSeparation;
 }
 
+#endif
+
 static void b2FindIncidentEdge(std::array<b2ClipVertex, 2>& c,
                              const b2PolygonShape* poly1, const b2Transform& xf1, std::int32_t edge1,
                              const b2PolygonShape* poly2, const b2Transform& xf2)
@@ -186,12 +269,52 @@ void b2CollidePolygons(b2Manifold* manifold,
     v11 = b2Mul(xf1, v11);
     v12 = b2Mul(xf1, v12);
 
+    // Polygons with a radius larger than the skin have visibly rounded corners. Near the
+    // corners the separating axes underestimate the distance, so if the closest features
+    // are two vertices use the direction between them.
+    float sideRadius = totalRadius;
+    if (polyA->m_radius > b2_polygonRadius || polyB->m_radius > b2_polygonRadius)
+    {
+        b2SegmentDistanceResult result = b2SegmentDistance(v11, v12, incidentEdge[0].v, incidentEdge[1].v);
+        bool vertex1 = result.fraction1 == 0.0f || result.fraction1 == 1.0f;
+        bool vertex2 = result.fraction2 == 0.0f || result.fraction2 == 1.0f;
+        const float k_linearTol = 0.1f * b2_linearSlop;
+        if (vertex1 && vertex2 && result.distanceSquared > k_linearTol * k_linearTol)
+        {
+            if (result.distanceSquared > totalRadius * totalRadius)
+            {
+                return;
+            }
+
+            std::uint8_t index1 = static_cast<std::uint8_t>(result.fraction1 == 0.0f ? iv1 : iv2);
+            std::uint8_t index2 = result.fraction2 == 0.0f ? incidentEdge[0].id.cf.indexB : incidentEdge[1].id.cf.indexB;
+            b2Vec2 pointA = flip ? result.closest2 : result.closest1;
+            b2Vec2 pointB = flip ? result.closest1 : result.closest2;
+
+            manifold->type = b2Manifold::e_circles;
+            manifold->localNormal.SetZero();
+            manifold->localPoint = b2MulT(xfA, pointA);
+            manifold->pointCount = 1;
+
+            b2ManifoldPoint* cp = manifold->points + 0;
+            cp->localPoint = b2MulT(xfB, pointB);
+            cp->id.cf.indexA = flip ? index2 : index1;
+            cp->id.cf.indexB = flip ? index1 : index2;
+            cp->id.cf.typeA = b2ContactFeature::e_vertex;
+            cp->id.cf.typeB = b2ContactFeature::e_vertex;
+            return;
+        }
+
+        // The rounded corners are handled above, so clip to the reference face itself.
+        sideRadius = 0.0f;
+    }
+
     // Face offset.
     float frontOffset = b2Dot(normal, v11);
 
     // Side offsets, extended by polytope skin thickness.
-    float sideOffset1 = -b2Dot(tangent, v11) + totalRadius;
-    float sideOffset2 = b2Dot(tangent, v12) + totalRadius;
+    float sideOffset1 = -b2Dot(tangent, v11) + sideRadius;
+    float sideOffset2 = b2Dot(tangent, v12) + sideRadius;
 
     // Clip incident edge against extruded edge1 side edges.
     std::array<b2ClipVertex, 2>  clipPoints1;
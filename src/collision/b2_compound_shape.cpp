@@ -0,0 +1,295 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_compound_shape.h>
+#include <box2d/b2_block_allocator.h>
+#include <box2d/b2_capsule_shape.h>
+#include <box2d/b2_circle_shape.h>
+#include <box2d/b2_growable_stack.h>
+#include <box2d/b2_polygon_shape.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+b2CompoundShape::~b2CompoundShape()
+{
+    Clear();
+}
+
+void b2CompoundShape::Clear()
+{
+    for (std::int32_t i = 0; i < m_count; ++i)
+    {
+        m_children[i]->~b2Shape();
+        b2Free(m_children[i]);
+    }
+
+    b2Free(m_children);
+    m_children = nullptr;
+    m_count = 0;
+
+    b2Free(m_nodes);
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+}
+
+// Copy a convex child shape using b2Alloc.
+static b2Shape* b2CloneChild(const b2Shape* shape)
+{
+    switch (shape->GetType())
+    {
+    case b2Shape::e_circle:
+        {
+            void* mem = b2Alloc(sizeof(b2CircleShape));
+            return new (mem) b2CircleShape(*(const b2CircleShape*)shape);
+        }
+
+    case b2Shape::e_polygon:
+        {
+            void* mem = b2Alloc(sizeof(b2PolygonShape));
+            return new (mem) b2PolygonShape(*(const b2PolygonShape*)shape);
+        }
+
+    case b2Shape::e_capsule:
+        {
+            void* mem = b2Alloc(sizeof(b2CapsuleShape));
+            return new (mem) b2CapsuleShape(*(const b2CapsuleShape*)shape);
+        }
+
+    default:
+        // Only convex shapes can be compound children.
+        assert(false);
+        return nullptr;
+    }
+}
+
+// Build the subtree over the children [0, count) of the index array at the given node and
+// return the node that follows the subtree. The children are split at the median center
+// along the longest axis.
+static std::int32_t b2BuildCompoundTree(b2CompoundTreeNode* nodes, std::int32_t nodeIndex, const b2AABB* childAABBs,
+    std::int32_t* children, std::int32_t count)
+{
+    b2CompoundTreeNode* node = nodes + nodeIndex;
+    if (count == 1)
+    {
+        node->aabb = childAABBs[children[0]];
+        node->child2 = -1;
+        node->child = children[0];
+        return nodeIndex + 1;
+    }
+
+    b2Vec2 lower = childAABBs[children[0]].GetCenter();
+    b2Vec2 upper = lower;
+    for (std::int32_t i = 1; i < count; ++i)
+    {
+        b2Vec2 c = childAABBs[children[i]].GetCenter();
+        lower = b2Min(lower, c);
+        upper = b2Max(upper, c);
+    }
+
+    b2Vec2 d = upper - lower;
+    std::int32_t axis = d.x >= d.y ? 0 : 1;
+
+    std::int32_t half = count / 2;
+    std::nth_element(children, children + half, children + count,
+        [childAABBs, axis](std::int32_t a, std::int32_t b)
+        {
+            return childAABBs[a].GetCenter()(axis) < childAABBs[b].GetCenter()(axis);
+        });
+
+    std::int32_t child1 = nodeIndex + 1;
+    std::int32_t child2 = b2BuildCompoundTree(nodes, child1, childAABBs, children, half);
+    std::int32_t next = b2BuildCompoundTree(nodes, child2, childAABBs, children + half, count - half);
+
+    node->aabb.Combine(nodes[child1].aabb, nodes[child2].aabb);
+    node->child2 = child2;
+    node->child = -1;
+    return next;
+}
+
+void b2CompoundShape::Create(const b2Shape* const* children, std::int32_t count)
+{
+    assert(m_children == nullptr && m_count == 0);
+    assert(count >= 1);
+
+    m_count = count;
+    m_children = (b2Shape**)b2Alloc(count * sizeof(b2Shape*));
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        m_children[i] = b2CloneChild(children[i]);
+    }
+
+    b2Transform identity;
+    identity.SetIdentity();
+
+    b2AABB* childAABBs = (b2AABB*)b2Alloc(count * sizeof(b2AABB));
+    std::int32_t* indices = (std::int32_t*)b2Alloc(count * sizeof(std::int32_t));
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        m_children[i]->ComputeAABB(childAABBs + i, identity, 0);
+        indices[i] = i;
+    }
+
+    m_nodeCount = 2 * count - 1;
+    m_nodes = (b2CompoundTreeNode*)b2Alloc(m_nodeCount * sizeof(b2CompoundTreeNode));
+    std::int32_t next = b2BuildCompoundTree(m_nodes, 0, childAABBs, indices, count);
+    assert(next == m_nodeCount);
+    (void)next;
+
+    b2Free(indices);
+    b2Free(childAABBs);
+}
+
+b2Shape* b2CompoundShape::Clone(b2BlockAllocator* allocator) const
+{
+    auto* mem = allocator->Allocate<b2CompoundShape>();
+    b2CompoundShape* clone = new (mem) b2CompoundShape;
+    clone->m_count = m_count;
+    clone->m_children = (b2Shape**)b2Alloc(m_count * sizeof(b2Shape*));
+    for (std::int32_t i = 0; i < m_count; ++i)
+    {
+        clone->m_children[i] = b2CloneChild(m_children[i]);
+    }
+
+    clone->m_nodeCount = m_nodeCount;
+    clone->m_nodes = (b2CompoundTreeNode*)b2Alloc(m_nodeCount * sizeof(b2CompoundTreeNode));
+    memcpy(clone->m_nodes, m_nodes, m_nodeCount * sizeof(b2CompoundTreeNode));
+    return clone;
+}
+
+std::int32_t b2CompoundShape::GetChildCount() const
+{
+    return m_count;
+}
+
+bool b2CompoundShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
+{
+    for (std::int32_t i = 0; i < m_count; ++i)
+    {
+        if (m_children[i]->TestPoint(xf, p))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool b2CompoundShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+                            const b2Transform& xf, std::int32_t childIndex) const
+{
+    assert(0 <= childIndex && childIndex < m_count);
+    return m_children[childIndex]->RayCast(output, input, xf, 0);
+}
+
+void b2CompoundShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, std::int32_t childIndex) const
+{
+    assert(0 <= childIndex && childIndex < m_count);
+    m_children[childIndex]->ComputeAABB(aabb, xf, 0);
+}
+
+void b2CompoundShape::ComputeMass(b2MassData* massData, float density) const
+{
+    // The child inertia is about the shape origin, so it can be summed directly.
+    massData->mass = 0.0f;
+    massData->center.SetZero();
+    massData->I = 0.0f;
+
+    for (std::int32_t i = 0; i < m_count; ++i)
+    {
+        b2MassData childMass;
+        m_children[i]->ComputeMass(&childMass, density);
+        massData->mass += childMass.mass;
+        massData->center += childMass.mass * childMass.center;
+        massData->I += childMass.I;
+    }
+
+    if (massData->mass > 0.0f)
+    {
+        massData->center *= 1.0f / massData->mass;
+    }
+}
+
+float b2CompoundShape::GetChildRadius(std::int32_t childIndex) const
+{
+    assert(0 <= childIndex && childIndex < m_count);
+    return m_children[childIndex]->m_radius;
+}
+
+bool b2CompoundShape::SharesProxy() const
+{
+    return true;
+}
+
+void b2CompoundShape::ComputeProxyAABB(b2AABB* aabb, const b2Transform& xf) const
+{
+    // Transform the root bounds. The child radii are already included.
+    const b2AABB& root = m_nodes[0].aabb;
+    b2Vec2 v1 = b2Mul(xf, root.lowerBound);
+    b2Vec2 v2 = b2Mul(xf, b2Vec2(root.upperBound.x, root.lowerBound.y));
+    b2Vec2 v3 = b2Mul(xf, root.upperBound);
+    b2Vec2 v4 = b2Mul(xf, b2Vec2(root.lowerBound.x, root.upperBound.y));
+
+    aabb->lowerBound = b2Min(b2Min(v1, v2), b2Min(v3, v4));
+    aabb->upperBound = b2Max(b2Max(v1, v2), b2Max(v3, v4));
+}
+
+void b2CompoundShape::QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& xf) const
+{
+    // Bound the query box in local coordinates.
+    b2Vec2 v1 = b2MulT(xf, aabb.lowerBound);
+    b2Vec2 v2 = b2MulT(xf, b2Vec2(aabb.upperBound.x, aabb.lowerBound.y));
+    b2Vec2 v3 = b2MulT(xf, aabb.upperBound);
+    b2Vec2 v4 = b2MulT(xf, b2Vec2(aabb.lowerBound.x, aabb.upperBound.y));
+
+    b2AABB box;
+    box.lowerBound = b2Min(b2Min(v1, v2), b2Min(v3, v4));
+    box.upperBound = b2Max(b2Max(v1, v2), b2Max(v3, v4));
+
+    b2GrowableStack<std::int32_t, 64> stack;
+    stack.Push(0);
+
+    while (stack.GetCount() > 0)
+    {
+        std::int32_t nodeIndex = stack.Pop();
+        const b2CompoundTreeNode* node = m_nodes + nodeIndex;
+
+        if (b2TestOverlap(node->aabb, box) == false)
+        {
+            continue;
+        }
+
+        if (node->child2 == -1)
+        {
+            if (callback->ReportChild(node->child) == false)
+            {
+                return;
+            }
+        }
+        else
+        {
+            stack.Push(node->child2);
+            stack.Push(nodeIndex + 1);
+        }
+    }
+}
@@ -20,10 +20,13 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <box2d/b2_capsule_shape.h>
 #include <box2d/b2_circle_shape.h>
 #include <box2d/b2_distance.h>
 #include <box2d/b2_edge_shape.h>
 #include <box2d/b2_chain_shape.h>
+#include <box2d/b2_compound_shape.h>
+#include <box2d/b2_height_field_shape.h>
 #include <box2d/b2_polygon_shape.h>
 
 // GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
@@ -72,6 +75,20 @@ void b2DistanceProxy::Set(const b2Shape* shape, std::int32_t index)
         }
         break;
 
+    case b2Shape::e_heightField:
+        {
+            const b2HeightFieldShape* heightField = static_cast<const b2HeightFieldShape*>(shape);
+            assert(0 <= index && index < heightField->m_count - 1);
+
+            m_buffer[0] = heightField->GetVertex(index);
+            m_buffer[1] = heightField->GetVertex(index + 1);
+
+            m_vertices = m_buffer.data();
+            m_count = 2;
+            m_radius = heightField->m_radius;
+        }
+        break;
+
     case b2Shape::e_edge:
         {
             const b2EdgeShape* edge = static_cast<const b2EdgeShape*>(shape);
@@ -81,6 +98,22 @@ void b2DistanceProxy::Set(const b2Shape* shape, std::int32_t index)
         }
         break;
 
+    case b2Shape::e_capsule:
+        {
+            const b2CapsuleShape* capsule = static_cast<const b2CapsuleShape*>(shape);
+            m_vertices = &capsule->m_vertex1;
+            m_count = 2;
+            m_radius = capsule->m_radius;
+        }
+        break;
+
+    case b2Shape::e_compound:
+        {
+            const b2CompoundShape* compound = static_cast<const b2CompoundShape*>(shape);
+            Set(compound->GetChild(index), 0);
+        }
+        break;
+
     default:
         assert(false);
     }
@@ -742,3 +775,74 @@ bool b2ShapeCast(b2ShapeCastOutput * output, const b2ShapeCastInput * input)
     output->iterations = iter;
     return true;
 }
+
+b2SegmentDistanceResult b2SegmentDistance(const b2Vec2& p1, const b2Vec2& q1, const b2Vec2& p2, const b2Vec2& q2)
+{
+    b2SegmentDistanceResult result;
+
+    b2Vec2 d1 = q1 - p1;
+    b2Vec2 d2 = q2 - p2;
+    b2Vec2 r = p1 - p2;
+    float dd1 = b2Dot(d1, d1);
+    float dd2 = b2Dot(d2, d2);
+    float rd1 = b2Dot(r, d1);
+    float rd2 = b2Dot(r, d2);
+
+    const float epsSqr = FLT_EPSILON * FLT_EPSILON;
+
+    if (dd1 < epsSqr || dd2 < epsSqr)
+    {
+        // Handle degenerate segments
+        if (dd1 >= epsSqr)
+        {
+            result.fraction1 = b2Clamp(-rd1 / dd1, 0.0f, 1.0f);
+            result.fraction2 = 0.0f;
+        }
+        else if (dd2 >= epsSqr)
+        {
+            result.fraction1 = 0.0f;
+            result.fraction2 = b2Clamp(rd2 / dd2, 0.0f, 1.0f);
+        }
+        else
+        {
+            result.fraction1 = 0.0f;
+            result.fraction2 = 0.0f;
+        }
+    }
+    else
+    {
+        // Non-degenerate segments
+        float d12 = b2Dot(d1, d2);
+        float denominator = dd1 * dd2 - d12 * d12;
+
+        // Parallel segments use the first vertex of segment 1
+        float f1 = 0.0f;
+        if (denominator != 0.0f)
+        {
+            f1 = b2Clamp((d12 * rd2 - rd1 * dd2) / denominator, 0.0f, 1.0f);
+        }
+
+        // Compute point on segment 2 closest to p1 + f1 * d1
+        float f2 = (d12 * f1 + rd2) / dd2;
+
+        // Clamping of segment 2 requires a do over on segment 1
+        if (f2 < 0.0f)
+        {
+            f2 = 0.0f;
+            f1 = b2Clamp(-rd1 / dd1, 0.0f, 1.0f);
+        }
+        else if (f2 > 1.0f)
+        {
+            f2 = 1.0f;
+            f1 = b2Clamp((d12 - rd1) / dd1, 0.0f, 1.0f);
+        }
+
+        result.fraction1 = f1;
+        result.fraction2 = f2;
+    }
+
+    result.closest1 = p1 + result.fraction1 * d1;
+    result.closest2 = p2 + result.fraction2 * d2;
+    result.distanceSquared = b2DistanceSquared(result.closest1, result.closest2);
+    return result;
+}
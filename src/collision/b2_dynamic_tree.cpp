@@ -22,13 +22,22 @@
 #include <box2d/b2_dynamic_tree.h>
 #include <cstring>
 
-b2DynamicTree::b2DynamicTree()
+// Number of bins used by the top-down builder to evaluate split planes.
+static constexpr std::int32_t b2_treeBinCount = 8;
+
+// In refit mode the tree quality is checked after this many refits. The tree is rebuilt
+// once the area ratio grows by b2_treeRebuildRatio since the last rebuild.
+static constexpr std::int32_t b2_treeQualityInterval = 8;
+static constexpr float b2_treeRebuildRatio = 1.1f;
+
+b2DynamicTree::b2DynamicTree(b2AllocationTracker* tracker)
 {
+    m_tracker = tracker;
     m_root = b2_nullNode;
 
     m_nodeCapacity = 16;
     m_nodeCount = 0;
-    m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+    m_nodes = (b2TreeNode*)b2TrackedAlloc(m_tracker, m_nodeCapacity * sizeof(b2TreeNode), b2_treeAllocation);
     memset(m_nodes, 0, m_nodeCapacity * sizeof(b2TreeNode));
 
     // Build a linked list for the free list.
@@ -42,12 +51,21 @@ b2DynamicTree::b2DynamicTree()
     m_freeList = 0;
 
     m_insertionCount = 0;
+    m_optimizeCursor = 0;
+
+    m_refit = false;
+    m_refitCount = 0;
+    m_rebuildAreaRatio = 0.0f;
+    m_bulkInsert = false;
+    m_leafBuffer = nullptr;
+    m_leafBufferCapacity = 0;
 }
 
 b2DynamicTree::~b2DynamicTree()
 {
     // This frees the entire tree in one shot.
-    b2Free(m_nodes);
+    b2TrackedFree(m_tracker, m_nodes, m_nodeCapacity * sizeof(b2TreeNode), b2_treeAllocation);
+    b2TrackedFree(m_tracker, m_leafBuffer, m_leafBufferCapacity * sizeof(std::int32_t), b2_treeAllocation);
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -60,10 +78,11 @@ std::int32_t b2DynamicTree::AllocateNode()
 
         // The free list is empty. Rebuild a bigger pool.
         b2TreeNode* oldNodes = m_nodes;
+        std::int32_t oldCapacity = m_nodeCapacity;
         m_nodeCapacity *= 2;
-        m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+        m_nodes = (b2TreeNode*)b2TrackedAlloc(m_tracker, m_nodeCapacity * sizeof(b2TreeNode), b2_treeAllocation);
         memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-        b2Free(oldNodes);
+        b2TrackedFree(m_tracker, oldNodes, oldCapacity * sizeof(b2TreeNode), b2_treeAllocation);
 
         // Build a linked list for the free list. The parent
         // pointer becomes the "next" pointer.
@@ -86,6 +105,8 @@ std::int32_t b2DynamicTree::AllocateNode()
     m_nodes[nodeId].height = 0;
     m_nodes[nodeId].userData = nullptr;
     m_nodes[nodeId].moved = false;
+    m_nodes[nodeId].enlarged = false;
+    m_nodes[nodeId].motion = b2_aabbExtension;
     ++m_nodeCount;
     return nodeId;
 }
@@ -108,14 +129,22 @@ std::int32_t b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 {
     std::int32_t proxyId = AllocateNode();
 
-    // Fatten the aabb.
-    b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+    // Fatten the aabb. Without motion history this uses b2_aabbExtension, so proxies that
+    // never move, such as static ones, keep the classic margin.
+    float margin = GetMargin(proxyId);
+    b2Vec2 r(margin, margin);
     m_nodes[proxyId].aabb.lowerBound = aabb.lowerBound - r;
     m_nodes[proxyId].aabb.upperBound = aabb.upperBound + r;
     m_nodes[proxyId].userData = userData;
     m_nodes[proxyId].height = 0;
     m_nodes[proxyId].moved = true;
 
+    if (m_bulkInsert)
+    {
+        m_nodes[proxyId].parent = b2_nullNode;
+        return proxyId;
+    }
+
     InsertLeaf(proxyId);
 
     return proxyId;
@@ -123,6 +152,7 @@ std::int32_t b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 
 void b2DynamicTree::DestroyProxy(std::int32_t proxyId)
 {
+    assert(m_bulkInsert == false);
     assert(0 <= proxyId && proxyId < m_nodeCapacity);
     assert(m_nodes[proxyId].IsLeaf());
 
@@ -132,13 +162,19 @@ void b2DynamicTree::DestroyProxy(std::int32_t proxyId)
 
 bool b2DynamicTree::MoveProxy(std::int32_t proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
+    assert(m_bulkInsert == false);
     assert(0 <= proxyId && proxyId < m_nodeCapacity);
 
     assert(m_nodes[proxyId].IsLeaf());
 
+    // Track the recent motion. Speeding up takes effect at once, slowing down gradually.
+    b2TreeNode* node = m_nodes + proxyId;
+    node->motion = b2Max(displacement.Length(), b2_aabbMotionDecay * node->motion);
+
     // Extend AABB
     b2AABB fatAABB;
-    b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+    float margin = GetMargin(proxyId);
+    b2Vec2 r(margin, margin);
     fatAABB.lowerBound = aabb.lowerBound - r;
     fatAABB.upperBound = aabb.upperBound + r;
 
@@ -168,10 +204,14 @@ bool b2DynamicTree::MoveProxy(std::int32_t proxyId, const b2AABB& aabb, const b2
     {
         // The tree AABB still contains the object, but it might be too large.
         // Perhaps the object was moving fast but has since gone to sleep.
-        // The huge AABB is larger than the new fat AABB.
+        // The huge AABB is larger than the new fat AABB. It also covers the
+        // predicted motion, otherwise the trailing side of a fast proxy would
+        // look huge on every move.
+        float extension = GetHugeExtension(proxyId);
+        b2Vec2 h(extension, extension);
         b2AABB hugeAABB;
-        hugeAABB.lowerBound = fatAABB.lowerBound - 4.0f * r;
-        hugeAABB.upperBound = fatAABB.upperBound + 4.0f * r;
+        hugeAABB.lowerBound = fatAABB.lowerBound - h;
+        hugeAABB.upperBound = fatAABB.upperBound + h;
 
         if (hugeAABB.Contains(treeAABB))
         {
@@ -183,11 +223,35 @@ bool b2DynamicTree::MoveProxy(std::int32_t proxyId, const b2AABB& aabb, const b2
         // Otherwise the tree AABB is huge and needs to be shrunk
     }
 
-    RemoveLeaf(proxyId);
+    if (m_refit)
+    {
+        // Update the leaf in place. The ancestors grow to contain it and are flagged
+        // so that Refit shrinks them again. A flagged ancestor that already contains
+        // the leaf has flagged ancestors that contain it as well.
+        m_nodes[proxyId].aabb = fatAABB;
+
+        std::int32_t index = m_nodes[proxyId].parent;
+        while (index != b2_nullNode)
+        {
+            b2TreeNode* parent = m_nodes + index;
+            if (parent->enlarged && parent->aabb.Contains(fatAABB))
+            {
+                break;
+            }
 
-    m_nodes[proxyId].aabb = fatAABB;
+            parent->aabb.Combine(fatAABB);
+            parent->enlarged = true;
+            index = parent->parent;
+        }
+    }
+    else
+    {
+        RemoveLeaf(proxyId);
 
-    InsertLeaf(proxyId);
+        m_nodes[proxyId].aabb = fatAABB;
+
+        InsertLeaf(proxyId);
+    }
 
     m_nodes[proxyId].moved = true;
 
@@ -313,12 +377,11 @@ void b2DynamicTree::InsertLeaf(std::int32_t leaf)
         m_root = newParent;
     }
 
-    // Walk back up the tree fixing heights and AABBs
+    // Walk back up the tree fixing heights and AABBs. Rotations keep the
+    // surface area low, which matters more for queries than the height.
     index = m_nodes[leaf].parent;
     while (index != b2_nullNode)
     {
-        index = Balance(index);
-
         std::int32_t child1 = m_nodes[index].child1;
         std::int32_t child2 = m_nodes[index].child2;
 
@@ -328,6 +391,8 @@ void b2DynamicTree::InsertLeaf(std::int32_t leaf)
         m_nodes[index].height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
         m_nodes[index].aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
 
+        Rotate(index);
+
         index = m_nodes[index].parent;
     }
 
@@ -372,8 +437,6 @@ void b2DynamicTree::RemoveLeaf(std::int32_t leaf)
         std::int32_t index = grandParent;
         while (index != b2_nullNode)
         {
-            index = Balance(index);
-
             std::int32_t child1 = m_nodes[index].child1;
             std::int32_t child2 = m_nodes[index].child2;
 
@@ -393,149 +456,221 @@ void b2DynamicTree::RemoveLeaf(std::int32_t leaf)
     //Validate();
 }
 
-// Perform a left or right rotation if node A is imbalanced.
-// Returns the new root index.
-std::int32_t b2DynamicTree::Balance(std::int32_t iA)
+// Perform the rotation that most reduces the perimeter of the children of node A. A child
+// swaps with a grandchild on the other side, or two grandchildren on opposite sides swap.
+// The leaves under A do not change, so A keeps its AABB.
+//
+//       A
+//    +--+--+
+//    B     C
+//  +-+-+ +-+-+
+//  D   E F   G
+//
+// Returns true if the nodes were rotated.
+bool b2DynamicTree::Rotate(std::int32_t iA)
 {
-    assert(iA != b2_nullNode);
-
     b2TreeNode* A = m_nodes + iA;
-    if (A->IsLeaf() || A->height < 2)
+    if (A->height < 2)
     {
-        return iA;
+        return false;
     }
 
     std::int32_t iB = A->child1;
     std::int32_t iC = A->child2;
-    assert(0 <= iB && iB < m_nodeCapacity);
-    assert(0 <= iC && iC < m_nodeCapacity);
-
     b2TreeNode* B = m_nodes + iB;
     b2TreeNode* C = m_nodes + iC;
 
-    std::int32_t balance = C->height - B->height;
-
-    // Rotate C up
-    if (balance > 1)
+    enum Rotation
     {
-        std::int32_t iF = C->child1;
-        std::int32_t iG = C->child2;
-        b2TreeNode* F = m_nodes + iF;
-        b2TreeNode* G = m_nodes + iG;
-        assert(0 <= iF && iF < m_nodeCapacity);
-        assert(0 <= iG && iG < m_nodeCapacity);
-
-        // Swap A and C
-        C->child1 = iA;
-        C->parent = A->parent;
-        A->parent = iC;
-
-        // A's old parent should point to C
-        if (C->parent != b2_nullNode)
+        e_none,
+        e_BF,
+        e_BG,
+        e_CD,
+        e_CE,
+        e_DF,
+        e_DG
+    };
+
+    Rotation best = e_none;
+    float bestCost = 0.0f;
+
+    if (B->IsLeaf() == false && C->IsLeaf() == false)
+    {
+        const b2AABB& aabbD = m_nodes[B->child1].aabb;
+        const b2AABB& aabbE = m_nodes[B->child2].aabb;
+        const b2AABB& aabbF = m_nodes[C->child1].aabb;
+        const b2AABB& aabbG = m_nodes[C->child2].aabb;
+        float areaB = B->aabb.GetPerimeter();
+        float areaC = C->aabb.GetPerimeter();
+
+        b2AABB aabb;
+        aabb.Combine(B->aabb, aabbG);
+        float cost = aabb.GetPerimeter() - areaC;
+        if (cost < bestCost)
         {
-            if (m_nodes[C->parent].child1 == iA)
-            {
-                m_nodes[C->parent].child1 = iC;
-            }
-            else
-            {
-                assert(m_nodes[C->parent].child2 == iA);
-                m_nodes[C->parent].child2 = iC;
-            }
+            best = e_BF;
+            bestCost = cost;
         }
-        else
+
+        aabb.Combine(B->aabb, aabbF);
+        cost = aabb.GetPerimeter() - areaC;
+        if (cost < bestCost)
         {
-            m_root = iC;
+            best = e_BG;
+            bestCost = cost;
         }
 
-        // Rotate
-        if (F->height > G->height)
+        aabb.Combine(C->aabb, aabbE);
+        cost = aabb.GetPerimeter() - areaB;
+        if (cost < bestCost)
         {
-            C->child2 = iF;
-            A->child2 = iG;
-            G->parent = iA;
-            A->aabb.Combine(B->aabb, G->aabb);
-            C->aabb.Combine(A->aabb, F->aabb);
-
-            A->height = 1 + b2Max(B->height, G->height);
-            C->height = 1 + b2Max(A->height, F->height);
+            best = e_CD;
+            bestCost = cost;
         }
-        else
+
+        aabb.Combine(C->aabb, aabbD);
+        cost = aabb.GetPerimeter() - areaB;
+        if (cost < bestCost)
         {
-            C->child2 = iG;
-            A->child2 = iF;
-            F->parent = iA;
-            A->aabb.Combine(B->aabb, F->aabb);
-            C->aabb.Combine(A->aabb, G->aabb);
+            best = e_CE;
+            bestCost = cost;
+        }
 
-            A->height = 1 + b2Max(B->height, F->height);
-            C->height = 1 + b2Max(A->height, G->height);
+        b2AABB aabb2;
+        aabb.Combine(aabbF, aabbE);
+        aabb2.Combine(aabbD, aabbG);
+        cost = aabb.GetPerimeter() + aabb2.GetPerimeter() - areaB - areaC;
+        if (cost < bestCost)
+        {
+            best = e_DF;
+            bestCost = cost;
         }
 
-        return iC;
+        aabb.Combine(aabbG, aabbE);
+        aabb2.Combine(aabbF, aabbD);
+        cost = aabb.GetPerimeter() + aabb2.GetPerimeter() - areaB - areaC;
+        if (cost < bestCost)
+        {
+            best = e_DG;
+            bestCost = cost;
+        }
     }
-
-    // Rotate B up
-    if (balance < -1)
+    else if (C->IsLeaf() == false)
     {
-        std::int32_t iD = B->child1;
-        std::int32_t iE = B->child2;
-        b2TreeNode* D = m_nodes + iD;
-        b2TreeNode* E = m_nodes + iE;
-        assert(0 <= iD && iD < m_nodeCapacity);
-        assert(0 <= iE && iE < m_nodeCapacity);
-
-        // Swap A and B
-        B->child1 = iA;
-        B->parent = A->parent;
-        A->parent = iB;
+        float areaC = C->aabb.GetPerimeter();
 
-        // A's old parent should point to B
-        if (B->parent != b2_nullNode)
+        b2AABB aabb;
+        aabb.Combine(B->aabb, m_nodes[C->child2].aabb);
+        float cost = aabb.GetPerimeter() - areaC;
+        if (cost < bestCost)
         {
-            if (m_nodes[B->parent].child1 == iA)
-            {
-                m_nodes[B->parent].child1 = iB;
-            }
-            else
-            {
-                assert(m_nodes[B->parent].child2 == iA);
-                m_nodes[B->parent].child2 = iB;
-            }
+            best = e_BF;
+            bestCost = cost;
         }
-        else
+
+        aabb.Combine(B->aabb, m_nodes[C->child1].aabb);
+        cost = aabb.GetPerimeter() - areaC;
+        if (cost < bestCost)
         {
-            m_root = iB;
+            best = e_BG;
+            bestCost = cost;
         }
+    }
+    else
+    {
+        float areaB = B->aabb.GetPerimeter();
 
-        // Rotate
-        if (D->height > E->height)
+        b2AABB aabb;
+        aabb.Combine(C->aabb, m_nodes[B->child2].aabb);
+        float cost = aabb.GetPerimeter() - areaB;
+        if (cost < bestCost)
         {
-            B->child2 = iD;
-            A->child1 = iE;
-            E->parent = iA;
-            A->aabb.Combine(C->aabb, E->aabb);
-            B->aabb.Combine(A->aabb, D->aabb);
-
-            A->height = 1 + b2Max(C->height, E->height);
-            B->height = 1 + b2Max(A->height, D->height);
+            best = e_CD;
+            bestCost = cost;
         }
-        else
-        {
-            B->child2 = iE;
-            A->child1 = iD;
-            D->parent = iA;
-            A->aabb.Combine(C->aabb, D->aabb);
-            B->aabb.Combine(A->aabb, E->aabb);
 
-            A->height = 1 + b2Max(C->height, D->height);
-            B->height = 1 + b2Max(A->height, E->height);
+        aabb.Combine(C->aabb, m_nodes[B->child1].aabb);
+        cost = aabb.GetPerimeter() - areaB;
+        if (cost < bestCost)
+        {
+            best = e_CE;
+            bestCost = cost;
         }
+    }
 
-        return iB;
+    switch (best)
+    {
+        case e_none:
+            return false;
+
+        case e_BF:
+            SwapNodes(iA, iB, iC, C->child1);
+            break;
+
+        case e_BG:
+            SwapNodes(iA, iB, iC, C->child2);
+            break;
+
+        case e_CD:
+            SwapNodes(iA, iC, iB, B->child1);
+            break;
+
+        case e_CE:
+            SwapNodes(iA, iC, iB, B->child2);
+            break;
+
+        case e_DF:
+            SwapNodes(iB, B->child1, iC, C->child1);
+            break;
+
+        case e_DG:
+            SwapNodes(iB, B->child1, iC, C->child2);
+            break;
+    }
+
+    // Refit the children of A. A leaf may have moved down, but leaves need no refit.
+    if (B->IsLeaf() == false)
+    {
+        B->aabb.Combine(m_nodes[B->child1].aabb, m_nodes[B->child2].aabb);
+        B->height = 1 + b2Max(m_nodes[B->child1].height, m_nodes[B->child2].height);
     }
 
-    return iA;
+    if (C->IsLeaf() == false)
+    {
+        C->aabb.Combine(m_nodes[C->child1].aabb, m_nodes[C->child2].aabb);
+        C->height = 1 + b2Max(m_nodes[C->child1].height, m_nodes[C->child2].height);
+    }
+
+    A->height = 1 + b2Max(m_nodes[A->child1].height, m_nodes[A->child2].height);
+    return true;
+}
+
+// Exchange child i1 of p1 with child i2 of p2.
+void b2DynamicTree::SwapNodes(std::int32_t p1, std::int32_t i1, std::int32_t p2, std::int32_t i2)
+{
+    b2TreeNode* parent1 = m_nodes + p1;
+    b2TreeNode* parent2 = m_nodes + p2;
+
+    if (parent1->child1 == i1)
+    {
+        parent1->child1 = i2;
+    }
+    else
+    {
+        parent1->child2 = i2;
+    }
+
+    if (parent2->child1 == i2)
+    {
+        parent2->child1 = i1;
+    }
+    else
+    {
+        parent2->child2 = i1;
+    }
+
+    m_nodes[i1].parent = p2;
+    m_nodes[i2].parent = p1;
 }
 
 std::int32_t b2DynamicTree::GetHeight() const
@@ -664,8 +799,15 @@ void b2DynamicTree::ValidateMetrics(std::int32_t index) const
     b2AABB aabb;
     aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
 
-    assert(aabb.lowerBound == node->aabb.lowerBound);
-    assert(aabb.upperBound == node->aabb.upperBound);
+    if (node->enlarged)
+    {
+        assert(node->aabb.Contains(aabb));
+    }
+    else
+    {
+        assert(aabb.lowerBound == node->aabb.lowerBound);
+        assert(aabb.upperBound == node->aabb.upperBound);
+    }
 
     ValidateMetrics(child1);
     ValidateMetrics(child2);
@@ -716,7 +858,8 @@ std::int32_t b2DynamicTree::GetMaxBalance() const
 
 void b2DynamicTree::RebuildBottomUp()
 {
-    std::int32_t* nodes = (std::int32_t*)b2Alloc(m_nodeCount * sizeof(std::int32_t));
+    std::int32_t* nodes = (std::int32_t*)b2TrackedAlloc(m_tracker, m_nodeCount * sizeof(std::int32_t), b2_treeAllocation);
+    std::int32_t nodeCount = m_nodeCount;
     std::int32_t count = 0;
 
     // Build array of leaves. Free the rest.
@@ -785,11 +928,341 @@ void b2DynamicTree::RebuildBottomUp()
     }
 
     m_root = nodes[0];
-    b2Free(nodes);
+    b2TrackedFree(m_tracker, nodes, nodeCount * sizeof(std::int32_t), b2_treeAllocation);
+
+    Validate();
+}
+
+struct b2TreeBin
+{
+    b2AABB aabb;
+    std::int32_t count;
+};
+
+// Build a subtree over the given leaves. The leaves are binned by their centers along
+// the longest axis and split at the bin boundary with the least surface area heuristic
+// cost, the summed perimeters of the two halves weighted by their leaf counts.
+std::int32_t b2DynamicTree::BuildSubtree(std::int32_t* leaves, std::int32_t count)
+{
+    if (count == 1)
+    {
+        return leaves[0];
+    }
+
+    b2Vec2 lower = m_nodes[leaves[0]].aabb.GetCenter();
+    b2Vec2 upper = lower;
+    for (std::int32_t i = 1; i < count; ++i)
+    {
+        b2Vec2 c = m_nodes[leaves[i]].aabb.GetCenter();
+        lower = b2Min(lower, c);
+        upper = b2Max(upper, c);
+    }
+
+    b2Vec2 extents = upper - lower;
+    std::int32_t axis = extents.x >= extents.y ? 0 : 1;
+    float minValue = lower(axis);
+    float extent = extents(axis);
+
+    std::int32_t split = count / 2;
+    if (count > 2 && extent > 0.0f)
+    {
+        b2TreeBin bins[b2_treeBinCount];
+        for (std::int32_t i = 0; i < b2_treeBinCount; ++i)
+        {
+            bins[i].count = 0;
+        }
+
+        float scale = b2_treeBinCount / extent;
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            const b2AABB& aabb = m_nodes[leaves[i]].aabb;
+            std::int32_t binIndex = b2Min(std::int32_t(scale * (aabb.GetCenter()(axis) - minValue)), b2_treeBinCount - 1);
+            b2TreeBin* bin = bins + binIndex;
+            if (bin->count == 0)
+            {
+                bin->aabb = aabb;
+            }
+            else
+            {
+                bin->aabb.Combine(aabb);
+            }
+            ++bin->count;
+        }
+
+        // leftCosts[i] is the cost of bins [0, i].
+        float leftCosts[b2_treeBinCount];
+        std::int32_t leftCount = 0;
+        b2AABB leftAABB = m_nodes[leaves[0]].aabb;
+        for (std::int32_t i = 0; i < b2_treeBinCount - 1; ++i)
+        {
+            if (bins[i].count > 0)
+            {
+                if (leftCount == 0)
+                {
+                    leftAABB = bins[i].aabb;
+                }
+                else
+                {
+                    leftAABB.Combine(bins[i].aabb);
+                }
+                leftCount += bins[i].count;
+            }
+            leftCosts[i] = leftCount > 0 ? leftCount * leftAABB.GetPerimeter() : 0.0f;
+        }
+
+        float bestCost = FLT_MAX;
+        std::int32_t bestPlane = 0;
+        std::int32_t rightCount = 0;
+        b2AABB rightAABB = m_nodes[leaves[0]].aabb;
+        for (std::int32_t i = b2_treeBinCount - 1; i > 0; --i)
+        {
+            if (bins[i].count > 0)
+            {
+                if (rightCount == 0)
+                {
+                    rightAABB = bins[i].aabb;
+                }
+                else
+                {
+                    rightAABB.Combine(bins[i].aabb);
+                }
+                rightCount += bins[i].count;
+            }
+
+            if (rightCount == 0 || rightCount == count)
+            {
+                continue;
+            }
+
+            float cost = leftCosts[i - 1] + rightCount * rightAABB.GetPerimeter();
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestPlane = i;
+            }
+        }
+
+        if (bestPlane > 0)
+        {
+            // Partition the leaves, left of the plane first.
+            std::int32_t i = 0, j = count;
+            while (i < j)
+            {
+                std::int32_t binIndex = b2Min(std::int32_t(scale * (m_nodes[leaves[i]].aabb.GetCenter()(axis) - minValue)), b2_treeBinCount - 1);
+                if (binIndex < bestPlane)
+                {
+                    ++i;
+                }
+                else
+                {
+                    --j;
+                    b2Swap(leaves[i], leaves[j]);
+                }
+            }
+
+            split = i;
+        }
+    }
+
+    std::int32_t child1 = BuildSubtree(leaves, split);
+    std::int32_t child2 = BuildSubtree(leaves + split, count - split);
+
+    std::int32_t parentIndex = AllocateNode();
+    b2TreeNode* parent = m_nodes + parentIndex;
+    parent->child1 = child1;
+    parent->child2 = child2;
+    parent->height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+    parent->aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+    m_nodes[child1].parent = parentIndex;
+    m_nodes[child2].parent = parentIndex;
+    return parentIndex;
+}
+
+void b2DynamicTree::Rebuild()
+{
+    // Leaves from a bulk insert may exist without a root.
+    if (m_nodeCount == 0)
+    {
+        return;
+    }
+
+    // The leaf buffer is kept, so periodic rebuilds in refit mode do not use the heap.
+    if (m_leafBufferCapacity < m_nodeCount)
+    {
+        b2TrackedFree(m_tracker, m_leafBuffer, m_leafBufferCapacity * sizeof(std::int32_t), b2_treeAllocation);
+        m_leafBufferCapacity = m_nodeCapacity;
+        m_leafBuffer = (std::int32_t*)b2TrackedAlloc(m_tracker, m_leafBufferCapacity * sizeof(std::int32_t), b2_treeAllocation);
+    }
+
+    std::int32_t* leaves = m_leafBuffer;
+    std::int32_t count = 0;
+
+    // Build array of leaves. Free the rest.
+    for (std::int32_t i = 0; i < m_nodeCapacity; ++i)
+    {
+        if (m_nodes[i].height < 0)
+        {
+            // free node in pool
+            continue;
+        }
+
+        if (m_nodes[i].IsLeaf())
+        {
+            leaves[count] = i;
+            ++count;
+        }
+        else
+        {
+            FreeNode(i);
+        }
+    }
+
+    // The freed nodes are enough for the new internal nodes, so the pool does not grow.
+    m_root = BuildSubtree(leaves, count);
+    m_nodes[m_root].parent = b2_nullNode;
+
+    m_rebuildAreaRatio = GetAreaRatio();
+    m_refitCount = 0;
 
     Validate();
 }
 
+void b2DynamicTree::BeginBulkInsert()
+{
+    assert(m_bulkInsert == false);
+    m_bulkInsert = true;
+}
+
+void b2DynamicTree::EndBulkInsert()
+{
+    assert(m_bulkInsert == true);
+    m_bulkInsert = false;
+    Rebuild();
+}
+
+void b2DynamicTree::SetRefit(bool flag)
+{
+    if (flag == m_refit)
+    {
+        return;
+    }
+
+    Refit();
+    m_refit = flag;
+    m_refitCount = 0;
+    m_rebuildAreaRatio = GetAreaRatio();
+}
+
+void b2DynamicTree::RefitNode(std::int32_t index)
+{
+    b2TreeNode* node = m_nodes + index;
+    if (node->enlarged == false)
+    {
+        // Leaves are never flagged.
+        return;
+    }
+
+    RefitNode(node->child1);
+    RefitNode(node->child2);
+
+    node->aabb.Combine(m_nodes[node->child1].aabb, m_nodes[node->child2].aabb);
+    node->enlarged = false;
+}
+
+void b2DynamicTree::Refit()
+{
+    if (m_root == b2_nullNode)
+    {
+        return;
+    }
+
+    RefitNode(m_root);
+
+    if (m_refit == false)
+    {
+        return;
+    }
+
+    ++m_refitCount;
+    if (m_refitCount < b2_treeQualityInterval)
+    {
+        return;
+    }
+
+    m_refitCount = 0;
+    if (GetAreaRatio() > b2_treeRebuildRatio * m_rebuildAreaRatio)
+    {
+        Rebuild();
+    }
+}
+
+std::int32_t b2DynamicTree::Optimize(std::int32_t budget)
+{
+    std::int32_t rotationCount = 0;
+
+    // A rotation can move an enlarged subtree under a node that is not flagged, where
+    // RefitNode would no longer reach it.
+    if (m_refit && m_root != b2_nullNode && budget > 0)
+    {
+        RefitNode(m_root);
+    }
+
+    // Sweep the node pool so that every internal node is eventually visited.
+    for (std::int32_t i = 0; i < m_nodeCapacity && budget > 0; ++i)
+    {
+        if (m_optimizeCursor >= m_nodeCapacity)
+        {
+            m_optimizeCursor = 0;
+        }
+
+        std::int32_t index = m_optimizeCursor++;
+        if (m_nodes[index].height < 2)
+        {
+            // Free node, leaf, or parent of two leaves
+            continue;
+        }
+
+        --budget;
+        if (Rotate(index))
+        {
+            ++rotationCount;
+
+            // Fix the heights up the tree.
+            std::int32_t parent = m_nodes[index].parent;
+            while (parent != b2_nullNode)
+            {
+                b2TreeNode* node = m_nodes + parent;
+                node->height = 1 + b2Max(m_nodes[node->child1].height, m_nodes[node->child2].height);
+                parent = node->parent;
+            }
+        }
+    }
+
+    return rotationCount;
+}
+
+void b2DynamicTree::Reset()
+{
+    m_root = b2_nullNode;
+    m_nodeCount = 0;
+
+    // Build a linked list for the free list.
+    for (std::int32_t i = 0; i < m_nodeCapacity - 1; ++i)
+    {
+        m_nodes[i].next = i + 1;
+        m_nodes[i].height = -1;
+    }
+    m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+    m_nodes[m_nodeCapacity-1].height = -1;
+    m_freeList = 0;
+
+    m_insertionCount = 0;
+    m_optimizeCursor = 0;
+    m_refitCount = 0;
+    m_rebuildAreaRatio = 0.0f;
+    m_bulkInsert = false;
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
     // Build array of leaves. Free the rest.
@@ -0,0 +1,200 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_height_field_shape.h>
+#include <box2d/b2_edge_shape.h>
+
+#include <box2d/b2_block_allocator.h>
+
+#include <new>
+#include <cstring>
+
+b2HeightFieldShape::~b2HeightFieldShape()
+{
+    Clear();
+}
+
+void b2HeightFieldShape::Clear()
+{
+    b2Free(m_heights);
+    m_heights = nullptr;
+    m_count = 0;
+}
+
+void b2HeightFieldShape::Create(const float* heights, std::int32_t count, float spacing)
+{
+    assert(m_heights == nullptr && m_count == 0);
+    assert(count >= 2);
+    assert(spacing > b2_linearSlop);
+
+    m_count = count;
+    m_spacing = spacing;
+    m_heights = (float*)b2Alloc(count * sizeof(float));
+    memcpy(m_heights, heights, count * sizeof(float));
+
+    m_minHeight = heights[0];
+    m_maxHeight = heights[0];
+    for (std::int32_t i = 1; i < count; ++i)
+    {
+        m_minHeight = b2Min(m_minHeight, heights[i]);
+        m_maxHeight = b2Max(m_maxHeight, heights[i]);
+    }
+}
+
+b2Shape* b2HeightFieldShape::Clone(b2BlockAllocator* allocator) const
+{
+    auto* mem = allocator->Allocate<b2HeightFieldShape>();
+    b2HeightFieldShape* clone = new (mem) b2HeightFieldShape;
+    clone->Create(m_heights, m_count, m_spacing);
+    clone->m_radius = m_radius;
+    return clone;
+}
+
+std::int32_t b2HeightFieldShape::GetChildCount() const
+{
+    // column count = sample count - 1
+    return m_count - 1;
+}
+
+void b2HeightFieldShape::GetChildEdge(b2EdgeShape* edge, std::int32_t index) const
+{
+    assert(0 <= index && index < m_count - 1);
+    edge->m_type = b2Shape::e_edge;
+    edge->m_radius = m_radius;
+
+    // One-sided edges collide on their right side, so the edge runs from right to
+    // left to face up. The ends continue flat.
+    b2Vec2 dx(m_spacing, 0.0f);
+    edge->m_vertex1 = GetVertex(index + 1);
+    edge->m_vertex2 = GetVertex(index);
+    edge->m_vertex0 = index + 2 < m_count ? GetVertex(index + 2) : edge->m_vertex1 + dx;
+    edge->m_vertex3 = index > 0 ? GetVertex(index - 1) : edge->m_vertex2 - dx;
+    edge->m_oneSided = true;
+}
+
+bool b2HeightFieldShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
+{
+    (void)xf;
+    (void)p;
+    return false;
+}
+
+bool b2HeightFieldShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+                                 const b2Transform& xf, std::int32_t childIndex) const
+{
+    assert(0 <= childIndex && childIndex < m_count - 1);
+
+    b2EdgeShape edgeShape;
+    edgeShape.m_vertex1 = GetVertex(childIndex);
+    edgeShape.m_vertex2 = GetVertex(childIndex + 1);
+
+    return edgeShape.RayCast(output, input, xf, 0);
+}
+
+void b2HeightFieldShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, std::int32_t childIndex) const
+{
+    assert(0 <= childIndex && childIndex < m_count - 1);
+
+    b2Vec2 v1 = b2Mul(xf, GetVertex(childIndex));
+    b2Vec2 v2 = b2Mul(xf, GetVertex(childIndex + 1));
+
+    b2Vec2 lower = b2Min(v1, v2);
+    b2Vec2 upper = b2Max(v1, v2);
+
+    b2Vec2 r(m_radius, m_radius);
+    aabb->lowerBound = lower - r;
+    aabb->upperBound = upper + r;
+}
+
+void b2HeightFieldShape::ComputeMass(b2MassData* massData, float density) const
+{
+    (void)density;
+
+    massData->mass = 0.0f;
+    massData->center.SetZero();
+    massData->I = 0.0f;
+}
+
+bool b2HeightFieldShape::SharesProxy() const
+{
+    return true;
+}
+
+void b2HeightFieldShape::ComputeProxyAABB(b2AABB* aabb, const b2Transform& xf) const
+{
+    float width = (m_count - 1) * m_spacing;
+    b2Vec2 v1 = b2Mul(xf, b2Vec2(0.0f, m_minHeight));
+    b2Vec2 v2 = b2Mul(xf, b2Vec2(width, m_minHeight));
+    b2Vec2 v3 = b2Mul(xf, b2Vec2(width, m_maxHeight));
+    b2Vec2 v4 = b2Mul(xf, b2Vec2(0.0f, m_maxHeight));
+
+    b2Vec2 lower = b2Min(b2Min(v1, v2), b2Min(v3, v4));
+    b2Vec2 upper = b2Max(b2Max(v1, v2), b2Max(v3, v4));
+
+    b2Vec2 r(m_radius, m_radius);
+    aabb->lowerBound = lower - r;
+    aabb->upperBound = upper + r;
+}
+
+void b2HeightFieldShape::QueryChildren(b2ChildQueryCallback* callback, const b2AABB& aabb, const b2Transform& xf) const
+{
+    // Bound the query box in local coordinates.
+    b2Vec2 v1 = b2MulT(xf, aabb.lowerBound);
+    b2Vec2 v2 = b2MulT(xf, b2Vec2(aabb.upperBound.x, aabb.lowerBound.y));
+    b2Vec2 v3 = b2MulT(xf, aabb.upperBound);
+    b2Vec2 v4 = b2MulT(xf, b2Vec2(aabb.lowerBound.x, aabb.upperBound.y));
+
+    b2Vec2 r(m_radius, m_radius);
+    b2Vec2 lower = b2Min(b2Min(v1, v2), b2Min(v3, v4)) - r;
+    b2Vec2 upper = b2Max(b2Max(v1, v2), b2Max(v3, v4)) + r;
+
+    if (upper.y < m_minHeight || m_maxHeight < lower.y)
+    {
+        return;
+    }
+
+    // Walk the columns under the box.
+    float invSpacing = 1.0f / m_spacing;
+    float lastColumn = float(m_count - 2);
+    if (upper.x < 0.0f || lastColumn + 1.0f < lower.x * invSpacing)
+    {
+        return;
+    }
+
+    std::int32_t first = std::int32_t(b2Max(lower.x * invSpacing, 0.0f));
+    std::int32_t last = std::int32_t(b2Min(upper.x * invSpacing, lastColumn));
+
+    for (std::int32_t i = first; i <= last; ++i)
+    {
+        float h1 = m_heights[i];
+        float h2 = m_heights[i + 1];
+        if (upper.y < b2Min(h1, h2) || b2Max(h1, h2) < lower.y)
+        {
+            continue;
+        }
+
+        if (callback->ReportChild(i) == false)
+        {
+            return;
+        }
+    }
+}
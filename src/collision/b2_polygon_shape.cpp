@@ -22,6 +22,7 @@
 
 #include <box2d/b2_polygon_shape.h>
 #include <box2d/b2_block_allocator.h>
+#include <box2d/b2_circle_shape.h>
 
 #include <new>
 
@@ -72,6 +73,13 @@ void b2PolygonShape::SetAsBox(float hx, float hy, const b2Vec2& center, float an
     }
 }
 
+void b2PolygonShape::SetAsRoundedBox(float hx, float hy, float radius)
+{
+    assert(radius >= 0.0f);
+    SetAsBox(hx, hy);
+    m_radius = radius;
+}
+
 std::int32_t b2PolygonShape::GetChildCount() const
 {
     return 1;
@@ -251,6 +259,40 @@ bool b2PolygonShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
 {
     b2Vec2 pLocal = b2MulT(xf.q, p - xf.p);
 
+    if (m_radius > b2_polygonRadius)
+    {
+        // Rounded polygon: test the distance to the core polygon.
+        float separation = -FLT_MAX;
+        for (std::int32_t i = 0; i < m_count; ++i)
+        {
+            separation = b2Max(separation, b2Dot(m_normals[i], pLocal - m_vertices[i]));
+        }
+
+        if (separation <= 0.0f)
+        {
+            return true;
+        }
+
+        if (separation > m_radius)
+        {
+            return false;
+        }
+
+        float rr = m_radius * m_radius;
+        for (std::int32_t i = 0; i < m_count; ++i)
+        {
+            b2Vec2 v1 = m_vertices[i];
+            b2Vec2 e = (i + 1 < m_count ? m_vertices[i + 1] : m_vertices[0]) - v1;
+            float t = b2Clamp(b2Dot(pLocal - v1, e) / b2Dot(e, e), 0.0f, 1.0f);
+            if (b2DistanceSquared(pLocal, v1 + t * e) <= rr)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     for (std::int32_t i = 0; i < m_count; ++i)
     {
         float dot = b2Dot(m_normals[i], pLocal - m_vertices[i]);
@@ -273,6 +315,68 @@ bool b2PolygonShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& inpu
     b2Vec2 p2 = b2MulT(xf.q, input.p2 - xf.p);
     b2Vec2 d = p2 - p1;
 
+    if (m_radius > b2_polygonRadius)
+    {
+        // A rounded polygon is the union of the core polygon pushed out along each edge
+        // normal and a circle at each vertex. The ray enters at the first entry point.
+        float fraction = FLT_MAX;
+        b2Vec2 normal(0.0f, 0.0f);
+
+        for (std::int32_t i = 0; i < m_count; ++i)
+        {
+            // dot(normal, p1 + t * d - v) = radius
+            float offset = b2Dot(m_normals[i], p1 - m_vertices[i]);
+            float denominator = b2Dot(m_normals[i], d);
+            if (offset <= m_radius || denominator >= 0.0f)
+            {
+                continue;
+            }
+
+            float t = (m_radius - offset) / denominator;
+            if (t > input.maxFraction || t >= fraction)
+            {
+                continue;
+            }
+
+            b2Vec2 v1 = m_vertices[i];
+            b2Vec2 e = (i + 1 < m_count ? m_vertices[i + 1] : m_vertices[0]) - v1;
+            float s = b2Dot(p1 + t * d - v1, e);
+            if (0.0f <= s && s <= b2Dot(e, e))
+            {
+                fraction = t;
+                normal = m_normals[i];
+            }
+        }
+
+        b2CircleShape circle;
+        circle.m_radius = m_radius;
+        b2Transform identity;
+        identity.SetIdentity();
+        b2RayCastInput localInput;
+        localInput.p1 = p1;
+        localInput.p2 = p2;
+        localInput.maxFraction = input.maxFraction;
+        for (std::int32_t i = 0; i < m_count; ++i)
+        {
+            circle.m_p = m_vertices[i];
+            b2RayCastOutput circleOutput;
+            if (circle.RayCast(&circleOutput, localInput, identity, 0) && circleOutput.fraction < fraction)
+            {
+                fraction = circleOutput.fraction;
+                normal = circleOutput.normal;
+            }
+        }
+
+        if (fraction == FLT_MAX)
+        {
+            return false;
+        }
+
+        output->fraction = fraction;
+        output->normal = b2Mul(xf.q, normal);
+        return true;
+    }
+
     float lower = 0.0f, upper = input.maxFraction;
 
     std::int32_t index = -1;
@@ -415,6 +519,44 @@ void b2PolygonShape::ComputeMass(b2MassData* massData, float density) const
         I += (0.25f * k_inv3 * D) * (intx2 + inty2);
     }
 
+    if (m_radius > b2_polygonRadius)
+    {
+        // Rounded polygon. Add a rectangle along each edge and a circular sector at each
+        // vertex. The sectors add up to a full circle.
+        float r = m_radius;
+        for (std::int32_t i = 0; i < m_count; ++i)
+        {
+            b2Vec2 v1 = m_vertices[i] - s;
+            b2Vec2 v2 = (i + 1 < m_count ? m_vertices[i + 1] : m_vertices[0]) - s;
+            b2Vec2 n = m_normals[i];
+            float length = b2Distance(v1, v2);
+
+            float rectangleArea = length * r;
+            b2Vec2 rectangleCenter = 0.5f * (v1 + v2) + 0.5f * r * n;
+            area += rectangleArea;
+            center += rectangleArea * rectangleCenter;
+            I += rectangleArea * ((length * length + r * r) / 12.0f + b2Dot(rectangleCenter, rectangleCenter));
+
+            // The sector at v1 spans from the previous normal to this normal.
+            b2Vec2 n0 = m_normals[i > 0 ? i - 1 : m_count - 1];
+            float angle = std::atan2(b2Cross(n0, n), b2Dot(n0, n));
+            float sectorArea = 0.5f * angle * r * r;
+            if (sectorArea <= 0.0f)
+            {
+                continue;
+            }
+
+            // The sector centroid lies on the bisector.
+            b2Vec2 bisector = n0 + n;
+            bisector.Normalize();
+            float offset = 4.0f * r * std::sin(0.5f * angle) / (3.0f * angle);
+            b2Vec2 sectorCenter = v1 + offset * bisector;
+            area += sectorArea;
+            center += sectorArea * sectorCenter;
+            I += sectorArea * (0.5f * r * r - offset * offset + b2Dot(sectorCenter, sectorCenter));
+        }
+    }
+
     // Total mass
     massData->mass = density * area;
 
@@ -0,0 +1,162 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_quantized_tree.h>
+#include <box2d/b2_dynamic_tree.h>
+
+// Initial guess for the number of steps from a bound of the parent to a bound of the child.
+static std::uint16_t b2Quantize(float distance, float step)
+{
+    if (step <= 0.0f)
+    {
+        return 0;
+    }
+
+    float q = b2Clamp(floorf(distance / step), 0.0f, 65535.0f);
+    return std::uint16_t(q);
+}
+
+b2QuantizedTree::b2QuantizedTree()
+{
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+    m_leaves = nullptr;
+    m_leafCount = 0;
+    m_bounds.lowerBound.SetZero();
+    m_bounds.upperBound.SetZero();
+    m_root = 0;
+}
+
+b2QuantizedTree::~b2QuantizedTree()
+{
+    Clear();
+}
+
+void b2QuantizedTree::Clear()
+{
+    b2Free(m_nodes);
+    b2Free(m_leaves);
+    m_nodes = nullptr;
+    m_nodeCount = 0;
+    m_leaves = nullptr;
+    m_leafCount = 0;
+    m_root = 0;
+}
+
+void b2QuantizedTree::Build(const b2DynamicTree& tree)
+{
+    Clear();
+
+    if (tree.m_root == b2_nullNode)
+    {
+        return;
+    }
+
+    // A binary tree with n leaves has n - 1 internal nodes.
+    std::int32_t leafCount = (tree.m_nodeCount + 1) / 2;
+    m_leaves = (Leaf*)b2Alloc(leafCount * sizeof(Leaf));
+    if (leafCount > 1)
+    {
+        m_nodes = (b2QuantizedNode*)b2Alloc((leafCount - 1) * sizeof(b2QuantizedNode));
+    }
+
+    // Nodes are stored depth first, so the first child of a node usually follows it in memory.
+    m_bounds = tree.m_nodes[tree.m_root].aabb;
+    m_root = BuildNode(tree, tree.m_root, m_bounds);
+
+    assert(m_leafCount == leafCount);
+    assert(m_nodeCount == leafCount - 1);
+}
+
+std::int32_t b2QuantizedTree::BuildNode(const b2DynamicTree& tree, std::int32_t sourceId, const b2AABB& aabb)
+{
+    const b2TreeNode* source = tree.m_nodes + sourceId;
+    if (source->IsLeaf())
+    {
+        std::int32_t leafId = m_leafCount++;
+        m_leaves[leafId].userData = source->userData;
+        m_leaves[leafId].proxyId = sourceId;
+        return ~leafId;
+    }
+
+    std::int32_t nodeId = m_nodeCount++;
+    b2QuantizedNode* node = m_nodes + nodeId;
+
+    const float scale = 1.0f / 65535.0f;
+    b2Vec2 step = scale * (aabb.upperBound - aabb.lowerBound);
+
+    std::int32_t sourceChildren[2] = {source->child1, source->child2};
+    for (std::int32_t i = 0; i < 2; ++i)
+    {
+        const b2AABB& target = tree.m_nodes[sourceChildren[i]].aabb;
+        assert(aabb.Contains(target));
+
+        node->lowerX[i] = b2Quantize(target.lowerBound.x - aabb.lowerBound.x, step.x);
+        node->lowerY[i] = b2Quantize(target.lowerBound.y - aabb.lowerBound.y, step.y);
+        node->upperX[i] = b2Quantize(aabb.upperBound.x - target.upperBound.x, step.x);
+        node->upperY[i] = b2Quantize(aabb.upperBound.y - target.upperBound.y, step.y);
+
+        // Round outward until the decoded bounds contain the source bounds. Zero steps
+        // decode to the bounds of this node, so this terminates.
+        b2AABB childAABB;
+        for (;;)
+        {
+            Decode(node, i, aabb, &childAABB);
+
+            bool contained = true;
+            if (childAABB.lowerBound.x > target.lowerBound.x)
+            {
+                --node->lowerX[i];
+                contained = false;
+            }
+            if (childAABB.lowerBound.y > target.lowerBound.y)
+            {
+                --node->lowerY[i];
+                contained = false;
+            }
+            if (childAABB.upperBound.x < target.upperBound.x)
+            {
+                --node->upperX[i];
+                contained = false;
+            }
+            if (childAABB.upperBound.y < target.upperBound.y)
+            {
+                --node->upperY[i];
+                contained = false;
+            }
+
+            if (contained)
+            {
+                break;
+            }
+        }
+
+        node->children[i] = BuildNode(tree, sourceChildren[i], childAABB);
+    }
+
+    return nodeId;
+}
+
+std::int32_t b2QuantizedTree::GetByteCount() const
+{
+    return std::int32_t(m_nodeCount * sizeof(b2QuantizedNode) + m_leafCount * sizeof(Leaf));
+}
@@ -0,0 +1,83 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_allocation_tracker.h>
+#include <box2d/b2_math.h>
+
+#include <cstring>
+
+b2AllocationTracker::b2AllocationTracker(b2Allocator* allocator)
+{
+    m_allocator = allocator;
+    memset(&m_stats, 0, sizeof(b2AllocationStats));
+    m_check = false;
+}
+
+void* b2AllocationTracker::Allocate(std::size_t size, b2AllocationCategory category)
+{
+    assert(0 <= category && category < b2_allocationCategoryCount);
+
+    if (m_check)
+    {
+        // A checked time step used the heap. The stats tell which subsystem.
+        ++m_stats.checkedAllocationCount;
+        assert(false);
+    }
+
+    b2AllocationCounter& counter = m_stats.categories[category];
+    ++counter.allocationCount;
+    counter.bytes += size;
+    counter.totalBytes += size;
+    counter.peakBytes = b2Max(counter.peakBytes, counter.bytes);
+
+    if (m_allocator)
+    {
+        void* mem = m_allocator->Allocate(size);
+        assert(mem != nullptr);
+        return mem;
+    }
+
+    return b2Alloc(size);
+}
+
+void b2AllocationTracker::Free(void* mem, std::size_t size, b2AllocationCategory category)
+{
+    assert(0 <= category && category < b2_allocationCategoryCount);
+
+    if (mem == nullptr)
+    {
+        return;
+    }
+
+    b2AllocationCounter& counter = m_stats.categories[category];
+    assert(counter.bytes >= size);
+    ++counter.freeCount;
+    counter.bytes -= size;
+
+    if (m_allocator)
+    {
+        m_allocator->Free(mem, size);
+        return;
+    }
+
+    b2Free(mem);
+}
@@ -21,6 +21,9 @@
 // SOFTWARE.
 
 #include <box2d/b2_block_allocator.h>
+#include <box2d/b2_shared_block_allocator.h>
+
+#include <algorithm>
 #include <climits>
 #include <cstring>
 #include <cstddef>
@@ -29,6 +32,10 @@ static constexpr std::int32_t b2_chunkSize = 16 * 1024;
 static constexpr std::int32_t b2_maxBlockSize = 640;
 static constexpr std::size_t b2_chunkArrayIncrement = 128;
 
+// A b2BlockCache takes this many blocks from the shared pool at once. It gives half
+// of a free list back once the list holds twice this many.
+static constexpr std::int32_t b2_blockCacheBatch = 32;
+
 // These are the supported object sizes. Actual allocations are rounded up the next size.
 static constexpr std::int32_t b2_blockSizes[b2_blockSizeCount] =
     {
@@ -86,26 +93,33 @@ struct b2Block
     b2Block* next;
 };
 
-b2BlockAllocator::b2BlockAllocator()
+b2BlockAllocator::b2BlockAllocator(b2AllocationTracker* tracker)
 {
     assert(b2_blockSizeCount < UCHAR_MAX);
 
+    m_tracker = tracker;
+
     m_chunkSpace = b2_chunkArrayIncrement;
     m_chunkCount = 0;
-    m_chunks = (b2Chunk*)b2Alloc(static_cast<std::int32_t> (m_chunkSpace * sizeof(b2Chunk)));
+    m_spareChunkCount = 0;
+    m_chunks = (b2Chunk*)b2TrackedAlloc(m_tracker, m_chunkSpace * sizeof(b2Chunk), b2_blockAllocation);
 
     memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
     memset(m_freeLists.data(), 0, m_freeLists.size() * sizeof(b2Block *));
+    m_freeCounts.fill(0);
+
+    m_largeCount = 0;
+    m_largeBytes = 0;
 }
 
 b2BlockAllocator::~b2BlockAllocator()
 {
-    for (std::int32_t i = 0; i < m_chunkCount; ++i)
+    for (std::int32_t i = 0; i < m_chunkCount + m_spareChunkCount; ++i)
     {
-        b2Free(m_chunks[i].blocks);
+        b2TrackedFree(m_tracker, m_chunks[i].blocks, b2_chunkSize, b2_blockAllocation);
     }
 
-    b2Free(m_chunks);
+    b2TrackedFree(m_tracker, m_chunks, m_chunkSpace * sizeof(b2Chunk), b2_blockAllocation);
 }
 
 void* b2BlockAllocator::HandleAllocate(std::size_t size)
@@ -119,53 +133,74 @@ void* b2BlockAllocator::HandleAllocate(std::size_t size)
 
     if (size > b2_maxBlockSize)
     {
-        return b2Alloc(size);
+        ++m_largeCount;
+        m_largeBytes += size;
+        return b2TrackedAlloc(m_tracker, size, b2_blockAllocation);
     }
 
     std::int32_t index = b2_sizeMap.values[size];
     assert(0 <= index && index < b2_blockSizeCount);
 
-    if (m_freeLists[index])
+    if (m_freeLists[index] == nullptr)
     {
-        b2Block* block = m_freeLists[index];
-        m_freeLists[index] = block->next;
-        return block;
+        AllocateChunk(index);
     }
-    else
-    {
-        if (m_chunkCount == m_chunkSpace)
-        {
-            b2Chunk* oldChunks = m_chunks;
-            m_chunkSpace += b2_chunkArrayIncrement;
-            m_chunks = (b2Chunk*)b2Alloc(static_cast<std::int32_t>(m_chunkSpace * sizeof(b2Chunk)));
-            memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
-            memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
-            b2Free(oldChunks);
-        }
 
-        b2Chunk* chunk = m_chunks + m_chunkCount;
-        chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
-#if defined(_DEBUG)
-        memset(chunk->blocks, 0xcd, b2_chunkSize);
-#endif
-        std::int32_t blockSize = b2_blockSizes[index];
-        chunk->blockSize = blockSize;
-        std::int32_t blockCount = b2_chunkSize / blockSize;
-        assert(blockCount * blockSize <= b2_chunkSize);
-        for (std::int32_t i = 0; i < blockCount - 1; ++i)
-        {
-            b2Block* block = (b2Block*)((std::int8_t*)chunk->blocks + blockSize * i);
-            b2Block* next = (b2Block*)((std::int8_t*)chunk->blocks + blockSize * (i + 1));
-            block->next = next;
-        }
-        b2Block* last = (b2Block*)((std::int8_t*)chunk->blocks + blockSize * (blockCount - 1));
-        last->next = nullptr;
+    b2Block* block = m_freeLists[index];
+    m_freeLists[index] = block->next;
+    --m_freeCounts[index];
+    return block;
+}
 
-        m_freeLists[index] = chunk->blocks->next;
+void b2BlockAllocator::AllocateChunk(std::int32_t index)
+{
+    b2Chunk* chunk = m_chunks + m_chunkCount;
+    if (m_spareChunkCount > 0)
+    {
+        // Chunks have the same size for all block sizes, so a spare chunk fits any.
+        --m_spareChunkCount;
+        FormatChunk(chunk, index);
         ++m_chunkCount;
+        return;
+    }
 
-        return chunk->blocks;
+    if (m_chunkCount == m_chunkSpace)
+    {
+        b2Chunk* oldChunks = m_chunks;
+        std::size_t oldSpace = m_chunkSpace;
+        m_chunkSpace += b2_chunkArrayIncrement;
+        m_chunks = (b2Chunk*)b2TrackedAlloc(m_tracker, m_chunkSpace * sizeof(b2Chunk), b2_blockAllocation);
+        memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
+        memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
+        b2TrackedFree(m_tracker, oldChunks, oldSpace * sizeof(b2Chunk), b2_blockAllocation);
+        chunk = m_chunks + m_chunkCount;
     }
+
+    chunk->blocks = (b2Block*)b2TrackedAlloc(m_tracker, b2_chunkSize, b2_blockAllocation);
+    FormatChunk(chunk, index);
+    ++m_chunkCount;
+}
+
+void b2BlockAllocator::FormatChunk(b2Chunk* chunk, std::int32_t index)
+{
+#if defined(_DEBUG)
+    memset(chunk->blocks, 0xcd, b2_chunkSize);
+#endif
+    std::int32_t blockSize = b2_blockSizes[index];
+    chunk->blockSize = blockSize;
+    std::int32_t blockCount = b2_chunkSize / blockSize;
+    assert(blockCount * blockSize <= b2_chunkSize);
+    for (std::int32_t i = 0; i < blockCount - 1; ++i)
+    {
+        b2Block* block = (b2Block*)((std::int8_t*)chunk->blocks + blockSize * i);
+        b2Block* next = (b2Block*)((std::int8_t*)chunk->blocks + blockSize * (i + 1));
+        block->next = next;
+    }
+    b2Block* last = (b2Block*)((std::int8_t*)chunk->blocks + blockSize * (blockCount - 1));
+    last->next = m_freeLists[index];
+
+    m_freeLists[index] = chunk->blocks;
+    m_freeCounts[index] += blockCount;
 }
 
 void b2BlockAllocator::HandleFree(void *p, std::size_t size)
@@ -179,7 +214,10 @@ void b2BlockAllocator::HandleFree(void *p, std::size_t size)
 
     if (size > b2_maxBlockSize)
     {
-        b2Free(p);
+        assert(m_largeCount > 0 && m_largeBytes >= size);
+        --m_largeCount;
+        m_largeBytes -= size;
+        b2TrackedFree(m_tracker, p, size, b2_blockAllocation);
         return;
     }
 
@@ -215,16 +253,378 @@ void b2BlockAllocator::HandleFree(void *p, std::size_t size)
     b2Block* block = (b2Block*)p;
     block->next = m_freeLists[index];
     m_freeLists[index] = block;
+    ++m_freeCounts[index];
 }
 
 void b2BlockAllocator::Clear()
 {
-    for (std::int32_t i = 0; i < m_chunkCount; ++i)
+    for (std::int32_t i = 0; i < m_chunkCount + m_spareChunkCount; ++i)
     {
-        b2Free(m_chunks[i].blocks);
+        b2TrackedFree(m_tracker, m_chunks[i].blocks, b2_chunkSize, b2_blockAllocation);
     }
 
     m_chunkCount = 0;
+    m_spareChunkCount = 0;
     memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
     memset(m_freeLists.data(), 0, m_freeLists.size() * sizeof(b2Block *));
+    m_freeCounts.fill(0);
+}
+
+void b2BlockAllocator::Reset()
+{
+    // Large allocations are not tracked by address and cannot be discarded.
+    assert(m_largeCount == 0);
+
+    // Keep the chunks as spares. They are formatted again on demand.
+    m_spareChunkCount += m_chunkCount;
+    m_chunkCount = 0;
+    memset(m_freeLists.data(), 0, m_freeLists.size() * sizeof(b2Block *));
+    m_freeCounts.fill(0);
+}
+
+void b2BlockAllocator::Reserve(std::size_t size, std::int32_t count)
+{
+    assert(0 < size && size <= b2_maxBlockSize);
+    if (size == 0 || size > b2_maxBlockSize)
+    {
+        return;
+    }
+
+    std::int32_t index = b2_sizeMap.values[size];
+    while (m_freeCounts[index] < count)
+    {
+        AllocateChunk(index);
+    }
+}
+
+// Sorts chunk indices by address, so a block can be mapped to its chunk with a binary search.
+struct b2ChunkOrder
+{
+    bool operator()(std::int32_t a, std::int32_t b) const
+    {
+        return chunks[a].blocks < chunks[b].blocks;
+    }
+
+    const b2Chunk* chunks;
+};
+
+// Find the chunk of a block given the chunk indices sorted by address.
+static std::int32_t b2FindChunk(const b2Chunk* chunks, const std::int32_t* order, std::int32_t count, const b2Block* block)
+{
+    // Last chunk that starts at or before the block.
+    std::int32_t lower = 0;
+    std::int32_t upper = count;
+    while (upper - lower > 1)
+    {
+        std::int32_t mid = (lower + upper) / 2;
+        if ((const std::int8_t*)chunks[order[mid]].blocks <= (const std::int8_t*)block)
+        {
+            lower = mid;
+        }
+        else
+        {
+            upper = mid;
+        }
+    }
+
+    return order[lower];
+}
+
+std::int32_t* b2BlockAllocator::CountFreeBlocks() const
+{
+    // Chunk indices sorted by address followed by the free block count of each chunk.
+    std::int32_t* order = (std::int32_t*)b2TrackedAlloc(m_tracker, 2 * m_chunkCount * sizeof(std::int32_t), b2_blockAllocation);
+    std::int32_t* counts = order + m_chunkCount;
+    for (std::int32_t i = 0; i < m_chunkCount; ++i)
+    {
+        order[i] = i;
+        counts[i] = 0;
+    }
+    std::sort(order, order + m_chunkCount, b2ChunkOrder{m_chunks});
+
+    for (std::int32_t index = 0; index < b2_blockSizeCount; ++index)
+    {
+        for (b2Block* block = m_freeLists[index]; block; block = block->next)
+        {
+            std::int32_t chunkIndex = b2FindChunk(m_chunks, order, m_chunkCount, block);
+            assert((std::int8_t*)m_chunks[chunkIndex].blocks <= (std::int8_t*)block);
+            assert((std::int8_t*)block < (std::int8_t*)m_chunks[chunkIndex].blocks + b2_chunkSize);
+            ++counts[chunkIndex];
+        }
+    }
+
+    return order;
+}
+
+std::int32_t b2BlockAllocator::Trim()
+{
+    std::int32_t spareCount = m_spareChunkCount;
+    for (std::int32_t i = m_chunkCount; i < m_chunkCount + m_spareChunkCount; ++i)
+    {
+        b2TrackedFree(m_tracker, m_chunks[i].blocks, b2_chunkSize, b2_blockAllocation);
+    }
+    memset(m_chunks + m_chunkCount, 0, m_spareChunkCount * sizeof(b2Chunk));
+    m_spareChunkCount = 0;
+
+    if (m_chunkCount == 0)
+    {
+        return spareCount;
+    }
+
+    std::int32_t chunkCount = m_chunkCount;
+    std::int32_t* order = CountFreeBlocks();
+    const std::int32_t* counts = order + chunkCount;
+
+    // Mark the chunks without live blocks by clearing their block size.
+    std::int32_t releaseCount = 0;
+    for (std::int32_t i = 0; i < m_chunkCount; ++i)
+    {
+        if (counts[i] == b2_chunkSize / m_chunks[i].blockSize)
+        {
+            m_chunks[i].blockSize = 0;
+            ++releaseCount;
+        }
+    }
+
+    if (releaseCount > 0)
+    {
+        // Drop the blocks of released chunks from the free lists.
+        for (std::int32_t index = 0; index < b2_blockSizeCount; ++index)
+        {
+            b2Block** link = &m_freeLists[index];
+            while (*link)
+            {
+                b2Block* block = *link;
+                std::int32_t chunkIndex = b2FindChunk(m_chunks, order, m_chunkCount, block);
+                if (m_chunks[chunkIndex].blockSize == 0)
+                {
+                    *link = block->next;
+                    --m_freeCounts[index];
+                }
+                else
+                {
+                    link = &block->next;
+                }
+            }
+        }
+
+        // Free the chunks and compact the chunk array.
+        std::int32_t count = 0;
+        for (std::int32_t i = 0; i < m_chunkCount; ++i)
+        {
+            if (m_chunks[i].blockSize == 0)
+            {
+                b2TrackedFree(m_tracker, m_chunks[i].blocks, b2_chunkSize, b2_blockAllocation);
+                continue;
+            }
+
+            m_chunks[count++] = m_chunks[i];
+        }
+
+        memset(m_chunks + count, 0, (m_chunkCount - count) * sizeof(b2Chunk));
+        m_chunkCount = count;
+    }
+
+    b2TrackedFree(m_tracker, order, 2 * chunkCount * sizeof(std::int32_t), b2_blockAllocation);
+    return releaseCount + spareCount;
+}
+
+void b2BlockAllocator::GetStats(b2BlockAllocatorStats* stats) const
+{
+    memset(stats, 0, sizeof(b2BlockAllocatorStats));
+
+    for (std::int32_t index = 0; index < b2_blockSizeCount; ++index)
+    {
+        stats->sizes[index].blockSize = b2_blockSizes[index];
+        stats->sizes[index].freeBlockCount = m_freeCounts[index];
+    }
+
+    stats->largeCount = m_largeCount;
+    stats->largeBytes = m_largeBytes;
+    stats->spareChunkCount = m_spareChunkCount;
+    stats->chunkBytes = (m_chunkCount + m_spareChunkCount) * std::size_t(b2_chunkSize);
+
+    if (m_chunkCount == 0)
+    {
+        return;
+    }
+
+    std::int32_t* order = CountFreeBlocks();
+    const std::int32_t* counts = order + m_chunkCount;
+
+    for (std::int32_t i = 0; i < m_chunkCount; ++i)
+    {
+        std::int32_t index = b2_sizeMap.values[m_chunks[i].blockSize];
+        b2BlockSizeStats& sizeStats = stats->sizes[index];
+        std::int32_t blockCount = b2_chunkSize / m_chunks[i].blockSize;
+
+        ++sizeStats.chunkCount;
+        sizeStats.liveBlockCount += blockCount - counts[i];
+        if (counts[i] == blockCount)
+        {
+            ++sizeStats.freeChunkCount;
+        }
+    }
+
+    b2TrackedFree(m_tracker, order, 2 * m_chunkCount * sizeof(std::int32_t), b2_blockAllocation);
+
+    for (std::int32_t index = 0; index < b2_blockSizeCount; ++index)
+    {
+        b2BlockSizeStats& sizeStats = stats->sizes[index];
+        if (sizeStats.chunkCount == 0)
+        {
+            continue;
+        }
+
+        // Free blocks that Trim cannot release because their chunk has live blocks.
+        std::int32_t blockCount = sizeStats.chunkCount * (b2_chunkSize / sizeStats.blockSize);
+        std::int32_t freeChunkBlocks = sizeStats.freeChunkCount * (b2_chunkSize / sizeStats.blockSize);
+        sizeStats.fragmentation = float(sizeStats.freeBlockCount - freeChunkBlocks) / float(blockCount);
+    }
+
+    stats->chunkCount = m_chunkCount;
+}
+
+b2SharedBlockAllocator::b2SharedBlockAllocator(b2AllocationTracker* tracker)
+    : m_allocator(tracker)
+{
+}
+
+b2SharedBlockAllocator::~b2SharedBlockAllocator()
+{
+}
+
+b2Block* b2SharedBlockAllocator::Acquire(std::int32_t index, std::int32_t count)
+{
+    assert(0 <= index && index < b2_blockSizeCount);
+    std::size_t blockSize = b2_blockSizes[index];
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    b2Block* list = nullptr;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        b2Block* block = (b2Block*)m_allocator.HandleAllocate(blockSize);
+        block->next = list;
+        list = block;
+    }
+
+    return list;
+}
+
+void b2SharedBlockAllocator::Release(std::int32_t index, b2Block* list)
+{
+    assert(0 <= index && index < b2_blockSizeCount);
+    std::size_t blockSize = b2_blockSizes[index];
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    while (list)
+    {
+        b2Block* next = list->next;
+        m_allocator.HandleFree(list, blockSize);
+        list = next;
+    }
+}
+
+void* b2SharedBlockAllocator::AllocateLarge(std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocator.HandleAllocate(size);
+}
+
+void b2SharedBlockAllocator::FreeLarge(void* p, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocator.HandleFree(p, size);
+}
+
+b2BlockCache::b2BlockCache(b2SharedBlockAllocator* allocator)
+{
+    m_allocator = allocator;
+    m_freeLists.fill(nullptr);
+    m_counts.fill(0);
+}
+
+b2BlockCache::~b2BlockCache()
+{
+    Flush();
+}
+
+void* b2BlockCache::HandleAllocate(std::size_t size)
+{
+    if (size == 0)
+    {
+        return nullptr;
+    }
+
+    if (size > b2_maxBlockSize)
+    {
+        return m_allocator->AllocateLarge(size);
+    }
+
+    std::int32_t index = b2_sizeMap.values[size];
+    assert(0 <= index && index < b2_blockSizeCount);
+
+    if (m_freeLists[index] == nullptr)
+    {
+        m_freeLists[index] = m_allocator->Acquire(index, b2_blockCacheBatch);
+        m_counts[index] = b2_blockCacheBatch;
+    }
+
+    b2Block* block = m_freeLists[index];
+    m_freeLists[index] = block->next;
+    --m_counts[index];
+    return block;
+}
+
+void b2BlockCache::HandleFree(void* p, std::size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (size > b2_maxBlockSize)
+    {
+        m_allocator->FreeLarge(p, size);
+        return;
+    }
+
+    std::int32_t index = b2_sizeMap.values[size];
+    assert(0 <= index && index < b2_blockSizeCount);
+
+    b2Block* block = (b2Block*)p;
+    block->next = m_freeLists[index];
+    m_freeLists[index] = block;
+    ++m_counts[index];
+
+    // Keep a batch for the next allocations and return the rest in one go. This
+    // bounds the memory a thread can hold when it frees what others allocated.
+    if (m_counts[index] >= 2 * b2_blockCacheBatch)
+    {
+        b2Block* last = m_freeLists[index];
+        for (std::int32_t i = 1; i < b2_blockCacheBatch; ++i)
+        {
+            last = last->next;
+        }
+
+        b2Block* rest = last->next;
+        last->next = nullptr;
+        m_counts[index] = b2_blockCacheBatch;
+        m_allocator->Release(index, rest);
+    }
+}
+
+void b2BlockCache::Flush()
+{
+    for (std::int32_t i = 0; i < b2_blockSizeCount; ++i)
+    {
+        if (m_freeLists[i])
+        {
+            m_allocator->Release(i, m_freeLists[i]);
+            m_freeLists[i] = nullptr;
+            m_counts[i] = 0;
+        }
+    }
 }
@@ -0,0 +1,123 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_handle_pool.h>
+
+#include <cstring>
+
+static constexpr std::int32_t b2_initialHandleCapacity = 16;
+static constexpr std::int32_t b2_nullSlot = -1;
+
+// Skip zero on wrap around so a zero initialized handle stays invalid.
+static inline std::uint32_t b2NextGeneration(std::uint32_t generation)
+{
+    ++generation;
+    return generation != 0 ? generation : 1;
+}
+
+b2HandlePool::b2HandlePool(b2AllocationTracker* tracker)
+{
+    m_tracker = tracker;
+    m_slots = nullptr;
+    m_capacity = 0;
+    m_count = 0;
+    m_freeList = b2_nullSlot;
+    Grow();
+}
+
+b2HandlePool::~b2HandlePool()
+{
+    b2TrackedFree(m_tracker, m_slots, m_capacity * sizeof(b2HandleSlot), b2_handleAllocation);
+}
+
+void b2HandlePool::Grow()
+{
+    b2HandleSlot* oldSlots = m_slots;
+    std::int32_t oldCapacity = m_capacity;
+    m_capacity = oldSlots ? 2 * oldCapacity : b2_initialHandleCapacity;
+    m_slots = (b2HandleSlot*)b2TrackedAlloc(m_tracker, m_capacity * sizeof(b2HandleSlot), b2_handleAllocation);
+    if (oldSlots)
+    {
+        memcpy(m_slots, oldSlots, oldCapacity * sizeof(b2HandleSlot));
+        b2TrackedFree(m_tracker, oldSlots, oldCapacity * sizeof(b2HandleSlot), b2_handleAllocation);
+    }
+
+    // Link the new slots into the free list, lowest index first.
+    for (std::int32_t i = oldCapacity; i < m_capacity; ++i)
+    {
+        m_slots[i].object = nullptr;
+        m_slots[i].generation = 1;
+        m_slots[i].next = i + 1 < m_capacity ? i + 1 : m_freeList;
+    }
+    m_freeList = oldCapacity;
+}
+
+std::int32_t b2HandlePool::Allocate(void* object)
+{
+    assert(object != nullptr);
+
+    if (m_freeList == b2_nullSlot)
+    {
+        Grow();
+    }
+
+    std::int32_t index = m_freeList;
+    b2HandleSlot& slot = m_slots[index];
+    m_freeList = slot.next;
+    slot.object = object;
+    slot.next = b2_nullSlot;
+    ++m_count;
+    return index;
+}
+
+void b2HandlePool::Free(std::int32_t index)
+{
+    assert(0 <= index && index < m_capacity);
+    b2HandleSlot& slot = m_slots[index];
+    assert(slot.object != nullptr);
+
+    slot.object = nullptr;
+    slot.generation = b2NextGeneration(slot.generation);
+    slot.next = m_freeList;
+    m_freeList = index;
+    --m_count;
+}
+
+void b2HandlePool::Reset()
+{
+    // Walk backwards so the lowest index is reused first, as after Grow.
+    m_freeList = b2_nullSlot;
+    for (std::int32_t i = m_capacity - 1; i >= 0; --i)
+    {
+        b2HandleSlot& slot = m_slots[i];
+        if (slot.object != nullptr)
+        {
+            slot.object = nullptr;
+            slot.generation = b2NextGeneration(slot.generation);
+        }
+
+        slot.next = m_freeList;
+        m_freeList = i;
+    }
+
+    m_count = 0;
+}
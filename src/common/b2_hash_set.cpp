@@ -0,0 +1,158 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <box2d/b2_hash_set.h>
+
+#include <cstring>
+
+// Capacity must be a power of two.
+static constexpr std::int32_t b2_initialHashSetCapacity = 256;
+
+static inline std::uint32_t b2KeyHash(const b2PairKey& key)
+{
+    // Murmur3 finalizer
+    std::uint64_t h = key.id1 ^ (key.id2 * 0x9e3779b97f4a7c15ull);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return static_cast<std::uint32_t>(h);
+}
+
+b2HashSet::b2HashSet(b2AllocationTracker* tracker, b2AllocationCategory category)
+{
+    m_tracker = tracker;
+    m_category = category;
+    m_capacity = b2_initialHashSetCapacity;
+    m_count = 0;
+    m_keys = (b2PairKey*)b2TrackedAlloc(m_tracker, m_capacity * sizeof(b2PairKey), m_category);
+    memset(m_keys, 0, m_capacity * sizeof(b2PairKey));
+}
+
+b2HashSet::~b2HashSet()
+{
+    b2TrackedFree(m_tracker, m_keys, m_capacity * sizeof(b2PairKey), m_category);
+}
+
+std::int32_t b2HashSet::FindSlot(const b2PairKey& key) const
+{
+    std::uint32_t mask = m_capacity - 1;
+    std::uint32_t index = b2KeyHash(key) & mask;
+    while (m_keys[index].id1 != 0 && (m_keys[index] == key) == false)
+    {
+        index = (index + 1) & mask;
+    }
+
+    return index;
+}
+
+void b2HashSet::Grow()
+{
+    b2PairKey* oldKeys = m_keys;
+    std::int32_t oldCapacity = m_capacity;
+
+    m_capacity *= 2;
+    m_keys = (b2PairKey*)b2TrackedAlloc(m_tracker, m_capacity * sizeof(b2PairKey), m_category);
+    memset(m_keys, 0, m_capacity * sizeof(b2PairKey));
+
+    for (std::int32_t i = 0; i < oldCapacity; ++i)
+    {
+        if (oldKeys[i].id1 != 0)
+        {
+            m_keys[FindSlot(oldKeys[i])] = oldKeys[i];
+        }
+    }
+
+    b2TrackedFree(m_tracker, oldKeys, oldCapacity * sizeof(b2PairKey), m_category);
+}
+
+bool b2HashSet::Add(const b2PairKey& key)
+{
+    assert(key.id1 != 0);
+
+    std::int32_t index = FindSlot(key);
+    if (m_keys[index] == key)
+    {
+        return true;
+    }
+
+    // Keep the load factor at or below one half.
+    if (2 * (m_count + 1) > m_capacity)
+    {
+        Grow();
+        index = FindSlot(key);
+    }
+
+    m_keys[index] = key;
+    ++m_count;
+    return false;
+}
+
+bool b2HashSet::Remove(const b2PairKey& key)
+{
+    assert(key.id1 != 0);
+
+    std::int32_t index = FindSlot(key);
+    if (m_keys[index].id1 == 0)
+    {
+        return false;
+    }
+
+    // Shift following keys back into the hole until the probe chain ends.
+    std::uint32_t mask = m_capacity - 1;
+    std::uint32_t hole = index;
+    std::uint32_t i = hole;
+    for (;;)
+    {
+        i = (i + 1) & mask;
+        if (m_keys[i].id1 == 0)
+        {
+            break;
+        }
+
+        // A key may move into the hole if its home slot is not in (hole, i].
+        std::uint32_t home = b2KeyHash(m_keys[i]) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            m_keys[hole] = m_keys[i];
+            hole = i;
+        }
+    }
+
+    m_keys[hole].id1 = 0;
+    m_keys[hole].id2 = 0;
+    --m_count;
+    return true;
+}
+
+bool b2HashSet::Contains(const b2PairKey& key) const
+{
+    assert(key.id1 != 0);
+    return m_keys[FindSlot(key)] == key;
+}
+
+void b2HashSet::Clear()
+{
+    memset(m_keys, 0, m_capacity * sizeof(b2PairKey));
+    m_count = 0;
+}
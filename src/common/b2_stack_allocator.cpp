@@ -23,34 +23,61 @@
 #include <box2d/b2_stack_allocator.h>
 #include <box2d/b2_math.h>
 
-b2StackAllocator::b2StackAllocator()
+#include <cstddef>
+
+// Sizes are rounded up to this, so that an allocation after an odd sized one, or after
+// one that fell back to the heap, is still aligned for any type.
+static constexpr std::size_t b2_stackAlignment = alignof(std::max_align_t);
+
+b2StackAllocator::b2StackAllocator(b2AllocationTracker* tracker)
 {
+    m_tracker = tracker;
+    m_capacity = b2_stackSize;
+    m_data = (char*)b2TrackedAlloc(m_tracker, m_capacity, b2_stackAllocation);
     m_index = 0;
     m_allocation = 0;
     m_maxAllocation = 0;
     m_entryCount = 0;
+    m_heapAllocationCount = 0;
 }
 
 b2StackAllocator::~b2StackAllocator()
 {
     assert(m_index == 0);
     assert(m_entryCount == 0);
+    b2TrackedFree(m_tracker, m_data, m_capacity, b2_stackAllocation);
+}
+
+void b2StackAllocator::Reserve(std::size_t size)
+{
+    assert(m_entryCount == 0);
+    if (size <= m_capacity)
+    {
+        return;
+    }
+
+    b2TrackedFree(m_tracker, m_data, m_capacity, b2_stackAllocation);
+    m_capacity = size;
+    m_data = (char*)b2TrackedAlloc(m_tracker, m_capacity, b2_stackAllocation);
 }
 
 void* b2StackAllocator::HandleAllocate(std::size_t size)
 {
     assert(m_entryCount < b2_maxStackEntries);
 
+    size = (size + b2_stackAlignment - 1) & ~(b2_stackAlignment - 1);
+
     b2StackEntry* entry = m_entries.data() + m_entryCount;
     entry->size = size;
-    if (m_index + size > b2_stackSize)
+    if (m_index + size > m_capacity)
     {
-        entry->data = (char*)b2Alloc(size);
+        entry->data = (char*)b2TrackedAlloc(m_tracker, size, b2_stackAllocation);
         entry->usedMalloc = true;
+        ++m_heapAllocationCount;
     }
     else
     {
-        entry->data = m_data.data() + m_index;
+        entry->data = m_data + m_index;
         entry->usedMalloc = false;
         m_index += size;
     }
@@ -69,7 +96,7 @@ void b2StackAllocator::HandleFree(void* p)
     assert(p == entry->data);
     if (entry->usedMalloc)
     {
-        b2Free(p);
+        b2TrackedFree(m_tracker, p, entry->size, b2_stackAllocation);
     }
     else
     {
@@ -78,6 +105,13 @@ void b2StackAllocator::HandleFree(void* p)
     m_allocation -= entry->size;
     --m_entryCount;
 
+    // Nothing points into the arena now, so it is safe to grow it to the high water mark.
+    // Grow geometrically to avoid a reallocation each time the peak creeps up.
+    if (m_entryCount == 0 && m_maxAllocation > m_capacity)
+    {
+        Reserve(b2Max(m_maxAllocation, m_capacity + m_capacity / 2));
+    }
+
     p = nullptr;
 }
 
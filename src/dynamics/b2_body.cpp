@@ -24,11 +24,12 @@
 #include <box2d/b2_contact.h>
 #include <box2d/b2_fixture.h>
 #include <box2d/b2_joint.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_world.h>
 
 #include <new>
 
-b2Body::b2Body(const b2BodyDef* bd, b2World* world)
+b2Body::b2Body(const b2BodyDef* bd, b2World* world, b2BodySim* sim)
 {
     assert(bd->position.IsValid());
     assert(bd->linearVelocity.IsValid());
@@ -37,70 +38,75 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
     assert(b2IsValid(bd->angularDamping) && bd->angularDamping >= 0.0f);
     assert(b2IsValid(bd->linearDamping) && bd->linearDamping >= 0.0f);
 
-    m_flags = 0;
+    m_sim = sim;
+    m_sim->flags = 0;
 
     if (bd->bullet)
     {
-        m_flags |= e_bulletFlag;
+        m_sim->flags |= e_bulletFlag;
     }
     if (bd->fixedRotation)
     {
-        m_flags |= e_fixedRotationFlag;
+        m_sim->flags |= e_fixedRotationFlag;
     }
     if (bd->allowSleep)
     {
-        m_flags |= e_autoSleepFlag;
+        m_sim->flags |= e_autoSleepFlag;
     }
     if (bd->awake && bd->type != b2_staticBody)
     {
-        m_flags |= e_awakeFlag;
+        m_sim->flags |= e_awakeFlag;
     }
     if (bd->enabled)
     {
-        m_flags |= e_enabledFlag;
+        m_sim->flags |= e_enabledFlag;
     }
 
     m_world = world;
 
-    m_xf.p = bd->position;
-    m_xf.q.Set(bd->angle);
+    m_sim->xf.p = bd->position;
+    m_sim->xf.q.Set(bd->angle);
 
-    m_sweep.localCenter.SetZero();
-    m_sweep.c0 = m_xf.p;
-    m_sweep.c = m_xf.p;
-    m_sweep.a0 = bd->angle;
-    m_sweep.a = bd->angle;
-    m_sweep.alpha0 = 0.0f;
+    m_sim->sweep.localCenter.SetZero();
+    m_sim->sweep.c0 = m_sim->xf.p;
+    m_sim->sweep.c = m_sim->xf.p;
+    m_sim->sweep.a0 = bd->angle;
+    m_sim->sweep.a = bd->angle;
+    m_sim->sweep.alpha0 = 0.0f;
 
     m_jointList = nullptr;
     m_contactList = nullptr;
     m_prev = nullptr;
     m_next = nullptr;
 
-    m_linearVelocity = bd->linearVelocity;
-    m_angularVelocity = bd->angularVelocity;
+    m_sim->linearVelocity = bd->linearVelocity;
+    m_sim->angularVelocity = bd->angularVelocity;
 
-    m_linearDamping = bd->linearDamping;
-    m_angularDamping = bd->angularDamping;
-    m_gravityScale = bd->gravityScale;
+    m_sim->linearDamping = bd->linearDamping;
+    m_sim->angularDamping = bd->angularDamping;
+    m_sim->gravityScale = bd->gravityScale;
 
-    m_force.SetZero();
-    m_torque = 0.0f;
+    m_sim->force.SetZero();
+    m_sim->torque = 0.0f;
 
-    m_sleepTime = 0.0f;
+    m_sim->sleepTime = 0.0f;
 
     m_type = bd->type;
 
-    m_mass = 0.0f;
-    m_invMass = 0.0f;
+    m_sim->mass = 0.0f;
+    m_sim->invMass = 0.0f;
 
     m_I = 0.0f;
-    m_invI = 0.0f;
+    m_sim->invI = 0.0f;
 
     m_userData = bd->userData;
 
     m_fixtureList = nullptr;
     m_fixtureCount = 0;
+
+    m_syncTransform = m_sim->xf;
+    m_syncSlack = -1.0f;
+    m_fixtureExtent = 0.0f;
 }
 
 b2Body::~b2Body()
@@ -116,6 +122,11 @@ void b2Body::SetType(b2BodyType type)
         return;
     }
 
+    if (m_world->m_recorder != nullptr)
+    {
+        m_world->m_recorder->RecordInput(this, b2_replaySetType, b2Vec2_zero, float(type), false);
+    }
+
     if (m_type == type)
     {
         return;
@@ -127,18 +138,18 @@ void b2Body::SetType(b2BodyType type)
 
     if (m_type == b2_staticBody)
     {
-        m_linearVelocity.SetZero();
-        m_angularVelocity = 0.0f;
-        m_sweep.a0 = m_sweep.a;
-        m_sweep.c0 = m_sweep.c;
-        m_flags &= ~e_awakeFlag;
+        m_sim->linearVelocity.SetZero();
+        m_sim->angularVelocity = 0.0f;
+        m_sim->sweep.a0 = m_sim->sweep.a;
+        m_sim->sweep.c0 = m_sim->sweep.c;
+        m_sim->flags &= ~e_awakeFlag;
         SynchronizeFixtures();
     }
 
     SetAwake(true);
 
-    m_force.SetZero();
-    m_torque = 0.0f;
+    m_sim->force.SetZero();
+    m_sim->torque = 0.0f;
 
     // Delete the attached contacts.
     b2ContactEdge* ce = m_contactList;
@@ -175,17 +186,23 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
     auto* memory = allocator->Allocate<b2Fixture>();
     b2Fixture* fixture = new (memory) b2Fixture;
     fixture->Create(allocator, this, def);
+    fixture->m_id.index = m_world->m_fixtureHandles.Allocate(fixture);
+    fixture->m_id.generation = m_world->m_fixtureHandles.GetGeneration(fixture->m_id.index);
 
-    if (m_flags & e_enabledFlag)
+    if (m_sim->flags & e_enabledFlag)
     {
         b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-        fixture->CreateProxies(broadPhase, m_xf);
+        fixture->CreateProxies(broadPhase, m_sim->xf);
     }
 
     fixture->m_next = m_fixtureList;
     m_fixtureList = fixture;
     ++m_fixtureCount;
 
+    // The new proxies must be synchronized with the others.
+    m_fixtureExtent = b2Max(m_fixtureExtent, fixture->m_extent);
+    m_syncSlack = -1.0f;
+
     fixture->m_body = this;
 
     // Adjust mass properties if needed.
@@ -198,6 +215,11 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
     // to be created at the beginning of the next time step.
     m_world->m_newContacts = true;
 
+    if (m_world->m_recorder != nullptr)
+    {
+        m_world->m_recorder->RecordCreateFixture(fixture);
+    }
+
     return fixture;
 }
 
@@ -225,6 +247,11 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 
     assert(fixture->m_body == this);
 
+    if (m_world->m_recorder != nullptr)
+    {
+        m_world->m_recorder->RecordDestroyFixture(fixture);
+    }
+
     // Remove the fixture from this body's singly linked list.
     assert(m_fixtureCount > 0);
     b2Fixture** node = &m_fixtureList;
@@ -266,7 +293,7 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 
     b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
-    if (m_flags & e_enabledFlag)
+    if (m_sim->flags & e_enabledFlag)
     {
         b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
         fixture->DestroyProxies(broadPhase);
@@ -274,6 +301,7 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 
     fixture->m_body = nullptr;
     fixture->m_next = nullptr;
+    m_world->m_fixtureHandles.Free(fixture->m_id.index);
     fixture->Destroy(allocator);
     fixture->~b2Fixture();
     allocator->Free(fixture);
@@ -290,18 +318,18 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 void b2Body::ResetMassData()
 {
     // Compute mass data from shapes. Each shape has its own density.
-    m_mass = 0.0f;
-    m_invMass = 0.0f;
+    m_sim->mass = 0.0f;
+    m_sim->invMass = 0.0f;
     m_I = 0.0f;
-    m_invI = 0.0f;
-    m_sweep.localCenter.SetZero();
+    m_sim->invI = 0.0f;
+    m_sim->sweep.localCenter.SetZero();
 
     // Static and kinematic bodies have zero mass.
     if (m_type == b2_staticBody || m_type == b2_kinematicBody)
     {
-        m_sweep.c0 = m_xf.p;
-        m_sweep.c = m_xf.p;
-        m_sweep.a0 = m_sweep.a;
+        m_sim->sweep.c0 = m_sim->xf.p;
+        m_sim->sweep.c = m_sim->xf.p;
+        m_sim->sweep.a0 = m_sim->sweep.a;
         return;
     }
 
@@ -318,39 +346,39 @@ void b2Body::ResetMassData()
 
         b2MassData massData;
         f->GetMassData(&massData);
-        m_mass += massData.mass;
+        m_sim->mass += massData.mass;
         localCenter += massData.mass * massData.center;
         m_I += massData.I;
     }
 
     // Compute center of mass.
-    if (m_mass > 0.0f)
+    if (m_sim->mass > 0.0f)
     {
-        m_invMass = 1.0f / m_mass;
-        localCenter *= m_invMass;
+        m_sim->invMass = 1.0f / m_sim->mass;
+        localCenter *= m_sim->invMass;
     }
 
-    if (m_I > 0.0f && (m_flags & e_fixedRotationFlag) == 0)
+    if (m_I > 0.0f && (m_sim->flags & e_fixedRotationFlag) == 0)
     {
         // Center the inertia about the center of mass.
-        m_I -= m_mass * b2Dot(localCenter, localCenter);
+        m_I -= m_sim->mass * b2Dot(localCenter, localCenter);
         assert(m_I > 0.0f);
-        m_invI = 1.0f / m_I;
+        m_sim->invI = 1.0f / m_I;
 
     }
     else
     {
         m_I = 0.0f;
-        m_invI = 0.0f;
+        m_sim->invI = 0.0f;
     }
 
     // Move center of mass.
-    b2Vec2 oldCenter = m_sweep.c;
-    m_sweep.localCenter = localCenter;
-    m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+    b2Vec2 oldCenter = m_sim->sweep.c;
+    m_sim->sweep.localCenter = localCenter;
+    m_sim->sweep.c0 = m_sim->sweep.c = b2Mul(m_sim->xf, m_sim->sweep.localCenter);
 
     // Update center of mass velocity.
-    m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+    m_sim->linearVelocity += b2Cross(m_sim->angularVelocity, m_sim->sweep.c - oldCenter);
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -366,32 +394,32 @@ void b2Body::SetMassData(const b2MassData* massData)
         return;
     }
 
-    m_invMass = 0.0f;
+    m_sim->invMass = 0.0f;
     m_I = 0.0f;
-    m_invI = 0.0f;
+    m_sim->invI = 0.0f;
 
-    m_mass = massData->mass;
-    if (m_mass <= 0.0f)
+    m_sim->mass = massData->mass;
+    if (m_sim->mass <= 0.0f)
     {
-        m_mass = 1.0f;
+        m_sim->mass = 1.0f;
     }
 
-    m_invMass = 1.0f / m_mass;
+    m_sim->invMass = 1.0f / m_sim->mass;
 
-    if (massData->I > 0.0f && (m_flags & b2Body::e_fixedRotationFlag) == 0)
+    if (massData->I > 0.0f && (m_sim->flags & b2Body::e_fixedRotationFlag) == 0)
     {
-        m_I = massData->I - m_mass * b2Dot(massData->center, massData->center);
+        m_I = massData->I - m_sim->mass * b2Dot(massData->center, massData->center);
         assert(m_I > 0.0f);
-        m_invI = 1.0f / m_I;
+        m_sim->invI = 1.0f / m_I;
     }
 
     // Move center of mass.
-    b2Vec2 oldCenter = m_sweep.c;
-    m_sweep.localCenter =  massData->center;
-    m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+    b2Vec2 oldCenter = m_sim->sweep.c;
+    m_sim->sweep.localCenter =  massData->center;
+    m_sim->sweep.c0 = m_sim->sweep.c = b2Mul(m_sim->xf, m_sim->sweep.localCenter);
 
     // Update center of mass velocity.
-    m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+    m_sim->linearVelocity += b2Cross(m_sim->angularVelocity, m_sim->sweep.c - oldCenter);
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -425,21 +453,30 @@ void b2Body::SetTransform(const b2Vec2& position, float angle)
         return;
     }
 
-    m_xf.q.Set(angle);
-    m_xf.p = position;
+    if (m_world->m_recorder != nullptr)
+    {
+        m_world->m_recorder->RecordInput(this, b2_replaySetTransform, position, angle, false);
+    }
+
+    m_sim->xf.q.Set(angle);
+    m_sim->xf.p = position;
 
-    m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
-    m_sweep.a = angle;
+    m_sim->sweep.c = b2Mul(m_sim->xf, m_sim->sweep.localCenter);
+    m_sim->sweep.a = angle;
 
-    m_sweep.c0 = m_sweep.c;
-    m_sweep.a0 = angle;
+    m_sim->sweep.c0 = m_sim->sweep.c;
+    m_sim->sweep.a0 = angle;
 
     b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+    float slack = FLT_MAX;
     for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
     {
-        f->Synchronize(broadPhase, m_xf, m_xf);
+        slack = b2Min(slack, f->Synchronize(broadPhase, m_sim->xf, m_sim->xf));
     }
 
+    m_syncTransform = m_sim->xf;
+    m_syncSlack = slack;
+
     // Check for new contacts the next step
     m_world->m_newContacts = true;
 }
@@ -448,24 +485,37 @@ void b2Body::SynchronizeFixtures()
 {
     b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 
-    if (m_flags & b2Body::e_awakeFlag)
+    float slack = FLT_MAX;
+    if (m_sim->flags & b2Body::e_awakeFlag)
     {
         b2Transform xf1;
-        xf1.q.Set(m_sweep.a0);
-        xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
+        xf1.q.Set(m_sim->sweep.a0);
+        xf1.p = m_sim->sweep.c0 - b2Mul(xf1.q, m_sim->sweep.localCenter);
+
+        // Skip the fixtures while no point of the body can have moved far enough since the
+        // last synchronization to change a proxy. This is common for resting and slow bodies.
+        float move1 = b2MotionBound(m_syncTransform, xf1, m_fixtureExtent);
+        float move2 = b2MotionBound(m_syncTransform, m_sim->xf, m_fixtureExtent);
+        if (b2Max(move1, move2) < m_syncSlack)
+        {
+            return;
+        }
 
         for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
         {
-            f->Synchronize(broadPhase, xf1, m_xf);
+            slack = b2Min(slack, f->Synchronize(broadPhase, xf1, m_sim->xf));
         }
     }
     else
     {
         for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
         {
-            f->Synchronize(broadPhase, m_xf, m_xf);
+            slack = b2Min(slack, f->Synchronize(broadPhase, m_sim->xf, m_sim->xf));
         }
     }
+
+    m_syncTransform = m_sim->xf;
+    m_syncSlack = slack;
 }
 
 void b2Body::SetEnabled(bool flag)
@@ -477,23 +527,29 @@ void b2Body::SetEnabled(bool flag)
         return;
     }
 
+    if (m_world->m_recorder != nullptr)
+    {
+        m_world->m_recorder->RecordInput(this, b2_replaySetEnabled, b2Vec2_zero, 0.0f, flag);
+    }
+
     if (flag)
     {
-        m_flags |= e_enabledFlag;
+        m_sim->flags |= e_enabledFlag;
 
         // Create all proxies.
         b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
         for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
         {
-            f->CreateProxies(broadPhase, m_xf);
+            f->CreateProxies(broadPhase, m_sim->xf);
         }
+        m_syncSlack = -1.0f;
 
         // Contacts are created at the beginning of the next
         m_world->m_newContacts = true;
     }
     else
     {
-        m_flags &= ~e_enabledFlag;
+        m_sim->flags &= ~e_enabledFlag;
 
         // Destroy all proxies.
         b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
@@ -516,22 +572,27 @@ void b2Body::SetEnabled(bool flag)
 
 void b2Body::SetFixedRotation(bool flag)
 {
-    bool status = (m_flags & e_fixedRotationFlag) == e_fixedRotationFlag;
+    bool status = (m_sim->flags & e_fixedRotationFlag) == e_fixedRotationFlag;
     if (status == flag)
     {
         return;
     }
 
+    if (m_world->m_recorder != nullptr)
+    {
+        m_world->m_recorder->RecordInput(this, b2_replaySetFixedRotation, b2Vec2_zero, 0.0f, flag);
+    }
+
     if (flag)
     {
-        m_flags |= e_fixedRotationFlag;
+        m_sim->flags |= e_fixedRotationFlag;
     }
     else
     {
-        m_flags &= ~e_fixedRotationFlag;
+        m_sim->flags &= ~e_fixedRotationFlag;
     }
 
-    m_angularVelocity = 0.0f;
+    m_sim->angularVelocity = 0.0f;
 
     ResetMassData();
 }
@@ -546,18 +607,18 @@ void b2Body::Dump()
     b2Dump("{\n");
     b2Dump("  b2BodyDef bd;\n");
     b2Dump("  bd.type = b2BodyType(%d);\n", m_type);
-    b2Dump("  bd.position.Set(%.9g, %.9g);\n", m_xf.p.x, m_xf.p.y);
-    b2Dump("  bd.angle = %.9g;\n", m_sweep.a);
-    b2Dump("  bd.linearVelocity.Set(%.9g, %.9g);\n", m_linearVelocity.x, m_linearVelocity.y);
-    b2Dump("  bd.angularVelocity = %.9g;\n", m_angularVelocity);
-    b2Dump("  bd.linearDamping = %.9g;\n", m_linearDamping);
-    b2Dump("  bd.angularDamping = %.9g;\n", m_angularDamping);
-    b2Dump("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
-    b2Dump("  bd.awake = bool(%d);\n", m_flags & e_awakeFlag);
-    b2Dump("  bd.fixedRotation = bool(%d);\n", m_flags & e_fixedRotationFlag);
-    b2Dump("  bd.bullet = bool(%d);\n", m_flags & e_bulletFlag);
-    b2Dump("  bd.enabled = bool(%d);\n", m_flags & e_enabledFlag);
-    b2Dump("  bd.gravityScale = %.9g;\n", m_gravityScale);
+    b2Dump("  bd.position.Set(%.9g, %.9g);\n", m_sim->xf.p.x, m_sim->xf.p.y);
+    b2Dump("  bd.angle = %.9g;\n", m_sim->sweep.a);
+    b2Dump("  bd.linearVelocity.Set(%.9g, %.9g);\n", m_sim->linearVelocity.x, m_sim->linearVelocity.y);
+    b2Dump("  bd.angularVelocity = %.9g;\n", m_sim->angularVelocity);
+    b2Dump("  bd.linearDamping = %.9g;\n", m_sim->linearDamping);
+    b2Dump("  bd.angularDamping = %.9g;\n", m_sim->angularDamping);
+    b2Dump("  bd.allowSleep = bool(%d);\n", m_sim->flags & e_autoSleepFlag);
+    b2Dump("  bd.awake = bool(%d);\n", m_sim->flags & e_awakeFlag);
+    b2Dump("  bd.fixedRotation = bool(%d);\n", m_sim->flags & e_fixedRotationFlag);
+    b2Dump("  bd.bullet = bool(%d);\n", m_sim->flags & e_bulletFlag);
+    b2Dump("  bd.enabled = bool(%d);\n", m_sim->flags & e_enabledFlag);
+    b2Dump("  bd.gravityScale = %.9g;\n", m_sim->gravityScale);
     b2Dump("  bodies[%d] = m_world->CreateBody(&bd);\n", m_islandIndex);
     b2Dump("\n");
     for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
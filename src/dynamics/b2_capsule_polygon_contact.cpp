@@ -0,0 +1,54 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "b2_capsule_polygon_contact.h"
+
+#include <box2d/b2_block_allocator.h>
+#include <box2d/b2_fixture.h>
+
+#include <new>
+
+b2Contact* b2CapsuleAndPolygonContact::Create(b2Fixture* fixtureA, std::int32_t, b2Fixture* fixtureB, std::int32_t, b2BlockAllocator* allocator)
+{
+    auto* mem = allocator->Allocate<b2CapsuleAndPolygonContact>();
+    return new (mem) b2CapsuleAndPolygonContact(fixtureA, fixtureB);
+}
+
+void b2CapsuleAndPolygonContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+{
+    ((b2CapsuleAndPolygonContact*)contact)->~b2CapsuleAndPolygonContact();
+    allocator->Free(contact);
+}
+
+b2CapsuleAndPolygonContact::b2CapsuleAndPolygonContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
+: b2Contact(fixtureA, 0, fixtureB, 0)
+{
+    assert(m_fixtureA->GetType() == b2Shape::e_capsule);
+    assert(m_fixtureB->GetType() == b2Shape::e_polygon);
+}
+
+void b2CapsuleAndPolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
+{
+    b2CollideCapsuleAndPolygon( manifold,
+                                (b2CapsuleShape*)m_fixtureA->GetShape(), xfA,
+                                (b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+}
@@ -0,0 +1,228 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "b2_compound_contact.h"
+#include <box2d/b2_block_allocator.h>
+#include <box2d/b2_capsule_shape.h>
+#include <box2d/b2_chain_shape.h>
+#include <box2d/b2_circle_shape.h>
+#include <box2d/b2_compound_shape.h>
+#include <box2d/b2_edge_shape.h>
+#include <box2d/b2_fixture.h>
+#include <box2d/b2_height_field_shape.h>
+#include <box2d/b2_polygon_shape.h>
+
+#include <new>
+
+b2Contact* b2CompoundContact::Create(b2Fixture* fixtureA, std::int32_t indexA, b2Fixture* fixtureB, std::int32_t indexB, b2BlockAllocator* allocator)
+{
+    auto* mem = allocator->Allocate<b2CompoundContact>();
+    return new (mem) b2CompoundContact(fixtureA, indexA, fixtureB, indexB);
+}
+
+void b2CompoundContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+{
+    ((b2CompoundContact*)contact)->~b2CompoundContact();
+    allocator->Free(contact);
+}
+
+b2CompoundContact::b2CompoundContact(b2Fixture* fixtureA, std::int32_t indexA, b2Fixture* fixtureB, std::int32_t indexB)
+: b2Contact(fixtureA, indexA, fixtureB, indexB)
+{
+    assert(m_fixtureA->GetType() == b2Shape::e_compound);
+}
+
+// Swap the roles of the shapes in a manifold computed with the shapes in the other order.
+// Face manifolds keep their data and change the reference shape. Circle manifolds swap
+// the local points.
+static void b2FlipManifold(b2Manifold* manifold)
+{
+    switch (manifold->type)
+    {
+    case b2Manifold::e_circles:
+        {
+            b2Vec2 localPoint = manifold->localPoint;
+            manifold->localPoint = manifold->points[0].localPoint;
+            manifold->points[0].localPoint = localPoint;
+        }
+        break;
+
+    case b2Manifold::e_faceA:
+        manifold->type = b2Manifold::e_faceB;
+        break;
+
+    case b2Manifold::e_faceB:
+        manifold->type = b2Manifold::e_faceA;
+        break;
+    }
+
+    for (std::int32_t i = 0; i < manifold->pointCount; ++i)
+    {
+        b2ContactFeature& cf = manifold->points[i].id.cf;
+        b2ContactFeature flipped;
+        flipped.indexA = cf.indexB;
+        flipped.indexB = cf.indexA;
+        flipped.typeA = cf.typeB;
+        flipped.typeB = cf.typeA;
+        cf = flipped;
+    }
+}
+
+// Collide a compound child with a convex shape or an edge.
+static void b2CollideChild(b2Manifold* manifold, const b2Shape* shapeA, const b2Transform& xfA,
+                           const b2Shape* shapeB, const b2Transform& xfB)
+{
+    bool flip = false;
+
+    switch (shapeA->GetType())
+    {
+    case b2Shape::e_circle:
+        {
+            const b2CircleShape* circleA = (const b2CircleShape*)shapeA;
+            switch (shapeB->GetType())
+            {
+            case b2Shape::e_circle:
+                b2CollideCircles(manifold, circleA, xfA, (const b2CircleShape*)shapeB, xfB);
+                break;
+
+            case b2Shape::e_polygon:
+                b2CollidePolygonAndCircle(manifold, (const b2PolygonShape*)shapeB, xfB, circleA, xfA);
+                flip = true;
+                break;
+
+            case b2Shape::e_capsule:
+                b2CollideCapsuleAndCircle(manifold, (const b2CapsuleShape*)shapeB, xfB, circleA, xfA);
+                flip = true;
+                break;
+
+            case b2Shape::e_edge:
+                b2CollideEdgeAndCircle(manifold, (const b2EdgeShape*)shapeB, xfB, circleA, xfA);
+                flip = true;
+                break;
+
+            default:
+                assert(false);
+                break;
+            }
+        }
+        break;
+
+    case b2Shape::e_polygon:
+        {
+            const b2PolygonShape* polygonA = (const b2PolygonShape*)shapeA;
+            switch (shapeB->GetType())
+            {
+            case b2Shape::e_circle:
+                b2CollidePolygonAndCircle(manifold, polygonA, xfA, (const b2CircleShape*)shapeB, xfB);
+                break;
+
+            case b2Shape::e_polygon:
+                b2CollidePolygons(manifold, polygonA, xfA, (const b2PolygonShape*)shapeB, xfB);
+                break;
+
+            case b2Shape::e_capsule:
+                b2CollideCapsuleAndPolygon(manifold, (const b2CapsuleShape*)shapeB, xfB, polygonA, xfA);
+                flip = true;
+                break;
+
+            case b2Shape::e_edge:
+                b2CollideEdgeAndPolygon(manifold, (const b2EdgeShape*)shapeB, xfB, polygonA, xfA);
+                flip = true;
+                break;
+
+            default:
+                assert(false);
+                break;
+            }
+        }
+        break;
+
+    case b2Shape::e_capsule:
+        {
+            const b2CapsuleShape* capsuleA = (const b2CapsuleShape*)shapeA;
+            switch (shapeB->GetType())
+            {
+            case b2Shape::e_circle:
+                b2CollideCapsuleAndCircle(manifold, capsuleA, xfA, (const b2CircleShape*)shapeB, xfB);
+                break;
+
+            case b2Shape::e_polygon:
+                b2CollideCapsuleAndPolygon(manifold, capsuleA, xfA, (const b2PolygonShape*)shapeB, xfB);
+                break;
+
+            case b2Shape::e_capsule:
+                b2CollideCapsules(manifold, capsuleA, xfA, (const b2CapsuleShape*)shapeB, xfB);
+                break;
+
+            case b2Shape::e_edge:
+                b2CollideEdgeAndCapsule(manifold, (const b2EdgeShape*)shapeB, xfB, capsuleA, xfA);
+                flip = true;
+                break;
+
+            default:
+                assert(false);
+                break;
+            }
+        }
+        break;
+
+    default:
+        assert(false);
+        break;
+    }
+
+    if (flip)
+    {
+        b2FlipManifold(manifold);
+    }
+}
+
+void b2CompoundContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
+{
+    b2CompoundShape* compoundA = (b2CompoundShape*)m_fixtureA->GetShape();
+    const b2Shape* shapeA = compoundA->GetChild(m_indexA);
+
+    // Resolve the child of shape B. Chains and height fields provide edges.
+    b2EdgeShape edge;
+    const b2Shape* shapeB = m_fixtureB->GetShape();
+    switch (shapeB->GetType())
+    {
+    case b2Shape::e_compound:
+        shapeB = ((const b2CompoundShape*)shapeB)->GetChild(m_indexB);
+        break;
+
+    case b2Shape::e_chain:
+        ((const b2ChainShape*)shapeB)->GetChildEdge(&edge, m_indexB);
+        shapeB = &edge;
+        break;
+
+    case b2Shape::e_heightField:
+        ((const b2HeightFieldShape*)shapeB)->GetChildEdge(&edge, m_indexB);
+        shapeB = &edge;
+        break;
+
+    default:
+        break;
+    }
+
+    b2CollideChild(manifold, shapeA, xfA, shapeB, xfB);
+}
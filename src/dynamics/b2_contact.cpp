@@ -20,12 +20,21 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include "b2_capsule_circle_contact.h"
+#include "b2_capsule_contact.h"
+#include "b2_capsule_polygon_contact.h"
+#include "b2_chain_capsule_contact.h"
 #include "b2_chain_circle_contact.h"
 #include "b2_chain_polygon_contact.h"
 #include "b2_circle_contact.h"
+#include "b2_compound_contact.h"
 #include "b2_contact_solver.h"
+#include "b2_edge_capsule_contact.h"
 #include "b2_edge_circle_contact.h"
 #include "b2_edge_polygon_contact.h"
+#include "b2_height_field_capsule_contact.h"
+#include "b2_height_field_circle_contact.h"
+#include "b2_height_field_polygon_contact.h"
 #include "b2_polygon_circle_contact.h"
 #include "b2_polygon_contact.h"
 
@@ -50,6 +59,21 @@ void b2Contact::InitializeRegisters()
     AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
     AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
     AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
+    AddType(b2HeightFieldAndCircleContact::Create, b2HeightFieldAndCircleContact::Destroy, b2Shape::e_heightField, b2Shape::e_circle);
+    AddType(b2HeightFieldAndPolygonContact::Create, b2HeightFieldAndPolygonContact::Destroy, b2Shape::e_heightField, b2Shape::e_polygon);
+    AddType(b2CapsuleContact::Create, b2CapsuleContact::Destroy, b2Shape::e_capsule, b2Shape::e_capsule);
+    AddType(b2CapsuleAndCircleContact::Create, b2CapsuleAndCircleContact::Destroy, b2Shape::e_capsule, b2Shape::e_circle);
+    AddType(b2CapsuleAndPolygonContact::Create, b2CapsuleAndPolygonContact::Destroy, b2Shape::e_capsule, b2Shape::e_polygon);
+    AddType(b2EdgeAndCapsuleContact::Create, b2EdgeAndCapsuleContact::Destroy, b2Shape::e_edge, b2Shape::e_capsule);
+    AddType(b2ChainAndCapsuleContact::Create, b2ChainAndCapsuleContact::Destroy, b2Shape::e_chain, b2Shape::e_capsule);
+    AddType(b2HeightFieldAndCapsuleContact::Create, b2HeightFieldAndCapsuleContact::Destroy, b2Shape::e_heightField, b2Shape::e_capsule);
+    AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_circle);
+    AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_edge);
+    AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_polygon);
+    AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_chain);
+    AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_heightField);
+    AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_capsule);
+    AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_compound);
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
@@ -141,6 +165,9 @@ b2Contact::b2Contact(b2Fixture* fA, std::int32_t indexA, b2Fixture* fB, std::int
 
     m_prev = nullptr;
     m_next = nullptr;
+    m_contactIndex = -1;
+    m_pairKey.id1 = 0;
+    m_pairKey.id2 = 0;
 
     m_nodeA.contact = nullptr;
     m_nodeA.prev = nullptr;
@@ -163,8 +190,25 @@ b2Contact::b2Contact(b2Fixture* fA, std::int32_t indexA, b2Fixture* fB, std::int
 
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+bool b2Contact::CanReuseManifold(const b2Transform& xfA, const b2Transform& xfB) const
 {
+    b2Transform relativeXf = b2MulT(xfA, xfB);
+
+    b2Vec2 dp = relativeXf.p - m_relativeXf.p;
+    if (b2Dot(dp, dp) > b2_manifoldReuseLinearTolerance * b2_manifoldReuseLinearTolerance)
+    {
+        return false;
+    }
+
+    // Rotation from the cached relative rotation to the current one.
+    b2Rot dq = b2MulT(m_relativeXf.q, relativeXf.q);
+    return dq.c > 0.0f && b2Abs(dq.s) < b2_manifoldReuseAngularTolerance;
+}
+
+void b2Contact::Update(b2ContactManager* manager)
+{
+    b2ContactListener* listener = manager->m_contactListener;
+
     b2Manifold oldManifold = m_manifold;
 
     // Re-enable this contact.
@@ -192,11 +236,22 @@ void b2Contact::Update(b2ContactListener* listener)
         // Sensors don't generate manifolds.
         m_manifold.pointCount = 0;
     }
+    else if (manager->m_manifoldReuse && (m_flags & e_manifoldCacheFlag) && CanReuseManifold(xfA, xfB))
+    {
+        // The shapes have not moved relative to each other, so the cached manifold
+        // and its impulses are still valid.
+        touching = wasTouching;
+        ++manager->m_manifoldReuseCount;
+    }
     else
     {
         Evaluate(&m_manifold, xfA, xfB);
         touching = m_manifold.pointCount > 0;
 
+        m_relativeXf = b2MulT(xfA, xfB);
+        m_flags |= e_manifoldCacheFlag;
+        ++manager->m_manifoldUpdateCount;
+
         // Match old contact ids to new contact ids and copy the
         // stored impulses to warm start the solver.
         for (std::int32_t i = 0; i < m_manifold.pointCount; ++i)
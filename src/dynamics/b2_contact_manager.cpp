@@ -24,20 +24,36 @@
 #include <box2d/b2_contact.h>
 #include <box2d/b2_contact_manager.h>
 #include <box2d/b2_fixture.h>
+#include <box2d/b2_growable_stack.h>
 #include <box2d/b2_world_callbacks.h>
 
+#include <cstring>
+
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
-b2ContactManager::b2ContactManager()
+b2ContactManager::b2ContactManager(b2AllocationTracker* tracker)
+    : m_broadPhase(tracker), m_pairSet(tracker, b2_contactAllocation)
 {
+    m_tracker = tracker;
     m_contactList = nullptr;
+    m_contactCapacity = 16;
     m_contactCount = 0;
+    m_contacts = (b2Contact**)b2TrackedAlloc(m_tracker, m_contactCapacity * sizeof(b2Contact*), b2_contactAllocation);
+    m_manifoldReuse = false;
+    m_manifoldReuseCount = 0;
+    m_manifoldUpdateCount = 0;
+    m_falsePairCount = 0;
     m_contactFilter = &b2_defaultFilter;
     m_contactListener = &b2_defaultListener;
     m_allocator = nullptr;
 }
 
+b2ContactManager::~b2ContactManager()
+{
+    b2TrackedFree(m_tracker, m_contacts, m_contactCapacity * sizeof(b2Contact*), b2_contactAllocation);
+}
+
 void b2ContactManager::Destroy(b2Contact* c)
 {
     b2Fixture* fixtureA = c->GetFixtureA();
@@ -66,6 +82,18 @@ void b2ContactManager::Destroy(b2Contact* c)
         m_contactList = c->m_next;
     }
 
+    m_pairSet.Remove(c->m_pairKey);
+
+    // Remove from the contact array. Move the last contact into the hole.
+    std::int32_t index = c->m_contactIndex;
+    std::int32_t lastIndex = m_contactCount - 1;
+    assert(0 <= index && index <= lastIndex && m_contacts[index] == c);
+    if (index != lastIndex)
+    {
+        m_contacts[index] = m_contacts[lastIndex];
+        m_contacts[index]->m_contactIndex = index;
+    }
+
     // Remove from body 1
     if (c->m_nodeA.prev)
     {
@@ -108,10 +136,17 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
-    // Update awake contacts.
-    b2Contact* c = m_contactList;
-    while (c)
+    m_manifoldReuseCount = 0;
+    m_manifoldUpdateCount = 0;
+    m_falsePairCount = 0;
+    m_broadPhase.ResetReinsertionCount();
+
+    // Update awake contacts. Destroying a contact moves the last contact into
+    // the current slot, so the index only advances for surviving contacts.
+    std::int32_t index = 0;
+    while (index < m_contactCount)
     {
+        b2Contact* c = m_contacts[index];
         b2Fixture* fixtureA = c->GetFixtureA();
         b2Fixture* fixtureB = c->GetFixtureB();
         std::int32_t indexA = c->GetChildIndexA();
@@ -125,18 +160,14 @@ void b2ContactManager::Collide()
             // Should these bodies collide?
             if (bodyB->ShouldCollide(bodyA) == false)
             {
-                b2Contact* cNuke = c;
-                c = cNuke->GetNext();
-                Destroy(cNuke);
+                Destroy(c);
                 continue;
             }
 
             // Check user filtering.
             if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
             {
-                b2Contact* cNuke = c;
-                c = cNuke->GetNext();
-                Destroy(cNuke);
+                Destroy(c);
                 continue;
             }
 
@@ -150,26 +181,26 @@ void b2ContactManager::Collide()
         // At least one body must be awake and it must be dynamic or kinematic.
         if (activeA == false && activeB == false)
         {
-            c = c->GetNext();
+            ++index;
             continue;
         }
 
-        std::int32_t proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-        std::int32_t proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-        bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+        bool overlap = TestOverlap(fixtureA, indexA, fixtureB, indexB);
 
         // Here we destroy contacts that cease to overlap in the broad-phase.
         if (overlap == false)
         {
-            b2Contact* cNuke = c;
-            c = cNuke->GetNext();
-            Destroy(cNuke);
+            Destroy(c);
             continue;
         }
 
         // The contact persists.
-        c->Update(m_contactListener);
-        c = c->GetNext();
+        c->Update(this);
+        if (c->IsTouching() == false)
+        {
+            ++m_falsePairCount;
+        }
+        ++index;
     }
 }
 
@@ -178,6 +209,79 @@ void b2ContactManager::FindNewContacts()
     m_broadPhase.UpdatePairs(this);
 }
 
+// Test a contact for overlap in the broad-phase. The fat proxy AABBs must overlap. A
+// child of a shape that shares a proxy must also overlap the other proxy, or the other
+// child when both shapes share a proxy, within the AABB extension. Children move inside
+// their proxy, so the extension keeps pairs alive until the children are paired again.
+bool b2ContactManager::TestOverlap(b2Fixture* fixtureA, std::int32_t indexA, b2Fixture* fixtureB, std::int32_t indexB) const
+{
+    const b2Shape* shapeA = fixtureA->GetShape();
+    const b2Shape* shapeB = fixtureB->GetShape();
+    bool sharesProxyA = shapeA->SharesProxy();
+    bool sharesProxyB = shapeB->SharesProxy();
+
+    std::int32_t proxyIdA = fixtureA->m_proxies[sharesProxyA ? 0 : indexA].proxyId;
+    std::int32_t proxyIdB = fixtureB->m_proxies[sharesProxyB ? 0 : indexB].proxyId;
+    if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+    {
+        return false;
+    }
+
+    b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+    if (sharesProxyA && sharesProxyB)
+    {
+        b2AABB aabbA, aabbB;
+        shapeA->ComputeAABB(&aabbA, fixtureA->GetBody()->GetTransform(), indexA);
+        shapeB->ComputeAABB(&aabbB, fixtureB->GetBody()->GetTransform(), indexB);
+        aabbA.lowerBound -= r;
+        aabbA.upperBound += r;
+        return b2TestOverlap(aabbA, aabbB);
+    }
+
+    if (sharesProxyA)
+    {
+        b2AABB aabbA;
+        shapeA->ComputeAABB(&aabbA, fixtureA->GetBody()->GetTransform(), indexA);
+        aabbA.lowerBound -= r;
+        aabbA.upperBound += r;
+        if (b2TestOverlap(aabbA, m_broadPhase.GetFatAABB(proxyIdB)) == false)
+        {
+            return false;
+        }
+    }
+
+    if (sharesProxyB)
+    {
+        b2AABB aabbB;
+        shapeB->ComputeAABB(&aabbB, fixtureB->GetBody()->GetTransform(), indexB);
+        aabbB.lowerBound -= r;
+        aabbB.upperBound += r;
+        if (b2TestOverlap(aabbB, m_broadPhase.GetFatAABB(proxyIdA)) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Collects the children of a shape that shares a proxy.
+struct b2ChildCollector : public b2ChildQueryCallback
+{
+    explicit b2ChildCollector(b2AllocationTracker* tracker)
+        : children(tracker, b2_contactAllocation)
+    {
+    }
+
+    bool ReportChild(std::int32_t childIndex) override
+    {
+        children.Push(childIndex);
+        return true;
+    }
+
+    b2GrowableStack<std::int32_t, 64> children;
+};
+
 void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 {
     b2FixtureProxy* proxyA = (b2FixtureProxy*)proxyUserDataA;
@@ -186,45 +290,105 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
     b2Fixture* fixtureA = proxyA->fixture;
     b2Fixture* fixtureB = proxyB->fixture;
 
-    std::int32_t indexA = proxyA->childIndex;
-    std::int32_t indexB = proxyB->childIndex;
+    // Are the fixtures on the same body?
+    if (fixtureA->GetBody() == fixtureB->GetBody())
+    {
+        return;
+    }
 
-    b2Body* bodyA = fixtureA->GetBody();
-    b2Body* bodyB = fixtureB->GetBody();
+    const b2Shape* shapeA = fixtureA->GetShape();
+    const b2Shape* shapeB = fixtureB->GetShape();
+    bool sharesProxyA = shapeA->SharesProxy();
+    bool sharesProxyB = shapeB->SharesProxy();
 
-    // Are the fixtures on the same body?
-    if (bodyA == bodyB)
+    if (sharesProxyA == false && sharesProxyB == false)
     {
+        AddChildPair(proxyA, proxyA->childIndex, proxyB, proxyB->childIndex);
         return;
     }
 
-    // TODO_ERIN use a hash table to remove a potential bottleneck when both
-    // bodies have a lot of contacts.
-    // Does a contact already exist?
-    b2ContactEdge* edge = bodyB->GetContactList();
-    while (edge)
+    // Children move inside their proxy between pair updates, so they are paired with
+    // the AABB extension to spare.
+    const b2Transform& xfA = fixtureA->GetBody()->GetTransform();
+    const b2Transform& xfB = fixtureB->GetBody()->GetTransform();
+    b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+
+    if (sharesProxyA && sharesProxyB)
     {
-        if (edge->other == bodyA)
+        // Pair the children of both shapes that overlap each other, rather than every
+        // child that overlaps the other proxy. This matches the overlap test in Collide.
+        b2AABB aabb = m_broadPhase.GetFatAABB(proxyB->proxyId);
+        aabb.lowerBound -= r;
+        aabb.upperBound += r;
+
+        b2ChildCollector childrenA(m_tracker);
+        shapeA->QueryChildren(&childrenA, aabb, xfA);
+
+        std::int32_t countA = childrenA.children.GetCount();
+        for (std::int32_t i = 0; i < countA; ++i)
         {
-            b2Fixture* fA = edge->contact->GetFixtureA();
-            b2Fixture* fB = edge->contact->GetFixtureB();
-            std::int32_t iA = edge->contact->GetChildIndexA();
-            std::int32_t iB = edge->contact->GetChildIndexB();
+            std::int32_t indexA = childrenA.children.Get(i);
+            b2AABB aabbA;
+            shapeA->ComputeAABB(&aabbA, xfA, indexA);
+            aabbA.lowerBound -= r;
+            aabbA.upperBound += r;
 
-            if (fA == fixtureA && fB == fixtureB && iA == indexA && iB == indexB)
-            {
-                // A contact already exists.
-                return;
-            }
+            b2ChildCollector childrenB(m_tracker);
+            shapeB->QueryChildren(&childrenB, aabbA, xfB);
 
-            if (fA == fixtureB && fB == fixtureA && iA == indexB && iB == indexA)
+            std::int32_t countB = childrenB.children.GetCount();
+            for (std::int32_t j = 0; j < countB; ++j)
             {
-                // A contact already exists.
-                return;
+                AddChildPair(proxyA, indexA, proxyB, childrenB.children.Get(j));
             }
         }
+        return;
+    }
 
-        edge = edge->next;
+    // Otherwise the shape that shares a proxy pairs each child that overlaps the other
+    // proxy. This matches the overlap test in Collide.
+    b2ChildCollector children(m_tracker);
+    if (sharesProxyA)
+    {
+        b2AABB aabb = m_broadPhase.GetFatAABB(proxyB->proxyId);
+        aabb.lowerBound -= r;
+        aabb.upperBound += r;
+        shapeA->QueryChildren(&children, aabb, xfA);
+
+        std::int32_t count = children.children.GetCount();
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            AddChildPair(proxyA, children.children.Get(i), proxyB, proxyB->childIndex);
+        }
+    }
+    else
+    {
+        b2AABB aabb = m_broadPhase.GetFatAABB(proxyA->proxyId);
+        aabb.lowerBound -= r;
+        aabb.upperBound += r;
+        shapeB->QueryChildren(&children, aabb, xfB);
+
+        std::int32_t count = children.children.GetCount();
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            AddChildPair(proxyA, proxyA->childIndex, proxyB, children.children.Get(i));
+        }
+    }
+}
+
+void b2ContactManager::AddChildPair(b2FixtureProxy* proxyA, std::int32_t indexA, b2FixtureProxy* proxyB, std::int32_t indexB)
+{
+    b2Fixture* fixtureA = proxyA->fixture;
+    b2Fixture* fixtureB = proxyB->fixture;
+
+    b2Body* bodyA = fixtureA->GetBody();
+    b2Body* bodyB = fixtureB->GetBody();
+
+    // Does a contact already exist?
+    b2PairKey pairKey = b2MakePairKey(b2ChildId(proxyA->proxyId, indexA), b2ChildId(proxyB->proxyId, indexB));
+    if (m_pairSet.Contains(pairKey))
+    {
+        return;
     }
 
     // Does a joint override collision? Is at least one body dynamic?
@@ -254,6 +418,9 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
     bodyA = fixtureA->GetBody();
     bodyB = fixtureB->GetBody();
 
+    m_pairSet.Add(pairKey);
+    c->m_pairKey = pairKey;
+
     // Insert into the world.
     c->m_prev = nullptr;
     c->m_next = m_contactList;
@@ -263,6 +430,20 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
     }
     m_contactList = c;
 
+    // Append to the contact array.
+    if (m_contactCount == m_contactCapacity)
+    {
+        b2Contact** oldContacts = m_contacts;
+        std::int32_t oldCapacity = m_contactCapacity;
+        m_contactCapacity *= 2;
+        m_contacts = (b2Contact**)b2TrackedAlloc(m_tracker, m_contactCapacity * sizeof(b2Contact*), b2_contactAllocation);
+        memcpy(m_contacts, oldContacts, m_contactCount * sizeof(b2Contact*));
+        b2TrackedFree(m_tracker, oldContacts, oldCapacity * sizeof(b2Contact*), b2_contactAllocation);
+    }
+
+    c->m_contactIndex = m_contactCount;
+    m_contacts[m_contactCount] = c;
+
     // Connect to island graph.
 
     // Connect to body A
@@ -68,8 +68,8 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
         b2Fixture* fixtureB = contact->m_fixtureB;
         b2Shape* shapeA = fixtureA->GetShape();
         b2Shape* shapeB = fixtureB->GetShape();
-        float radiusA = shapeA->m_radius;
-        float radiusB = shapeB->m_radius;
+        float radiusA = shapeA->GetChildRadius(contact->m_indexA);
+        float radiusB = shapeB->GetChildRadius(contact->m_indexB);
         b2Body* bodyA = fixtureA->GetBody();
         b2Body* bodyB = fixtureB->GetBody();
         b2Manifold* manifold = contact->GetManifold();
@@ -84,10 +84,10 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
         vc->tangentSpeed = contact->m_tangentSpeed;
         vc->indexA = bodyA->m_islandIndex;
         vc->indexB = bodyB->m_islandIndex;
-        vc->invMassA = bodyA->m_invMass;
-        vc->invMassB = bodyB->m_invMass;
-        vc->invIA = bodyA->m_invI;
-        vc->invIB = bodyB->m_invI;
+        vc->invMassA = bodyA->m_sim->invMass;
+        vc->invMassB = bodyB->m_sim->invMass;
+        vc->invIA = bodyA->m_sim->invI;
+        vc->invIB = bodyB->m_sim->invI;
         vc->contactIndex = i;
         vc->pointCount = pointCount;
         vc->K.SetZero();
@@ -96,12 +96,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
         b2ContactPositionConstraint* pc = m_positionConstraints + i;
         pc->indexA = bodyA->m_islandIndex;
         pc->indexB = bodyB->m_islandIndex;
-        pc->invMassA = bodyA->m_invMass;
-        pc->invMassB = bodyB->m_invMass;
-        pc->localCenterA = bodyA->m_sweep.localCenter;
-        pc->localCenterB = bodyB->m_sweep.localCenter;
-        pc->invIA = bodyA->m_invI;
-        pc->invIB = bodyB->m_invI;
+        pc->invMassA = bodyA->m_sim->invMass;
+        pc->invMassB = bodyB->m_sim->invMass;
+        pc->localCenterA = bodyA->m_sim->sweep.localCenter;
+        pc->localCenterB = bodyB->m_sim->sweep.localCenter;
+        pc->invIA = bodyA->m_sim->invI;
+        pc->invIB = bodyB->m_sim->invI;
         pc->localNormal = manifold->localNormal;
         pc->localPoint = manifold->localPoint;
         pc->pointCount = pointCount;
@@ -23,6 +23,7 @@
 #include <box2d/b2_body.h>
 #include <box2d/b2_draw.h>
 #include <box2d/b2_distance_joint.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_time_step.h>
 
 // 1-D constrained system
@@ -77,12 +78,12 @@ void b2DistanceJoint::InitVelocityConstraints(const b2SolverData& data)
 {
     m_indexA = m_bodyA->m_islandIndex;
     m_indexB = m_bodyB->m_islandIndex;
-    m_localCenterA = m_bodyA->m_sweep.localCenter;
-    m_localCenterB = m_bodyB->m_sweep.localCenter;
-    m_invMassA = m_bodyA->m_invMass;
-    m_invMassB = m_bodyB->m_invMass;
-    m_invIA = m_bodyA->m_invI;
-    m_invIB = m_bodyB->m_invI;
+    m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+    m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+    m_invMassA = m_bodyA->m_sim->invMass;
+    m_invMassB = m_bodyB->m_sim->invMass;
+    m_invIA = m_bodyA->m_sim->invI;
+    m_invIB = m_bodyB->m_sim->invI;
 
     b2Vec2 cA = data.positions[m_indexA].c;
     float aA = data.positions[m_indexA].a;
@@ -337,6 +338,8 @@ float b2DistanceJoint::GetReactionTorque(float inv_dt) const
 
 float b2DistanceJoint::SetLength(float length)
 {
+    RecordInput(b2_replaySetLength, length);
+
     m_impulse = 0.0f;
     m_length = b2Max(b2_linearSlop, length);
     return m_length;
@@ -344,6 +347,8 @@ float b2DistanceJoint::SetLength(float length)
 
 float b2DistanceJoint::SetMinLength(float minLength)
 {
+    RecordInput(b2_replaySetMinLength, minLength);
+
     m_lowerImpulse = 0.0f;
     m_minLength = b2Clamp(minLength, b2_linearSlop, m_maxLength);
     return m_minLength;
@@ -351,6 +356,8 @@ float b2DistanceJoint::SetMinLength(float minLength)
 
 float b2DistanceJoint::SetMaxLength(float maxLength)
 {
+    RecordInput(b2_replaySetMaxLength, maxLength);
+
     m_upperImpulse = 0.0f;
     m_maxLength = b2Max(maxLength, m_minLength);
     return m_maxLength;
@@ -23,12 +23,16 @@
 #include <box2d/b2_fixture.h>
 #include <box2d/b2_block_allocator.h>
 #include <box2d/b2_broad_phase.h>
+#include <box2d/b2_capsule_shape.h>
 #include <box2d/b2_chain_shape.h>
 #include <box2d/b2_circle_shape.h>
 #include <box2d/b2_collision.h>
+#include <box2d/b2_compound_shape.h>
 #include <box2d/b2_contact.h>
 #include <box2d/b2_edge_shape.h>
+#include <box2d/b2_height_field_shape.h>
 #include <box2d/b2_polygon_shape.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_world.h>
 
 b2Fixture::b2Fixture()
@@ -58,15 +62,24 @@ void b2Fixture::Create(b2BlockAllocator* allocator, b2Body* body, const b2Fixtur
     m_shape = def->shape->Clone(allocator);
 
     // Reserve proxy space
-    std::int32_t childCount = m_shape->GetChildCount();
-    m_proxies = allocator->Allocate<b2FixtureProxy>(childCount);
-    for (std::int32_t i = 0; i < childCount; ++i)
+    std::int32_t proxyCapacity = m_shape->SharesProxy() ? 1 : m_shape->GetChildCount();
+    m_proxies = allocator->Allocate<b2FixtureProxy>(proxyCapacity);
+    for (std::int32_t i = 0; i < proxyCapacity; ++i)
     {
         m_proxies[i].fixture = nullptr;
         m_proxies[i].proxyId = b2BroadPhase::e_nullProxy;
     }
     m_proxyCount = 0;
 
+    // Bound the shape in body coordinates. This bounds how far the shape moves for a
+    // given body motion.
+    b2Transform identity;
+    identity.SetIdentity();
+    b2AABB aabb;
+    m_shape->ComputeProxyAABB(&aabb, identity);
+    b2Vec2 extent = b2Max(b2Abs(aabb.lowerBound), b2Abs(aabb.upperBound));
+    m_extent = extent.Length();
+
     m_density = def->density;
 }
 
@@ -76,8 +89,8 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
     assert(m_proxyCount == 0);
 
     // Free the proxy array.
-    std::int32_t childCount = m_shape->GetChildCount();
-    allocator->Free(m_proxies, childCount);
+    std::int32_t proxyCapacity = m_shape->SharesProxy() ? 1 : m_shape->GetChildCount();
+    allocator->Free(m_proxies, proxyCapacity);
     m_proxies = nullptr;
 
     // Free the child shape.
@@ -115,6 +128,30 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
         }
         break;
 
+    case b2Shape::e_heightField:
+        {
+            b2HeightFieldShape* s = (b2HeightFieldShape*)m_shape;
+            s->~b2HeightFieldShape();
+            allocator->Free(s);
+        }
+        break;
+
+    case b2Shape::e_capsule:
+        {
+            b2CapsuleShape* s = (b2CapsuleShape*)m_shape;
+            s->~b2CapsuleShape();
+            allocator->Free(s);
+        }
+        break;
+
+    case b2Shape::e_compound:
+        {
+            b2CompoundShape* s = (b2CompoundShape*)m_shape;
+            s->~b2CompoundShape();
+            allocator->Free(s);
+        }
+        break;
+
     default:
         assert(false);
         break;
@@ -127,17 +164,28 @@ void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 {
     assert(m_proxyCount == 0);
 
-    // Create proxies in the broad-phase.
-    m_proxyCount = m_shape->GetChildCount();
+    // Create proxies in the broad-phase. A shape that shares a proxy gets one
+    // proxy covering all children.
+    bool sharesProxy = m_shape->SharesProxy();
+    m_proxyCount = sharesProxy ? 1 : m_shape->GetChildCount();
 
     for (std::int32_t i = 0; i < m_proxyCount; ++i)
     {
         b2FixtureProxy* proxy = m_proxies + i;
-        m_shape->ComputeAABB(&proxy->aabb, xf, i);
+        if (sharesProxy)
+        {
+            m_shape->ComputeProxyAABB(&proxy->aabb, xf);
+        }
+        else
+        {
+            m_shape->ComputeAABB(&proxy->aabb, xf, i);
+        }
         proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
         proxy->fixture = this;
         proxy->childIndex = i;
     }
+
+    m_pairTransform = xf;
 }
 
 void b2Fixture::DestroyProxies(b2BroadPhase* broadPhase)
@@ -153,34 +201,84 @@ void b2Fixture::DestroyProxies(b2BroadPhase* broadPhase)
     m_proxyCount = 0;
 }
 
-void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transform1, const b2Transform& transform2)
+float b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transform1, const b2Transform& transform2)
 {
+    float slack = FLT_MAX;
     if (m_proxyCount == 0)
     {
-        return;
+        return slack;
     }
 
+    bool sharesProxy = m_shape->SharesProxy();
+
     for (std::int32_t i = 0; i < m_proxyCount; ++i)
     {
         b2FixtureProxy* proxy = m_proxies + i;
 
         // Compute an AABB that covers the swept shape (may miss some rotation effect).
         b2AABB aabb1, aabb2;
-        m_shape->ComputeAABB(&aabb1, transform1, proxy->childIndex);
-        m_shape->ComputeAABB(&aabb2, transform2, proxy->childIndex);
+        if (sharesProxy)
+        {
+            m_shape->ComputeProxyAABB(&aabb1, transform1);
+            m_shape->ComputeProxyAABB(&aabb2, transform2);
+        }
+        else
+        {
+            m_shape->ComputeAABB(&aabb1, transform1, proxy->childIndex);
+            m_shape->ComputeAABB(&aabb2, transform2, proxy->childIndex);
+        }
 
         proxy->aabb.Combine(aabb1, aabb2);
 
         b2Vec2 displacement = aabb2.GetCenter() - aabb1.GetCenter();
 
-        broadPhase->MoveProxy(proxy->proxyId, proxy->aabb, displacement);
+        bool buffered = broadPhase->MoveProxy(proxy->proxyId, proxy->aabb, displacement);
+
+        // The proxy stays put while the swept AABB is inside the fat AABB and the fat AABB
+        // is not huge. See b2DynamicTree::MoveProxy. Later swept AABBs are within the
+        // motion bound of the AABB at transform2.
+        const b2AABB& fatAABB = broadPhase->GetFatAABB(proxy->proxyId);
+        float extension = broadPhase->GetMargin(proxy->proxyId) + broadPhase->GetHugeExtension(proxy->proxyId);
+        b2Vec2 lowerGap = aabb2.lowerBound - fatAABB.lowerBound;
+        b2Vec2 upperGap = fatAABB.upperBound - aabb2.upperBound;
+        float minGap = b2Min(b2Min(lowerGap.x, lowerGap.y), b2Min(upperGap.x, upperGap.y));
+        float maxGap = b2Max(b2Max(lowerGap.x, lowerGap.y), b2Max(upperGap.x, upperGap.y));
+        slack = b2Min(slack, b2Min(minGap, extension - maxGap));
+
+        if (sharesProxy)
+        {
+            // The children move inside the fat proxy. Their pairs are found with half
+            // the AABB extension to spare, so refresh them once a child point may have
+            // moved that far since the last refresh.
+            float move = b2MotionBound(m_pairTransform, transform2, m_extent);
+            if (buffered || move > 0.5f * b2_aabbExtension)
+            {
+                if (buffered == false)
+                {
+                    broadPhase->TouchProxy(proxy->proxyId);
+                }
+
+                m_pairTransform = transform2;
+                move = 0.0f;
+            }
+
+            slack = b2Min(slack, 0.5f * b2_aabbExtension - move);
+        }
     }
+
+    return slack;
 }
 
 void b2Fixture::SetFilterData(const b2Filter& filter)
 {
     m_filter = filter;
 
+    b2ReplayRecorder* recorder = m_body->GetWorld()->m_recorder;
+    if (recorder != nullptr)
+    {
+        recorder->RecordFixtureInput(this, b2_replaySetFilter);
+    }
+
     Refilter();
 }
 
@@ -227,6 +325,12 @@ void b2Fixture::SetSensor(bool sensor)
     {
         m_body->SetAwake(true);
         m_isSensor = sensor;
+
+        b2ReplayRecorder* recorder = m_body->GetWorld()->m_recorder;
+        if (recorder != nullptr)
+        {
+            recorder->RecordFixtureInput(this, b2_replaySetSensor);
+        }
     }
 }
 
@@ -291,6 +395,88 @@ void b2Fixture::Dump(std::int32_t bodyIndex)
             b2Dump("    shape.CreateChain(vs, %d);\n", s->m_count);
             b2Dump("    shape.m_prevVertex.Set(%.9g, %.9g);\n", s->m_prevVertex.x, s->m_prevVertex.y);
             b2Dump("    shape.m_nextVertex.Set(%.9g, %.9g);\n", s->m_nextVertex.x, s->m_nextVertex.y);
+            if (s->IsSingleProxy())
+            {
+                b2Dump("    shape.SetSingleProxy(true);\n");
+            }
+        }
+        break;
+
+    case b2Shape::e_heightField:
+        {
+            b2HeightFieldShape* s = (b2HeightFieldShape*)m_shape;
+            b2Dump("    b2HeightFieldShape shape;\n");
+            b2Dump("    float hs[%d];\n", s->m_count);
+            for (std::int32_t i = 0; i < s->m_count; ++i)
+            {
+                b2Dump("    hs[%d] = %.9g;\n", i, s->m_heights[i]);
+            }
+            b2Dump("    shape.Create(hs, %d, %.9g);\n", s->m_count, s->m_spacing);
+        }
+        break;
+
+    case b2Shape::e_capsule:
+        {
+            b2CapsuleShape* s = (b2CapsuleShape*)m_shape;
+            b2Dump("    b2CapsuleShape shape;\n");
+            b2Dump("    shape.m_radius = %.9g;\n", s->m_radius);
+            b2Dump("    shape.m_vertex1.Set(%.9g, %.9g);\n", s->m_vertex1.x, s->m_vertex1.y);
+            b2Dump("    shape.m_vertex2.Set(%.9g, %.9g);\n", s->m_vertex2.x, s->m_vertex2.y);
+        }
+        break;
+
+    case b2Shape::e_compound:
+        {
+            b2CompoundShape* s = (b2CompoundShape*)m_shape;
+            b2Dump("    b2CompoundShape shape;\n");
+            for (std::int32_t i = 0; i < s->m_count; ++i)
+            {
+                const b2Shape* child = s->GetChild(i);
+                switch (child->m_type)
+                {
+                case b2Shape::e_circle:
+                    {
+                        const b2CircleShape* c = (const b2CircleShape*)child;
+                        b2Dump("    b2CircleShape child%d;\n", i);
+                        b2Dump("    child%d.m_radius = %.9g;\n", i, c->m_radius);
+                        b2Dump("    child%d.m_p.Set(%.9g, %.9g);\n", i, c->m_p.x, c->m_p.y);
+                    }
+                    break;
+
+                case b2Shape::e_polygon:
+                    {
+                        const b2PolygonShape* c = (const b2PolygonShape*)child;
+                        b2Dump("    b2PolygonShape child%d;\n", i);
+                        b2Dump("    b2Vec2 vs%d[%d];\n", i, b2_maxPolygonVertices);
+                        for (std::int32_t j = 0; j < c->m_count; ++j)
+                        {
+                            b2Dump("    vs%d[%d].Set(%.9g, %.9g);\n", i, j, c->m_vertices[j].x, c->m_vertices[j].y);
+                        }
+                        b2Dump("    child%d.Set(vs%d, %d);\n", i, i, c->m_count);
+                        b2Dump("    child%d.m_radius = %.9g;\n", i, c->m_radius);
+                    }
+                    break;
+
+                case b2Shape::e_capsule:
+                    {
+                        const b2CapsuleShape* c = (const b2CapsuleShape*)child;
+                        b2Dump("    b2CapsuleShape child%d;\n", i);
+                        b2Dump("    child%d.m_radius = %.9g;\n", i, c->m_radius);
+                        b2Dump("    child%d.m_vertex1.Set(%.9g, %.9g);\n", i, c->m_vertex1.x, c->m_vertex1.y);
+                        b2Dump("    child%d.m_vertex2.Set(%.9g, %.9g);\n", i, c->m_vertex2.x, c->m_vertex2.y);
+                    }
+                    break;
+
+                default:
+                    break;
+                }
+            }
+            b2Dump("    const b2Shape* children[%d];\n", s->m_count);
+            for (std::int32_t i = 0; i < s->m_count; ++i)
+            {
+                b2Dump("    children[%d] = &child%d;\n", i, i);
+            }
+            b2Dump("    shape.Create(children, %d);\n", s->m_count);
         }
         break;
 
@@ -22,6 +22,7 @@
 
 #include <box2d/b2_friction_joint.h>
 #include <box2d/b2_body.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_time_step.h>
 
 // Point-to-point constraint
@@ -61,12 +62,12 @@ void b2FrictionJoint::InitVelocityConstraints(const b2SolverData& data)
 {
     m_indexA = m_bodyA->m_islandIndex;
     m_indexB = m_bodyB->m_islandIndex;
-    m_localCenterA = m_bodyA->m_sweep.localCenter;
-    m_localCenterB = m_bodyB->m_sweep.localCenter;
-    m_invMassA = m_bodyA->m_invMass;
-    m_invMassB = m_bodyB->m_invMass;
-    m_invIA = m_bodyA->m_invI;
-    m_invIB = m_bodyB->m_invI;
+    m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+    m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+    m_invMassA = m_bodyA->m_sim->invMass;
+    m_invMassB = m_bodyB->m_sim->invMass;
+    m_invIA = m_bodyA->m_sim->invI;
+    m_invIB = m_bodyB->m_sim->invI;
 
     float aA = data.positions[m_indexA].a;
     b2Vec2 vA = data.velocities[m_indexA].v;
@@ -219,6 +220,7 @@ float b2FrictionJoint::GetReactionTorque(float inv_dt) const
 void b2FrictionJoint::SetMaxForce(float force)
 {
     assert(b2IsValid(force) && force >= 0.0f);
+    RecordInput(b2_replaySetMaxForce, force);
     m_maxForce = force;
 }
 
@@ -230,6 +232,7 @@ float b2FrictionJoint::GetMaxForce() const
 void b2FrictionJoint::SetMaxTorque(float torque)
 {
     assert(b2IsValid(torque) && torque >= 0.0f);
+    RecordInput(b2_replaySetMaxTorque, torque);
     m_maxTorque = torque;
 }
 
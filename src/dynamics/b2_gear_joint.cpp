@@ -24,6 +24,7 @@
 #include <box2d/b2_revolute_joint.h>
 #include <box2d/b2_prismatic_joint.h>
 #include <box2d/b2_body.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_time_step.h>
 
 // Gear Joint:
@@ -68,10 +69,10 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
     assert(m_bodyA->m_type == b2_dynamicBody);
 
     // Get geometry of joint1
-    b2Transform xfA = m_bodyA->m_xf;
-    float aA = m_bodyA->m_sweep.a;
-    b2Transform xfC = m_bodyC->m_xf;
-    float aC = m_bodyC->m_sweep.a;
+    b2Transform xfA = m_bodyA->m_sim->xf;
+    float aA = m_bodyA->m_sim->sweep.a;
+    b2Transform xfC = m_bodyC->m_sim->xf;
+    float aC = m_bodyC->m_sim->sweep.a;
 
     if (m_typeA == e_revoluteJoint)
     {
@@ -109,10 +110,10 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
     assert(m_bodyB->m_type == b2_dynamicBody);
 
     // Get geometry of joint2
-    b2Transform xfB = m_bodyB->m_xf;
-    float aB = m_bodyB->m_sweep.a;
-    b2Transform xfD = m_bodyD->m_xf;
-    float aD = m_bodyD->m_sweep.a;
+    b2Transform xfB = m_bodyB->m_sim->xf;
+    float aB = m_bodyB->m_sim->sweep.a;
+    b2Transform xfD = m_bodyD->m_sim->xf;
+    float aD = m_bodyD->m_sim->sweep.a;
 
     if (m_typeB == e_revoluteJoint)
     {
@@ -150,18 +151,18 @@ void b2GearJoint::InitVelocityConstraints(const b2SolverData& data)
     m_indexB = m_bodyB->m_islandIndex;
     m_indexC = m_bodyC->m_islandIndex;
     m_indexD = m_bodyD->m_islandIndex;
-    m_lcA = m_bodyA->m_sweep.localCenter;
-    m_lcB = m_bodyB->m_sweep.localCenter;
-    m_lcC = m_bodyC->m_sweep.localCenter;
-    m_lcD = m_bodyD->m_sweep.localCenter;
-    m_mA = m_bodyA->m_invMass;
-    m_mB = m_bodyB->m_invMass;
-    m_mC = m_bodyC->m_invMass;
-    m_mD = m_bodyD->m_invMass;
-    m_iA = m_bodyA->m_invI;
-    m_iB = m_bodyB->m_invI;
-    m_iC = m_bodyC->m_invI;
-    m_iD = m_bodyD->m_invI;
+    m_lcA = m_bodyA->m_sim->sweep.localCenter;
+    m_lcB = m_bodyB->m_sim->sweep.localCenter;
+    m_lcC = m_bodyC->m_sim->sweep.localCenter;
+    m_lcD = m_bodyD->m_sim->sweep.localCenter;
+    m_mA = m_bodyA->m_sim->invMass;
+    m_mB = m_bodyB->m_sim->invMass;
+    m_mC = m_bodyC->m_sim->invMass;
+    m_mD = m_bodyD->m_sim->invMass;
+    m_iA = m_bodyA->m_sim->invI;
+    m_iB = m_bodyB->m_sim->invI;
+    m_iC = m_bodyC->m_sim->invI;
+    m_iD = m_bodyD->m_sim->invI;
 
     float aA = data.positions[m_indexA].a;
     b2Vec2 vA = data.velocities[m_indexA].v;
@@ -410,6 +411,7 @@ float b2GearJoint::GetReactionTorque(float inv_dt) const
 void b2GearJoint::SetRatio(float ratio)
 {
     assert(b2IsValid(ratio));
+    RecordInput(b2_replaySetRatio, ratio);
     m_ratio = ratio;
 }
 
@@ -195,21 +195,22 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
     for (std::int32_t i = 0; i < m_bodyCount; ++i)
     {
         b2Body* b = m_bodies[i];
+        b2BodySim* sim = b->m_sim;
 
-        b2Vec2 c = b->m_sweep.c;
-        float a = b->m_sweep.a;
-        b2Vec2 v = b->m_linearVelocity;
-        float w = b->m_angularVelocity;
+        b2Vec2 c = sim->sweep.c;
+        float a = sim->sweep.a;
+        b2Vec2 v = sim->linearVelocity;
+        float w = sim->angularVelocity;
 
         // Store positions for continuous collision.
-        b->m_sweep.c0 = b->m_sweep.c;
-        b->m_sweep.a0 = b->m_sweep.a;
+        sim->sweep.c0 = sim->sweep.c;
+        sim->sweep.a0 = sim->sweep.a;
 
         if (b->m_type == b2_dynamicBody)
         {
             // Integrate velocities.
-            v += h * b->m_invMass * (b->m_gravityScale * b->m_mass * gravity + b->m_force);
-            w += h * b->m_invI * b->m_torque;
+            v += h * sim->invMass * (sim->gravityScale * sim->mass * gravity + sim->force);
+            w += h * sim->invI * sim->torque;
 
             // Apply damping.
             // ODE: dv/dt + c * v = 0
@@ -218,8 +219,8 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
             // v2 = exp(-c * dt) * v1
             // Pade approximation:
             // v2 = v1 * 1 / (1 + c * dt)
-            v *= 1.0f / (1.0f + h * b->m_linearDamping);
-            w *= 1.0f / (1.0f + h * b->m_angularDamping);
+            v *= 1.0f / (1.0f + h * sim->linearDamping);
+            w *= 1.0f / (1.0f + h * sim->angularDamping);
         }
 
         m_positions[i].c = c;
@@ -335,10 +336,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
     for (std::int32_t i = 0; i < m_bodyCount; ++i)
     {
         b2Body* body = m_bodies[i];
-        body->m_sweep.c = m_positions[i].c;
-        body->m_sweep.a = m_positions[i].a;
-        body->m_linearVelocity = m_velocities[i].v;
-        body->m_angularVelocity = m_velocities[i].w;
+        b2BodySim* sim = body->m_sim;
+        sim->sweep.c = m_positions[i].c;
+        sim->sweep.a = m_positions[i].a;
+        sim->linearVelocity = m_velocities[i].v;
+        sim->angularVelocity = m_velocities[i].w;
         body->SynchronizeTransform();
     }
 
@@ -361,17 +363,18 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
                 continue;
             }
 
-            if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-                b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-                b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+            b2BodySim* sim = b->m_sim;
+            if ((sim->flags & b2Body::e_autoSleepFlag) == 0 ||
+                sim->angularVelocity * sim->angularVelocity > angTolSqr ||
+                b2Dot(sim->linearVelocity, sim->linearVelocity) > linTolSqr)
             {
-                b->m_sleepTime = 0.0f;
+                sim->sleepTime = 0.0f;
                 minSleepTime = 0.0f;
             }
             else
             {
-                b->m_sleepTime += h;
-                minSleepTime = b2Min(minSleepTime, b->m_sleepTime);
+                sim->sleepTime += h;
+                minSleepTime = b2Min(minSleepTime, sim->sleepTime);
             }
         }
 
@@ -395,10 +398,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, std::int32_t toiIndexA, std::
     for (std::int32_t i = 0; i < m_bodyCount; ++i)
     {
         b2Body* b = m_bodies[i];
-        m_positions[i].c = b->m_sweep.c;
-        m_positions[i].a = b->m_sweep.a;
-        m_velocities[i].v = b->m_linearVelocity;
-        m_velocities[i].w = b->m_angularVelocity;
+        m_positions[i].c = b->m_sim->sweep.c;
+        m_positions[i].a = b->m_sim->sweep.a;
+        m_velocities[i].v = b->m_sim->linearVelocity;
+        m_velocities[i].w = b->m_sim->angularVelocity;
     }
 
     b2ContactSolverDef contactSolverDef;
@@ -454,10 +457,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, std::int32_t toiIndexA, std::
 #endif
 
     // Leap of faith to new safe state.
-    m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-    m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-    m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-    m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+    m_bodies[toiIndexA]->m_sim->sweep.c0 = m_positions[toiIndexA].c;
+    m_bodies[toiIndexA]->m_sim->sweep.a0 = m_positions[toiIndexA].a;
+    m_bodies[toiIndexB]->m_sim->sweep.c0 = m_positions[toiIndexB].c;
+    m_bodies[toiIndexB]->m_sim->sweep.a0 = m_positions[toiIndexB].a;
 
     // No warm starting is needed for TOI events because warm
     // starting impulses were applied in the discrete solver.
@@ -508,10 +511,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, std::int32_t toiIndexA, std::
 
         // Sync bodies
         b2Body* body = m_bodies[i];
-        body->m_sweep.c = c;
-        body->m_sweep.a = a;
-        body->m_linearVelocity = v;
-        body->m_angularVelocity = w;
+        body->m_sim->sweep.c = c;
+        body->m_sim->sweep.a = a;
+        body->m_sim->linearVelocity = v;
+        body->m_sim->angularVelocity = w;
         body->SynchronizeTransform();
     }
 
@@ -30,6 +30,7 @@
 #include <box2d/b2_mouse_joint.h>
 #include <box2d/b2_prismatic_joint.h>
 #include <box2d/b2_pulley_joint.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_revolute_joint.h>
 #include <box2d/b2_weld_joint.h>
 #include <box2d/b2_wheel_joint.h>
@@ -252,6 +253,15 @@ bool b2Joint::IsEnabled() const
     return m_bodyA->IsEnabled() && m_bodyB->IsEnabled();
 }
 
+void b2Joint::RecordInput(std::int32_t input, float a, float b)
+{
+    b2ReplayRecorder* recorder = m_bodyA->GetWorld()->m_recorder;
+    if (recorder != nullptr)
+    {
+        recorder->RecordJointInput(this, input, a, b);
+    }
+}
+
 void b2Joint::Draw(b2Draw* draw) const
 {
     const b2Transform& xf1 = m_bodyA->GetTransform();
@@ -22,6 +22,7 @@
 
 #include <box2d/b2_body.h>
 #include <box2d/b2_motor_joint.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_time_step.h>
 
 // Point-to-point constraint
@@ -69,12 +70,12 @@ void b2MotorJoint::InitVelocityConstraints(const b2SolverData& data)
 {
     m_indexA = m_bodyA->m_islandIndex;
     m_indexB = m_bodyB->m_islandIndex;
-    m_localCenterA = m_bodyA->m_sweep.localCenter;
-    m_localCenterB = m_bodyB->m_sweep.localCenter;
-    m_invMassA = m_bodyA->m_invMass;
-    m_invMassB = m_bodyB->m_invMass;
-    m_invIA = m_bodyA->m_invI;
-    m_invIB = m_bodyB->m_invI;
+    m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+    m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+    m_invMassA = m_bodyA->m_sim->invMass;
+    m_invMassB = m_bodyB->m_sim->invMass;
+    m_invIA = m_bodyA->m_sim->invI;
+    m_invIB = m_bodyB->m_sim->invI;
 
     b2Vec2 cA = data.positions[m_indexA].c;
     float aA = data.positions[m_indexA].a;
@@ -233,6 +234,7 @@ float b2MotorJoint::GetReactionTorque(float inv_dt) const
 void b2MotorJoint::SetMaxForce(float force)
 {
     assert(b2IsValid(force) && force >= 0.0f);
+    RecordInput(b2_replaySetMaxForce, force);
     m_maxForce = force;
 }
 
@@ -244,6 +246,7 @@ float b2MotorJoint::GetMaxForce() const
 void b2MotorJoint::SetMaxTorque(float torque)
 {
     assert(b2IsValid(torque) && torque >= 0.0f);
+    RecordInput(b2_replaySetMaxTorque, torque);
     m_maxTorque = torque;
 }
 
@@ -255,6 +258,7 @@ float b2MotorJoint::GetMaxTorque() const
 void b2MotorJoint::SetCorrectionFactor(float factor)
 {
     assert(b2IsValid(factor) && 0.0f <= factor && factor <= 1.0f);
+    RecordInput(b2_replaySetCorrectionFactor, factor);
     m_correctionFactor = factor;
 }
 
@@ -265,6 +269,8 @@ float b2MotorJoint::GetCorrectionFactor() const
 
 void b2MotorJoint::SetLinearOffset(const b2Vec2& linearOffset)
 {
+    RecordInput(b2_replaySetLinearOffset, linearOffset.x, linearOffset.y);
+
     if (linearOffset.x != m_linearOffset.x || linearOffset.y != m_linearOffset.y)
     {
         m_bodyA->SetAwake(true);
@@ -280,6 +286,8 @@ const b2Vec2& b2MotorJoint::GetLinearOffset() const
 
 void b2MotorJoint::SetAngularOffset(float angularOffset)
 {
+    RecordInput(b2_replaySetAngularOffset, angularOffset);
+
     if (angularOffset != m_angularOffset)
     {
         m_bodyA->SetAwake(true);
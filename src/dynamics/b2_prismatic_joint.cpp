@@ -23,6 +23,7 @@
 #include <box2d/b2_body.h>
 #include <box2d/b2_draw.h>
 #include <box2d/b2_prismatic_joint.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_time_step.h>
 
 // Linear constraint (point-to-line)
@@ -115,12 +116,12 @@ void b2PrismaticJoint::InitVelocityConstraints(const b2SolverData& data)
 {
     m_indexA = m_bodyA->m_islandIndex;
     m_indexB = m_bodyB->m_islandIndex;
-    m_localCenterA = m_bodyA->m_sweep.localCenter;
-    m_localCenterB = m_bodyB->m_sweep.localCenter;
-    m_invMassA = m_bodyA->m_invMass;
-    m_invMassB = m_bodyB->m_invMass;
-    m_invIA = m_bodyA->m_invI;
-    m_invIB = m_bodyB->m_invI;
+    m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+    m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+    m_invMassA = m_bodyA->m_sim->invMass;
+    m_invMassB = m_bodyB->m_sim->invMass;
+    m_invIA = m_bodyA->m_sim->invI;
+    m_invIB = m_bodyB->m_sim->invI;
 
     b2Vec2 cA = data.positions[m_indexA].c;
     float aA = data.positions[m_indexA].a;
@@ -486,17 +487,17 @@ float b2PrismaticJoint::GetJointSpeed() const
     b2Body* bA = m_bodyA;
     b2Body* bB = m_bodyB;
 
-    b2Vec2 rA = b2Mul(bA->m_xf.q, m_localAnchorA - bA->m_sweep.localCenter);
-    b2Vec2 rB = b2Mul(bB->m_xf.q, m_localAnchorB - bB->m_sweep.localCenter);
-    b2Vec2 p1 = bA->m_sweep.c + rA;
-    b2Vec2 p2 = bB->m_sweep.c + rB;
+    b2Vec2 rA = b2Mul(bA->m_sim->xf.q, m_localAnchorA - bA->m_sim->sweep.localCenter);
+    b2Vec2 rB = b2Mul(bB->m_sim->xf.q, m_localAnchorB - bB->m_sim->sweep.localCenter);
+    b2Vec2 p1 = bA->m_sim->sweep.c + rA;
+    b2Vec2 p2 = bB->m_sim->sweep.c + rB;
     b2Vec2 d = p2 - p1;
-    b2Vec2 axis = b2Mul(bA->m_xf.q, m_localXAxisA);
+    b2Vec2 axis = b2Mul(bA->m_sim->xf.q, m_localXAxisA);
 
-    b2Vec2 vA = bA->m_linearVelocity;
-    b2Vec2 vB = bB->m_linearVelocity;
-    float wA = bA->m_angularVelocity;
-    float wB = bB->m_angularVelocity;
+    b2Vec2 vA = bA->m_sim->linearVelocity;
+    b2Vec2 vB = bB->m_sim->linearVelocity;
+    float wA = bA->m_sim->angularVelocity;
+    float wB = bB->m_sim->angularVelocity;
 
     float speed = b2Dot(d, b2Cross(wA, axis)) + b2Dot(axis, vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA));
     return speed;
@@ -509,6 +510,8 @@ bool b2PrismaticJoint::IsLimitEnabled() const
 
 void b2PrismaticJoint::EnableLimit(bool flag)
 {
+    RecordInput(b2_replayEnableLimit, flag ? 1.0f : 0.0f);
+
     if (flag != m_enableLimit)
     {
         m_bodyA->SetAwake(true);
@@ -532,6 +535,9 @@ float b2PrismaticJoint::GetUpperLimit() const
 void b2PrismaticJoint::SetLimits(float lower, float upper)
 {
     assert(lower <= upper);
+
+    RecordInput(b2_replaySetLimits, lower, upper);
+
     if (lower != m_lowerTranslation || upper != m_upperTranslation)
     {
         m_bodyA->SetAwake(true);
@@ -550,6 +556,8 @@ bool b2PrismaticJoint::IsMotorEnabled() const
 
 void b2PrismaticJoint::EnableMotor(bool flag)
 {
+    RecordInput(b2_replayEnableMotor, flag ? 1.0f : 0.0f);
+
     if (flag != m_enableMotor)
     {
         m_bodyA->SetAwake(true);
@@ -560,6 +568,8 @@ void b2PrismaticJoint::EnableMotor(bool flag)
 
 void b2PrismaticJoint::SetMotorSpeed(float speed)
 {
+    RecordInput(b2_replaySetMotorSpeed, speed);
+
     if (speed != m_motorSpeed)
     {
         m_bodyA->SetAwake(true);
@@ -570,6 +580,8 @@ void b2PrismaticJoint::SetMotorSpeed(float speed)
 
 void b2PrismaticJoint::SetMaxMotorForce(float force)
 {
+    RecordInput(b2_replaySetMaxMotorForce, force);
+
     if (force != m_maxMotorForce)
     {
         m_bodyA->SetAwake(true);
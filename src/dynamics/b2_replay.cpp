@@ -0,0 +1,1251 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "b2_scene_stream.h"
+
+#include <box2d/b2_body.h>
+#include <box2d/b2_distance_joint.h>
+#include <box2d/b2_fixture.h>
+#include <box2d/b2_friction_joint.h>
+#include <box2d/b2_gear_joint.h>
+#include <box2d/b2_joint.h>
+#include <box2d/b2_motor_joint.h>
+#include <box2d/b2_prismatic_joint.h>
+#include <box2d/b2_replay.h>
+#include <box2d/b2_revolute_joint.h>
+#include <box2d/b2_scene.h>
+#include <box2d/b2_timer.h>
+#include <box2d/b2_wheel_joint.h>
+#include <box2d/b2_world.h>
+
+#include <cstring>
+
+static_assert(sizeof(b2ReplayHeader) % 4 == 0, "replay events must keep four byte alignment");
+static_assert(sizeof(b2ReplayBodyState) == 44, "body states are compared byte by byte");
+static_assert(sizeof(b2ReplayWorldSettings) == 8, "world settings are compared byte by byte");
+
+static void b2ClearIndexMap(b2ReplayIndexMap* map)
+{
+    for (std::int32_t i = 0; i < map->capacity; ++i)
+    {
+        map->indices[i] = -1;
+    }
+}
+
+static void b2FreeIndexMap(b2ReplayIndexMap* map)
+{
+    b2Free(map->indices);
+    map->indices = nullptr;
+    map->capacity = 0;
+}
+
+static void b2SetIndex(b2ReplayIndexMap* map, std::int32_t handleIndex, std::int32_t index)
+{
+    assert(handleIndex >= 0);
+    if (handleIndex >= map->capacity)
+    {
+        std::int32_t oldCapacity = map->capacity;
+        std::int32_t* oldIndices = map->indices;
+        map->capacity = b2Max(2 * oldCapacity, b2Max(handleIndex + 1, 16));
+        map->indices = (std::int32_t*)b2Alloc(map->capacity * sizeof(std::int32_t));
+        if (oldIndices != nullptr)
+        {
+            memcpy(map->indices, oldIndices, oldCapacity * sizeof(std::int32_t));
+            b2Free(oldIndices);
+        }
+
+        for (std::int32_t i = oldCapacity; i < map->capacity; ++i)
+        {
+            map->indices[i] = -1;
+        }
+    }
+
+    map->indices[handleIndex] = index;
+}
+
+static std::int32_t b2GetIndex(const b2ReplayIndexMap* map, std::int32_t handleIndex)
+{
+    return handleIndex < map->capacity ? map->indices[handleIndex] : -1;
+}
+
+// Grow an object array so that it holds at least count objects.
+template <typename T>
+static void b2GrowArray(T*** array, std::int32_t* capacity, std::int32_t size, std::int32_t count)
+{
+    if (count <= *capacity)
+    {
+        return;
+    }
+
+    T** oldArray = *array;
+    *capacity = b2Max(2 * *capacity, b2Max(count, 16));
+    *array = (T**)b2Alloc(*capacity * sizeof(T*));
+    if (oldArray != nullptr)
+    {
+        memcpy(*array, oldArray, size * sizeof(T*));
+        b2Free(oldArray);
+    }
+}
+
+// Visit the objects of a scene that was just saved or loaded with their index in the
+// scene. Bodies and joints are prepended to the world lists and fixtures to the body
+// lists, so each list holds its part of the scene in reverse. Gear joints come after
+// the other joints in a scene and mouse joints are left out.
+template <typename BodyVisitor, typename FixtureVisitor, typename JointVisitor>
+static void b2VisitScene(b2World* world, std::int32_t bodyCount, std::int32_t fixtureCount, std::int32_t jointCount,
+    BodyVisitor visitBody, FixtureVisitor visitFixture, JointVisitor visitJoint)
+{
+    std::int32_t fixtureEnd = fixtureCount;
+    b2Body* body = world->GetBodyList();
+    for (std::int32_t bodyIndex = bodyCount - 1; bodyIndex >= 0; --bodyIndex)
+    {
+        assert(body != nullptr);
+        visitBody(body, bodyIndex);
+
+        std::int32_t count = 0;
+        for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+        {
+            visitFixture(f, fixtureEnd - 1 - count);
+            ++count;
+        }
+
+        fixtureEnd -= count;
+        body = body->GetNext();
+    }
+
+    assert(fixtureEnd == 0);
+
+    std::int32_t gearCount = 0;
+    std::int32_t count = 0;
+    for (b2Joint* j = world->GetJointList(); j && count < jointCount; j = j->GetNext())
+    {
+        if (j->GetType() != e_mouseJoint)
+        {
+            gearCount += j->GetType() == e_gearJoint ? 1 : 0;
+            ++count;
+        }
+    }
+
+    std::int32_t gearIndex = jointCount;
+    std::int32_t jointIndex = jointCount - gearCount;
+    count = 0;
+    for (b2Joint* j = world->GetJointList(); j && count < jointCount; j = j->GetNext())
+    {
+        if (j->GetType() != e_mouseJoint)
+        {
+            visitJoint(j, j->GetType() == e_gearJoint ? --gearIndex : --jointIndex);
+            ++count;
+        }
+    }
+}
+
+b2ReplayRecorder::b2ReplayRecorder()
+{
+    m_world = nullptr;
+    m_data = nullptr;
+    m_capacity = 0;
+    m_size = 0;
+    m_bodyMap = { nullptr, 0 };
+    m_fixtureMap = { nullptr, 0 };
+    m_jointMap = { nullptr, 0 };
+    m_settings = { 0, 0 };
+    m_bodyStates = nullptr;
+    m_bodyStateCapacity = 0;
+    m_bodyCount = 0;
+    m_fixtureCount = 0;
+    m_jointCount = 0;
+    m_stepCount = 0;
+}
+
+b2ReplayRecorder::~b2ReplayRecorder()
+{
+    End();
+    b2Free(m_data);
+    b2Free(m_bodyStates);
+    b2FreeIndexMap(&m_bodyMap);
+    b2FreeIndexMap(&m_fixtureMap);
+    b2FreeIndexMap(&m_jointMap);
+}
+
+void b2ReplayRecorder::Begin(b2World* world)
+{
+    assert(world->IsLocked() == false);
+    assert(world->m_recorder == nullptr || world->m_recorder == this);
+    End();
+
+    m_size = 0;
+    m_bodyCount = 0;
+    m_fixtureCount = 0;
+    m_jointCount = 0;
+    m_stepCount = 0;
+    b2ClearIndexMap(&m_bodyMap);
+    b2ClearIndexMap(&m_fixtureMap);
+    b2ClearIndexMap(&m_jointMap);
+
+    b2SceneWriter writer;
+    writer.data = m_data;
+    writer.capacity = m_capacity;
+    writer.size = 0;
+    writer.growable = true;
+
+    b2ReplayHeader header;
+    header.magic = b2_replayMagic;
+    header.version = b2_replayVersion;
+    writer.Write(header);
+
+    // The snapshot is saved straight into the recording.
+    std::uint32_t byteCount = static_cast<std::uint32_t>(world->SaveScene(nullptr, 0));
+    writer.Write(std::int32_t(b2_replayScene));
+    writer.Write(byteCount);
+    if (writer.size + byteCount > writer.capacity)
+    {
+        writer.Grow(writer.size + byteCount);
+    }
+
+    world->SaveScene(writer.data + writer.size, byteCount);
+    b2SceneHeader scene;
+    memcpy(&scene, writer.data + writer.size, sizeof(scene));
+    writer.size += byteCount;
+
+    m_world = world;
+    GetWorldSettings(&m_settings);
+    writer.Write(std::int32_t(b2_replayWorldSettings));
+    writer.Write(m_settings);
+    EndEvent(&writer);
+
+    m_world->m_recorder = this;
+    AddScene(scene.bodyCount, scene.fixtureCount, scene.jointCount);
+}
+
+void b2ReplayRecorder::End()
+{
+    if (m_world == nullptr)
+    {
+        return;
+    }
+
+    m_world->m_recorder = nullptr;
+    m_world = nullptr;
+}
+
+bool b2ReplayRecorder::IsRecording() const
+{
+    return m_world != nullptr;
+}
+
+const void* b2ReplayRecorder::GetData() const
+{
+    return m_data;
+}
+
+std::size_t b2ReplayRecorder::GetSize() const
+{
+    return m_size;
+}
+
+std::int32_t b2ReplayRecorder::GetStepCount() const
+{
+    return m_stepCount;
+}
+
+void b2ReplayRecorder::AddScene(std::int32_t bodyCount, std::int32_t fixtureCount, std::int32_t jointCount)
+{
+    b2VisitScene(m_world, bodyCount, fixtureCount, jointCount,
+        [this](b2Body* body, std::int32_t index) { AddBody(body, m_bodyCount + index); },
+        [this](b2Fixture* fixture, std::int32_t index) { AddFixture(fixture, m_fixtureCount + index); },
+        [this](b2Joint* joint, std::int32_t index) { AddJoint(joint, m_jointCount + index); });
+
+    m_bodyCount += bodyCount;
+    m_fixtureCount += fixtureCount;
+    m_jointCount += jointCount;
+}
+
+void b2ReplayRecorder::AddBody(b2Body* body, std::int32_t index)
+{
+    b2SetIndex(&m_bodyMap, body->m_id.index, index);
+
+    if (index >= m_bodyStateCapacity)
+    {
+        b2ReplayBodyState* oldStates = m_bodyStates;
+        std::int32_t oldCapacity = m_bodyStateCapacity;
+        m_bodyStateCapacity = b2Max(2 * oldCapacity, b2Max(index + 1, 16));
+        m_bodyStates = (b2ReplayBodyState*)b2Alloc(m_bodyStateCapacity * sizeof(b2ReplayBodyState));
+        if (oldStates != nullptr)
+        {
+            memcpy(m_bodyStates, oldStates, oldCapacity * sizeof(b2ReplayBodyState));
+            b2Free(oldStates);
+        }
+    }
+
+    // The player creates the body in the same state.
+    GetBodyState(body, m_bodyStates + index);
+}
+
+void b2ReplayRecorder::GetBodyState(const b2Body* body, b2ReplayBodyState* state) const
+{
+    const b2BodySim* sim = body->m_sim;
+    state->linearVelocity = sim->linearVelocity;
+    state->angularVelocity = sim->angularVelocity;
+    state->force = sim->force;
+    state->torque = sim->torque;
+    state->linearDamping = sim->linearDamping;
+    state->angularDamping = sim->angularDamping;
+    state->gravityScale = sim->gravityScale;
+    state->sleepTime = sim->sleepTime;
+    state->flags = 0;
+    state->flags |= (sim->flags & b2Body::e_awakeFlag) != 0 ? b2_sceneAwake : 0;
+    state->flags |= (sim->flags & b2Body::e_autoSleepFlag) != 0 ? b2_sceneAllowSleep : 0;
+    state->flags |= (sim->flags & b2Body::e_bulletFlag) != 0 ? b2_sceneBullet : 0;
+}
+
+void b2ReplayRecorder::GetWorldSettings(b2ReplayWorldSettings* settings) const
+{
+    settings->flags = 0;
+    settings->flags |= m_world->GetAllowSleeping() ? b2_replayAllowSleep : 0;
+    settings->flags |= m_world->GetWarmStarting() ? b2_replayWarmStarting : 0;
+    settings->flags |= m_world->GetContinuousPhysics() ? b2_replayContinuousPhysics : 0;
+    settings->flags |= m_world->GetSubStepping() ? b2_replaySubStepping : 0;
+    settings->flags |= m_world->GetAutoClearForces() ? b2_replayAutoClearForces : 0;
+    settings->flags |= m_world->GetTreeRefit() ? b2_replayTreeRefit : 0;
+    settings->flags |= m_world->GetManifoldReuse() ? b2_replayManifoldReuse : 0;
+    settings->treeOptimizationBudget = m_world->GetTreeOptimizationBudget();
+}
+
+void b2ReplayRecorder::AddFixture(b2Fixture* fixture, std::int32_t index)
+{
+    b2SetIndex(&m_fixtureMap, fixture->GetId().index, index);
+}
+
+void b2ReplayRecorder::AddJoint(b2Joint* joint, std::int32_t index)
+{
+    b2SetIndex(&m_jointMap, joint->GetId().index, index);
+}
+
+void b2ReplayRecorder::BeginEvent(b2SceneWriter* writer, std::int32_t type)
+{
+    writer->data = m_data;
+    writer->capacity = m_capacity;
+    writer->size = m_size;
+    writer->growable = true;
+
+    // The world setters are inline, so a change is written ahead of the next event.
+    b2ReplayWorldSettings settings;
+    GetWorldSettings(&settings);
+    if (memcmp(&settings, &m_settings, sizeof(settings)) != 0)
+    {
+        m_settings = settings;
+        writer->Write(std::int32_t(b2_replayWorldSettings));
+        writer->Write(settings);
+    }
+
+    writer->Write(type);
+}
+
+void b2ReplayRecorder::EndEvent(const b2SceneWriter* writer)
+{
+    m_data = writer->data;
+    m_capacity = writer->capacity;
+    m_size = writer->size;
+}
+
+void b2ReplayRecorder::RecordScene(const void* scene, std::uint32_t byteCount)
+{
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayScene);
+    writer.Write(byteCount);
+    writer.WriteArray(static_cast<const char*>(scene), byteCount);
+    EndEvent(&writer);
+
+    const b2SceneHeader* header = static_cast<const b2SceneHeader*>(scene);
+    AddScene(header->bodyCount, header->fixtureCount, header->jointCount);
+}
+
+void b2ReplayRecorder::RecordStep(float dt, std::int32_t velocityIterations, std::int32_t positionIterations)
+{
+    // The setters, forces and impulses between the time steps are inline, so instead of
+    // recording each call this compares the bodies with their state after the last step.
+    for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+    {
+        std::int32_t index = b2GetIndex(&m_bodyMap, b->m_id.index);
+        assert(index >= 0);
+
+        b2ReplayBodyState state;
+        GetBodyState(b, &state);
+        if (memcmp(&state, m_bodyStates + index, sizeof(state)) == 0)
+        {
+            continue;
+        }
+
+        m_bodyStates[index] = state;
+
+        b2SceneWriter bodyWriter;
+        BeginEvent(&bodyWriter, b2_replayBodyState);
+        bodyWriter.Write(index);
+        bodyWriter.Write(state);
+        EndEvent(&bodyWriter);
+    }
+
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayStep);
+    writer.Write(dt);
+    writer.Write(velocityIterations);
+    writer.Write(positionIterations);
+    EndEvent(&writer);
+    ++m_stepCount;
+}
+
+void b2ReplayRecorder::EndStep()
+{
+    for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+    {
+        std::int32_t index = b2GetIndex(&m_bodyMap, b->m_id.index);
+        GetBodyState(b, m_bodyStates + index);
+    }
+}
+
+void b2ReplayRecorder::RecordClear()
+{
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayClear);
+    EndEvent(&writer);
+}
+
+void b2ReplayRecorder::RecordGravity(const b2Vec2& gravity)
+{
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replaySetGravity);
+    writer.Write(gravity);
+    EndEvent(&writer);
+}
+
+void b2ReplayRecorder::RecordCreateBody(b2Body* body)
+{
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayCreateBody);
+    b2WriteSceneBody(&writer, body, 0);
+    EndEvent(&writer);
+
+    AddBody(body, m_bodyCount++);
+}
+
+void b2ReplayRecorder::RecordDestroyBody(b2Body* body)
+{
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayDestroyBody);
+    writer.Write(b2GetIndex(&m_bodyMap, body->m_id.index));
+    EndEvent(&writer);
+}
+
+void b2ReplayRecorder::RecordCreateFixture(b2Fixture* fixture)
+{
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayCreateFixture);
+    writer.Write(b2GetIndex(&m_bodyMap, fixture->GetBody()->m_id.index));
+    b2WriteSceneFixture(&writer, fixture);
+    EndEvent(&writer);
+
+    AddFixture(fixture, m_fixtureCount++);
+}
+
+void b2ReplayRecorder::RecordDestroyFixture(b2Fixture* fixture)
+{
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayDestroyFixture);
+    writer.Write(b2GetIndex(&m_fixtureMap, fixture->GetId().index));
+    EndEvent(&writer);
+}
+
+void b2ReplayRecorder::RecordCreateJoint(b2Joint* joint)
+{
+    if (joint->GetType() == e_mouseJoint)
+    {
+        b2SetIndex(&m_jointMap, joint->GetId().index, -1);
+        return;
+    }
+
+    std::int32_t joint1 = -1;
+    std::int32_t joint2 = -1;
+    if (joint->GetType() == e_gearJoint)
+    {
+        b2GearJoint* gear = static_cast<b2GearJoint*>(joint);
+        joint1 = b2GetIndex(&m_jointMap, gear->GetJoint1()->GetId().index);
+        joint2 = b2GetIndex(&m_jointMap, gear->GetJoint2()->GetId().index);
+    }
+
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayCreateJoint);
+    b2WriteSceneJoint(&writer, joint, b2GetIndex(&m_bodyMap, joint->GetBodyA()->m_id.index),
+        b2GetIndex(&m_bodyMap, joint->GetBodyB()->m_id.index), joint1, joint2);
+    EndEvent(&writer);
+
+    AddJoint(joint, m_jointCount++);
+}
+
+void b2ReplayRecorder::RecordDestroyJoint(b2Joint* joint)
+{
+    std::int32_t index = b2GetIndex(&m_jointMap, joint->GetId().index);
+    if (index < 0)
+    {
+        return;
+    }
+
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayDestroyJoint);
+    writer.Write(index);
+    EndEvent(&writer);
+
+    b2SetIndex(&m_jointMap, joint->GetId().index, -1);
+}
+
+void b2ReplayRecorder::RecordInput(b2Body* body, std::int32_t type, const b2Vec2& a, float value, bool flag)
+{
+    // Inside a time step the solver itself changes the bodies.
+    if (m_world->IsLocked())
+    {
+        return;
+    }
+
+    b2SceneWriter writer;
+    BeginEvent(&writer, type);
+    writer.Write(b2GetIndex(&m_bodyMap, body->m_id.index));
+
+    switch (type)
+    {
+    case b2_replaySetTransform:
+        writer.Write(a);
+        writer.Write(value);
+        break;
+
+    case b2_replaySetType:
+        writer.Write(std::int32_t(value));
+        break;
+
+    case b2_replaySetEnabled:
+    case b2_replaySetFixedRotation:
+        writer.WriteBool(flag);
+        break;
+
+    default:
+        assert(false);
+        break;
+    }
+
+    EndEvent(&writer);
+}
+
+void b2ReplayRecorder::RecordFixtureInput(b2Fixture* fixture, std::int32_t type)
+{
+    if (m_world->IsLocked())
+    {
+        return;
+    }
+
+    b2SceneWriter writer;
+    BeginEvent(&writer, type);
+    writer.Write(b2GetIndex(&m_fixtureMap, fixture->GetId().index));
+
+    switch (type)
+    {
+    case b2_replaySetFilter:
+        {
+            const b2Filter& filter = fixture->GetFilterData();
+            writer.Write(std::uint32_t(filter.categoryBits));
+            writer.Write(std::uint32_t(filter.maskBits));
+            writer.Write(std::int32_t(filter.groupIndex));
+        }
+        break;
+
+    case b2_replaySetSensor:
+        writer.WriteBool(fixture->IsSensor());
+        break;
+
+    default:
+        assert(false);
+        break;
+    }
+
+    EndEvent(&writer);
+}
+
+void b2ReplayRecorder::RecordJointInput(b2Joint* joint, std::int32_t input, float a, float b)
+{
+    // Mouse joints are not recorded.
+    std::int32_t index = b2GetIndex(&m_jointMap, joint->GetId().index);
+    if (m_world->IsLocked() || index < 0)
+    {
+        return;
+    }
+
+    b2SceneWriter writer;
+    BeginEvent(&writer, b2_replayJointInput);
+    writer.Write(index);
+    writer.Write(input);
+    writer.Write(a);
+    writer.Write(b);
+    EndEvent(&writer);
+}
+
+b2ReplayPlayer::b2ReplayPlayer()
+{
+    m_world = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_offset = 0;
+    m_bodies = nullptr;
+    m_fixtures = nullptr;
+    m_joints = nullptr;
+    m_bodyCapacity = 0;
+    m_fixtureCapacity = 0;
+    m_jointCapacity = 0;
+    m_bodyCount = 0;
+    m_fixtureCount = 0;
+    m_jointCount = 0;
+    m_fixtureMap = { nullptr, 0 };
+    m_jointMap = { nullptr, 0 };
+    m_stepCount = 0;
+    m_stepTime = 0.0f;
+    m_done = false;
+}
+
+b2ReplayPlayer::~b2ReplayPlayer()
+{
+    b2Free(m_bodies);
+    b2Free(m_fixtures);
+    b2Free(m_joints);
+    b2FreeIndexMap(&m_fixtureMap);
+    b2FreeIndexMap(&m_jointMap);
+}
+
+bool b2ReplayPlayer::Begin(b2World* world, const void* data, std::size_t size)
+{
+    m_world = nullptr;
+    m_bodyCount = 0;
+    m_fixtureCount = 0;
+    m_jointCount = 0;
+    m_stepCount = 0;
+    m_stepTime = 0.0f;
+    m_done = false;
+    b2ClearIndexMap(&m_fixtureMap);
+    b2ClearIndexMap(&m_jointMap);
+
+    // The events are read in place.
+    assert((reinterpret_cast<std::uintptr_t>(data) & 3) == 0);
+    if (data == nullptr || (reinterpret_cast<std::uintptr_t>(data) & 3) != 0 || size < sizeof(b2ReplayHeader))
+    {
+        return false;
+    }
+
+    const b2ReplayHeader* header = static_cast<const b2ReplayHeader*>(data);
+    if (header->magic != b2_replayMagic || header->version != b2_replayVersion)
+    {
+        return false;
+    }
+
+    m_world = world;
+    m_data = static_cast<const char*>(data);
+    m_size = size;
+    m_offset = sizeof(b2ReplayHeader);
+    return true;
+}
+
+bool b2ReplayPlayer::Step()
+{
+    if (m_world == nullptr || m_done)
+    {
+        return false;
+    }
+
+    b2SceneReader reader;
+    reader.data = m_data;
+    reader.size = m_size;
+    reader.offset = m_offset;
+    reader.ok = true;
+
+    while (reader.offset < reader.size)
+    {
+        std::int32_t type = reader.Read<std::int32_t>();
+        if (type == b2_replayStep)
+        {
+            float dt = reader.ReadFloat();
+            std::int32_t velocityIterations = reader.Read<std::int32_t>();
+            std::int32_t positionIterations = reader.Read<std::int32_t>();
+            if (reader.ok == false)
+            {
+                return false;
+            }
+
+            b2Timer timer;
+            m_world->Step(dt, velocityIterations, positionIterations);
+            m_stepTime = timer.GetMilliseconds();
+            ++m_stepCount;
+
+            m_offset = reader.offset;
+            return true;
+        }
+
+        if (ReadEvent(&reader, type) == false)
+        {
+            // Stay at the bad event.
+            return false;
+        }
+
+        m_offset = reader.offset;
+    }
+
+    m_done = true;
+    return false;
+}
+
+bool b2ReplayPlayer::IsDone() const
+{
+    return m_done;
+}
+
+float b2ReplayPlayer::GetStepTime() const
+{
+    return m_stepTime;
+}
+
+std::int32_t b2ReplayPlayer::GetStepCount() const
+{
+    return m_stepCount;
+}
+
+void b2ReplayPlayer::AddScene(std::int32_t bodyCount, std::int32_t fixtureCount, std::int32_t jointCount)
+{
+    b2GrowArray(&m_bodies, &m_bodyCapacity, m_bodyCount, m_bodyCount + bodyCount);
+    b2GrowArray(&m_fixtures, &m_fixtureCapacity, m_fixtureCount, m_fixtureCount + fixtureCount);
+    b2GrowArray(&m_joints, &m_jointCapacity, m_jointCount, m_jointCount + jointCount);
+
+    b2VisitScene(m_world, bodyCount, fixtureCount, jointCount,
+        [this](b2Body* body, std::int32_t index) { AddBody(body, m_bodyCount + index); },
+        [this](b2Fixture* fixture, std::int32_t index) { AddFixture(fixture, m_fixtureCount + index); },
+        [this](b2Joint* joint, std::int32_t index) { AddJoint(joint, m_jointCount + index); });
+
+    m_bodyCount += bodyCount;
+    m_fixtureCount += fixtureCount;
+    m_jointCount += jointCount;
+}
+
+void b2ReplayPlayer::AddBody(b2Body* body, std::int32_t index)
+{
+    assert(index < m_bodyCapacity);
+    m_bodies[index] = body;
+}
+
+void b2ReplayPlayer::AddFixture(b2Fixture* fixture, std::int32_t index)
+{
+    assert(index < m_fixtureCapacity);
+    m_fixtures[index] = fixture;
+    b2SetIndex(&m_fixtureMap, fixture->GetId().index, index);
+}
+
+void b2ReplayPlayer::AddJoint(b2Joint* joint, std::int32_t index)
+{
+    assert(index < m_jointCapacity);
+    m_joints[index] = joint;
+    b2SetIndex(&m_jointMap, joint->GetId().index, index);
+}
+
+void b2ReplayPlayer::RemoveBody(std::int32_t index)
+{
+    // The fixtures and joints are destroyed with the body.
+    b2Body* body = m_bodies[index];
+    for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+    {
+        std::int32_t fixtureIndex = b2GetIndex(&m_fixtureMap, f->GetId().index);
+        if (fixtureIndex >= 0 && m_fixtures[fixtureIndex] == f)
+        {
+            m_fixtures[fixtureIndex] = nullptr;
+        }
+    }
+
+    for (b2JointEdge* je = body->GetJointList(); je; je = je->next)
+    {
+        std::int32_t jointIndex = b2GetIndex(&m_jointMap, je->joint->GetId().index);
+        if (jointIndex >= 0 && m_joints[jointIndex] == je->joint)
+        {
+            m_joints[jointIndex] = nullptr;
+        }
+    }
+
+    m_bodies[index] = nullptr;
+}
+
+b2Body* b2ReplayPlayer::GetBody(std::int32_t index) const
+{
+    return 0 <= index && index < m_bodyCount ? m_bodies[index] : nullptr;
+}
+
+// Apply one event other than a time step. Returns false for bad data.
+bool b2ReplayPlayer::ReadEvent(b2SceneReader* reader, std::int32_t type)
+{
+    switch (type)
+    {
+    case b2_replayScene:
+        {
+            std::uint32_t byteCount = reader->Read<std::uint32_t>();
+            const char* scene = reader->ReadArray<char>(std::int32_t(byteCount));
+            if (scene == nullptr || byteCount % 4 != 0 || m_world->LoadScene(scene, byteCount) == false)
+            {
+                return false;
+            }
+
+            const b2SceneHeader* header = reinterpret_cast<const b2SceneHeader*>(scene);
+            AddScene(header->bodyCount, header->fixtureCount, header->jointCount);
+        }
+        return true;
+
+    case b2_replayClear:
+        m_world->Clear();
+        memset(m_bodies, 0, m_bodyCount * sizeof(b2Body*));
+        memset(m_fixtures, 0, m_fixtureCount * sizeof(b2Fixture*));
+        memset(m_joints, 0, m_jointCount * sizeof(b2Joint*));
+        return true;
+
+    case b2_replaySetGravity:
+        {
+            b2Vec2 gravity = reader->ReadVec2();
+            m_world->SetGravity(gravity);
+        }
+        return reader->ok;
+
+    case b2_replayCreateBody:
+        {
+            const b2SceneBody* record = reader->ReadArray<b2SceneBody>(1);
+            b2BodyDef def;
+            if (record == nullptr || b2GetSceneBodyDef(record, &def) == false)
+            {
+                return false;
+            }
+
+            b2GrowArray(&m_bodies, &m_bodyCapacity, m_bodyCount, m_bodyCount + 1);
+            AddBody(m_world->CreateBody(&def), m_bodyCount++);
+        }
+        return true;
+
+    case b2_replayDestroyBody:
+        {
+            std::int32_t index = reader->Read<std::int32_t>();
+            b2Body* body = GetBody(index);
+            if (body == nullptr)
+            {
+                return false;
+            }
+
+            RemoveBody(index);
+            m_world->DestroyBody(body);
+        }
+        return true;
+
+    case b2_replayCreateFixture:
+        {
+            b2Body* body = GetBody(reader->Read<std::int32_t>());
+            if (body == nullptr)
+            {
+                return false;
+            }
+
+            // Validate before creating anything.
+            std::size_t offset = reader->offset;
+            if (m_world->ReadSceneFixture(reader, nullptr, false, nullptr) == false)
+            {
+                return false;
+            }
+
+            reader->offset = offset;
+            b2Fixture* fixture = nullptr;
+            m_world->ReadSceneFixture(reader, body, false, &fixture);
+            b2GrowArray(&m_fixtures, &m_fixtureCapacity, m_fixtureCount, m_fixtureCount + 1);
+            AddFixture(fixture, m_fixtureCount++);
+        }
+        return true;
+
+    case b2_replayDestroyFixture:
+        {
+            std::int32_t index = reader->Read<std::int32_t>();
+            if (index < 0 || m_fixtureCount <= index || m_fixtures[index] == nullptr)
+            {
+                return false;
+            }
+
+            b2Fixture* fixture = m_fixtures[index];
+            m_fixtures[index] = nullptr;
+            fixture->GetBody()->DestroyFixture(fixture);
+        }
+        return true;
+
+    case b2_replayCreateJoint:
+        {
+            std::size_t offset = reader->offset;
+            if (m_world->ReadSceneJoint(reader, false, m_bodies, m_bodyCount, m_joints, nullptr, m_jointCount,
+                nullptr, nullptr) == false)
+            {
+                return false;
+            }
+
+            reader->offset = offset;
+            b2Joint* joint = nullptr;
+            m_world->ReadSceneJoint(reader, true, m_bodies, m_bodyCount, m_joints, nullptr, m_jointCount, &joint, nullptr);
+            b2GrowArray(&m_joints, &m_jointCapacity, m_jointCount, m_jointCount + 1);
+            AddJoint(joint, m_jointCount++);
+        }
+        return true;
+
+    case b2_replayDestroyJoint:
+        {
+            std::int32_t index = reader->Read<std::int32_t>();
+            if (index < 0 || m_jointCount <= index || m_joints[index] == nullptr)
+            {
+                return false;
+            }
+
+            b2Joint* joint = m_joints[index];
+            m_joints[index] = nullptr;
+            m_world->DestroyJoint(joint);
+        }
+        return true;
+
+    case b2_replayWorldSettings:
+        {
+            const b2ReplayWorldSettings* settings = reader->ReadArray<b2ReplayWorldSettings>(1);
+            if (settings == nullptr)
+            {
+                return false;
+            }
+
+            std::uint32_t flags = settings->flags;
+            m_world->SetAllowSleeping((flags & b2_replayAllowSleep) != 0);
+            m_world->SetWarmStarting((flags & b2_replayWarmStarting) != 0);
+            m_world->SetContinuousPhysics((flags & b2_replayContinuousPhysics) != 0);
+            m_world->SetSubStepping((flags & b2_replaySubStepping) != 0);
+            m_world->SetAutoClearForces((flags & b2_replayAutoClearForces) != 0);
+            m_world->SetTreeRefit((flags & b2_replayTreeRefit) != 0);
+            m_world->SetManifoldReuse((flags & b2_replayManifoldReuse) != 0);
+            m_world->SetTreeOptimizationBudget(settings->treeOptimizationBudget);
+        }
+        return true;
+
+    case b2_replaySetFilter:
+    case b2_replaySetSensor:
+        {
+            std::int32_t index = reader->Read<std::int32_t>();
+            if (index < 0 || m_fixtureCount <= index || m_fixtures[index] == nullptr)
+            {
+                return false;
+            }
+
+            b2Fixture* fixture = m_fixtures[index];
+            if (type == b2_replaySetFilter)
+            {
+                b2Filter filter;
+                filter.categoryBits = std::uint16_t(reader->Read<std::uint32_t>());
+                filter.maskBits = std::uint16_t(reader->Read<std::uint32_t>());
+                filter.groupIndex = std::int16_t(reader->Read<std::int32_t>());
+                if (reader->ok)
+                {
+                    fixture->SetFilterData(filter);
+                }
+            }
+            else
+            {
+                bool flag = reader->ReadBool();
+                if (reader->ok)
+                {
+                    fixture->SetSensor(flag);
+                }
+            }
+        }
+        return reader->ok;
+
+    case b2_replayJointInput:
+        return ReadJointInput(reader);
+
+    default:
+        break;
+    }
+
+    // Body inputs.
+    b2Body* body = GetBody(reader->Read<std::int32_t>());
+    if (body == nullptr)
+    {
+        return false;
+    }
+
+    switch (type)
+    {
+    case b2_replaySetTransform:
+        {
+            b2Vec2 position = reader->ReadVec2();
+            float angle = reader->ReadFloat();
+            if (reader->ok)
+            {
+                body->SetTransform(position, angle);
+            }
+        }
+        break;
+
+    case b2_replayBodyState:
+        {
+            const b2ReplayBodyState* state = reader->ReadArray<b2ReplayBodyState>(1);
+            if (state == nullptr || state->linearVelocity.IsValid() == false ||
+                b2IsValid(state->angularVelocity) == false || state->force.IsValid() == false ||
+                b2IsValid(state->torque) == false || b2IsValid(state->linearDamping) == false ||
+                b2IsValid(state->angularDamping) == false || b2IsValid(state->gravityScale) == false ||
+                b2IsValid(state->sleepTime) == false)
+            {
+                return false;
+            }
+
+            bool awake = (state->flags & b2_sceneAwake) != 0;
+            if (body->IsAwake() != awake)
+            {
+                body->SetAwake(awake);
+            }
+
+            // The flags are set directly, because SetSleepingAllowed would wake the body.
+            b2BodySim* sim = body->m_sim;
+            sim->flags &= ~(b2Body::e_autoSleepFlag | b2Body::e_bulletFlag);
+            sim->flags |= (state->flags & b2_sceneAllowSleep) != 0 ? b2Body::e_autoSleepFlag : 0;
+            sim->flags |= (state->flags & b2_sceneBullet) != 0 ? b2Body::e_bulletFlag : 0;
+            sim->linearVelocity = state->linearVelocity;
+            sim->angularVelocity = state->angularVelocity;
+            sim->force = state->force;
+            sim->torque = state->torque;
+            sim->linearDamping = state->linearDamping;
+            sim->angularDamping = state->angularDamping;
+            sim->gravityScale = state->gravityScale;
+            sim->sleepTime = state->sleepTime;
+        }
+        break;
+
+    case b2_replaySetType:
+        {
+            std::int32_t bodyType = reader->Read<std::int32_t>();
+            if (bodyType < b2_staticBody || b2_dynamicBody < bodyType)
+            {
+                return false;
+            }
+
+            if (reader->ok)
+            {
+                body->SetType(b2BodyType(bodyType));
+            }
+        }
+        break;
+
+    case b2_replaySetEnabled:
+        {
+            bool flag = reader->ReadBool();
+            if (reader->ok)
+            {
+                body->SetEnabled(flag);
+            }
+        }
+        break;
+
+    case b2_replaySetFixedRotation:
+        {
+            bool flag = reader->ReadBool();
+            if (reader->ok)
+            {
+                body->SetFixedRotation(flag);
+            }
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    return reader->ok;
+}
+
+// Call the recorded joint setter. Returns false for bad data or a setter the joint
+// does not have.
+bool b2ReplayPlayer::ReadJointInput(b2SceneReader* reader)
+{
+    std::int32_t index = reader->Read<std::int32_t>();
+    std::int32_t input = reader->Read<std::int32_t>();
+    float a = reader->ReadFloat();
+    float b = reader->ReadFloat();
+    if (reader->ok == false || index < 0 || m_jointCount <= index || m_joints[index] == nullptr)
+    {
+        return false;
+    }
+
+    b2Joint* joint = m_joints[index];
+    switch (joint->GetType())
+    {
+    case e_distanceJoint:
+        {
+            b2DistanceJoint* j = static_cast<b2DistanceJoint*>(joint);
+            switch (input)
+            {
+            case b2_replaySetLength:
+                j->SetLength(a);
+                return true;
+            case b2_replaySetMinLength:
+                j->SetMinLength(a);
+                return true;
+            case b2_replaySetMaxLength:
+                j->SetMaxLength(a);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    case e_frictionJoint:
+        {
+            b2FrictionJoint* j = static_cast<b2FrictionJoint*>(joint);
+            switch (input)
+            {
+            case b2_replaySetMaxForce:
+                j->SetMaxForce(b2Max(a, 0.0f));
+                return true;
+            case b2_replaySetMaxTorque:
+                j->SetMaxTorque(b2Max(a, 0.0f));
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    case e_gearJoint:
+        if (input == b2_replaySetRatio)
+        {
+            static_cast<b2GearJoint*>(joint)->SetRatio(a);
+            return true;
+        }
+        return false;
+
+    case e_motorJoint:
+        {
+            b2MotorJoint* j = static_cast<b2MotorJoint*>(joint);
+            switch (input)
+            {
+            case b2_replaySetMaxForce:
+                j->SetMaxForce(b2Max(a, 0.0f));
+                return true;
+            case b2_replaySetMaxTorque:
+                j->SetMaxTorque(b2Max(a, 0.0f));
+                return true;
+            case b2_replaySetCorrectionFactor:
+                j->SetCorrectionFactor(b2Clamp(a, 0.0f, 1.0f));
+                return true;
+            case b2_replaySetLinearOffset:
+                j->SetLinearOffset(b2Vec2(a, b));
+                return true;
+            case b2_replaySetAngularOffset:
+                j->SetAngularOffset(a);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    case e_prismaticJoint:
+        {
+            b2PrismaticJoint* j = static_cast<b2PrismaticJoint*>(joint);
+            switch (input)
+            {
+            case b2_replayEnableLimit:
+                j->EnableLimit(a != 0.0f);
+                return true;
+            case b2_replaySetLimits:
+                j->SetLimits(a, b2Max(a, b));
+                return true;
+            case b2_replayEnableMotor:
+                j->EnableMotor(a != 0.0f);
+                return true;
+            case b2_replaySetMotorSpeed:
+                j->SetMotorSpeed(a);
+                return true;
+            case b2_replaySetMaxMotorForce:
+                j->SetMaxMotorForce(a);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    case e_revoluteJoint:
+        {
+            b2RevoluteJoint* j = static_cast<b2RevoluteJoint*>(joint);
+            switch (input)
+            {
+            case b2_replayEnableLimit:
+                j->EnableLimit(a != 0.0f);
+                return true;
+            case b2_replaySetLimits:
+                j->SetLimits(a, b2Max(a, b));
+                return true;
+            case b2_replayEnableMotor:
+                j->EnableMotor(a != 0.0f);
+                return true;
+            case b2_replaySetMotorSpeed:
+                j->SetMotorSpeed(a);
+                return true;
+            case b2_replaySetMaxMotorForce:
+                j->SetMaxMotorTorque(a);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    case e_wheelJoint:
+        {
+            b2WheelJoint* j = static_cast<b2WheelJoint*>(joint);
+            switch (input)
+            {
+            case b2_replayEnableLimit:
+                j->EnableLimit(a != 0.0f);
+                return true;
+            case b2_replaySetLimits:
+                j->SetLimits(a, b2Max(a, b));
+                return true;
+            case b2_replayEnableMotor:
+                j->EnableMotor(a != 0.0f);
+                return true;
+            case b2_replaySetMotorSpeed:
+                j->SetMotorSpeed(a);
+                return true;
+            case b2_replaySetMaxMotorForce:
+                j->SetMaxMotorTorque(a);
+                return true;
+            case b2_replaySetStiffness:
+                j->SetStiffness(a);
+                return true;
+            case b2_replaySetDamping:
+                j->SetDamping(a);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    default:
+        return false;
+    }
+}
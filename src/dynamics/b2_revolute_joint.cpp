@@ -22,6 +22,7 @@
 
 #include <box2d/b2_body.h>
 #include <box2d/b2_draw.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_revolute_joint.h>
 #include <box2d/b2_time_step.h>
 
@@ -74,12 +75,12 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2SolverData& data)
 {
     m_indexA = m_bodyA->m_islandIndex;
     m_indexB = m_bodyB->m_islandIndex;
-    m_localCenterA = m_bodyA->m_sweep.localCenter;
-    m_localCenterB = m_bodyB->m_sweep.localCenter;
-    m_invMassA = m_bodyA->m_invMass;
-    m_invMassB = m_bodyB->m_invMass;
-    m_invIA = m_bodyA->m_invI;
-    m_invIB = m_bodyB->m_invI;
+    m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+    m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+    m_invMassA = m_bodyA->m_sim->invMass;
+    m_invMassB = m_bodyB->m_sim->invMass;
+    m_invIA = m_bodyA->m_sim->invI;
+    m_invIB = m_bodyB->m_sim->invI;
 
     float aA = data.positions[m_indexA].a;
     b2Vec2 vA = data.velocities[m_indexA].v;
@@ -345,14 +346,14 @@ float b2RevoluteJoint::GetJointAngle() const
 {
     b2Body* bA = m_bodyA;
     b2Body* bB = m_bodyB;
-    return bB->m_sweep.a - bA->m_sweep.a - m_referenceAngle;
+    return bB->m_sim->sweep.a - bA->m_sim->sweep.a - m_referenceAngle;
 }
 
 float b2RevoluteJoint::GetJointSpeed() const
 {
     b2Body* bA = m_bodyA;
     b2Body* bB = m_bodyB;
-    return bB->m_angularVelocity - bA->m_angularVelocity;
+    return bB->m_sim->angularVelocity - bA->m_sim->angularVelocity;
 }
 
 bool b2RevoluteJoint::IsMotorEnabled() const
@@ -362,6 +363,8 @@ bool b2RevoluteJoint::IsMotorEnabled() const
 
 void b2RevoluteJoint::EnableMotor(bool flag)
 {
+    RecordInput(b2_replayEnableMotor, flag ? 1.0f : 0.0f);
+
     if (flag != m_enableMotor)
     {
         m_bodyA->SetAwake(true);
@@ -377,6 +380,8 @@ float b2RevoluteJoint::GetMotorTorque(float inv_dt) const
 
 void b2RevoluteJoint::SetMotorSpeed(float speed)
 {
+    RecordInput(b2_replaySetMotorSpeed, speed);
+
     if (speed != m_motorSpeed)
     {
         m_bodyA->SetAwake(true);
@@ -387,6 +392,8 @@ void b2RevoluteJoint::SetMotorSpeed(float speed)
 
 void b2RevoluteJoint::SetMaxMotorTorque(float torque)
 {
+    RecordInput(b2_replaySetMaxMotorForce, torque);
+
     if (torque != m_maxMotorTorque)
     {
         m_bodyA->SetAwake(true);
@@ -402,6 +409,8 @@ bool b2RevoluteJoint::IsLimitEnabled() const
 
 void b2RevoluteJoint::EnableLimit(bool flag)
 {
+    RecordInput(b2_replayEnableLimit, flag ? 1.0f : 0.0f);
+
     if (flag != m_enableLimit)
     {
         m_bodyA->SetAwake(true);
@@ -426,6 +435,8 @@ void b2RevoluteJoint::SetLimits(float lower, float upper)
 {
     assert(lower <= upper);
 
+    RecordInput(b2_replaySetLimits, lower, upper);
+
     if (lower != m_lowerAngle || upper != m_upperAngle)
     {
         m_bodyA->SetAwake(true);
@@ -0,0 +1,1219 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "b2_scene_stream.h"
+
+#include <box2d/b2_body.h>
+#include <box2d/b2_capsule_shape.h>
+#include <box2d/b2_chain_shape.h>
+#include <box2d/b2_circle_shape.h>
+#include <box2d/b2_compound_shape.h>
+#include <box2d/b2_distance_joint.h>
+#include <box2d/b2_edge_shape.h>
+#include <box2d/b2_fixture.h>
+#include <box2d/b2_friction_joint.h>
+#include <box2d/b2_gear_joint.h>
+#include <box2d/b2_height_field_shape.h>
+#include <box2d/b2_motor_joint.h>
+#include <box2d/b2_polygon_shape.h>
+#include <box2d/b2_prismatic_joint.h>
+#include <box2d/b2_pulley_joint.h>
+#include <box2d/b2_replay.h>
+#include <box2d/b2_revolute_joint.h>
+#include <box2d/b2_scene.h>
+#include <box2d/b2_weld_joint.h>
+#include <box2d/b2_wheel_joint.h>
+#include <box2d/b2_world.h>
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+static_assert(sizeof(b2SceneHeader) % 4 == 0, "scene records must keep four byte alignment");
+static_assert(sizeof(b2SceneBody) % 4 == 0, "scene records must keep four byte alignment");
+static_assert(sizeof(b2SceneFixture) % 4 == 0, "scene records must keep four byte alignment");
+static_assert(sizeof(b2SceneJoint) % 4 == 0, "scene records must keep four byte alignment");
+
+// Temporary shapes for reading. The fixture clones the shape it is given.
+struct b2SceneShapes
+{
+    b2CircleShape circle;
+    b2EdgeShape edge;
+    b2PolygonShape polygon;
+    b2CapsuleShape capsule;
+};
+
+static void b2WriteSimpleShape(b2SceneWriter* writer, const b2Shape* shape)
+{
+    switch (shape->m_type)
+    {
+    case b2Shape::e_circle:
+        {
+            const b2CircleShape* circle = static_cast<const b2CircleShape*>(shape);
+            writer->Write(circle->m_p);
+        }
+        break;
+
+    case b2Shape::e_edge:
+        {
+            const b2EdgeShape* edge = static_cast<const b2EdgeShape*>(shape);
+            writer->Write(edge->m_vertex0);
+            writer->Write(edge->m_vertex1);
+            writer->Write(edge->m_vertex2);
+            writer->Write(edge->m_vertex3);
+            writer->WriteBool(edge->m_oneSided);
+        }
+        break;
+
+    case b2Shape::e_polygon:
+        {
+            const b2PolygonShape* polygon = static_cast<const b2PolygonShape*>(shape);
+            writer->Write(polygon->m_count);
+            writer->Write(polygon->m_centroid);
+            writer->WriteArray(polygon->m_vertices.data(), polygon->m_count);
+            writer->WriteArray(polygon->m_normals.data(), polygon->m_count);
+        }
+        break;
+
+    case b2Shape::e_capsule:
+        {
+            const b2CapsuleShape* capsule = static_cast<const b2CapsuleShape*>(shape);
+            writer->Write(capsule->m_vertex1);
+            writer->Write(capsule->m_vertex2);
+        }
+        break;
+
+    default:
+        assert(false);
+        break;
+    }
+}
+
+// A polygon read from a scene must be what b2PolygonShape::Set makes: convex, counter
+// clockwise, with unit normals that match the edges, the centroid inside and an area
+// that b2PolygonShape::ComputeMass accepts.
+static bool b2IsValidPolygon(const b2PolygonShape* polygon)
+{
+    std::int32_t count = polygon->m_count;
+    const b2Vec2* vertices = polygon->m_vertices.data();
+    const b2Vec2* normals = polygon->m_normals.data();
+
+    float area = 0.0f;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        std::int32_t i2 = i + 1 < count ? i + 1 : 0;
+        b2Vec2 edge = vertices[i2] - vertices[i];
+        if (edge.LengthSquared() <= FLT_EPSILON * FLT_EPSILON)
+        {
+            return false;
+        }
+
+        b2Vec2 normal = b2Cross(edge, 1.0f);
+        normal.Normalize();
+        if (b2DistanceSquared(normal, normals[i]) > 1.0e-6f)
+        {
+            return false;
+        }
+
+        // Every vertex and the centroid are behind the edge.
+        for (std::int32_t j = 0; j < count; ++j)
+        {
+            if (b2Dot(normals[i], vertices[j] - vertices[i]) > b2_linearSlop)
+            {
+                return false;
+            }
+        }
+
+        if (b2Dot(normals[i], polygon->m_centroid - vertices[i]) > 0.0f)
+        {
+            return false;
+        }
+
+        area += 0.5f * b2Cross(vertices[i] - vertices[0], vertices[i2] - vertices[0]);
+    }
+
+    return area > FLT_EPSILON;
+}
+
+// Read a circle, edge, polygon or capsule into the matching temporary shape.
+// Returns nullptr for bad data.
+static b2Shape* b2ReadSimpleShape(b2SceneReader* reader, std::int32_t type, float radius, b2SceneShapes* shapes)
+{
+    b2Shape* shape = nullptr;
+    switch (type)
+    {
+    case b2Shape::e_circle:
+        shapes->circle.m_p = reader->ReadVec2();
+        shape = &shapes->circle;
+        break;
+
+    case b2Shape::e_edge:
+        shapes->edge.m_vertex0 = reader->ReadVec2();
+        shapes->edge.m_vertex1 = reader->ReadVec2();
+        shapes->edge.m_vertex2 = reader->ReadVec2();
+        shapes->edge.m_vertex3 = reader->ReadVec2();
+        shapes->edge.m_oneSided = reader->ReadBool();
+        shape = &shapes->edge;
+        break;
+
+    case b2Shape::e_polygon:
+        {
+            std::int32_t count = reader->Read<std::int32_t>();
+            if (count < 3 || b2_maxPolygonVertices < count)
+            {
+                return nullptr;
+            }
+
+            b2PolygonShape* polygon = &shapes->polygon;
+            polygon->m_count = count;
+            polygon->m_centroid = reader->ReadVec2();
+            const b2Vec2* vertices = reader->ReadPoints(count);
+            const b2Vec2* normals = reader->ReadPoints(count);
+            if (reader->ok == false)
+            {
+                return nullptr;
+            }
+
+            memcpy(polygon->m_vertices.data(), vertices, count * sizeof(b2Vec2));
+            memcpy(polygon->m_normals.data(), normals, count * sizeof(b2Vec2));
+            if (b2IsValidPolygon(polygon) == false)
+            {
+                return nullptr;
+            }
+
+            shape = polygon;
+        }
+        break;
+
+    case b2Shape::e_capsule:
+        shapes->capsule.m_vertex1 = reader->ReadVec2();
+        shapes->capsule.m_vertex2 = reader->ReadVec2();
+        shape = &shapes->capsule;
+        break;
+
+    default:
+        return nullptr;
+    }
+
+    if (reader->ok == false || b2IsValid(radius) == false || radius < 0.0f)
+    {
+        return nullptr;
+    }
+
+    shape->m_radius = radius;
+    return shape;
+}
+
+// Write the definition fields of a joint other than a gear or mouse joint.
+static void b2WriteJointDef(b2SceneWriter* writer, b2Joint* joint)
+{
+    switch (joint->GetType())
+    {
+    case e_distanceJoint:
+        {
+            b2DistanceJoint* j = static_cast<b2DistanceJoint*>(joint);
+            writer->Write(j->GetLocalAnchorA());
+            writer->Write(j->GetLocalAnchorB());
+            writer->Write(j->GetLength());
+            writer->Write(j->GetMinLength());
+            writer->Write(j->GetMaxLength());
+            writer->Write(j->GetStiffness());
+            writer->Write(j->GetDamping());
+        }
+        break;
+
+    case e_frictionJoint:
+        {
+            b2FrictionJoint* j = static_cast<b2FrictionJoint*>(joint);
+            writer->Write(j->GetLocalAnchorA());
+            writer->Write(j->GetLocalAnchorB());
+            writer->Write(j->GetMaxForce());
+            writer->Write(j->GetMaxTorque());
+        }
+        break;
+
+    case e_motorJoint:
+        {
+            b2MotorJoint* j = static_cast<b2MotorJoint*>(joint);
+            writer->Write(j->GetLinearOffset());
+            writer->Write(j->GetAngularOffset());
+            writer->Write(j->GetMaxForce());
+            writer->Write(j->GetMaxTorque());
+            writer->Write(j->GetCorrectionFactor());
+        }
+        break;
+
+    case e_prismaticJoint:
+        {
+            b2PrismaticJoint* j = static_cast<b2PrismaticJoint*>(joint);
+            writer->Write(j->GetLocalAnchorA());
+            writer->Write(j->GetLocalAnchorB());
+            writer->Write(j->GetLocalAxisA());
+            writer->Write(j->GetReferenceAngle());
+            writer->WriteBool(j->IsLimitEnabled());
+            writer->Write(j->GetLowerLimit());
+            writer->Write(j->GetUpperLimit());
+            writer->WriteBool(j->IsMotorEnabled());
+            writer->Write(j->GetMaxMotorForce());
+            writer->Write(j->GetMotorSpeed());
+        }
+        break;
+
+    case e_pulleyJoint:
+        {
+            b2PulleyJoint* j = static_cast<b2PulleyJoint*>(joint);
+            writer->Write(j->GetGroundAnchorA());
+            writer->Write(j->GetGroundAnchorB());
+            writer->Write(j->GetLocalAnchorA());
+            writer->Write(j->GetLocalAnchorB());
+            writer->Write(j->GetLengthA());
+            writer->Write(j->GetLengthB());
+            writer->Write(j->GetRatio());
+        }
+        break;
+
+    case e_revoluteJoint:
+        {
+            b2RevoluteJoint* j = static_cast<b2RevoluteJoint*>(joint);
+            writer->Write(j->GetLocalAnchorA());
+            writer->Write(j->GetLocalAnchorB());
+            writer->Write(j->GetReferenceAngle());
+            writer->WriteBool(j->IsLimitEnabled());
+            writer->Write(j->GetLowerLimit());
+            writer->Write(j->GetUpperLimit());
+            writer->WriteBool(j->IsMotorEnabled());
+            writer->Write(j->GetMotorSpeed());
+            writer->Write(j->GetMaxMotorTorque());
+        }
+        break;
+
+    case e_weldJoint:
+        {
+            b2WeldJoint* j = static_cast<b2WeldJoint*>(joint);
+            writer->Write(j->GetLocalAnchorA());
+            writer->Write(j->GetLocalAnchorB());
+            writer->Write(j->GetReferenceAngle());
+            writer->Write(j->GetStiffness());
+            writer->Write(j->GetDamping());
+        }
+        break;
+
+    case e_wheelJoint:
+        {
+            b2WheelJoint* j = static_cast<b2WheelJoint*>(joint);
+            writer->Write(j->GetLocalAnchorA());
+            writer->Write(j->GetLocalAnchorB());
+            writer->Write(j->GetLocalAxisA());
+            writer->WriteBool(j->IsLimitEnabled());
+            writer->Write(j->GetLowerLimit());
+            writer->Write(j->GetUpperLimit());
+            writer->WriteBool(j->IsMotorEnabled());
+            writer->Write(j->GetMaxMotorTorque());
+            writer->Write(j->GetMotorSpeed());
+            writer->Write(j->GetStiffness());
+            writer->Write(j->GetDamping());
+        }
+        break;
+
+    default:
+        assert(false);
+        break;
+    }
+}
+
+void b2WriteSceneBody(b2SceneWriter* writer, const b2Body* body, std::int32_t fixtureCount)
+{
+    b2SceneBody record;
+    record.type = body->GetType();
+    record.position = body->GetPosition();
+    record.angle = body->GetAngle();
+    record.linearVelocity = body->GetLinearVelocity();
+    record.angularVelocity = body->GetAngularVelocity();
+    record.linearDamping = body->GetLinearDamping();
+    record.angularDamping = body->GetAngularDamping();
+    record.gravityScale = body->GetGravityScale();
+    record.flags = 0;
+    if (body->IsAwake())
+    {
+        record.flags |= b2_sceneAwake;
+    }
+    if (body->IsSleepingAllowed())
+    {
+        record.flags |= b2_sceneAllowSleep;
+    }
+    if (body->IsFixedRotation())
+    {
+        record.flags |= b2_sceneFixedRotation;
+    }
+    if (body->IsBullet())
+    {
+        record.flags |= b2_sceneBullet;
+    }
+    if (body->IsEnabled())
+    {
+        record.flags |= b2_sceneEnabled;
+    }
+    record.fixtureCount = fixtureCount;
+    writer->Write(record);
+}
+
+void b2WriteSceneFixture(b2SceneWriter* writer, const b2Fixture* fixture)
+{
+    const b2Shape* shape = fixture->GetShape();
+    const b2Filter& filter = fixture->GetFilterData();
+
+    b2SceneFixture record;
+    record.friction = fixture->GetFriction();
+    record.restitution = fixture->GetRestitution();
+    record.restitutionThreshold = fixture->GetRestitutionThreshold();
+    record.density = fixture->GetDensity();
+    record.categoryBits = filter.categoryBits;
+    record.maskBits = filter.maskBits;
+    record.groupIndex = filter.groupIndex;
+    record.isSensor = fixture->IsSensor() ? 1 : 0;
+    record.shapeType = shape->m_type;
+    record.radius = shape->m_radius;
+    writer->Write(record);
+
+    switch (shape->m_type)
+    {
+    case b2Shape::e_chain:
+        {
+            const b2ChainShape* chain = static_cast<const b2ChainShape*>(shape);
+            writer->Write(chain->m_count);
+            writer->WriteBool(chain->IsSingleProxy());
+            writer->Write(chain->m_prevVertex);
+            writer->Write(chain->m_nextVertex);
+            writer->WriteArray(chain->m_vertices, chain->m_count);
+        }
+        break;
+
+    case b2Shape::e_heightField:
+        {
+            const b2HeightFieldShape* heightField = static_cast<const b2HeightFieldShape*>(shape);
+            writer->Write(heightField->m_count);
+            writer->Write(heightField->m_spacing);
+            writer->WriteArray(heightField->m_heights, heightField->m_count);
+        }
+        break;
+
+    case b2Shape::e_compound:
+        {
+            const b2CompoundShape* compound = static_cast<const b2CompoundShape*>(shape);
+            writer->Write(compound->m_count);
+            for (std::int32_t i = 0; i < compound->m_count; ++i)
+            {
+                const b2Shape* child = compound->GetChild(i);
+                writer->Write(std::int32_t(child->m_type));
+                writer->Write(child->m_radius);
+                b2WriteSimpleShape(writer, child);
+            }
+        }
+        break;
+
+    default:
+        b2WriteSimpleShape(writer, shape);
+        break;
+    }
+}
+
+void b2WriteSceneJoint(b2SceneWriter* writer, b2Joint* joint, std::int32_t bodyA, std::int32_t bodyB,
+    std::int32_t joint1, std::int32_t joint2)
+{
+    b2SceneJoint record;
+    record.type = joint->GetType();
+    record.bodyA = bodyA;
+    record.bodyB = bodyB;
+    record.collideConnected = joint->GetCollideConnected() ? 1 : 0;
+    writer->Write(record);
+
+    if (record.type == e_gearJoint)
+    {
+        b2GearJoint* gear = static_cast<b2GearJoint*>(joint);
+        writer->Write(joint1);
+        writer->Write(joint2);
+        writer->Write(gear->GetRatio());
+    }
+    else
+    {
+        b2WriteJointDef(writer, joint);
+    }
+}
+
+bool b2GetSceneBodyDef(const b2SceneBody* record, b2BodyDef* def)
+{
+    if (record->type < b2_staticBody || b2_dynamicBody < record->type)
+    {
+        return false;
+    }
+
+    if (record->position.IsValid() == false || b2IsValid(record->angle) == false ||
+        record->linearVelocity.IsValid() == false || b2IsValid(record->angularVelocity) == false ||
+        b2IsValid(record->linearDamping) == false || record->linearDamping < 0.0f ||
+        b2IsValid(record->angularDamping) == false || record->angularDamping < 0.0f ||
+        b2IsValid(record->gravityScale) == false)
+    {
+        return false;
+    }
+
+    def->type = b2BodyType(record->type);
+    def->position = record->position;
+    def->angle = record->angle;
+    def->linearVelocity = record->linearVelocity;
+    def->angularVelocity = record->angularVelocity;
+    def->linearDamping = record->linearDamping;
+    def->angularDamping = record->angularDamping;
+    def->gravityScale = record->gravityScale;
+    def->awake = (record->flags & b2_sceneAwake) != 0;
+    def->allowSleep = (record->flags & b2_sceneAllowSleep) != 0;
+    def->fixedRotation = (record->flags & b2_sceneFixedRotation) != 0;
+    def->bullet = (record->flags & b2_sceneBullet) != 0;
+    def->enabled = (record->flags & b2_sceneEnabled) != 0;
+    return true;
+}
+
+std::size_t b2World::SaveScene(void* buffer, std::size_t capacity)
+{
+    assert(IsLocked() == false);
+    if (IsLocked())
+    {
+        return 0;
+    }
+
+    b2SceneWriter writer;
+    writer.data = (char*)buffer;
+    writer.capacity = capacity;
+    writer.size = 0;
+    writer.growable = false;
+
+    // Bodies and fixtures are prepended to their lists on creation. Write them from
+    // the back so that loading restores the order of the lists.
+    b2Body* lastBody = m_bodyList;
+    std::int32_t fixtureCount = 0;
+    for (b2Body* b = m_bodyList; b; b = b->m_next)
+    {
+        lastBody = b;
+        fixtureCount += b->m_fixtureCount;
+    }
+
+    // Gear joints come last because they reference other joints. Mouse joints are skipped.
+    b2Joint* lastJoint = m_jointList;
+    for (b2Joint* j = m_jointList; j; j = j->m_next)
+    {
+        lastJoint = j;
+        j->m_index = -1;
+    }
+
+    std::int32_t jointCount = 0;
+    for (std::int32_t pass = 0; pass < 2; ++pass)
+    {
+        for (b2Joint* j = lastJoint; j; j = j->m_prev)
+        {
+            if (j->m_type != e_mouseJoint && (j->m_type == e_gearJoint) == (pass == 1))
+            {
+                j->m_index = jointCount++;
+            }
+        }
+    }
+
+    b2SceneHeader header;
+    header.magic = b2_sceneMagic;
+    header.version = b2_sceneVersion;
+    header.byteCount = 0;
+    header.bodyCount = m_bodyCount;
+    header.fixtureCount = fixtureCount;
+    header.jointCount = jointCount;
+    header.gravity = m_gravity;
+    writer.Write(header);
+
+    std::int32_t bodyIndex = 0;
+    for (b2Body* b = lastBody; b; b = b->m_prev)
+    {
+        b->m_islandIndex = bodyIndex++;
+        b2WriteSceneBody(&writer, b, b->m_fixtureCount);
+
+        if (b->m_fixtureCount == 0)
+        {
+            continue;
+        }
+
+        // The fixture list is singly linked, so collect it to walk it backwards.
+        b2Fixture** fixtures = m_stackAllocator.Allocate<b2Fixture*>(b->m_fixtureCount);
+        std::int32_t fixtureIndex = 0;
+        for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+        {
+            fixtures[fixtureIndex++] = f;
+        }
+
+        while (fixtureIndex > 0)
+        {
+            b2WriteSceneFixture(&writer, fixtures[--fixtureIndex]);
+        }
+
+        m_stackAllocator.Free(fixtures);
+    }
+
+    for (std::int32_t pass = 0; pass < 2; ++pass)
+    {
+        for (b2Joint* j = lastJoint; j; j = j->m_prev)
+        {
+            if (j->m_index < 0 || (j->m_type == e_gearJoint) != (pass == 1))
+            {
+                continue;
+            }
+
+            std::int32_t joint1 = -1;
+            std::int32_t joint2 = -1;
+            if (j->m_type == e_gearJoint)
+            {
+                b2GearJoint* gear = static_cast<b2GearJoint*>(j);
+                joint1 = gear->GetJoint1()->m_index;
+                joint2 = gear->GetJoint2()->m_index;
+            }
+
+            b2WriteSceneJoint(&writer, j, j->m_bodyA->m_islandIndex, j->m_bodyB->m_islandIndex, joint1, joint2);
+        }
+    }
+
+    // Patch the size into the header.
+    std::uint32_t byteCount = static_cast<std::uint32_t>(writer.size);
+    if (writer.data != nullptr && writer.size <= capacity)
+    {
+        memcpy(writer.data + offsetof(b2SceneHeader, byteCount), &byteCount, sizeof(byteCount));
+    }
+
+    return writer.size;
+}
+
+bool b2World::LoadScene(const void* data, std::size_t size, b2Body** bodies, b2Joint** joints)
+{
+    assert(IsLocked() == false);
+    if (IsLocked())
+    {
+        return false;
+    }
+
+    // The records are read in place.
+    assert((reinterpret_cast<std::uintptr_t>(data) & 3) == 0);
+    if (data == nullptr || (reinterpret_cast<std::uintptr_t>(data) & 3) != 0 || size < sizeof(b2SceneHeader))
+    {
+        return false;
+    }
+
+    const b2SceneHeader* header = static_cast<const b2SceneHeader*>(data);
+    if (header->magic != b2_sceneMagic || header->version != b2_sceneVersion ||
+        header->byteCount < sizeof(b2SceneHeader) || header->byteCount > size ||
+        header->bodyCount < 0 || header->fixtureCount < 0 || header->jointCount < 0 ||
+        header->gravity.IsValid() == false)
+    {
+        return false;
+    }
+
+    b2SceneReader reader;
+    reader.data = static_cast<const char*>(data);
+    reader.size = header->byteCount;
+    reader.offset = sizeof(b2SceneHeader);
+    reader.ok = true;
+
+    // Validate everything first so that a bad scene leaves the world unchanged.
+    if (ReadScene(&reader, header, false, nullptr, nullptr) == false)
+    {
+        return false;
+    }
+
+    // A recording gets the whole scene instead of the objects one by one.
+    b2ReplayRecorder* recorder = m_recorder;
+    m_recorder = nullptr;
+
+    reader.offset = sizeof(b2SceneHeader);
+    bool ok = ReadScene(&reader, header, true, bodies, joints);
+    assert(ok);
+
+    m_recorder = recorder;
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordScene(data, header->byteCount);
+    }
+
+    return ok;
+}
+
+// Read the bodies and joints of a scene. Without create this only validates the data.
+bool b2World::ReadScene(b2SceneReader* reader, const b2SceneHeader* header, bool create, b2Body** bodies, b2Joint** joints)
+{
+    std::int32_t bodyCount = header->bodyCount;
+    std::int32_t jointCount = header->jointCount;
+
+    // Scratch arrays for the body and joint references. The validation pass tracks the
+    // joint types for the gear joints.
+    b2Body** bodyArray = bodies;
+    if (create && bodyArray == nullptr && bodyCount > 0)
+    {
+        bodyArray = m_stackAllocator.Allocate<b2Body*>(bodyCount);
+    }
+
+    b2Joint** jointArray = joints;
+    if (create && jointArray == nullptr && jointCount > 0)
+    {
+        jointArray = m_stackAllocator.Allocate<b2Joint*>(jointCount);
+    }
+
+    std::int32_t* jointTypes = nullptr;
+    if (create == false && jointCount > 0)
+    {
+        jointTypes = m_stackAllocator.Allocate<std::int32_t>(jointCount);
+    }
+
+    if (create)
+    {
+        m_gravity = header->gravity;
+
+        // Create in bulk: reserve the storage and build the broad-phase tree once.
+        m_blockAllocator.Reserve<b2Body>(bodyCount);
+        m_blockAllocator.Reserve<b2Fixture>(header->fixtureCount);
+        ReserveBodySims(m_bodyCount + bodyCount);
+        m_contactManager.m_broadPhase.BeginBulkInsert();
+    }
+
+    bool ok = true;
+    std::int32_t fixtureCount = 0;
+
+    for (std::int32_t bodyIndex = 0; ok && bodyIndex < bodyCount; ++bodyIndex)
+    {
+        const b2SceneBody* record = reader->ReadArray<b2SceneBody>(1);
+        b2BodyDef bodyDef;
+        if (record == nullptr || b2GetSceneBodyDef(record, &bodyDef) == false || record->fixtureCount < 0)
+        {
+            ok = false;
+            break;
+        }
+
+        fixtureCount += record->fixtureCount;
+
+        b2Body* body = nullptr;
+        if (create)
+        {
+            body = CreateBody(&bodyDef);
+            bodyArray[bodyIndex] = body;
+        }
+
+        // The mass is computed once per body below, not for every fixture.
+        for (std::int32_t fixtureIndex = 0; ok && fixtureIndex < record->fixtureCount; ++fixtureIndex)
+        {
+            ok = ReadSceneFixture(reader, body, true, nullptr);
+        }
+
+        if (create && ok)
+        {
+            // Set the velocities afterwards, so the center of mass shift does not change them.
+            body->ResetMassData();
+            body->m_sim->linearVelocity = record->linearVelocity;
+            body->m_sim->angularVelocity = record->angularVelocity;
+        }
+    }
+
+    if (create)
+    {
+        m_contactManager.m_broadPhase.EndBulkInsert();
+    }
+
+    ok = ok && fixtureCount == header->fixtureCount;
+
+    for (std::int32_t jointIndex = 0; ok && jointIndex < jointCount; ++jointIndex)
+    {
+        b2Joint* joint = nullptr;
+        std::int32_t type = e_unknownJoint;
+        ok = ReadSceneJoint(reader, create, create ? bodyArray : nullptr, bodyCount, create ? jointArray : nullptr,
+            jointTypes, jointIndex, &joint, &type);
+        if (create)
+        {
+            jointArray[jointIndex] = joint;
+        }
+        else
+        {
+            jointTypes[jointIndex] = type;
+        }
+    }
+
+    ok = ok && reader->ok && reader->offset == reader->size;
+
+    if (jointTypes != nullptr)
+    {
+        m_stackAllocator.Free(jointTypes);
+    }
+
+    if (jointArray != joints)
+    {
+        m_stackAllocator.Free(jointArray);
+    }
+
+    if (bodyArray != bodies)
+    {
+        m_stackAllocator.Free(bodyArray);
+    }
+
+    return ok;
+}
+
+// Read a fixture record and its shape. Without a body this only validates the data. With
+// deferMass the fixture is created without mass and the caller resets the mass data.
+bool b2World::ReadSceneFixture(b2SceneReader* reader, b2Body* body, bool deferMass, b2Fixture** fixtureOut)
+{
+    const b2SceneFixture* fixture = reader->ReadArray<b2SceneFixture>(1);
+    if (fixture == nullptr || b2IsValid(fixture->radius) == false || fixture->radius < 0.0f ||
+        b2IsValid(fixture->friction) == false || fixture->friction < 0.0f ||
+        b2IsValid(fixture->restitution) == false || b2IsValid(fixture->restitutionThreshold) == false ||
+        b2IsValid(fixture->density) == false || fixture->density < 0.0f)
+    {
+        return false;
+    }
+
+    bool create = body != nullptr;
+    bool ok = true;
+    b2SceneShapes shapes;
+
+    b2FixtureDef fixtureDef;
+    fixtureDef.friction = fixture->friction;
+    fixtureDef.restitution = fixture->restitution;
+    fixtureDef.restitutionThreshold = fixture->restitutionThreshold;
+    fixtureDef.density = deferMass ? 0.0f : fixture->density;
+    fixtureDef.filter.categoryBits = fixture->categoryBits;
+    fixtureDef.filter.maskBits = fixture->maskBits;
+    fixtureDef.filter.groupIndex = fixture->groupIndex;
+    fixtureDef.isSensor = fixture->isSensor != 0;
+
+    b2Fixture* created = nullptr;
+    switch (fixture->shapeType)
+    {
+    case b2Shape::e_chain:
+        {
+            std::int32_t count = reader->Read<std::int32_t>();
+            bool singleProxy = reader->ReadBool();
+            b2Vec2 prevVertex = reader->ReadVec2();
+            b2Vec2 nextVertex = reader->ReadVec2();
+            const b2Vec2* vertices = reader->ReadPoints(count);
+            if (reader->ok == false || count < 2)
+            {
+                ok = false;
+                break;
+            }
+
+            for (std::int32_t i = 1; i < count; ++i)
+            {
+                if (b2DistanceSquared(vertices[i-1], vertices[i]) <= b2_linearSlop * b2_linearSlop)
+                {
+                    ok = false;
+                    break;
+                }
+            }
+
+            if (create && ok)
+            {
+                // Borrow the vertices in place, the fixture makes its own copy.
+                b2ChainShape chain;
+                chain.m_radius = fixture->radius;
+                chain.m_vertices = const_cast<b2Vec2*>(vertices);
+                chain.m_count = count;
+                chain.m_prevVertex = prevVertex;
+                chain.m_nextVertex = nextVertex;
+                chain.SetSingleProxy(singleProxy);
+                fixtureDef.shape = &chain;
+                created = body->CreateFixture(&fixtureDef);
+                chain.m_vertices = nullptr;
+                chain.m_count = 0;
+            }
+        }
+        break;
+
+    case b2Shape::e_heightField:
+        {
+            std::int32_t count = reader->Read<std::int32_t>();
+            float spacing = reader->ReadFloat();
+            const float* heights = reader->ReadArray<float>(count);
+            if (reader->ok == false || count < 2 || spacing <= b2_linearSlop)
+            {
+                ok = false;
+                break;
+            }
+
+            for (std::int32_t i = 0; i < count; ++i)
+            {
+                if (b2IsValid(heights[i]) == false)
+                {
+                    ok = false;
+                    break;
+                }
+            }
+
+            if (ok == false)
+            {
+                break;
+            }
+
+            if (create)
+            {
+                // Borrow the heights in place, the fixture makes its own copy.
+                b2HeightFieldShape heightField;
+                heightField.m_radius = fixture->radius;
+                heightField.m_heights = const_cast<float*>(heights);
+                heightField.m_count = count;
+                heightField.m_spacing = spacing;
+                fixtureDef.shape = &heightField;
+                created = body->CreateFixture(&fixtureDef);
+                heightField.m_heights = nullptr;
+                heightField.m_count = 0;
+            }
+        }
+        break;
+
+    case b2Shape::e_compound:
+        {
+            std::int32_t count = reader->Read<std::int32_t>();
+            if (reader->ok == false || count < 1)
+            {
+                ok = false;
+                break;
+            }
+
+            // The temporary shapes own no memory, so they are not destroyed.
+            b2SceneShapes* storage = nullptr;
+            const b2Shape** children = nullptr;
+            if (create)
+            {
+                storage = m_stackAllocator.Allocate<b2SceneShapes>(count);
+                children = m_stackAllocator.Allocate<const b2Shape*>(count);
+            }
+
+            for (std::int32_t i = 0; i < count; ++i)
+            {
+                std::int32_t type = reader->Read<std::int32_t>();
+                float radius = reader->ReadFloat();
+                b2SceneShapes* childShapes = &shapes;
+                if (create)
+                {
+                    childShapes = new (storage + i) b2SceneShapes;
+                }
+
+                const b2Shape* child = nullptr;
+                if (type != b2Shape::e_edge)
+                {
+                    child = b2ReadSimpleShape(reader, type, radius, childShapes);
+                }
+
+                if (child == nullptr)
+                {
+                    ok = false;
+                    break;
+                }
+
+                if (create)
+                {
+                    children[i] = child;
+                }
+            }
+
+            if (create)
+            {
+                if (ok)
+                {
+                    b2CompoundShape compound;
+                    compound.Create(children, count);
+                    compound.m_radius = fixture->radius;
+                    fixtureDef.shape = &compound;
+                    created = body->CreateFixture(&fixtureDef);
+                }
+
+                m_stackAllocator.Free(children);
+                m_stackAllocator.Free(storage);
+            }
+        }
+        break;
+
+    default:
+        {
+            const b2Shape* shape = b2ReadSimpleShape(reader, fixture->shapeType, fixture->radius, &shapes);
+            if (shape == nullptr)
+            {
+                ok = false;
+                break;
+            }
+
+            if (create)
+            {
+                fixtureDef.shape = shape;
+                created = body->CreateFixture(&fixtureDef);
+            }
+        }
+        break;
+    }
+
+    if (ok == false)
+    {
+        return false;
+    }
+
+    if (created != nullptr && deferMass)
+    {
+        created->m_density = fixture->density;
+    }
+
+    if (fixtureOut != nullptr)
+    {
+        *fixtureOut = created;
+    }
+
+    return true;
+}
+
+// Read a joint record. The bodies are looked up in the body array. The geared joints of a
+// gear joint are looked up in the joint array or, without one, their types in jointTypes.
+// Without create this only validates the data.
+bool b2World::ReadSceneJoint(b2SceneReader* reader, bool create, b2Body* const* bodies, std::int32_t bodyCount,
+    b2Joint* const* joints, const std::int32_t* jointTypes, std::int32_t jointCount, b2Joint** jointOut,
+    std::int32_t* typeOut)
+{
+    const b2SceneJoint* record = reader->ReadArray<b2SceneJoint>(1);
+    if (record == nullptr || record->bodyA < 0 || bodyCount <= record->bodyA ||
+        record->bodyB < 0 || bodyCount <= record->bodyB)
+    {
+        return false;
+    }
+
+    b2Body* bodyA = bodies != nullptr ? bodies[record->bodyA] : nullptr;
+    b2Body* bodyB = bodies != nullptr ? bodies[record->bodyB] : nullptr;
+    if (bodies != nullptr && (bodyA == nullptr || bodyB == nullptr))
+    {
+        return false;
+    }
+
+    bool collideConnected = record->collideConnected != 0;
+    bool ok = true;
+
+    b2Joint* created = nullptr;
+    switch (record->type)
+    {
+    case e_distanceJoint:
+        {
+            b2DistanceJointDef def;
+            def.localAnchorA = reader->ReadVec2();
+            def.localAnchorB = reader->ReadVec2();
+            def.length = reader->ReadFloat();
+            def.minLength = reader->ReadFloat();
+            def.maxLength = reader->ReadFloat();
+            def.stiffness = reader->ReadFloat();
+            def.damping = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_frictionJoint:
+        {
+            b2FrictionJointDef def;
+            def.localAnchorA = reader->ReadVec2();
+            def.localAnchorB = reader->ReadVec2();
+            def.maxForce = reader->ReadFloat();
+            def.maxTorque = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_gearJoint:
+        {
+            std::int32_t index1 = reader->Read<std::int32_t>();
+            std::int32_t index2 = reader->Read<std::int32_t>();
+            float ratio = reader->ReadFloat();
+
+            // The geared joints come first and must be revolute or prismatic.
+            if (reader->ok == false || index1 < 0 || jointCount <= index1 || index2 < 0 || jointCount <= index2)
+            {
+                ok = false;
+                break;
+            }
+
+            std::int32_t type1 = e_unknownJoint;
+            std::int32_t type2 = e_unknownJoint;
+            if (joints != nullptr)
+            {
+                type1 = joints[index1] != nullptr ? joints[index1]->GetType() : e_unknownJoint;
+                type2 = joints[index2] != nullptr ? joints[index2]->GetType() : e_unknownJoint;
+            }
+            else if (jointTypes != nullptr)
+            {
+                type1 = jointTypes[index1];
+                type2 = jointTypes[index2];
+            }
+
+            if ((type1 != e_revoluteJoint && type1 != e_prismaticJoint) ||
+                (type2 != e_revoluteJoint && type2 != e_prismaticJoint))
+            {
+                ok = false;
+                break;
+            }
+
+            b2GearJointDef def;
+            def.joint1 = create ? joints[index1] : nullptr;
+            def.joint2 = create ? joints[index2] : nullptr;
+            def.ratio = ratio;
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_motorJoint:
+        {
+            b2MotorJointDef def;
+            def.linearOffset = reader->ReadVec2();
+            def.angularOffset = reader->ReadFloat();
+            def.maxForce = reader->ReadFloat();
+            def.maxTorque = reader->ReadFloat();
+            def.correctionFactor = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_prismaticJoint:
+        {
+            b2PrismaticJointDef def;
+            def.localAnchorA = reader->ReadVec2();
+            def.localAnchorB = reader->ReadVec2();
+            def.localAxisA = reader->ReadVec2();
+            def.referenceAngle = reader->ReadFloat();
+            def.enableLimit = reader->ReadBool();
+            def.lowerTranslation = reader->ReadFloat();
+            def.upperTranslation = reader->ReadFloat();
+            def.enableMotor = reader->ReadBool();
+            def.maxMotorForce = reader->ReadFloat();
+            def.motorSpeed = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_pulleyJoint:
+        {
+            b2PulleyJointDef def;
+            def.groundAnchorA = reader->ReadVec2();
+            def.groundAnchorB = reader->ReadVec2();
+            def.localAnchorA = reader->ReadVec2();
+            def.localAnchorB = reader->ReadVec2();
+            def.lengthA = reader->ReadFloat();
+            def.lengthB = reader->ReadFloat();
+            def.ratio = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            ok = def.ratio != 0.0f;
+            created = create && ok ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_revoluteJoint:
+        {
+            b2RevoluteJointDef def;
+            def.localAnchorA = reader->ReadVec2();
+            def.localAnchorB = reader->ReadVec2();
+            def.referenceAngle = reader->ReadFloat();
+            def.enableLimit = reader->ReadBool();
+            def.lowerAngle = reader->ReadFloat();
+            def.upperAngle = reader->ReadFloat();
+            def.enableMotor = reader->ReadBool();
+            def.motorSpeed = reader->ReadFloat();
+            def.maxMotorTorque = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_weldJoint:
+        {
+            b2WeldJointDef def;
+            def.localAnchorA = reader->ReadVec2();
+            def.localAnchorB = reader->ReadVec2();
+            def.referenceAngle = reader->ReadFloat();
+            def.stiffness = reader->ReadFloat();
+            def.damping = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    case e_wheelJoint:
+        {
+            b2WheelJointDef def;
+            def.localAnchorA = reader->ReadVec2();
+            def.localAnchorB = reader->ReadVec2();
+            def.localAxisA = reader->ReadVec2();
+            def.enableLimit = reader->ReadBool();
+            def.lowerTranslation = reader->ReadFloat();
+            def.upperTranslation = reader->ReadFloat();
+            def.enableMotor = reader->ReadBool();
+            def.maxMotorTorque = reader->ReadFloat();
+            def.motorSpeed = reader->ReadFloat();
+            def.stiffness = reader->ReadFloat();
+            def.damping = reader->ReadFloat();
+            def.bodyA = bodyA;
+            def.bodyB = bodyB;
+            def.collideConnected = collideConnected;
+            created = create ? CreateJoint(&def) : nullptr;
+        }
+        break;
+
+    default:
+        ok = false;
+        break;
+    }
+
+    ok = ok && reader->ok;
+    if (ok == false)
+    {
+        return false;
+    }
+
+    if (jointOut != nullptr)
+    {
+        *jointOut = created;
+    }
+
+    if (typeOut != nullptr)
+    {
+        *typeOut = record->type;
+    }
+
+    return true;
+}
@@ -0,0 +1,180 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <box2d/b2_body.h>
+#include <box2d/b2_scene.h>
+#include <box2d/b2_settings.h>
+
+#include <cstddef>
+#include <cstring>
+
+class b2Fixture;
+class b2Joint;
+
+// Appends values to a buffer. Values that do not fit are only counted, so a first
+// pass without a buffer gives the size. A growable writer reallocates the buffer
+// with b2Alloc instead.
+struct b2SceneWriter
+{
+    template <typename T>
+    void WriteArray(const T* values, std::int32_t count)
+    {
+        std::size_t bytes = count * sizeof(T);
+        if (growable && size + bytes > capacity)
+        {
+            Grow(size + bytes);
+        }
+
+        if (data != nullptr && size + bytes <= capacity)
+        {
+            memcpy(data + size, values, bytes);
+        }
+        size += bytes;
+    }
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        WriteArray(&value, 1);
+    }
+
+    void WriteBool(bool flag)
+    {
+        Write(std::uint32_t(flag ? 1 : 0));
+    }
+
+    void Grow(std::size_t required)
+    {
+        std::size_t newCapacity = capacity > 0 ? 2 * capacity : 1024;
+        while (newCapacity < required)
+        {
+            newCapacity *= 2;
+        }
+
+        char* newData = (char*)b2Alloc(newCapacity);
+        if (data != nullptr)
+        {
+            memcpy(newData, data, size);
+            b2Free(data);
+        }
+        data = newData;
+        capacity = newCapacity;
+    }
+
+    char* data;
+    std::size_t capacity;
+    std::size_t size;
+    bool growable;
+};
+
+// Reads values in place. Every value is four bytes, so all reads are aligned if the
+// scene is. Reading past the end or a float that is not finite clears the ok flag and
+// returns zeros.
+struct b2SceneReader
+{
+    template <typename T>
+    const T* ReadArray(std::int32_t count)
+    {
+        if (ok == false || count < 0 || offset > size || std::size_t(count) > (size - offset) / sizeof(T))
+        {
+            ok = false;
+            return nullptr;
+        }
+
+        const T* values = reinterpret_cast<const T*>(data + offset);
+        offset += count * sizeof(T);
+        return values;
+    }
+
+    template <typename T>
+    T Read()
+    {
+        const T* value = ReadArray<T>(1);
+        return value != nullptr ? *value : T();
+    }
+
+    float ReadFloat()
+    {
+        float value = Read<float>();
+        if (b2IsValid(value) == false)
+        {
+            ok = false;
+            return 0.0f;
+        }
+
+        return value;
+    }
+
+    b2Vec2 ReadVec2()
+    {
+        const b2Vec2* value = ReadArray<b2Vec2>(1);
+        if (value != nullptr && value->IsValid() == false)
+        {
+            ok = false;
+            return b2Vec2_zero;
+        }
+
+        return value != nullptr ? *value : b2Vec2_zero;
+    }
+
+    // Read an array of points that must all be finite.
+    const b2Vec2* ReadPoints(std::int32_t count)
+    {
+        const b2Vec2* points = ReadArray<b2Vec2>(count);
+        for (std::int32_t i = 0; points != nullptr && i < count; ++i)
+        {
+            if (points[i].IsValid() == false)
+            {
+                ok = false;
+                return nullptr;
+            }
+        }
+
+        return points;
+    }
+
+    bool ReadBool()
+    {
+        return Read<std::uint32_t>() != 0;
+    }
+
+    const char* data;
+    std::size_t size;
+    std::size_t offset;
+    bool ok;
+};
+
+// Write a body record with the given fixture count. The fixtures are written separately.
+void b2WriteSceneBody(b2SceneWriter* writer, const b2Body* body, std::int32_t fixtureCount);
+
+// Write a fixture record followed by its shape.
+void b2WriteSceneFixture(b2SceneWriter* writer, const b2Fixture* fixture);
+
+// Write a joint record other than a mouse joint. The bodies and, for a gear joint, the
+// geared joints are given as indices.
+void b2WriteSceneJoint(b2SceneWriter* writer, b2Joint* joint, std::int32_t bodyA, std::int32_t bodyB,
+    std::int32_t joint1, std::int32_t joint2);
+
+// Get the definition of a body record, or false for a bad record.
+bool b2GetSceneBodyDef(const b2SceneBody* record, b2BodyDef* def);
@@ -22,6 +22,7 @@
 
 #include <box2d/b2_body.h>
 #include <box2d/b2_draw.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_wheel_joint.h>
 #include <box2d/b2_time_step.h>
 
@@ -90,12 +91,12 @@ void b2WheelJoint::InitVelocityConstraints(const b2SolverData& data)
 {
     m_indexA = m_bodyA->m_islandIndex;
     m_indexB = m_bodyB->m_islandIndex;
-    m_localCenterA = m_bodyA->m_sweep.localCenter;
-    m_localCenterB = m_bodyB->m_sweep.localCenter;
-    m_invMassA = m_bodyA->m_invMass;
-    m_invMassB = m_bodyB->m_invMass;
-    m_invIA = m_bodyA->m_invI;
-    m_invIB = m_bodyB->m_invI;
+    m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+    m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+    m_invMassA = m_bodyA->m_sim->invMass;
+    m_invMassB = m_bodyB->m_sim->invMass;
+    m_invIA = m_bodyA->m_sim->invI;
+    m_invIB = m_bodyB->m_sim->invI;
 
     float mA = m_invMassA, mB = m_invMassB;
     float iA = m_invIA, iB = m_invIB;
@@ -482,17 +483,17 @@ float b2WheelJoint::GetJointLinearSpeed() const
     b2Body* bA = m_bodyA;
     b2Body* bB = m_bodyB;
 
-    b2Vec2 rA = b2Mul(bA->m_xf.q, m_localAnchorA - bA->m_sweep.localCenter);
-    b2Vec2 rB = b2Mul(bB->m_xf.q, m_localAnchorB - bB->m_sweep.localCenter);
-    b2Vec2 p1 = bA->m_sweep.c + rA;
-    b2Vec2 p2 = bB->m_sweep.c + rB;
+    b2Vec2 rA = b2Mul(bA->m_sim->xf.q, m_localAnchorA - bA->m_sim->sweep.localCenter);
+    b2Vec2 rB = b2Mul(bB->m_sim->xf.q, m_localAnchorB - bB->m_sim->sweep.localCenter);
+    b2Vec2 p1 = bA->m_sim->sweep.c + rA;
+    b2Vec2 p2 = bB->m_sim->sweep.c + rB;
     b2Vec2 d = p2 - p1;
-    b2Vec2 axis = b2Mul(bA->m_xf.q, m_localXAxisA);
+    b2Vec2 axis = b2Mul(bA->m_sim->xf.q, m_localXAxisA);
 
-    b2Vec2 vA = bA->m_linearVelocity;
-    b2Vec2 vB = bB->m_linearVelocity;
-    float wA = bA->m_angularVelocity;
-    float wB = bB->m_angularVelocity;
+    b2Vec2 vA = bA->m_sim->linearVelocity;
+    b2Vec2 vB = bB->m_sim->linearVelocity;
+    float wA = bA->m_sim->angularVelocity;
+    float wB = bB->m_sim->angularVelocity;
 
     float speed = b2Dot(d, b2Cross(wA, axis)) + b2Dot(axis, vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA));
     return speed;
@@ -502,13 +503,13 @@ float b2WheelJoint::GetJointAngle() const
 {
     b2Body* bA = m_bodyA;
     b2Body* bB = m_bodyB;
-    return bB->m_sweep.a - bA->m_sweep.a;
+    return bB->m_sim->sweep.a - bA->m_sim->sweep.a;
 }
 
 float b2WheelJoint::GetJointAngularSpeed() const
 {
-    float wA = m_bodyA->m_angularVelocity;
-    float wB = m_bodyB->m_angularVelocity;
+    float wA = m_bodyA->m_sim->angularVelocity;
+    float wB = m_bodyB->m_sim->angularVelocity;
     return wB - wA;
 }
 
@@ -519,6 +520,8 @@ bool b2WheelJoint::IsLimitEnabled() const
 
 void b2WheelJoint::EnableLimit(bool flag)
 {
+    RecordInput(b2_replayEnableLimit, flag ? 1.0f : 0.0f);
+
     if (flag != m_enableLimit)
     {
         m_bodyA->SetAwake(true);
@@ -542,6 +545,9 @@ float b2WheelJoint::GetUpperLimit() const
 void b2WheelJoint::SetLimits(float lower, float upper)
 {
     assert(lower <= upper);
+
+    RecordInput(b2_replaySetLimits, lower, upper);
+
     if (lower != m_lowerTranslation || upper != m_upperTranslation)
     {
         m_bodyA->SetAwake(true);
@@ -560,6 +566,8 @@ bool b2WheelJoint::IsMotorEnabled() const
 
 void b2WheelJoint::EnableMotor(bool flag)
 {
+    RecordInput(b2_replayEnableMotor, flag ? 1.0f : 0.0f);
+
     if (flag != m_enableMotor)
     {
         m_bodyA->SetAwake(true);
@@ -570,6 +578,8 @@ void b2WheelJoint::EnableMotor(bool flag)
 
 void b2WheelJoint::SetMotorSpeed(float speed)
 {
+    RecordInput(b2_replaySetMotorSpeed, speed);
+
     if (speed != m_motorSpeed)
     {
         m_bodyA->SetAwake(true);
@@ -580,6 +590,8 @@ void b2WheelJoint::SetMotorSpeed(float speed)
 
 void b2WheelJoint::SetMaxMotorTorque(float torque)
 {
+    RecordInput(b2_replaySetMaxMotorForce, torque);
+
     if (torque != m_maxMotorTorque)
     {
         m_bodyA->SetAwake(true);
@@ -595,6 +607,8 @@ float b2WheelJoint::GetMotorTorque(float inv_dt) const
 
 void b2WheelJoint::SetStiffness(float stiffness)
 {
+    RecordInput(b2_replaySetStiffness, stiffness);
+
     m_stiffness = stiffness;
 }
 
@@ -605,6 +619,8 @@ float b2WheelJoint::GetStiffness() const
 
 void b2WheelJoint::SetDamping(float damping)
 {
+    RecordInput(b2_replaySetDamping, damping);
+
     m_damping = damping;
 }
 
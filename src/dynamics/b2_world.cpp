@@ -25,22 +25,33 @@
 
 #include <box2d/b2_body.h>
 #include <box2d/b2_broad_phase.h>
+#include <box2d/b2_capsule_shape.h>
 #include <box2d/b2_chain_shape.h>
 #include <box2d/b2_circle_shape.h>
 #include <box2d/b2_collision.h>
+#include <box2d/b2_compound_shape.h>
 #include <box2d/b2_contact.h>
 #include <box2d/b2_draw.h>
 #include <box2d/b2_edge_shape.h>
 #include <box2d/b2_fixture.h>
+#include <box2d/b2_height_field_shape.h>
 #include <box2d/b2_polygon_shape.h>
 #include <box2d/b2_pulley_joint.h>
+#include <box2d/b2_replay.h>
 #include <box2d/b2_time_of_impact.h>
 #include <box2d/b2_timer.h>
 #include <box2d/b2_world.h>
 
 #include <new>
 
-b2World::b2World(const b2Vec2& gravity)
+b2World::b2World(const b2Vec2& gravity, b2Allocator* allocator)
+    : m_allocationTracker(allocator)
+    , m_blockAllocator(&m_allocationTracker)
+    , m_stackAllocator(&m_allocationTracker)
+    , m_contactManager(&m_allocationTracker)
+    , m_bodyHandles(&m_allocationTracker)
+    , m_fixtureHandles(&m_allocationTracker)
+    , m_jointHandles(&m_allocationTracker)
 {
     m_destructionListener = nullptr;
     m_debugDraw = nullptr;
@@ -51,12 +62,21 @@ b2World::b2World(const b2Vec2& gravity)
     m_bodyCount = 0;
     m_jointCount = 0;
 
+    m_bodySimCapacity = 16;
+    m_bodySims = (b2BodySim*)m_allocationTracker.Allocate(m_bodySimCapacity * sizeof(b2BodySim), b2_bodyAllocation);
+    m_bodySimOwners = (b2Body**)m_allocationTracker.Allocate(m_bodySimCapacity * sizeof(b2Body*), b2_bodyAllocation);
+
     m_warmStarting = true;
     m_continuousPhysics = true;
     m_subStepping = false;
 
     m_stepComplete = true;
 
+    m_treeOptimizationBudget = b2_treeOptimizationBudget;
+
+    m_stepCount = 0;
+    m_allocationCheckStepCount = -1;
+
     m_allowSleep = true;
     m_gravity = gravity;
 
@@ -64,6 +84,8 @@ b2World::b2World(const b2Vec2& gravity)
     m_locked = false;
     m_clearForces = true;
 
+    m_recorder = nullptr;
+
     m_inv_dt0 = 0.0f;
 
     m_contactManager.m_allocator = &m_blockAllocator;
@@ -73,6 +95,11 @@ b2World::b2World(const b2Vec2& gravity)
 
 b2World::~b2World()
 {
+    if (m_recorder != nullptr)
+    {
+        m_recorder->End();
+    }
+
     // Some shapes allocate using b2Alloc.
     b2Body* b = m_bodyList;
     while (b)
@@ -90,6 +117,9 @@ b2World::~b2World()
 
         b = bNext;
     }
+
+    m_allocationTracker.Free(m_bodySimOwners, m_bodySimCapacity * sizeof(b2Body*), b2_bodyAllocation);
+    m_allocationTracker.Free(m_bodySims, m_bodySimCapacity * sizeof(b2BodySim), b2_bodyAllocation);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -121,7 +151,10 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
     }
 
     auto* mem = m_blockAllocator.Allocate<b2Body>();
-    b2Body* b = new (mem) b2Body(def, this);
+    b2BodySim* sim = AllocateBodySim((b2Body*)mem);
+    b2Body* b = new (mem) b2Body(def, this, sim);
+    b->m_id.index = m_bodyHandles.Allocate(b);
+    b->m_id.generation = m_bodyHandles.GetGeneration(b->m_id.index);
 
     // Add to world doubly linked list.
     b->m_prev = nullptr;
@@ -133,6 +166,11 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
     m_bodyList = b;
     ++m_bodyCount;
 
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordCreateBody(b);
+    }
+
     return b;
 }
 
@@ -163,6 +201,12 @@ void b2World::DestroyBody(b2Body* b)
     }
     b->m_jointList = nullptr;
 
+    // After the joints, so that a replay destroys them first.
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordDestroyBody(b);
+    }
+
     // Delete the attached contacts.
     b2ContactEdge* ce = b->m_contactList;
     while (ce)
@@ -186,6 +230,7 @@ void b2World::DestroyBody(b2Body* b)
         }
 
         f0->DestroyProxies(&m_contactManager.m_broadPhase);
+        m_fixtureHandles.Free(f0->m_id.index);
         f0->Destroy(&m_blockAllocator);
         f0->~b2Fixture();
         m_blockAllocator.Free(f0);
@@ -212,11 +257,69 @@ void b2World::DestroyBody(b2Body* b)
         m_bodyList = b->m_next;
     }
 
+    FreeBodySim(b);
+    m_bodyHandles.Free(b->m_id.index);
+
     --m_bodyCount;
     b->~b2Body();
     m_blockAllocator.Free(b);
 }
 
+// Append simulation state for a new body. Grow the array if necessary.
+b2BodySim* b2World::AllocateBodySim(b2Body* body)
+{
+    if (m_bodyCount == m_bodySimCapacity)
+    {
+        ReserveBodySims(2 * m_bodySimCapacity);
+    }
+
+    m_bodySimOwners[m_bodyCount] = body;
+    return m_bodySims + m_bodyCount;
+}
+
+// Grow the simulation state array to the given capacity and patch the sim
+// pointers of the existing bodies.
+void b2World::ReserveBodySims(std::int32_t capacity)
+{
+    if (capacity > m_bodySimCapacity)
+    {
+        b2BodySim* oldSims = m_bodySims;
+        b2Body** oldOwners = m_bodySimOwners;
+        std::int32_t oldCapacity = m_bodySimCapacity;
+        m_bodySimCapacity = capacity;
+        m_bodySims = (b2BodySim*)m_allocationTracker.Allocate(m_bodySimCapacity * sizeof(b2BodySim), b2_bodyAllocation);
+        m_bodySimOwners = (b2Body**)m_allocationTracker.Allocate(m_bodySimCapacity * sizeof(b2Body*), b2_bodyAllocation);
+        memcpy(m_bodySims, oldSims, m_bodyCount * sizeof(b2BodySim));
+        memcpy(m_bodySimOwners, oldOwners, m_bodyCount * sizeof(b2Body*));
+        m_allocationTracker.Free(oldSims, oldCapacity * sizeof(b2BodySim), b2_bodyAllocation);
+        m_allocationTracker.Free(oldOwners, oldCapacity * sizeof(b2Body*), b2_bodyAllocation);
+
+        for (std::int32_t i = 0; i < m_bodyCount; ++i)
+        {
+            m_bodySimOwners[i]->m_sim = m_bodySims + i;
+        }
+    }
+}
+
+// Remove the simulation state of a body. The last entry is moved into
+// the hole to keep the array dense.
+void b2World::FreeBodySim(b2Body* body)
+{
+    std::int32_t index = static_cast<std::int32_t>(body->m_sim - m_bodySims);
+    std::int32_t lastIndex = m_bodyCount - 1;
+    assert(0 <= index && index <= lastIndex);
+    assert(m_bodySimOwners[index] == body);
+
+    if (index != lastIndex)
+    {
+        m_bodySims[index] = m_bodySims[lastIndex];
+        m_bodySimOwners[index] = m_bodySimOwners[lastIndex];
+        m_bodySimOwners[index]->m_sim = m_bodySims + index;
+    }
+
+    body->m_sim = nullptr;
+}
+
 b2Joint* b2World::CreateJoint(const b2JointDef* def)
 {
     assert(IsLocked() == false);
@@ -226,6 +329,8 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
     }
 
     b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
+    j->m_id.index = m_jointHandles.Allocate(j);
+    j->m_id.generation = m_jointHandles.GetGeneration(j->m_id.index);
 
     // Connect to the world list.
     j->m_prev = nullptr;
@@ -274,6 +379,11 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 
     // Note: creating a joint doesn't wake the bodies.
 
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordCreateJoint(j);
+    }
+
     return j;
 }
 
@@ -285,6 +395,11 @@ void b2World::DestroyJoint(b2Joint* j)
         return;
     }
 
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordDestroyJoint(j);
+    }
+
     bool collideConnected = j->m_collideConnected;
 
     // Remove from the doubly linked list.
@@ -349,6 +464,7 @@ void b2World::DestroyJoint(b2Joint* j)
     j->m_edgeB.prev = nullptr;
     j->m_edgeB.next = nullptr;
 
+    m_jointHandles.Free(j->m_id.index);
     b2Joint::Destroy(j, &m_blockAllocator);
 
     assert(m_jointCount > 0);
@@ -390,6 +506,39 @@ void b2World::SetAllowSleeping(bool flag)
     }
 }
 
+void b2World::ReserveStack(std::size_t size)
+{
+    assert(IsLocked() == false);
+    if (IsLocked())
+    {
+        return;
+    }
+
+    m_stackAllocator.Reserve(size);
+}
+
+void b2World::ReserveBlocks(std::size_t size, std::int32_t count)
+{
+    assert(IsLocked() == false);
+    if (IsLocked())
+    {
+        return;
+    }
+
+    m_blockAllocator.Reserve(size, count);
+}
+
+std::int32_t b2World::TrimBlocks()
+{
+    assert(IsLocked() == false);
+    if (IsLocked())
+    {
+        return 0;
+    }
+
+    return m_blockAllocator.Trim();
+}
+
 // Find islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
@@ -405,13 +554,13 @@ void b2World::Solve(const b2TimeStep& step)
                     m_contactManager.m_contactListener);
 
     // Clear all the island flags.
-    for (b2Body* b = m_bodyList; b; b = b->m_next)
+    for (std::int32_t i = 0; i < m_bodyCount; ++i)
     {
-        b->m_flags &= ~b2Body::e_islandFlag;
+        m_bodySims[i].flags &= ~b2Body::e_islandFlag;
     }
-    for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+    for (std::int32_t i = 0; i < m_contactManager.m_contactCount; ++i)
     {
-        c->m_flags &= ~b2Contact::e_islandFlag;
+        m_contactManager.m_contacts[i]->m_flags &= ~b2Contact::e_islandFlag;
     }
     for (b2Joint* j = m_jointList; j; j = j->m_next)
     {
@@ -423,7 +572,7 @@ void b2World::Solve(const b2TimeStep& step)
     b2Body** stack = m_stackAllocator.Allocate<b2Body*>(stackSize);
     for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
     {
-        if (seed->m_flags & b2Body::e_islandFlag)
+        if (seed->m_sim->flags & b2Body::e_islandFlag)
         {
             continue;
         }
@@ -443,7 +592,7 @@ void b2World::Solve(const b2TimeStep& step)
         island.Clear();
         std::int32_t stackCount = 0;
         stack[stackCount++] = seed;
-        seed->m_flags |= b2Body::e_islandFlag;
+        seed->m_sim->flags |= b2Body::e_islandFlag;
 
         // Perform a depth first search (DFS) on the constraint graph.
         while (stackCount > 0)
@@ -461,7 +610,7 @@ void b2World::Solve(const b2TimeStep& step)
             }
 
             // Make sure the body is awake (without resetting sleep timer).
-            b->m_flags |= b2Body::e_awakeFlag;
+            b->m_sim->flags |= b2Body::e_awakeFlag;
 
             // Search all contacts connected to this body.
             for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
@@ -495,14 +644,14 @@ void b2World::Solve(const b2TimeStep& step)
                 b2Body* other = ce->other;
 
                 // Was the other body already added to this island?
-                if (other->m_flags & b2Body::e_islandFlag)
+                if (other->m_sim->flags & b2Body::e_islandFlag)
                 {
                     continue;
                 }
 
                 assert(stackCount < stackSize);
                 stack[stackCount++] = other;
-                other->m_flags |= b2Body::e_islandFlag;
+                other->m_sim->flags |= b2Body::e_islandFlag;
             }
 
             // Search all joints connect to this body.
@@ -524,14 +673,14 @@ void b2World::Solve(const b2TimeStep& step)
                 island.Add(je->joint);
                 je->joint->m_islandFlag = true;
 
-                if (other->m_flags & b2Body::e_islandFlag)
+                if (other->m_sim->flags & b2Body::e_islandFlag)
                 {
                     continue;
                 }
 
                 assert(stackCount < stackSize);
                 stack[stackCount++] = other;
-                other->m_flags |= b2Body::e_islandFlag;
+                other->m_sim->flags |= b2Body::e_islandFlag;
             }
         }
 
@@ -548,7 +697,7 @@ void b2World::Solve(const b2TimeStep& step)
             b2Body* b = island.m_bodies[i];
             if (b->GetType() == b2_staticBody)
             {
-                b->m_flags &= ~b2Body::e_islandFlag;
+                b->m_sim->flags &= ~b2Body::e_islandFlag;
             }
         }
     }
@@ -561,7 +710,7 @@ void b2World::Solve(const b2TimeStep& step)
         for (b2Body* b = m_bodyList; b; b = b->GetNext())
         {
             // If a body was not in an island then it did not move.
-            if ((b->m_flags & b2Body::e_islandFlag) == 0)
+            if ((b->m_sim->flags & b2Body::e_islandFlag) == 0)
             {
                 continue;
             }
@@ -575,6 +724,12 @@ void b2World::Solve(const b2TimeStep& step)
             b->SynchronizeFixtures();
         }
 
+        // Improve the tree before querying it.
+        if (m_treeOptimizationBudget > 0)
+        {
+            m_contactManager.m_broadPhase.OptimizeTree(m_treeOptimizationBudget);
+        }
+
         // Look for new contacts.
         m_contactManager.FindNewContacts();
         m_profile.broadphase = timer.GetMilliseconds();
@@ -588,14 +743,16 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
     if (m_stepComplete)
     {
-        for (b2Body* b = m_bodyList; b; b = b->m_next)
+        for (std::int32_t i = 0; i < m_bodyCount; ++i)
         {
-            b->m_flags &= ~b2Body::e_islandFlag;
-            b->m_sweep.alpha0 = 0.0f;
+            m_bodySims[i].flags &= ~b2Body::e_islandFlag;
+            m_bodySims[i].sweep.alpha0 = 0.0f;
         }
 
-        for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+        for (std::int32_t i = 0; i < m_contactManager.m_contactCount; ++i)
         {
+            b2Contact* c = m_contactManager.m_contacts[i];
+
             // Invalidate TOI
             c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
             c->m_toiCount = 0;
@@ -610,8 +767,10 @@ void b2World::SolveTOI(const b2TimeStep& step)
         b2Contact* minContact = nullptr;
         float minAlpha = 1.0f;
 
-        for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+        for (std::int32_t i = 0; i < m_contactManager.m_contactCount; ++i)
         {
+            b2Contact* c = m_contactManager.m_contacts[i];
+
             // Is this contact disabled?
             if (c->IsEnabled() == false)
             {
@@ -668,17 +827,17 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
                 // Compute the TOI for this contact.
                 // Put the sweeps onto the same time interval.
-                float alpha0 = bA->m_sweep.alpha0;
+                float alpha0 = bA->m_sim->sweep.alpha0;
 
-                if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
+                if (bA->m_sim->sweep.alpha0 < bB->m_sim->sweep.alpha0)
                 {
-                    alpha0 = bB->m_sweep.alpha0;
-                    bA->m_sweep.Advance(alpha0);
+                    alpha0 = bB->m_sim->sweep.alpha0;
+                    bA->m_sim->sweep.Advance(alpha0);
                 }
-                else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
+                else if (bB->m_sim->sweep.alpha0 < bA->m_sim->sweep.alpha0)
                 {
-                    alpha0 = bA->m_sweep.alpha0;
-                    bB->m_sweep.Advance(alpha0);
+                    alpha0 = bA->m_sim->sweep.alpha0;
+                    bB->m_sim->sweep.Advance(alpha0);
                 }
 
                 assert(alpha0 < 1.0f);
@@ -690,8 +849,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
                 b2TOIInput input;
                 input.proxyA.Set(fA->GetShape(), indexA);
                 input.proxyB.Set(fB->GetShape(), indexB);
-                input.sweepA = bA->m_sweep;
-                input.sweepB = bB->m_sweep;
+                input.sweepA = bA->m_sim->sweep;
+                input.sweepB = bB->m_sim->sweep;
                 input.tMax = 1.0f;
 
                 b2TOIOutput output;
@@ -733,14 +892,14 @@ void b2World::SolveTOI(const b2TimeStep& step)
         b2Body* bA = fA->GetBody();
         b2Body* bB = fB->GetBody();
 
-        b2Sweep backup1 = bA->m_sweep;
-        b2Sweep backup2 = bB->m_sweep;
+        b2Sweep backup1 = bA->m_sim->sweep;
+        b2Sweep backup2 = bB->m_sim->sweep;
 
         bA->Advance(minAlpha);
         bB->Advance(minAlpha);
 
         // The TOI contact likely has some new contact points.
-        minContact->Update(m_contactManager.m_contactListener);
+        minContact->Update(&m_contactManager);
         minContact->m_flags &= ~b2Contact::e_toiFlag;
         ++minContact->m_toiCount;
 
@@ -749,8 +908,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
         {
             // Restore the sweeps.
             minContact->SetEnabled(false);
-            bA->m_sweep = backup1;
-            bB->m_sweep = backup2;
+            bA->m_sim->sweep = backup1;
+            bB->m_sim->sweep = backup2;
             bA->SynchronizeTransform();
             bB->SynchronizeTransform();
             continue;
@@ -765,8 +924,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
         island.Add(bB);
         island.Add(minContact);
 
-        bA->m_flags |= b2Body::e_islandFlag;
-        bB->m_flags |= b2Body::e_islandFlag;
+        bA->m_sim->flags |= b2Body::e_islandFlag;
+        bB->m_sim->flags |= b2Body::e_islandFlag;
         minContact->m_flags |= b2Contact::e_islandFlag;
 
         // Get contacts on bodyA and bodyB.
@@ -813,19 +972,19 @@ void b2World::SolveTOI(const b2TimeStep& step)
                     }
 
                     // Tentatively advance the body to the TOI.
-                    b2Sweep backup = other->m_sweep;
-                    if ((other->m_flags & b2Body::e_islandFlag) == 0)
+                    b2Sweep backup = other->m_sim->sweep;
+                    if ((other->m_sim->flags & b2Body::e_islandFlag) == 0)
                     {
                         other->Advance(minAlpha);
                     }
 
                     // Update the contact points
-                    contact->Update(m_contactManager.m_contactListener);
+                    contact->Update(&m_contactManager);
 
                     // Was the contact disabled by the user?
                     if (contact->IsEnabled() == false)
                     {
-                        other->m_sweep = backup;
+                        other->m_sim->sweep = backup;
                         other->SynchronizeTransform();
                         continue;
                     }
@@ -833,7 +992,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
                     // Are there contact points?
                     if (contact->IsTouching() == false)
                     {
-                        other->m_sweep = backup;
+                        other->m_sim->sweep = backup;
                         other->SynchronizeTransform();
                         continue;
                     }
@@ -843,13 +1002,13 @@ void b2World::SolveTOI(const b2TimeStep& step)
                     island.Add(contact);
 
                     // Has the other body already been added to the island?
-                    if (other->m_flags & b2Body::e_islandFlag)
+                    if (other->m_sim->flags & b2Body::e_islandFlag)
                     {
                         continue;
                     }
 
                     // Add the other body to the island.
-                    other->m_flags |= b2Body::e_islandFlag;
+                    other->m_sim->flags |= b2Body::e_islandFlag;
 
                     if (other->m_type != b2_staticBody)
                     {
@@ -874,7 +1033,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
         for (std::int32_t i = 0; i < island.m_bodyCount; ++i)
         {
             b2Body* body = island.m_bodies[i];
-            body->m_flags &= ~b2Body::e_islandFlag;
+            body->m_sim->flags &= ~b2Body::e_islandFlag;
 
             if (body->m_type != b2_dynamicBody)
             {
@@ -904,8 +1063,18 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 void b2World::Step(float dt, std::int32_t velocityIterations, std::int32_t positionIterations)
 {
+    // Before the timer, so that recording does not count toward the step profile.
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordStep(dt, velocityIterations, positionIterations);
+    }
+
     b2Timer stepTimer;
 
+    // After the warm-up steps all memory should be in place.
+    bool checkAllocations = 0 <= m_allocationCheckStepCount && m_allocationCheckStepCount <= m_stepCount;
+    m_allocationTracker.SetCheck(checkAllocations);
+
     // If new fixtures were added, we need to find the new contacts.
     if (m_newContacts)
     {
@@ -967,15 +1136,33 @@ void b2World::Step(float dt, std::int32_t velocityIterations, std::int32_t posit
 
     m_locked = false;
 
+    if (m_recorder != nullptr)
+    {
+        m_recorder->EndStep();
+    }
+
+    m_allocationTracker.SetCheck(false);
+    ++m_stepCount;
+
     m_profile.step = stepTimer.GetMilliseconds();
 }
 
+void b2World::SetGravity(const b2Vec2& gravity)
+{
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordGravity(gravity);
+    }
+
+    m_gravity = gravity;
+}
+
 void b2World::ClearForces()
 {
-    for (b2Body* body = m_bodyList; body; body = body->GetNext())
+    for (std::int32_t i = 0; i < m_bodyCount; ++i)
     {
-        body->m_force.SetZero();
-        body->m_torque = 0.0f;
+        m_bodySims[i].force.SetZero();
+        m_bodySims[i].torque = 0.0f;
     }
 }
 
@@ -999,6 +1186,28 @@ void b2World::QueryAABB(b2QueryCallback* callback, const b2AABB& aabb) const
     m_contactManager.m_broadPhase.Query(&wrapper, aabb);
 }
 
+// Finds the closest child hit of a shape that shares a proxy.
+struct b2WorldChildRayCastCallback : public b2ChildQueryCallback
+{
+    bool ReportChild(std::int32_t childIndex) override
+    {
+        b2RayCastOutput childOutput;
+        if (fixture->RayCast(&childOutput, input, childIndex))
+        {
+            output = childOutput;
+            input.maxFraction = childOutput.fraction;
+            hit = true;
+        }
+
+        return true;
+    }
+
+    const b2Fixture* fixture;
+    b2RayCastInput input;
+    b2RayCastOutput output;
+    bool hit;
+};
+
 struct b2WorldRayCastWrapper
 {
     float RayCastCallback(const b2RayCastInput& input, std::int32_t proxyId)
@@ -1008,7 +1217,30 @@ struct b2WorldRayCastWrapper
         b2Fixture* fixture = proxy->fixture;
         std::int32_t index = proxy->childIndex;
         b2RayCastOutput output;
-        bool hit = fixture->RayCast(&output, input, index);
+        bool hit;
+
+        const b2Shape* shape = fixture->GetShape();
+        if (shape->SharesProxy())
+        {
+            // Only cast against the children along the ray.
+            b2Vec2 p2 = input.p1 + input.maxFraction * (input.p2 - input.p1);
+            b2AABB aabb;
+            aabb.lowerBound = b2Min(input.p1, p2);
+            aabb.upperBound = b2Max(input.p1, p2);
+
+            b2WorldChildRayCastCallback childCallback;
+            childCallback.fixture = fixture;
+            childCallback.input = input;
+            childCallback.hit = false;
+            shape->QueryChildren(&childCallback, aabb, fixture->GetBody()->GetTransform());
+
+            hit = childCallback.hit;
+            output = childCallback.output;
+        }
+        else
+        {
+            hit = fixture->RayCast(&output, input, index);
+        }
 
         if (hit)
         {
@@ -1036,13 +1268,13 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
     m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
-void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
+void b2World::DrawShape(const b2Shape* shape, const b2Transform& xf, const b2Color& color)
 {
-    switch (fixture->GetType())
+    switch (shape->GetType())
     {
     case b2Shape::e_circle:
         {
-            b2CircleShape* circle = (b2CircleShape*)fixture->GetShape();
+            const b2CircleShape* circle = (const b2CircleShape*)shape;
 
             b2Vec2 center = b2Mul(xf, circle->m_p);
             float radius = circle->m_radius;
@@ -1054,7 +1286,7 @@ void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color
 
     case b2Shape::e_edge:
         {
-            b2EdgeShape* edge = (b2EdgeShape*)fixture->GetShape();
+            const b2EdgeShape* edge = (const b2EdgeShape*)shape;
             b2Vec2 v1 = b2Mul(xf, edge->m_vertex1);
             b2Vec2 v2 = b2Mul(xf, edge->m_vertex2);
             m_debugDraw->DrawSegment(v1, v2, color);
@@ -1069,7 +1301,7 @@ void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color
 
     case b2Shape::e_chain:
         {
-            b2ChainShape* chain = (b2ChainShape*)fixture->GetShape();
+            const b2ChainShape* chain = (const b2ChainShape*)shape;
             std::int32_t count = chain->m_count;
             const b2Vec2* vertices = chain->m_vertices;
 
@@ -1083,9 +1315,43 @@ void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color
         }
         break;
 
+    case b2Shape::e_heightField:
+        {
+            const b2HeightFieldShape* heightField = (const b2HeightFieldShape*)shape;
+            std::int32_t count = heightField->m_count;
+
+            b2Vec2 v1 = b2Mul(xf, heightField->GetVertex(0));
+            for (std::int32_t i = 1; i < count; ++i)
+            {
+                b2Vec2 v2 = b2Mul(xf, heightField->GetVertex(i));
+                m_debugDraw->DrawSegment(v1, v2, color);
+                v1 = v2;
+            }
+        }
+        break;
+
+    case b2Shape::e_capsule:
+        {
+            const b2CapsuleShape* capsule = (const b2CapsuleShape*)shape;
+            b2Vec2 v1 = b2Mul(xf, capsule->m_vertex1);
+            b2Vec2 v2 = b2Mul(xf, capsule->m_vertex2);
+            float radius = capsule->m_radius;
+
+            b2Vec2 axis = v2 - v1;
+            axis.Normalize();
+            b2Vec2 offset = radius * b2Vec2(-axis.y, axis.x);
+
+            m_debugDraw->DrawCircle(v1, radius, color);
+            m_debugDraw->DrawCircle(v2, radius, color);
+            m_debugDraw->DrawSegment(v1 + offset, v2 + offset, color);
+            m_debugDraw->DrawSegment(v1 - offset, v2 - offset, color);
+            m_debugDraw->DrawSegment(v1, v2, color);
+        }
+        break;
+
     case b2Shape::e_polygon:
         {
-            b2PolygonShape* poly = (b2PolygonShape*)fixture->GetShape();
+            const b2PolygonShape* poly = (const b2PolygonShape*)shape;
             std::int32_t vertexCount = poly->m_count;
             assert(vertexCount <= b2_maxPolygonVertices);
             b2Vec2 vertices[b2_maxPolygonVertices];
@@ -1099,6 +1365,16 @@ void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color
         }
         break;
 
+    case b2Shape::e_compound:
+        {
+            const b2CompoundShape* compound = (const b2CompoundShape*)shape;
+            for (std::int32_t i = 0; i < compound->m_count; ++i)
+            {
+                DrawShape(compound->GetChild(i), xf, color);
+            }
+        }
+        break;
+
     default:
     break;
     }
@@ -1120,30 +1396,30 @@ void b2World::DebugDraw()
             const b2Transform& xf = b->GetTransform();
             for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext())
             {
-                if (b->GetType() == b2_dynamicBody && b->m_mass == 0.0f)
+                if (b->GetType() == b2_dynamicBody && b->m_sim->mass == 0.0f)
                 {
                     // Bad body
-                    DrawShape(f, xf, b2Color(1.0f, 0.0f, 0.0f));
+                    DrawShape(f->GetShape(), xf, b2Color(1.0f, 0.0f, 0.0f));
                 }
                 else if (b->IsEnabled() == false)
                 {
-                    DrawShape(f, xf, b2Color(0.5f, 0.5f, 0.3f));
+                    DrawShape(f->GetShape(), xf, b2Color(0.5f, 0.5f, 0.3f));
                 }
                 else if (b->GetType() == b2_staticBody)
                 {
-                    DrawShape(f, xf, b2Color(0.5f, 0.9f, 0.5f));
+                    DrawShape(f->GetShape(), xf, b2Color(0.5f, 0.9f, 0.5f));
                 }
                 else if (b->GetType() == b2_kinematicBody)
                 {
-                    DrawShape(f, xf, b2Color(0.5f, 0.5f, 0.9f));
+                    DrawShape(f->GetShape(), xf, b2Color(0.5f, 0.5f, 0.9f));
                 }
                 else if (b->IsAwake() == false)
                 {
-                    DrawShape(f, xf, b2Color(0.6f, 0.6f, 0.6f));
+                    DrawShape(f->GetShape(), xf, b2Color(0.6f, 0.6f, 0.6f));
                 }
                 else
                 {
-                    DrawShape(f, xf, b2Color(0.9f, 0.7f, 0.7f));
+                    DrawShape(f->GetShape(), xf, b2Color(0.9f, 0.7f, 0.7f));
                 }
             }
         }
@@ -1160,8 +1436,9 @@ void b2World::DebugDraw()
     if (flags & b2Draw::e_pairBit)
     {
         b2Color color(0.3f, 0.9f, 0.9f);
-        for (b2Contact* c = m_contactManager.m_contactList; c; c = c->GetNext())
+        for (std::int32_t i = 0; i < m_contactManager.m_contactCount; ++i)
         {
+            b2Contact* c = m_contactManager.m_contacts[i];
             b2Fixture* fixtureA = c->GetFixtureA();
             b2Fixture* fixtureB = c->GetFixtureB();
             std::int32_t indexA = c->GetChildIndexA();
@@ -1234,6 +1511,64 @@ float b2World::GetTreeQuality() const
     return m_contactManager.m_broadPhase.GetTreeQuality();
 }
 
+void b2World::Clear()
+{
+    assert(IsLocked() == false);
+    if (IsLocked())
+    {
+        return;
+    }
+
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordClear();
+    }
+
+    // Shapes with many children allocate using b2Alloc, either for the shape data or for
+    // a proxy array beyond the block sizes. Everything else lives in the block allocator.
+    for (b2Body* b = m_bodyList; b; b = b->m_next)
+    {
+        b2Fixture* f = b->m_fixtureList;
+        while (f)
+        {
+            b2Fixture* fNext = f->m_next;
+            b2Shape::Type type = f->m_shape->m_type;
+            if (type == b2Shape::e_chain || type == b2Shape::e_heightField || type == b2Shape::e_compound)
+            {
+                f->m_proxyCount = 0;
+                f->Destroy(&m_blockAllocator);
+            }
+            f = fNext;
+        }
+    }
+
+    m_contactManager.m_contactList = nullptr;
+    m_contactManager.m_contactCount = 0;
+    m_contactManager.m_pairSet.Clear();
+    m_contactManager.m_manifoldReuseCount = 0;
+    m_contactManager.m_manifoldUpdateCount = 0;
+    m_contactManager.m_falsePairCount = 0;
+    m_contactManager.m_broadPhase.Reset();
+
+    m_blockAllocator.Reset();
+
+    m_bodyHandles.Reset();
+    m_fixtureHandles.Reset();
+    m_jointHandles.Reset();
+
+    m_bodyList = nullptr;
+    m_jointList = nullptr;
+    m_bodyCount = 0;
+    m_jointCount = 0;
+
+    m_newContacts = false;
+    m_stepComplete = true;
+    m_inv_dt0 = 0.0f;
+    m_stepCount = 0;
+
+    memset(&m_profile, 0, sizeof(b2Profile));
+}
+
 void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 {
     assert(m_locked == false);
@@ -1242,11 +1577,12 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
         return;
     }
 
-    for (b2Body* b = m_bodyList; b; b = b->m_next)
+    for (std::int32_t i = 0; i < m_bodyCount; ++i)
     {
-        b->m_xf.p -= newOrigin;
-        b->m_sweep.c0 -= newOrigin;
-        b->m_sweep.c -= newOrigin;
+        b2BodySim* sim = m_bodySims + i;
+        sim->xf.p -= newOrigin;
+        sim->sweep.c0 -= newOrigin;
+        sim->sweep.c -= newOrigin;
     }
 
     for (b2Joint* j = m_jointList; j; j = j->m_next)
@@ -0,0 +1,385 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "b2_scene_stream.h"
+
+#include <box2d/b2_body.h>
+#include <box2d/b2_world_state.h>
+
+#include <cstring>
+
+// Fields of a delta record, after the flags that are sent as they are.
+enum
+{
+    b2_deltaPosition = 0x0004,
+    b2_deltaAngle = 0x0008,
+    b2_deltaLinearVelocity = 0x0010,
+    b2_deltaAngularVelocity = 0x0020
+};
+
+// Flags that are sent with a record.
+constexpr std::uint32_t b2_deltaStateFlags = b2_quantizedPresent | b2_quantizedAwake;
+
+// Unsigned LEB128, so small values take one byte on any host.
+static void b2WriteVarint(b2SceneWriter* writer, std::uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        writer->Write(std::uint8_t(value | 0x80));
+        value >>= 7;
+    }
+    writer->Write(std::uint8_t(value));
+}
+
+static std::uint32_t b2ReadVarint(b2SceneReader* reader)
+{
+    std::uint32_t value = 0;
+    for (std::int32_t shift = 0; shift < 35; shift += 7)
+    {
+        std::uint8_t byte = reader->Read<std::uint8_t>();
+        value |= std::uint32_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+
+    reader->ok = false;
+    return 0;
+}
+
+// Write the difference of two quantized values. The difference wraps, so it never
+// overflows, and zigzag coding keeps small negative values small.
+static void b2WriteDifference(b2SceneWriter* writer, std::int32_t value, std::int32_t base)
+{
+    std::uint32_t d = std::uint32_t(value) - std::uint32_t(base);
+    b2WriteVarint(writer, (d << 1) ^ (0u - (d >> 31)));
+}
+
+static std::int32_t b2ReadDifference(b2SceneReader* reader, std::int32_t base)
+{
+    std::uint32_t z = b2ReadVarint(reader);
+    std::uint32_t d = (z >> 1) ^ (0u - (z & 1));
+    return std::int32_t(std::uint32_t(base) + d);
+}
+
+static std::int32_t b2Quantize(float value, float scale)
+{
+    // Stay inside the int32 range.
+    float q = b2Clamp(value * scale, -2.0e9f, 2.0e9f);
+    return std::int32_t(q < 0.0f ? q - 0.5f : q + 0.5f);
+}
+
+// A full turn in 16 bits.
+static std::int32_t b2QuantizeAngle(float angle)
+{
+    float turns = angle * (0.5f / b2_pi);
+    turns -= std::floor(turns + 0.5f);
+    return std::int32_t(std::floor(turns * 65536.0f + 0.5f)) & 0xffff;
+}
+
+b2WorldState::b2WorldState(const b2StateQuantization& quantization)
+{
+    assert(quantization.positionScale > 0.0f && quantization.velocityScale > 0.0f);
+    m_quantization = quantization;
+    m_bodies = nullptr;
+    m_count = 0;
+    m_capacity = 0;
+    m_changeCount = 0;
+}
+
+b2WorldState::~b2WorldState()
+{
+    b2Free(m_bodies);
+}
+
+void b2WorldState::Reserve(std::int32_t count)
+{
+    if (count <= m_capacity)
+    {
+        return;
+    }
+
+    b2QuantizedBody* oldBodies = m_bodies;
+    m_capacity = b2Max(count, 2 * m_capacity);
+    m_bodies = (b2QuantizedBody*)b2Alloc(m_capacity * sizeof(b2QuantizedBody));
+    if (oldBodies != nullptr)
+    {
+        memcpy(m_bodies, oldBodies, m_count * sizeof(b2QuantizedBody));
+        b2Free(oldBodies);
+    }
+}
+
+void b2WorldState::Capture(b2Body* const* bodies, std::int32_t count)
+{
+    Reserve(count);
+    m_count = count;
+    m_changeCount = 0;
+
+    float positionScale = m_quantization.positionScale;
+    float velocityScale = m_quantization.velocityScale;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        b2QuantizedBody* state = m_bodies + i;
+        const b2Body* body = bodies[i];
+        if (body == nullptr)
+        {
+            memset(state, 0, sizeof(b2QuantizedBody));
+            continue;
+        }
+
+        const b2Vec2& p = body->GetPosition();
+        const b2Vec2& v = body->GetLinearVelocity();
+        state->x = b2Quantize(p.x, positionScale);
+        state->y = b2Quantize(p.y, positionScale);
+        state->angle = b2QuantizeAngle(body->GetAngle());
+        state->vx = b2Quantize(v.x, velocityScale);
+        state->vy = b2Quantize(v.y, velocityScale);
+        state->w = b2Quantize(body->GetAngularVelocity(), velocityScale);
+        state->flags = b2_quantizedPresent;
+        if (body->IsAwake())
+        {
+            state->flags |= b2_quantizedAwake;
+        }
+    }
+}
+
+void b2WorldState::Copy(const b2WorldState& other)
+{
+    if (&other == this)
+    {
+        return;
+    }
+
+    Reserve(other.m_count);
+    m_quantization = other.m_quantization;
+    m_count = other.m_count;
+    m_changeCount = other.m_changeCount;
+    if (m_count > 0)
+    {
+        memcpy(m_bodies, other.m_bodies, m_count * sizeof(b2QuantizedBody));
+    }
+}
+
+// A delta is the body count and the record count, followed by the records. A record is
+// the index gap to the previous record, the field mask with the state flags and the
+// differences of the changed fields. All values are varints.
+std::size_t b2WorldState::EncodeDelta(const b2WorldState* baseline, void* buffer, std::size_t capacity) const
+{
+    b2SceneWriter writer;
+    writer.data = (char*)buffer;
+    writer.capacity = buffer != nullptr ? capacity : 0;
+    writer.size = 0;
+    writer.growable = false;
+
+    // Count the records first.
+    const b2QuantizedBody empty = {};
+    std::int32_t baseCount = baseline != nullptr ? baseline->m_count : 0;
+    std::int32_t recordCount = 0;
+    for (std::int32_t i = 0; i < m_count; ++i)
+    {
+        const b2QuantizedBody& base = i < baseCount ? baseline->m_bodies[i] : empty;
+        const b2QuantizedBody& state = m_bodies[i];
+        if (state.x != base.x || state.y != base.y || state.angle != base.angle || state.vx != base.vx ||
+            state.vy != base.vy || state.w != base.w || (state.flags & b2_deltaStateFlags) != (base.flags & b2_deltaStateFlags))
+        {
+            ++recordCount;
+        }
+    }
+
+    b2WriteVarint(&writer, std::uint32_t(m_count));
+    b2WriteVarint(&writer, std::uint32_t(recordCount));
+
+    std::int32_t previous = -1;
+    for (std::int32_t i = 0; i < m_count; ++i)
+    {
+        const b2QuantizedBody& base = i < baseCount ? baseline->m_bodies[i] : empty;
+        const b2QuantizedBody& state = m_bodies[i];
+
+        std::uint32_t mask = state.flags & b2_deltaStateFlags;
+        if (state.x != base.x || state.y != base.y)
+        {
+            mask |= b2_deltaPosition;
+        }
+        if (state.angle != base.angle)
+        {
+            mask |= b2_deltaAngle;
+        }
+        if (state.vx != base.vx || state.vy != base.vy)
+        {
+            mask |= b2_deltaLinearVelocity;
+        }
+        if (state.w != base.w)
+        {
+            mask |= b2_deltaAngularVelocity;
+        }
+
+        if (mask == (base.flags & b2_deltaStateFlags))
+        {
+            continue;
+        }
+
+        b2WriteVarint(&writer, std::uint32_t(i - previous - 1));
+        b2WriteVarint(&writer, mask);
+        previous = i;
+
+        if (mask & b2_deltaPosition)
+        {
+            b2WriteDifference(&writer, state.x, base.x);
+            b2WriteDifference(&writer, state.y, base.y);
+        }
+        if (mask & b2_deltaAngle)
+        {
+            b2WriteDifference(&writer, state.angle, base.angle);
+        }
+        if (mask & b2_deltaLinearVelocity)
+        {
+            b2WriteDifference(&writer, state.vx, base.vx);
+            b2WriteDifference(&writer, state.vy, base.vy);
+        }
+        if (mask & b2_deltaAngularVelocity)
+        {
+            b2WriteDifference(&writer, state.w, base.w);
+        }
+    }
+
+    return writer.size;
+}
+
+bool b2WorldState::DecodeDelta(const b2WorldState* baseline, const void* data, std::size_t size,
+    std::int32_t maxBodyCount)
+{
+    assert(baseline != this);
+    assert(maxBodyCount >= 0);
+
+    b2SceneReader reader;
+    reader.data = static_cast<const char*>(data);
+    reader.size = data != nullptr ? size : 0;
+    reader.offset = 0;
+    reader.ok = true;
+
+    std::uint32_t count = b2ReadVarint(&reader);
+    std::uint32_t recordCount = b2ReadVarint(&reader);
+
+    // Each record takes two bytes at least.
+    if (reader.ok == false || recordCount > count || recordCount > (reader.size - reader.offset) / 2 ||
+        maxBodyCount < 0 || count > std::uint32_t(maxBodyCount))
+    {
+        m_count = 0;
+        m_changeCount = 0;
+        return false;
+    }
+
+    Reserve(std::int32_t(count));
+    m_count = std::int32_t(count);
+    m_changeCount = std::int32_t(recordCount);
+
+    std::int32_t baseCount = baseline != nullptr ? b2Min(baseline->m_count, m_count) : 0;
+    if (baseCount > 0)
+    {
+        memcpy(m_bodies, baseline->m_bodies, baseCount * sizeof(b2QuantizedBody));
+    }
+    memset(m_bodies + baseCount, 0, (m_count - baseCount) * sizeof(b2QuantizedBody));
+
+    for (std::int32_t i = 0; i < baseCount; ++i)
+    {
+        m_bodies[i].flags &= ~b2_quantizedChanged;
+    }
+
+    std::int64_t index = -1;
+    for (std::uint32_t record = 0; record < recordCount; ++record)
+    {
+        index += std::int64_t(b2ReadVarint(&reader)) + 1;
+        std::uint32_t mask = b2ReadVarint(&reader);
+        if (reader.ok == false || index >= m_count)
+        {
+            reader.ok = false;
+            break;
+        }
+
+        b2QuantizedBody* state = m_bodies + index;
+        if (mask & b2_deltaPosition)
+        {
+            state->x = b2ReadDifference(&reader, state->x);
+            state->y = b2ReadDifference(&reader, state->y);
+        }
+        if (mask & b2_deltaAngle)
+        {
+            state->angle = b2ReadDifference(&reader, state->angle) & 0xffff;
+        }
+        if (mask & b2_deltaLinearVelocity)
+        {
+            state->vx = b2ReadDifference(&reader, state->vx);
+            state->vy = b2ReadDifference(&reader, state->vy);
+        }
+        if (mask & b2_deltaAngularVelocity)
+        {
+            state->w = b2ReadDifference(&reader, state->w);
+        }
+
+        state->flags = (mask & b2_deltaStateFlags) | b2_quantizedChanged;
+    }
+
+    if (reader.ok == false || reader.offset != reader.size)
+    {
+        m_count = 0;
+        m_changeCount = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void b2WorldState::Apply(b2Body* const* bodies, std::int32_t count) const
+{
+    float positionScale = 1.0f / m_quantization.positionScale;
+    float velocityScale = 1.0f / m_quantization.velocityScale;
+    float angleScale = 2.0f * b2_pi / 65536.0f;
+
+    count = b2Min(count, m_count);
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        const b2QuantizedBody& state = m_bodies[i];
+        b2Body* body = bodies[i];
+        if ((state.flags & b2_quantizedChanged) == 0 || (state.flags & b2_quantizedPresent) == 0 || body == nullptr)
+        {
+            continue;
+        }
+
+        // Angles are sent in [0, 2pi), keep the body close to its current angle.
+        float angle = angleScale * state.angle;
+        angle += 2.0f * b2_pi * std::floor((body->GetAngle() - angle) / (2.0f * b2_pi) + 0.5f);
+
+        body->SetTransform(b2Vec2(positionScale * state.x, positionScale * state.y), angle);
+
+        if (state.flags & b2_quantizedAwake)
+        {
+            body->SetAwake(true);
+            body->SetLinearVelocity(b2Vec2(velocityScale * state.vx, velocityScale * state.vy));
+            body->SetAngularVelocity(velocityScale * state.w);
+        }
+        else
+        {
+            body->SetAwake(false);
+        }
+    }
+}
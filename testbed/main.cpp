@@ -372,6 +372,8 @@ static void UpdateUI()
                 ImGui::Checkbox("Warm Starting", &s_settings.m_enableWarmStarting);
                 ImGui::Checkbox("Time of Impact", &s_settings.m_enableContinuous);
                 ImGui::Checkbox("Sub-Stepping", &s_settings.m_enableSubStepping);
+                ImGui::Checkbox("Manifold Reuse", &s_settings.m_enableManifoldReuse);
+                ImGui::Checkbox("Tree Refit", &s_settings.m_enableTreeRefit);
 
                 ImGui::Separator();
 
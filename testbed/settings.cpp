@@ -76,6 +76,8 @@ void Settings::Save()
     fprintf(file, "  \"enableWarmStarting\": %s,\n", m_enableWarmStarting ? "true" : "false");
     fprintf(file, "  \"enableContinuous\": %s,\n", m_enableContinuous ? "true" : "false");
     fprintf(file, "  \"enableSubStepping\": %s,\n", m_enableSubStepping ? "true" : "false");
+    fprintf(file, "  \"enableManifoldReuse\": %s,\n", m_enableManifoldReuse ? "true" : "false");
+    fprintf(file, "  \"enableTreeRefit\": %s,\n", m_enableTreeRefit ? "true" : "false");
     fprintf(file, "  \"enableSleep\": %s\n", m_enableSleep ? "true" : "false");
     fprintf(file, "}\n");
     fclose(file);
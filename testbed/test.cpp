@@ -308,6 +308,8 @@ void Test::Step(Settings& settings)
     m_world->SetWarmStarting(settings.m_enableWarmStarting);
     m_world->SetContinuousPhysics(settings.m_enableContinuous);
     m_world->SetSubStepping(settings.m_enableSubStepping);
+    m_world->SetManifoldReuse(settings.m_enableManifoldReuse);
+    m_world->SetTreeRefit(settings.m_enableTreeRefit);
 
     m_pointCount = 0;
 
@@ -335,6 +337,19 @@ void Test::Step(Settings& settings)
         float quality = m_world->GetTreeQuality();
         g_debugDraw.DrawString(5, m_textLine, "proxies/height/balance/quality = %d/%d/%d/%g", proxyCount, height, balance, quality);
         m_textLine += m_textIncrement;
+
+        std::int32_t reinsertionCount = m_world->GetProxyReinsertionCount();
+        std::int32_t falsePairCount = m_world->GetFalsePositivePairCount();
+        g_debugDraw.DrawString(5, m_textLine, "reinsertions/false pairs = %d/%d", reinsertionCount, falsePairCount);
+        m_textLine += m_textIncrement;
+
+        if (settings.m_enableManifoldReuse)
+        {
+            std::int32_t reuseCount = m_world->GetManifoldReuseCount();
+            std::int32_t updateCount = m_world->GetManifoldUpdateCount();
+            g_debugDraw.DrawString(5, m_textLine, "manifolds reused/updated = %d/%d", reuseCount, updateCount);
+            m_textLine += m_textIncrement;
+        }
     }
 
     // Track maximum profile times
@@ -0,0 +1,104 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "test.h"
+
+// Capsules of different sizes dropped on boxes, circles and a chain.
+class Capsules : public Test
+{
+public:
+
+    enum
+    {
+        e_count = 40
+    };
+
+    Capsules()
+    {
+        {
+            b2BodyDef bd;
+            b2Body* ground = m_world->CreateBody(&bd);
+
+            b2Vec2 vs[5];
+            vs[0].Set(30.0f, 10.0f);
+            vs[1].Set(20.0f, 0.0f);
+            vs[2].Set(-20.0f, 0.0f);
+            vs[3].Set(-30.0f, 10.0f);
+            vs[4].Set(-40.0f, 10.0f);
+
+            b2ChainShape shape;
+            shape.CreateChain(vs, 5, b2Vec2(40.0f, 10.0f), b2Vec2(-50.0f, 10.0f));
+            ground->CreateFixture(&shape, 0.0f);
+        }
+
+        {
+            b2PolygonShape box;
+            box.SetAsBox(0.5f, 0.5f);
+
+            b2CircleShape circle;
+            circle.m_radius = 0.5f;
+
+            for (std::int32_t i = 0; i < 10; ++i)
+            {
+                b2BodyDef bd;
+                bd.type = b2_dynamicBody;
+                bd.position.Set(-15.0f + 3.0f * i, 1.0f);
+                b2Body* body = m_world->CreateBody(&bd);
+                body->CreateFixture(i % 2 == 0 ? (b2Shape*)&box : (b2Shape*)&circle, 1.0f);
+            }
+        }
+
+        m_count = 0;
+    }
+
+    void Step(Settings& settings) override
+    {
+        Test::Step(settings);
+
+        if (m_count < e_count && m_stepCount % 10 == 0)
+        {
+            float halfLength = RandomFloat(0.2f, 1.0f);
+            float radius = RandomFloat(0.2f, 0.6f);
+
+            b2CapsuleShape shape;
+            shape.Set(b2Vec2(-halfLength, 0.0f), b2Vec2(halfLength, 0.0f), radius);
+
+            b2BodyDef bd;
+            bd.type = b2_dynamicBody;
+            bd.position.Set(RandomFloat(-15.0f, 15.0f), 15.0f);
+            bd.angle = RandomFloat(-b2_pi, b2_pi);
+            b2Body* body = m_world->CreateBody(&bd);
+            body->CreateFixture(&shape, 1.0f);
+
+            ++m_count;
+        }
+    }
+
+    static Test* Create()
+    {
+        return new Capsules;
+    }
+
+    std::int32_t m_count;
+};
+
+static int testIndex = RegisterTest("Geometry", "Capsules", Capsules::Create);
@@ -0,0 +1,130 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "test.h"
+#include <imgui/imgui.h>
+
+// Gears made of many parts. Each gear is either a single compound fixture with one
+// broad-phase proxy or a fixture per part. Compare the proxy and contact counts.
+class CompoundBody : public Test
+{
+public:
+
+    enum
+    {
+        e_teethCount = 12,
+        e_count = 60
+    };
+
+    CompoundBody()
+    {
+        {
+            b2BodyDef bd;
+            b2Body* ground = m_world->CreateBody(&bd);
+
+            b2Vec2 vs[4];
+            vs[0].Set(-30.0f, 20.0f);
+            vs[1].Set(-20.0f, 0.0f);
+            vs[2].Set(20.0f, 0.0f);
+            vs[3].Set(30.0f, 20.0f);
+
+            b2ChainShape shape;
+            shape.CreateChain(vs, 4, b2Vec2(-40.0f, 20.0f), b2Vec2(40.0f, 20.0f));
+            ground->CreateFixture(&shape, 0.0f);
+        }
+
+        m_useCompound = true;
+        m_count = 0;
+    }
+
+    void Spawn()
+    {
+        b2CircleShape hub;
+        hub.m_radius = 0.6f;
+
+        b2PolygonShape teeth[e_teethCount];
+        const b2Shape* parts[e_teethCount + 1];
+        parts[0] = &hub;
+        for (std::int32_t i = 0; i < e_teethCount; ++i)
+        {
+            float angle = 2.0f * b2_pi * i / e_teethCount;
+            b2Vec2 center(0.8f * cosf(angle), 0.8f * sinf(angle));
+            teeth[i].SetAsBox(0.25f, 0.1f, center, angle);
+            parts[i + 1] = teeth + i;
+        }
+
+        b2BodyDef bd;
+        bd.type = b2_dynamicBody;
+        bd.position.Set(RandomFloat(-15.0f, 15.0f), 25.0f);
+        bd.angle = RandomFloat(-b2_pi, b2_pi);
+        b2Body* body = m_world->CreateBody(&bd);
+
+        if (m_useCompound)
+        {
+            b2CompoundShape shape;
+            shape.Create(parts, e_teethCount + 1);
+            body->CreateFixture(&shape, 1.0f);
+        }
+        else
+        {
+            for (std::int32_t i = 0; i < e_teethCount + 1; ++i)
+            {
+                body->CreateFixture(parts[i], 1.0f);
+            }
+        }
+    }
+
+    void UpdateUI() override
+    {
+        ImGui::SetNextWindowPos(ImVec2(10.0f, 100.0f));
+        ImGui::SetNextWindowSize(ImVec2(200.0f, 60.0f));
+        ImGui::Begin("Controls", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
+
+        ImGui::Checkbox("Compound", &m_useCompound);
+
+        ImGui::End();
+    }
+
+    void Step(Settings& settings) override
+    {
+        Test::Step(settings);
+
+        if (m_count < e_count && m_stepCount % 10 == 0)
+        {
+            Spawn();
+            ++m_count;
+        }
+
+        g_debugDraw.DrawString(5, m_textLine, "proxies = %d, contacts = %d", m_world->GetProxyCount(), m_world->GetContactCount());
+        m_textLine += m_textIncrement;
+    }
+
+    static Test* Create()
+    {
+        return new CompoundBody;
+    }
+
+    bool m_useCompound;
+    std::int32_t m_count;
+};
+
+static int testIndex = RegisterTest("Geometry", "Compound Body", CompoundBody::Create);
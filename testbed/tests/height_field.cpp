@@ -0,0 +1,98 @@
+// MIT License
+
+// Copyright (c) 2019 Erin Catto
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "test.h"
+
+// A large height field terrain. The terrain uses a single broad-phase proxy and
+// contacts are only created for the columns under each body.
+class HeightField : public Test
+{
+public:
+
+    enum
+    {
+        e_sampleCount = 2001,
+        e_count = 200
+    };
+
+    HeightField()
+    {
+        {
+            float heights[e_sampleCount];
+            for (std::int32_t i = 0; i < e_sampleCount; ++i)
+            {
+                float x = 0.25f * i;
+                heights[i] = 2.0f * sinf(0.1f * x) + 0.5f * sinf(0.7f * x);
+            }
+
+            b2HeightFieldShape shape;
+            shape.Create(heights, e_sampleCount, 0.25f);
+
+            b2BodyDef bd;
+            bd.position.Set(-250.0f, 0.0f);
+            b2Body* ground = m_world->CreateBody(&bd);
+            ground->CreateFixture(&shape, 0.0f);
+        }
+
+        m_count = 0;
+    }
+
+    void Step(Settings& settings) override
+    {
+        Test::Step(settings);
+
+        if (m_count < e_count && m_stepCount % 5 == 0)
+        {
+            b2BodyDef bd;
+            bd.type = b2_dynamicBody;
+            bd.position.Set(RandomFloat(-40.0f, 40.0f), 20.0f);
+            b2Body* body = m_world->CreateBody(&bd);
+
+            if (m_count % 2 == 0)
+            {
+                b2PolygonShape shape;
+                shape.SetAsBox(0.5f, 0.5f);
+                body->CreateFixture(&shape, 1.0f);
+            }
+            else
+            {
+                b2CircleShape shape;
+                shape.m_radius = 0.5f;
+                body->CreateFixture(&shape, 1.0f);
+            }
+
+            ++m_count;
+        }
+
+        g_debugDraw.DrawString(5, m_textLine, "proxies = %d, contacts = %d", m_world->GetProxyCount(), m_world->GetContactCount());
+        m_textLine += m_textIncrement;
+    }
+
+    static Test* Create()
+    {
+        return new HeightField;
+    }
+
+    std::int32_t m_count;
+};
+
+static int testIndex = RegisterTest("Geometry", "Height Field", HeightField::Create);
@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include <box2d/box2d.h>
+#include <box2d/b2_dynamic_tree.h>
+#include <box2d/b2_hash_set.h>
 #include <doctest/doctest.h>
 #include <cstdio>
 
@@ -79,3 +81,665 @@ TEST_CASE("collision test")
         CHECK(b2Abs(massData2.I - inertia) < 40.0f * (absTol + relTol * inertia));
     }
 }
+
+static b2PairKey MakeKey(std::int32_t proxyIdA, std::int32_t proxyIdB)
+{
+    return b2MakePairKey(b2ChildId(proxyIdA, 0), b2ChildId(proxyIdB, 0));
+}
+
+TEST_CASE("pair set")
+{
+    b2HashSet set;
+
+    // Enough pairs to grow the table and create long probe chains.
+    const std::int32_t count = 1000;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        CHECK(set.Add(MakeKey(i, i + 1)) == false);
+    }
+
+    CHECK(set.GetCount() == count);
+    CHECK(set.Add(MakeKey(11, 10)) == true);
+    CHECK(set.Contains(MakeKey(1, 0)));
+
+    for (std::int32_t i = 0; i < count; i += 2)
+    {
+        CHECK(set.Remove(MakeKey(i + 1, i)));
+    }
+
+    CHECK(set.GetCount() == count / 2);
+    CHECK(set.Remove(MakeKey(0, 1)) == false);
+
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        CHECK(set.Contains(MakeKey(i, i + 1)) == (i % 2 == 1));
+    }
+
+    // Children of the same proxy pair are distinct.
+    b2PairKey key1 = b2MakePairKey(b2ChildId(3, 7), b2ChildId(5, 0));
+    b2PairKey key2 = b2MakePairKey(b2ChildId(5, 0), b2ChildId(3, 8));
+    CHECK(set.Add(key1) == false);
+    CHECK(set.Contains(key2) == false);
+    CHECK(set.Contains(b2MakePairKey(b2ChildId(5, 0), b2ChildId(3, 7))));
+
+    set.Clear();
+    CHECK(set.GetCount() == 0);
+    CHECK(set.Contains(MakeKey(1, 2)) == false);
+}
+
+TEST_CASE("adaptive margin")
+{
+    b2DynamicTree tree;
+
+    b2AABB aabb;
+    aabb.lowerBound.Set(-0.5f, -0.5f);
+    aabb.upperBound.Set(0.5f, 0.5f);
+
+    // A new proxy uses the classic margin.
+    std::int32_t proxyId = tree.CreateProxy(aabb, nullptr);
+    CHECK(tree.GetMargin(proxyId) == b2_aabbExtension);
+    CHECK(tree.GetFatAABB(proxyId).lowerBound.x == -0.5f - b2_aabbExtension);
+
+    // A resting proxy thins out once it is re-inserted.
+    for (std::int32_t i = 0; i < 20; ++i)
+    {
+        tree.MoveProxy(proxyId, aabb, b2Vec2_zero);
+    }
+
+    CHECK(tree.GetMargin(proxyId) == b2_aabbMinExtension);
+
+    aabb.lowerBound.x += 0.2f;
+    aabb.upperBound.x += 0.2f;
+    CHECK(tree.MoveProxy(proxyId, aabb, b2Vec2_zero));
+    CHECK(tree.GetFatAABB(proxyId).upperBound.y == 0.5f + b2_aabbMinExtension);
+
+    // A fast proxy is re-inserted once its predicted motion runs out, not every move.
+    const b2Vec2 displacement(0.8f, 0.0f);
+    std::int32_t reinsertionCount = 0;
+    for (std::int32_t i = 0; i < 100; ++i)
+    {
+        aabb.lowerBound += displacement;
+        aabb.upperBound += displacement;
+        if (tree.MoveProxy(proxyId, aabb, displacement))
+        {
+            ++reinsertionCount;
+        }
+
+        CHECK(tree.GetFatAABB(proxyId).Contains(aabb));
+    }
+
+    CHECK(reinsertionCount <= 25);
+    CHECK(tree.GetMargin(proxyId) == b2_aabbExtension);
+
+    tree.Validate();
+    tree.DestroyProxy(proxyId);
+}
+
+// Counts the proxies reported by a tree query.
+struct TreeQueryCounter
+{
+    bool QueryCallback(std::int32_t proxyId)
+    {
+        (void)proxyId;
+        ++count;
+        return true;
+    }
+
+    std::int32_t count = 0;
+};
+
+TEST_CASE("tree optimizer")
+{
+    b2DynamicTree tree;
+
+    // Pseudo random boxes, then remove most of them to leave a sparse tree.
+    const std::int32_t count = 2000;
+    std::int32_t proxyIds[count];
+    b2AABB aabbs[count];
+    std::uint32_t seed = 1;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        seed = 1664525u * seed + 1013904223u;
+        float x = float(seed >> 20);
+        seed = 1664525u * seed + 1013904223u;
+        float y = float(seed >> 20);
+        aabbs[i].lowerBound.Set(0.1f * x, 0.1f * y);
+        aabbs[i].upperBound = aabbs[i].lowerBound + b2Vec2(1.0f, 1.0f);
+        proxyIds[i] = tree.CreateProxy(aabbs[i], nullptr);
+    }
+
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        if (i % 4 != 0)
+        {
+            tree.DestroyProxy(proxyIds[i]);
+            proxyIds[i] = b2_nullNode;
+        }
+    }
+
+    float areaRatio = tree.GetAreaRatio();
+
+    std::int32_t rotationCount = 0;
+    for (std::int32_t i = 0; i < 100; ++i)
+    {
+        rotationCount += tree.Optimize(64);
+        tree.Validate();
+    }
+
+    CHECK(rotationCount > 0);
+    CHECK(tree.GetAreaRatio() < areaRatio);
+
+    // Queries find the same proxies as a brute force search.
+    for (std::int32_t i = 0; i < count; i += 7)
+    {
+        b2AABB query;
+        query.lowerBound = aabbs[i].lowerBound - b2Vec2(10.0f, 10.0f);
+        query.upperBound = aabbs[i].upperBound + b2Vec2(10.0f, 10.0f);
+
+        std::int32_t expected = 0;
+        for (std::int32_t j = 0; j < count; ++j)
+        {
+            if (proxyIds[j] != b2_nullNode && b2TestOverlap(query, tree.GetFatAABB(proxyIds[j])))
+            {
+                ++expected;
+            }
+        }
+
+        TreeQueryCounter counter;
+        tree.Query(&counter, query);
+        CHECK(counter.count == expected);
+    }
+}
+
+TEST_CASE("polygon manifold")
+{
+    b2PolygonShape ground;
+    ground.SetAsBox(1.0f, 0.5f);
+    b2Transform xfGround;
+    xfGround.SetIdentity();
+
+    SUBCASE("box on box")
+    {
+        b2PolygonShape box;
+        box.SetAsBox(0.25f, 0.25f);
+        b2Transform xfBox(b2Vec2(0.0f, 0.74f), b2Rot(0.0f));
+
+        b2Manifold manifold;
+        b2CollidePolygons(&manifold, &ground, xfGround, &box, xfBox);
+
+        // The top face of the ground is the reference face.
+        CHECK(manifold.pointCount == 2);
+        CHECK(manifold.type == b2Manifold::e_faceA);
+        CHECK(manifold.localNormal == b2Vec2(0.0f, 1.0f));
+        CHECK(manifold.points[0].id.cf.indexA == 2);
+        CHECK(manifold.points[1].id.cf.indexA == 2);
+
+        // Separated by more than the polygon radius.
+        xfBox.p.y = 0.8f;
+        b2CollidePolygons(&manifold, &ground, xfGround, &box, xfBox);
+        CHECK(manifold.pointCount == 0);
+    }
+
+    SUBCASE("octagon on box")
+    {
+        // Eight vertices fill both SIMD blocks. The flat bottom edge has index 1.
+        b2Vec2 points[8];
+        for (std::int32_t i = 0; i < 8; ++i)
+        {
+            float angle = (i + 0.5f) * 0.25f * b2_pi - 0.5f * b2_pi;
+            points[i].Set(0.5f * cosf(angle), 0.5f * sinf(angle));
+        }
+
+        b2PolygonShape octagon;
+        octagon.Set(points, 8);
+        float apothem = 0.5f * cosf(0.125f * b2_pi);
+        b2Transform xfOctagon(b2Vec2(0.1f, 0.5f + apothem - 0.005f), b2Rot(0.0f));
+
+        b2Manifold manifold;
+        b2CollidePolygons(&manifold, &octagon, xfOctagon, &ground, xfGround);
+
+        CHECK(manifold.pointCount == 2);
+        CHECK(manifold.type == b2Manifold::e_faceA);
+        CHECK(b2Abs(manifold.localNormal.x) < 1.0e-6f);
+        CHECK(b2Abs(manifold.localNormal.y + 1.0f) < 1.0e-6f);
+    }
+}
+
+TEST_CASE("capsule")
+{
+    b2CapsuleShape capsule;
+    capsule.Set(b2Vec2(-1.0f, 0.0f), b2Vec2(1.0f, 0.0f), 0.5f);
+
+    SUBCASE("mass data")
+    {
+        b2MassData massData;
+        capsule.ComputeMass(&massData, 1.0f);
+
+        // Integrate over a grid of cells.
+        const std::int32_t n = 600;
+        const float h = 3.0f / n;
+        float mass = 0.0f, inertia = 0.0f;
+        b2Transform xf;
+        xf.SetIdentity();
+        for (std::int32_t i = 0; i < n; ++i)
+        {
+            for (std::int32_t j = 0; j < n; ++j)
+            {
+                b2Vec2 p(-1.5f + (i + 0.5f) * h, -1.5f + (j + 0.5f) * h);
+                if (capsule.TestPoint(xf, p))
+                {
+                    mass += h * h;
+                    inertia += h * h * b2Dot(p, p);
+                }
+            }
+        }
+
+        CHECK(b2Abs(massData.mass - mass) < 0.01f * mass);
+        CHECK(b2Abs(massData.I - inertia) < 0.01f * inertia);
+        CHECK(massData.center.Length() < FLT_EPSILON);
+    }
+
+    SUBCASE("capsule on box")
+    {
+        b2PolygonShape box;
+        box.SetAsBox(2.0f, 0.5f);
+
+        b2Transform xfA(b2Vec2(0.3f, 0.99f), b2Rot(0.0f));
+        b2Transform xfB(b2Vec2(0.0f, 0.0f), b2Rot(0.0f));
+
+        b2Manifold manifold;
+        b2CollideCapsuleAndPolygon(&manifold, &capsule, xfA, &box, xfB);
+        REQUIRE(manifold.pointCount == 2);
+
+        b2WorldManifold worldManifold;
+        worldManifold.Initialize(&manifold, xfA, capsule.m_radius, xfB, box.m_radius);
+        CHECK(b2Abs(worldManifold.normal.y + 1.0f) < 0.001f);
+        for (std::int32_t i = 0; i < 2; ++i)
+        {
+            CHECK(b2Abs(worldManifold.separations[i] + 0.01f + box.m_radius) < 0.001f);
+        }
+
+        // Near the rounded end over the box corner the separating axes underestimate the distance.
+        b2Transform xfC(b2Vec2(3.45f, 0.95f), b2Rot(0.0f));
+        b2CollideCapsuleAndPolygon(&manifold, &capsule, xfC, &box, xfB);
+        CHECK(manifold.pointCount == 0);
+
+        b2Transform xfD(b2Vec2(3.2f, 0.8f), b2Rot(0.0f));
+        b2CollideCapsuleAndPolygon(&manifold, &capsule, xfD, &box, xfB);
+        REQUIRE(manifold.pointCount == 1);
+        worldManifold.Initialize(&manifold, xfD, capsule.m_radius, xfB, box.m_radius);
+        float distance = b2Distance(b2Vec2(2.2f, 0.8f), b2Vec2(2.0f, 0.5f));
+        CHECK(b2Abs(worldManifold.separations[0] - (distance - capsule.m_radius - box.m_radius)) < 0.001f);
+    }
+
+    SUBCASE("capsule on capsule")
+    {
+        b2Transform xfA(b2Vec2(0.0f, 0.0f), b2Rot(0.0f));
+        b2Transform xfB(b2Vec2(0.5f, 0.95f), b2Rot(0.0f));
+
+        b2Manifold manifold;
+        b2CollideCapsules(&manifold, &capsule, xfA, &capsule, xfB);
+        REQUIRE(manifold.pointCount == 2);
+
+        b2WorldManifold worldManifold;
+        worldManifold.Initialize(&manifold, xfA, capsule.m_radius, xfB, capsule.m_radius);
+        CHECK(b2Abs(worldManifold.normal.y - 1.0f) < 0.001f);
+        CHECK(b2Abs(worldManifold.separations[0] + 0.05f) < 0.001f);
+        CHECK(b2Abs(worldManifold.separations[1] + 0.05f) < 0.001f);
+
+        // Crossed capsules touch at a single point.
+        b2Transform xfC(b2Vec2(0.0f, 1.95f), b2Rot(0.5f * b2_pi));
+        b2CollideCapsules(&manifold, &capsule, xfA, &capsule, xfC);
+        CHECK(manifold.pointCount == 1);
+
+        // End to end
+        b2Transform xfD(b2Vec2(2.9f, 0.0f), b2Rot(0.0f));
+        b2CollideCapsules(&manifold, &capsule, xfA, &capsule, xfD);
+        REQUIRE(manifold.pointCount == 1);
+        worldManifold.Initialize(&manifold, xfA, capsule.m_radius, xfD, capsule.m_radius);
+        CHECK(b2Abs(worldManifold.normal.x - 1.0f) < 0.001f);
+        CHECK(b2Abs(worldManifold.separations[0] + 0.1f) < 0.001f);
+    }
+
+    SUBCASE("capsule and circle")
+    {
+        b2CircleShape circle;
+        circle.m_radius = 0.25f;
+
+        b2Transform xfA(b2Vec2(0.0f, 0.0f), b2Rot(0.0f));
+        b2Transform xfB(b2Vec2(1.3f, -0.6f), b2Rot(0.0f));
+
+        b2Manifold manifold;
+        b2CollideCapsuleAndCircle(&manifold, &capsule, xfA, &circle, xfB);
+        REQUIRE(manifold.pointCount == 1);
+
+        b2WorldManifold worldManifold;
+        worldManifold.Initialize(&manifold, xfA, capsule.m_radius, xfB, circle.m_radius);
+        float distance = b2Distance(b2Vec2(1.0f, 0.0f), b2Vec2(1.3f, -0.6f));
+        CHECK(b2Abs(worldManifold.separations[0] - (distance - 0.75f)) < 0.001f);
+
+        b2Transform xfC(b2Vec2(0.0f, -0.8f), b2Rot(0.0f));
+        b2CollideCapsuleAndCircle(&manifold, &capsule, xfA, &circle, xfC);
+        CHECK(manifold.pointCount == 0);
+    }
+
+    SUBCASE("ray cast")
+    {
+        b2Transform xf(b2Vec2(1.0f, 2.0f), b2Rot(0.5f * b2_pi));
+
+        b2RayCastInput input;
+        input.p1.Set(-2.0f, 2.5f);
+        input.p2.Set(2.0f, 2.5f);
+        input.maxFraction = 1.0f;
+
+        b2RayCastOutput output;
+        REQUIRE(capsule.RayCast(&output, input, xf, 0));
+        CHECK(b2Abs(output.fraction - 0.625f) < 0.001f);
+        CHECK(b2Abs(output.normal.x + 1.0f) < 0.001f);
+
+        // Hit the rounded end.
+        input.p1.Set(1.0f, 5.0f);
+        input.p2.Set(1.0f, 0.0f);
+        REQUIRE(capsule.RayCast(&output, input, xf, 0));
+        CHECK(b2Abs(output.fraction - 0.3f) < 0.001f);
+        CHECK(b2Abs(output.normal.y - 1.0f) < 0.001f);
+    }
+}
+
+TEST_CASE("rounded polygon")
+{
+    b2PolygonShape box;
+    box.SetAsRoundedBox(0.5f, 0.5f, 0.25f);
+    CHECK(box.m_radius == 0.25f);
+
+    b2Transform identity;
+    identity.SetIdentity();
+
+    SUBCASE("mass data")
+    {
+        b2PolygonShape hexagon;
+        b2Vec2 points[6];
+        for (std::int32_t i = 0; i < 6; ++i)
+        {
+            float angle = b2_pi * i / 3.0f;
+            points[i].Set(1.0f + 0.6f * cosf(angle), 0.5f + 0.4f * sinf(angle));
+        }
+        hexagon.Set(points, 6);
+        hexagon.m_radius = 0.3f;
+
+        b2MassData massData;
+        hexagon.ComputeMass(&massData, 1.0f);
+
+        // Integrate over a grid of cells.
+        const std::int32_t n = 600;
+        const float h = 2.4f / n;
+        float mass = 0.0f, inertia = 0.0f;
+        b2Vec2 center(0.0f, 0.0f);
+        for (std::int32_t i = 0; i < n; ++i)
+        {
+            for (std::int32_t j = 0; j < n; ++j)
+            {
+                b2Vec2 p(-0.2f + (i + 0.5f) * h, -0.7f + (j + 0.5f) * h);
+                if (hexagon.TestPoint(identity, p))
+                {
+                    mass += h * h;
+                    center += h * h * p;
+                    inertia += h * h * b2Dot(p, p);
+                }
+            }
+        }
+        center *= 1.0f / mass;
+
+        CHECK(b2Abs(massData.mass - mass) < 0.005f * mass);
+        CHECK(b2Distance(massData.center, center) < 0.005f);
+        CHECK(b2Abs(massData.I - inertia) < 0.005f * inertia);
+    }
+
+    SUBCASE("manifolds")
+    {
+        // Stacked boxes touch along the face.
+        b2Transform xfB(b2Vec2(0.2f, 1.45f), b2Rot(0.0f));
+        b2Manifold manifold;
+        b2CollidePolygons(&manifold, &box, identity, &box, xfB);
+        REQUIRE(manifold.pointCount == 2);
+
+        b2WorldManifold worldManifold;
+        worldManifold.Initialize(&manifold, identity, box.m_radius, xfB, box.m_radius);
+        CHECK(b2Abs(worldManifold.normal.y - 1.0f) < 0.001f);
+        CHECK(b2Abs(worldManifold.separations[0] + 0.05f) < 0.001f);
+        CHECK(b2Abs(worldManifold.separations[1] + 0.05f) < 0.001f);
+
+        // Diagonal neighbors within the square corners but outside the rounded corners.
+        b2Transform xfC(b2Vec2(1.4f, 1.4f), b2Rot(0.0f));
+        b2CollidePolygons(&manifold, &box, identity, &box, xfC);
+        CHECK(manifold.pointCount == 0);
+
+        // Touching rounded corners use the direction between the corners.
+        b2Transform xfD(b2Vec2(1.3f, 1.3f), b2Rot(0.0f));
+        b2CollidePolygons(&manifold, &box, identity, &box, xfD);
+        REQUIRE(manifold.pointCount == 1);
+        worldManifold.Initialize(&manifold, identity, box.m_radius, xfD, box.m_radius);
+        float distance = b2Distance(b2Vec2(0.5f, 0.5f), b2Vec2(0.8f, 0.8f));
+        CHECK(b2Abs(worldManifold.separations[0] - (distance - 0.5f)) < 0.001f);
+        CHECK(b2Abs(worldManifold.normal.x - worldManifold.normal.y) < 0.001f);
+
+        // Circles see the rounded corners too.
+        b2CircleShape circle;
+        circle.m_radius = 0.25f;
+        b2Transform xfE(b2Vec2(0.9f, 0.9f), b2Rot(0.0f));
+        b2CollidePolygonAndCircle(&manifold, &box, identity, &circle, xfE);
+        CHECK(manifold.pointCount == 0);
+
+        b2Transform xfF(b2Vec2(0.8f, 0.8f), b2Rot(0.0f));
+        b2CollidePolygonAndCircle(&manifold, &box, identity, &circle, xfF);
+        REQUIRE(manifold.pointCount == 1);
+        worldManifold.Initialize(&manifold, identity, box.m_radius, xfF, circle.m_radius);
+        distance = b2Distance(b2Vec2(0.5f, 0.5f), b2Vec2(0.8f, 0.8f));
+        CHECK(b2Abs(worldManifold.separations[0] - (distance - 0.5f)) < 0.001f);
+    }
+
+    SUBCASE("ray cast")
+    {
+        b2RayCastInput input;
+        input.p1.Set(-2.0f, 0.0f);
+        input.p2.Set(2.0f, 0.0f);
+        input.maxFraction = 1.0f;
+
+        b2RayCastOutput output;
+        REQUIRE(box.RayCast(&output, input, identity, 0));
+        CHECK(b2Abs(output.fraction - 1.25f / 4.0f) < 0.001f);
+        CHECK(b2Abs(output.normal.x + 1.0f) < 0.001f);
+
+        // Along the diagonal the ray hits the rounded corner.
+        input.p1.Set(2.0f, 2.0f);
+        input.p2.Set(0.0f, 0.0f);
+        REQUIRE(box.RayCast(&output, input, identity, 0));
+        float expected = (1.5f * sqrtf(2.0f) - 0.25f) / (2.0f * sqrtf(2.0f));
+        CHECK(b2Abs(output.fraction - expected) < 0.001f);
+        CHECK(b2Abs(output.normal.x - output.normal.y) < 0.001f);
+    }
+}
+
+TEST_CASE("tree refit")
+{
+    b2DynamicTree tree;
+
+    const std::int32_t count = 1000;
+    std::int32_t proxyIds[count];
+    b2AABB aabbs[count];
+    std::uint32_t seed = 7;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        seed = 1664525u * seed + 1013904223u;
+        float x = float(seed >> 22);
+        seed = 1664525u * seed + 1013904223u;
+        float y = float(seed >> 22);
+        aabbs[i].lowerBound.Set(0.1f * x, 0.1f * y);
+        aabbs[i].upperBound = aabbs[i].lowerBound + b2Vec2(0.5f, 0.5f);
+        proxyIds[i] = tree.CreateProxy(aabbs[i], nullptr);
+    }
+
+    tree.SetRefit(true);
+    CHECK(tree.GetRefit());
+
+    // Move every proxy each step. Leaves update in place and the tree is refit.
+    for (std::int32_t step = 0; step < 50; ++step)
+    {
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            b2Vec2 d(0.05f * ((i + step) % 5 - 2), 0.04f * ((i * 3 + step) % 5 - 2));
+            aabbs[i].lowerBound += d;
+            aabbs[i].upperBound += d;
+            tree.MoveProxy(proxyIds[i], aabbs[i], d);
+            CHECK(tree.GetFatAABB(proxyIds[i]).Contains(aabbs[i]));
+        }
+
+        tree.Refit();
+        tree.Validate();
+    }
+
+    // Queries find the same proxies as a brute force search.
+    for (std::int32_t i = 0; i < count; i += 11)
+    {
+        b2AABB query;
+        query.lowerBound = aabbs[i].lowerBound - b2Vec2(3.0f, 3.0f);
+        query.upperBound = aabbs[i].upperBound + b2Vec2(3.0f, 3.0f);
+
+        std::int32_t expected = 0;
+        for (std::int32_t j = 0; j < count; ++j)
+        {
+            if (b2TestOverlap(query, tree.GetFatAABB(proxyIds[j])))
+            {
+                ++expected;
+            }
+        }
+
+        TreeQueryCounter counter;
+        tree.Query(&counter, query);
+        CHECK(counter.count == expected);
+    }
+
+    // The bulk builder keeps the proxies.
+    tree.Rebuild();
+    tree.Validate();
+    CHECK(tree.GetAreaRatio() > 0.0f);
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        CHECK(tree.GetFatAABB(proxyIds[i]).Contains(aabbs[i]));
+    }
+
+    tree.SetRefit(false);
+    tree.DestroyProxy(proxyIds[0]);
+    tree.Validate();
+}
+
+struct QuantizedTreeCollector
+{
+    bool QueryCallback(std::int32_t leafId)
+    {
+        found[tree->GetProxyId(leafId)] = true;
+        ++count;
+        return true;
+    }
+
+    float RayCastCallback(const b2RayCastInput& input, std::int32_t leafId)
+    {
+        found[tree->GetProxyId(leafId)] = true;
+        ++count;
+        return input.maxFraction;
+    }
+
+    const b2QuantizedTree* tree;
+    bool found[2048] = {};
+    std::int32_t count = 0;
+};
+
+TEST_CASE("quantized tree")
+{
+    b2DynamicTree tree;
+    b2QuantizedTree quantizedTree;
+
+    quantizedTree.Build(tree);
+    CHECK(quantizedTree.GetLeafCount() == 0);
+
+    const std::int32_t count = 1000;
+    std::int32_t proxyIds[count];
+    b2AABB aabbs[count];
+    std::uint32_t seed = 11;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        seed = 1664525u * seed + 1013904223u;
+        float x = float(seed >> 22);
+        seed = 1664525u * seed + 1013904223u;
+        float y = float(seed >> 22);
+        aabbs[i].lowerBound.Set(0.1f * x - 50.0f, 0.1f * y + 1000.0f);
+        aabbs[i].upperBound = aabbs[i].lowerBound + b2Vec2(0.1f + 0.001f * i, 0.3f);
+        proxyIds[i] = tree.CreateProxy(aabbs[i], aabbs + i);
+    }
+
+    tree.Rebuild();
+    quantizedTree.Build(tree);
+    CHECK(quantizedTree.GetLeafCount() == count);
+
+    // A tree with n leaves has 2n - 1 nodes. The quantized tree takes about 42 percent.
+    float byteRatio = float(quantizedTree.GetByteCount()) / float((2 * count - 1) * sizeof(b2TreeNode));
+    CHECK(byteRatio < 0.43f);
+
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        std::int32_t proxyId = quantizedTree.GetProxyId(i);
+        CHECK(quantizedTree.GetUserData(i) == tree.GetUserData(proxyId));
+    }
+
+    // Queries find at least the proxies that overlap, and almost no others.
+    for (std::int32_t i = 0; i < count; i += 7)
+    {
+        b2AABB query;
+        query.lowerBound = aabbs[i].lowerBound - b2Vec2(1.0f, 1.0f);
+        query.upperBound = aabbs[i].upperBound + b2Vec2(1.0f, 1.0f);
+
+        QuantizedTreeCollector collector;
+        collector.tree = &quantizedTree;
+        quantizedTree.Query(&collector, query);
+
+        std::int32_t expected = 0;
+        for (std::int32_t j = 0; j < count; ++j)
+        {
+            if (b2TestOverlap(query, tree.GetFatAABB(proxyIds[j])))
+            {
+                CHECK(collector.found[proxyIds[j]]);
+                ++expected;
+            }
+        }
+
+        CHECK(collector.count <= expected + 2);
+    }
+
+    // Ray casts hit at least the proxies of the dynamic tree.
+    for (std::int32_t i = 0; i < count; i += 37)
+    {
+        b2RayCastInput input;
+        input.p1 = aabbs[i].GetCenter() - b2Vec2(20.0f, 3.0f);
+        input.p2 = aabbs[i].GetCenter() + b2Vec2(20.0f, 3.0f);
+        input.maxFraction = 1.0f;
+
+        QuantizedTreeCollector collector;
+        collector.tree = &quantizedTree;
+        quantizedTree.RayCast(&collector, input);
+        CHECK(collector.found[proxyIds[i]]);
+    }
+
+    // A single proxy
+    b2DynamicTree smallTree;
+    smallTree.CreateProxy(aabbs[0], nullptr);
+    quantizedTree.Build(smallTree);
+    CHECK(quantizedTree.GetLeafCount() == 1);
+
+    QuantizedTreeCollector collector;
+    collector.tree = &quantizedTree;
+    quantizedTree.Query(&collector, aabbs[0]);
+    CHECK(collector.count == 1);
+
+    quantizedTree.Clear();
+    CHECK(quantizedTree.GetLeafCount() == 0);
+}
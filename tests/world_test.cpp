@@ -21,8 +21,15 @@
 // SOFTWARE.
 
 #include <box2d/box2d.h>
+#include <box2d/b2_shared_block_allocator.h>
+#include <box2d/b2_stack_allocator.h>
 #include <doctest/doctest.h>
 #include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 static bool begin_contact = false;
 
@@ -71,3 +78,1912 @@ TEST_CASE("begin contact")
     CHECK(world.GetContactList() != nullptr);
     CHECK(begin_contact == true);
 }
+
+TEST_CASE("body storage")
+{
+    b2World world(b2Vec2(0.0f, 0.0f));
+
+    b2CircleShape circle;
+    circle.m_radius = 0.5f;
+
+    // Create enough bodies to relocate the body state several times.
+    const std::int32_t count = 100;
+    b2Body* bodies[count];
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(2.0f * i, 0.0f);
+        bodyDef.linearVelocity.Set(0.0f, 0.01f * i);
+        bodies[i] = world.CreateBody(&bodyDef);
+        bodies[i]->CreateFixture(&circle, 1.0f);
+    }
+
+    // Destroying bodies moves the state of other bodies.
+    for (std::int32_t i = 0; i < count; i += 2)
+    {
+        world.DestroyBody(bodies[i]);
+        bodies[i] = nullptr;
+    }
+
+    CHECK(world.GetBodyCount() == count / 2);
+
+    for (std::int32_t i = 1; i < count; i += 2)
+    {
+        CHECK(bodies[i]->GetPosition() == b2Vec2(2.0f * i, 0.0f));
+        CHECK(bodies[i]->GetLinearVelocity() == b2Vec2(0.0f, 0.01f * i));
+    }
+
+    world.Step(1.0f, 1, 1);
+
+    for (std::int32_t i = 1; i < count; i += 2)
+    {
+        CHECK(bodies[i]->GetPosition().x == 2.0f * i);
+        CHECK(bodies[i]->GetPosition().y == 0.01f * i);
+    }
+}
+
+TEST_CASE("contact storage")
+{
+    b2World world(b2Vec2(0.0f, 0.0f));
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+
+    // Overlapping boxes in a row so that each body touches its neighbors.
+    const std::int32_t count = 40;
+    b2Body* bodies[count];
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(0.9f * i, 0.0f);
+        bodies[i] = world.CreateBody(&bodyDef);
+        bodies[i]->CreateFixture(&box, 1.0f);
+    }
+
+    world.Step(1.0f / 60.0f, 8, 3);
+    CHECK(world.GetContactCount() == count - 1);
+
+    // Destroying bodies removes contacts from the middle of the contact array.
+    for (std::int32_t i = 1; i < count; i += 3)
+    {
+        world.DestroyBody(bodies[i]);
+        bodies[i] = nullptr;
+    }
+
+    world.Step(1.0f / 60.0f, 8, 3);
+
+    std::int32_t listCount = 0;
+    for (b2Contact* c = world.GetContactList(); c; c = c->GetNext())
+    {
+        CHECK(c->IsTouching());
+        ++listCount;
+    }
+
+    CHECK(listCount == world.GetContactCount());
+    CHECK(listCount == 13);
+}
+
+// Compares every reused manifold with a fresh evaluation at the same transforms. A
+// manifold is reused by the contact that the reuse count went up for.
+class ManifoldReuseListener : public b2ContactListener
+{
+public:
+    void PreSolve(b2Contact* contact, const b2Manifold*) override
+    {
+        std::int32_t count = world->GetManifoldReuseCount();
+        if (count == reuseCount)
+        {
+            return;
+        }
+
+        reuseCount = count;
+        ++checkCount;
+
+        const b2Manifold* cached = contact->GetManifold();
+        b2Manifold fresh;
+        contact->Evaluate(&fresh, contact->GetFixtureA()->GetBody()->GetTransform(),
+            contact->GetFixtureB()->GetBody()->GetTransform());
+
+        CHECK(fresh.type == cached->type);
+        CHECK(fresh.pointCount == cached->pointCount);
+        CHECK(b2Dot(fresh.localNormal, cached->localNormal) > 0.999f);
+        CHECK(b2Distance(fresh.localPoint, cached->localPoint) < 10.0f * b2_manifoldReuseLinearTolerance);
+        for (std::int32_t i = 0; i < b2Min(fresh.pointCount, cached->pointCount); ++i)
+        {
+            CHECK(fresh.points[i].id.key == cached->points[i].id.key);
+            CHECK(b2Distance(fresh.points[i].localPoint, cached->points[i].localPoint) <
+                10.0f * b2_manifoldReuseLinearTolerance);
+        }
+    }
+
+    b2World* world = nullptr;
+    std::int32_t reuseCount = 0;
+    std::int32_t checkCount = 0;
+};
+
+TEST_CASE("manifold reuse")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+    world.SetManifoldReuse(true);
+    ManifoldReuseListener listener;
+    listener.world = &world;
+    world.SetContactListener(&listener);
+    world.SetAllowSleeping(false);
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-20.0f, 0.0f), b2Vec2(20.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+
+    b2Body* top = nullptr;
+    for (std::int32_t i = 0; i < 5; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(0.0f, 0.5f + 1.0f * i);
+        top = world.CreateBody(&bodyDef);
+        top->CreateFixture(&box, 1.0f);
+    }
+
+    // The manifold is evaluated when the contacts begin.
+    world.Step(1.0f / 60.0f, 8, 3);
+    CHECK(world.GetManifoldUpdateCount() == 5);
+    CHECK(world.GetManifoldReuseCount() == 0);
+
+    std::int32_t reuseCount = 0;
+    for (std::int32_t i = 0; i < 300; ++i)
+    {
+        listener.reuseCount = 0;
+        world.Step(1.0f / 60.0f, 8, 3);
+        reuseCount += world.GetManifoldReuseCount();
+    }
+
+    // A settled stack reuses most manifolds and stays upright. The reused manifolds
+    // match a fresh evaluation.
+    CHECK(reuseCount > 0);
+    CHECK(listener.checkCount == reuseCount);
+    CHECK(world.GetManifoldReuseCount() + world.GetManifoldUpdateCount() == 5);
+    CHECK(b2Abs(top->GetPosition().x) < 0.01f);
+    CHECK(b2Abs(top->GetPosition().y - 4.5f) < 0.1f);
+
+    // Disturbing the stack forces the narrow-phase.
+    top->SetLinearVelocity(b2Vec2(1.0f, 0.0f));
+    world.Step(1.0f / 60.0f, 8, 3);
+    world.Step(1.0f / 60.0f, 8, 3);
+    CHECK(world.GetManifoldUpdateCount() > 0);
+}
+
+TEST_CASE("tree refit with optimizer")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+    world.SetTreeRefit(true);
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-60.0f, 0.0f), b2Vec2(60.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2CircleShape circle;
+    circle.m_radius = 0.4f;
+    for (std::int32_t i = 0; i < 2000; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(-40.0f + 0.9f * (i % 90) + 0.3f * (i / 90 % 2), 1.0f + 0.9f * (i / 90));
+        b2Body* body = world.CreateBody(&bodyDef);
+        body->CreateFixture(&circle, 1.0f);
+    }
+
+    // The default optimizer budget rotates the tree every step. The bounds must stay
+    // tight after each step.
+    const b2BroadPhase& broadPhase = world.GetContactManager().m_broadPhase;
+    for (std::int32_t i = 0; i < 60; ++i)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+        broadPhase.ValidateTree();
+    }
+
+    CHECK(broadPhase.GetTreeRefit());
+}
+
+TEST_CASE("world clear")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    // Build the same scene twice, clearing in between.
+    std::int32_t chunkCount = 0;
+    for (std::int32_t pass = 0; pass < 2; ++pass)
+    {
+        b2BodyDef groundDef;
+        b2Body* ground = world.CreateBody(&groundDef);
+
+        // A long chain has a proxy array beyond the block sizes.
+        b2Vec2 vertices[200];
+        for (std::int32_t i = 0; i < 200; ++i)
+        {
+            vertices[i].Set(-50.0f + 0.5f * i, 0.0f);
+        }
+        b2ChainShape chain;
+        chain.CreateChain(vertices, 200, vertices[0], vertices[199]);
+        ground->CreateFixture(&chain, 0.0f);
+
+        b2PolygonShape box;
+        box.SetAsBox(0.5f, 0.5f);
+
+        b2Body* prev = ground;
+        for (std::int32_t i = 0; i < 50; ++i)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(-25.0f + i, 0.5f);
+            b2Body* body = world.CreateBody(&bodyDef);
+            body->CreateFixture(&box, 1.0f);
+
+            b2RevoluteJointDef jointDef;
+            jointDef.Initialize(prev, body, body->GetPosition());
+            world.CreateJoint(&jointDef);
+            prev = body;
+        }
+
+        for (std::int32_t i = 0; i < 10; ++i)
+        {
+            world.Step(1.0f / 60.0f, 8, 3);
+        }
+
+        CHECK(world.GetBodyCount() == 51);
+        CHECK(world.GetJointCount() == 50);
+        CHECK(world.GetContactCount() > 0);
+
+        b2BlockAllocatorStats stats;
+        world.GetBlockStats(&stats);
+        if (pass == 0)
+        {
+            chunkCount = stats.chunkCount;
+        }
+        else
+        {
+            // The second scene reuses the chunks of the first.
+            CHECK(stats.chunkCount + stats.spareChunkCount == chunkCount);
+        }
+
+        world.Clear();
+
+        CHECK(world.GetBodyCount() == 0);
+        CHECK(world.GetJointCount() == 0);
+        CHECK(world.GetContactCount() == 0);
+        CHECK(world.GetProxyCount() == 0);
+        CHECK(world.GetBodyList() == nullptr);
+
+        world.GetBlockStats(&stats);
+        CHECK(stats.chunkCount == 0);
+        CHECK(stats.spareChunkCount == chunkCount);
+        CHECK(stats.largeCount == 0);
+    }
+
+    CHECK(world.TrimBlocks() == chunkCount);
+}
+
+TEST_CASE("handles")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    // A zero handle is never valid.
+    CHECK(world.IsValid(b2BodyId{}) == false);
+    CHECK(world.GetFixture(b2FixtureId{}) == nullptr);
+
+    b2BodyDef bodyDef;
+    bodyDef.type = b2_dynamicBody;
+    b2Body* bodyA = world.CreateBody(&bodyDef);
+    b2Body* bodyB = world.CreateBody(&bodyDef);
+
+    b2CircleShape circle;
+    circle.m_radius = 0.5f;
+    b2Fixture* fixtureA = bodyA->CreateFixture(&circle, 1.0f);
+    b2Fixture* fixtureB = bodyB->CreateFixture(&circle, 1.0f);
+
+    b2RevoluteJointDef jointDef;
+    jointDef.Initialize(bodyA, bodyB, b2Vec2_zero);
+    b2Joint* joint = world.CreateJoint(&jointDef);
+
+    b2BodyId idA = bodyA->GetId();
+    b2BodyId idB = bodyB->GetId();
+    b2FixtureId fixtureIdA = fixtureA->GetId();
+    b2FixtureId fixtureIdB = fixtureB->GetId();
+    b2JointId jointId = joint->GetId();
+
+    CHECK(idA != idB);
+    CHECK(world.GetBody(idA) == bodyA);
+    CHECK(world.GetBody(idB) == bodyB);
+    CHECK(world.GetFixture(fixtureIdA) == fixtureA);
+    CHECK(world.GetFixture(fixtureIdB) == fixtureB);
+    CHECK(world.GetJoint(jointId) == joint);
+
+    // Destroying a body invalidates its fixtures and joints.
+    world.DestroyBody(bodyA);
+    CHECK(world.IsValid(idA) == false);
+    CHECK(world.IsValid(fixtureIdA) == false);
+    CHECK(world.IsValid(jointId) == false);
+    CHECK(world.GetBody(idB) == bodyB);
+    CHECK(world.GetFixture(fixtureIdB) == fixtureB);
+
+    // The slot is reused with a new generation.
+    b2Body* bodyC = world.CreateBody(&bodyDef);
+    b2BodyId idC = bodyC->GetId();
+    CHECK(idC.index == idA.index);
+    CHECK(idC.generation != idA.generation);
+    CHECK(world.GetBody(idA) == nullptr);
+    CHECK(world.GetBody(idC) == bodyC);
+
+    bodyB->DestroyFixture(fixtureB);
+    CHECK(world.IsValid(fixtureIdB) == false);
+    CHECK(world.IsValid(idB));
+
+    world.Clear();
+    CHECK(world.IsValid(idB) == false);
+    CHECK(world.IsValid(idC) == false);
+
+    b2HandlePool pool;
+    int objects[40];
+    for (std::int32_t i = 0; i < 40; ++i)
+    {
+        CHECK(pool.Allocate(objects + i) == i);
+    }
+    CHECK(pool.GetCount() == 40);
+    CHECK(pool.GetCapacity() >= 40);
+
+    std::uint32_t generation = pool.GetGeneration(7);
+    pool.Relocate(7, objects + 8);
+    CHECK(pool.Get(7, generation) == objects + 8);
+    pool.Free(7);
+    CHECK(pool.Get(7, generation) == nullptr);
+    CHECK(pool.Allocate(objects + 7) == 7);
+    CHECK(pool.Get(7, generation + 1) == objects + 7);
+}
+
+TEST_CASE("scene save and load")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+
+    b2Vec2 vertices[50];
+    for (std::int32_t i = 0; i < 50; ++i)
+    {
+        vertices[i].Set(-25.0f + i, 0.1f * (i % 3));
+    }
+    b2ChainShape chain;
+    chain.CreateChain(vertices, 50, b2Vec2(-26.0f, 0.0f), b2Vec2(25.0f, 0.0f));
+    chain.SetSingleProxy(true);
+    ground->CreateFixture(&chain, 0.0f);
+
+    float heights[20];
+    for (std::int32_t i = 0; i < 20; ++i)
+    {
+        heights[i] = 0.2f * (i % 4);
+    }
+    b2HeightFieldShape heightField;
+    heightField.Create(heights, 20, 0.5f);
+    ground->CreateFixture(&heightField, 0.0f);
+
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(30.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.25f);
+    b2CircleShape circle;
+    circle.m_radius = 0.3f;
+    circle.m_p.Set(0.1f, 0.2f);
+    b2CapsuleShape capsule;
+    capsule.Set(b2Vec2(-0.4f, 0.0f), b2Vec2(0.4f, 0.0f), 0.2f);
+    const b2Shape* parts[3] = { &box, &circle, &capsule };
+    b2CompoundShape compound;
+    compound.Create(parts, 3);
+
+    b2Body* bodies[6];
+    for (std::int32_t i = 0; i < 6; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = i == 5 ? b2_kinematicBody : b2_dynamicBody;
+        bodyDef.position.Set(-10.0f + 3.0f * i, 4.0f);
+        bodyDef.angle = 0.1f * i;
+        bodyDef.linearVelocity.Set(0.5f, 0.0f);
+        bodyDef.bullet = i == 1;
+        bodyDef.fixedRotation = i == 2;
+        bodyDef.gravityScale = 0.5f;
+        bodies[i] = world.CreateBody(&bodyDef);
+
+        b2FixtureDef fixtureDef;
+        fixtureDef.density = 1.0f + i;
+        fixtureDef.friction = 0.1f * i;
+        fixtureDef.isSensor = i == 4;
+        fixtureDef.filter.groupIndex = -1;
+        fixtureDef.filter.maskBits = 0x00ff;
+        fixtureDef.shape = i == 0 ? (const b2Shape*)&compound : (const b2Shape*)&box;
+        bodies[i]->CreateFixture(&fixtureDef);
+        fixtureDef.shape = &circle;
+        bodies[i]->CreateFixture(&fixtureDef);
+    }
+
+    b2RevoluteJointDef revoluteDef;
+    revoluteDef.Initialize(ground, bodies[0], bodies[0]->GetPosition());
+    revoluteDef.enableMotor = true;
+    revoluteDef.maxMotorTorque = 10.0f;
+    b2Joint* revolute = world.CreateJoint(&revoluteDef);
+
+    b2PrismaticJointDef prismaticDef;
+    prismaticDef.Initialize(ground, bodies[1], bodies[1]->GetPosition(), b2Vec2(1.0f, 0.0f));
+    prismaticDef.enableLimit = true;
+    prismaticDef.lowerTranslation = -1.0f;
+    prismaticDef.upperTranslation = 2.0f;
+    b2Joint* prismatic = world.CreateJoint(&prismaticDef);
+
+    b2GearJointDef gearDef;
+    gearDef.bodyA = bodies[0];
+    gearDef.bodyB = bodies[1];
+    gearDef.joint1 = revolute;
+    gearDef.joint2 = prismatic;
+    gearDef.ratio = 2.0f;
+    world.CreateJoint(&gearDef);
+
+    b2DistanceJointDef distanceDef;
+    distanceDef.Initialize(bodies[2], bodies[3], bodies[2]->GetPosition(), bodies[3]->GetPosition());
+    world.CreateJoint(&distanceDef);
+
+    b2PulleyJointDef pulleyDef;
+    pulleyDef.Initialize(bodies[3], bodies[4], b2Vec2(-1.0f, 10.0f), b2Vec2(1.0f, 10.0f),
+        bodies[3]->GetPosition(), bodies[4]->GetPosition(), 1.5f);
+    world.CreateJoint(&pulleyDef);
+
+    b2WheelJointDef wheelDef;
+    wheelDef.Initialize(bodies[4], bodies[5], bodies[5]->GetPosition(), b2Vec2(0.0f, 1.0f));
+    world.CreateJoint(&wheelDef);
+
+    b2WeldJointDef weldDef;
+    weldDef.Initialize(bodies[2], bodies[5], bodies[5]->GetPosition());
+    weldDef.stiffness = 5.0f;
+    world.CreateJoint(&weldDef);
+
+    b2FrictionJointDef frictionDef;
+    frictionDef.Initialize(ground, bodies[2], bodies[2]->GetPosition());
+    world.CreateJoint(&frictionDef);
+
+    b2MotorJointDef motorDef;
+    motorDef.Initialize(ground, bodies[3]);
+    world.CreateJoint(&motorDef);
+
+    // Mouse joints are not saved.
+    b2MouseJointDef mouseDef;
+    mouseDef.bodyA = ground;
+    mouseDef.bodyB = bodies[4];
+    mouseDef.target = bodies[4]->GetPosition();
+    world.CreateJoint(&mouseDef);
+
+    for (std::int32_t i = 0; i < 5; ++i)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    std::size_t size = world.SaveScene(nullptr, 0);
+    CHECK(size > sizeof(b2SceneHeader));
+
+    // Four byte aligned storage.
+    std::vector<std::uint32_t> scene((size + 3) / 4);
+    CHECK(world.SaveScene(scene.data(), size) == size);
+
+    const b2SceneHeader* header = (const b2SceneHeader*)scene.data();
+    CHECK(header->magic == b2_sceneMagic);
+    CHECK(header->byteCount == size);
+    CHECK(header->bodyCount == 7);
+    CHECK(header->fixtureCount == 15);
+    CHECK(header->jointCount == 9);
+
+    b2World loaded(b2Vec2_zero);
+    std::vector<b2Body*> loadedBodies(header->bodyCount);
+    CHECK(loaded.LoadScene(scene.data(), size, loadedBodies.data()));
+    CHECK(loaded.GetGravity().y == -10.0f);
+    CHECK(loaded.GetBodyCount() == 7);
+    CHECK(loaded.GetJointCount() == 9);
+    CHECK(loaded.GetProxyCount() == world.GetProxyCount());
+    CHECK(loadedBodies[1]->GetPosition() == bodies[0]->GetPosition());
+    CHECK(loadedBodies[1]->GetMass() == bodies[0]->GetMass());
+    CHECK(loadedBodies[2]->IsBullet());
+    CHECK(loadedBodies[3]->IsFixedRotation());
+
+    // Saving the loaded world gives the same scene.
+    std::vector<std::uint32_t> scene2(scene.size());
+    CHECK(loaded.SaveScene(scene2.data(), size) == size);
+    CHECK(memcmp(scene.data(), scene2.data(), size) == 0);
+
+    // The kinematic body keeps its saved velocity.
+    float x = loadedBodies[6]->GetPosition().x;
+    for (std::int32_t i = 0; i < 60; ++i)
+    {
+        loaded.Step(1.0f / 60.0f, 8, 3);
+    }
+    CHECK(b2Abs(loadedBodies[6]->GetPosition().x - x - 0.5f) < 0.01f);
+
+    // A bad scene leaves the world unchanged.
+    b2World other(b2Vec2_zero);
+    CHECK(other.LoadScene(scene.data(), size - 4) == false);
+    CHECK(other.LoadScene(scene.data(), sizeof(b2SceneHeader) - 4) == false);
+    std::vector<std::uint32_t> undersized(scene.begin(), scene.end());
+    reinterpret_cast<b2SceneHeader*>(undersized.data())->byteCount = 4;
+    CHECK(other.LoadScene(undersized.data(), size) == false);
+    scene[sizeof(b2SceneHeader) / 4] = 7;
+    CHECK(other.LoadScene(scene.data(), size) == false);
+    scene[0] = 0;
+    CHECK(other.LoadScene(scene.data(), size) == false);
+    CHECK(other.GetBodyCount() == 0);
+    CHECK(other.GetProxyCount() == 0);
+
+    // Floats that are not finite and polygons that b2PolygonShape::Set would not make.
+    b2World single(b2Vec2(0.0f, -10.0f));
+    b2BodyDef boxDef;
+    boxDef.type = b2_dynamicBody;
+    b2PolygonShape square;
+    square.SetAsBox(0.5f, 0.5f);
+    single.CreateBody(&boxDef)->CreateFixture(&square, 1.0f);
+    std::vector<std::uint32_t> good(64);
+    std::size_t goodSize = single.SaveScene(good.data(), good.size() * 4);
+    REQUIRE(goodSize > 0);
+    REQUIRE(other.LoadScene(good.data(), goodSize));
+    other.Clear();
+
+    const std::size_t bodyOffset = sizeof(b2SceneHeader) / 4;
+    const std::size_t fixtureOffset = bodyOffset + sizeof(b2SceneBody) / 4;
+    const std::size_t vertexOffset = fixtureOffset + sizeof(b2SceneFixture) / 4 + 3;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    auto corrupt = [&](std::size_t index, float value) {
+        std::vector<std::uint32_t> bad(good);
+        memcpy(bad.data() + index, &value, sizeof(float));
+        return other.LoadScene(bad.data(), goodSize);
+    };
+
+    CHECK(corrupt(6, nan) == false);
+    CHECK(corrupt(bodyOffset + 1, nan) == false);
+    CHECK(corrupt(bodyOffset + 3, inf) == false);
+    CHECK(corrupt(bodyOffset + 7, -1.0f) == false);
+    CHECK(corrupt(fixtureOffset, nan) == false);
+    CHECK(corrupt(fixtureOffset + 3, -1.0f) == false);
+    CHECK(corrupt(fixtureOffset + 7, nan) == false);
+    CHECK(corrupt(vertexOffset, nan) == false);
+
+    // A degenerate edge, a moved vertex and a normal that does not match its edge.
+    CHECK(corrupt(vertexOffset, 0.5f) == false);
+    CHECK(corrupt(vertexOffset + 4, 0.0f) == false);
+    CHECK(corrupt(vertexOffset + 8, 1.0f) == false);
+
+    // A counter clockwise quad with a reflex vertex and normals that match its edges.
+    std::vector<std::uint32_t> reflex(good);
+    b2Vec2 quad[4] = { b2Vec2(0.0f, -1.0f), b2Vec2(1.0f, 1.0f), b2Vec2(0.0f, 0.0f), b2Vec2(-1.0f, 1.0f) };
+    b2Vec2 normals[4];
+    for (std::int32_t i = 0; i < 4; ++i)
+    {
+        normals[i] = b2Cross(quad[(i + 1) % 4] - quad[i], 1.0f);
+        normals[i].Normalize();
+    }
+    memcpy(reflex.data() + vertexOffset, quad, sizeof(quad));
+    memcpy(reflex.data() + vertexOffset + 8, normals, sizeof(normals));
+    CHECK(other.LoadScene(reflex.data(), goodSize) == false);
+    CHECK(other.GetBodyCount() == 0);
+    CHECK(other.GetProxyCount() == 0);
+}
+
+TEST_CASE("replay")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+    b2ReplayRecorder recorder;
+    recorder.Begin(&world);
+    CHECK(recorder.IsRecording());
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+    b2Vec2 vertices[3] = { b2Vec2(-40.0f, 10.0f), b2Vec2(-40.0f, 0.0f), b2Vec2(-30.0f, 0.0f) };
+    b2ChainShape chain;
+    chain.CreateChain(vertices, 3, vertices[0], vertices[2]);
+    ground->CreateFixture(&chain, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    b2CircleShape circle;
+    circle.m_radius = 0.5f;
+
+    std::vector<b2Body*> bodies;
+    for (std::int32_t i = 0; i < 10; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(-5.0f + 1.1f * i, 0.5f + 1.5f * (i % 3));
+        b2Body* body = world.CreateBody(&bodyDef);
+        body->CreateFixture(i % 2 == 0 ? (const b2Shape*)&box : (const b2Shape*)&circle, 1.0f);
+        bodies.push_back(body);
+    }
+
+    b2RevoluteJointDef revoluteDef;
+    revoluteDef.Initialize(ground, bodies[0], bodies[0]->GetPosition());
+    b2Joint* revolute = world.CreateJoint(&revoluteDef);
+    b2RevoluteJointDef revoluteDef2;
+    revoluteDef2.Initialize(ground, bodies[2], bodies[2]->GetPosition());
+    b2Joint* revolute2 = world.CreateJoint(&revoluteDef2);
+    b2GearJointDef gearDef;
+    gearDef.bodyA = bodies[0];
+    gearDef.bodyB = bodies[2];
+    gearDef.joint1 = revolute;
+    gearDef.joint2 = revolute2;
+    world.CreateJoint(&gearDef);
+
+    b2DistanceJointDef distanceDef;
+    distanceDef.Initialize(bodies[5], bodies[6], bodies[5]->GetPosition(), bodies[6]->GetPosition());
+    world.CreateJoint(&distanceDef);
+
+    for (std::int32_t i = 0; i < 120; ++i)
+    {
+        bodies[3]->ApplyForceToCenter(b2Vec2(5.0f, 0.0f), true);
+        bodies[4]->ApplyTorque(1.0f, true);
+        if (i == 10)
+        {
+            bodies[7]->ApplyLinearImpulse(b2Vec2(0.0f, 8.0f), bodies[7]->GetWorldPoint(b2Vec2(0.2f, 0.0f)), true);
+            bodies[8]->SetLinearVelocity(b2Vec2(-3.0f, 2.0f));
+        }
+        if (i == 20)
+        {
+            bodies[9]->SetTransform(b2Vec2(0.0f, 8.0f), 0.5f);
+            bodies[1]->SetType(b2_kinematicBody);
+            bodies[1]->SetAngularVelocity(1.0f);
+        }
+        if (i == 30)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(2.0f, 6.0f);
+            bodyDef.angularVelocity = 2.0f;
+            b2Body* body = world.CreateBody(&bodyDef);
+            b2CompoundShape compound;
+            const b2Shape* parts[2] = { &box, &circle };
+            compound.Create(parts, 2);
+            body->CreateFixture(&compound, 2.0f);
+            bodies.push_back(body);
+        }
+        if (i == 40)
+        {
+            // This destroys the distance joint too.
+            world.DestroyBody(bodies[5]);
+            bodies[5] = nullptr;
+            bodies[6]->DestroyFixture(bodies[6]->GetFixtureList());
+            bodies[6]->CreateFixture(&box, 3.0f);
+        }
+        if (i == 50)
+        {
+            world.SetGravity(b2Vec2(1.0f, -8.0f));
+        }
+
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    recorder.End();
+    CHECK(recorder.IsRecording() == false);
+    CHECK(recorder.GetStepCount() == 120);
+    CHECK(recorder.GetSize() > sizeof(b2ReplayHeader));
+
+    std::vector<b2Transform> transforms;
+    for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+    {
+        transforms.push_back(b->GetTransform());
+    }
+
+    // Changes after the recording are not recorded.
+    std::size_t size = recorder.GetSize();
+    bodies[3]->ApplyForceToCenter(b2Vec2(5.0f, 0.0f), true);
+    world.Step(1.0f / 60.0f, 8, 3);
+    CHECK(recorder.GetSize() == size);
+
+    // Playback repeats the simulation exactly.
+    b2World played(b2Vec2_zero);
+    b2ReplayPlayer player;
+    CHECK(player.Begin(&played, recorder.GetData(), size));
+    while (player.Step())
+    {
+        CHECK(player.GetStepTime() >= 0.0f);
+    }
+    CHECK(player.IsDone());
+    CHECK(player.GetStepCount() == 120);
+    CHECK(played.GetGravity() == b2Vec2(1.0f, -8.0f));
+    CHECK(played.GetBodyCount() == world.GetBodyCount());
+    CHECK(played.GetJointCount() == world.GetJointCount());
+
+    std::size_t index = 0;
+    for (b2Body* b = played.GetBodyList(); b; b = b->GetNext())
+    {
+        CHECK(b->GetTransform().p == transforms[index].p);
+        CHECK(b->GetTransform().q.s == transforms[index].q.s);
+        ++index;
+    }
+
+    // Bad data stops the player.
+    std::vector<std::uint32_t> data(size / 4);
+    memcpy(data.data(), recorder.GetData(), size);
+    data[data.size() - 4] = 0xffff;
+    b2World bad(b2Vec2_zero);
+    CHECK(player.Begin(&bad, data.data(), size));
+    while (player.Step())
+    {
+    }
+    CHECK(player.IsDone() == false);
+    data[0] = 0;
+    CHECK(player.Begin(&bad, data.data(), size) == false);
+
+    // Start from a snapshot and load a scene while recording.
+    std::vector<std::uint32_t> scene(world.SaveScene(nullptr, 0) / 4);
+    world.SaveScene(scene.data(), 4 * scene.size());
+    recorder.Begin(&world);
+    CHECK(world.LoadScene(scene.data(), 4 * scene.size()));
+    world.GetBodyList()->ApplyLinearImpulseToCenter(b2Vec2(1.0f, 0.0f), true);
+    world.DestroyBody(world.GetBodyList()->GetNext());
+    world.Step(1.0f / 60.0f, 8, 3);
+    recorder.End();
+
+    b2World snapshot(b2Vec2_zero);
+    CHECK(player.Begin(&snapshot, recorder.GetData(), recorder.GetSize()));
+    CHECK(player.Step());
+    CHECK(player.Step() == false);
+    CHECK(player.IsDone());
+    CHECK(snapshot.GetBodyCount() == world.GetBodyCount());
+    CHECK(snapshot.GetJointCount() == world.GetJointCount());
+    CHECK(snapshot.GetBodyList()->GetMass() == world.GetBodyList()->GetMass());
+}
+
+TEST_CASE("replay settings")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+    world.SetWarmStarting(false);
+    world.SetTreeRefit(true);
+    world.SetTreeOptimizationBudget(4);
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    std::vector<b2Body*> bodies;
+    for (std::int32_t i = 0; i < 12; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(-6.0f + 1.1f * i, 0.5f + 1.2f * (i % 4));
+        b2Body* body = world.CreateBody(&bodyDef);
+        body->CreateFixture(&box, 1.0f);
+        bodies.push_back(body);
+    }
+
+    b2RevoluteJointDef revoluteDef;
+    revoluteDef.Initialize(ground, bodies[0], bodies[0]->GetPosition());
+    b2RevoluteJoint* revolute = static_cast<b2RevoluteJoint*>(world.CreateJoint(&revoluteDef));
+    b2PrismaticJointDef prismaticDef;
+    prismaticDef.Initialize(ground, bodies[1], bodies[1]->GetPosition(), b2Vec2(1.0f, 0.0f));
+    b2PrismaticJoint* prismatic = static_cast<b2PrismaticJoint*>(world.CreateJoint(&prismaticDef));
+    b2WheelJointDef wheelDef;
+    wheelDef.Initialize(bodies[2], bodies[3], bodies[3]->GetPosition(), b2Vec2(0.0f, 1.0f));
+    b2WheelJoint* wheel = static_cast<b2WheelJoint*>(world.CreateJoint(&wheelDef));
+
+    b2ReplayRecorder recorder;
+    recorder.Begin(&world);
+
+    for (std::int32_t i = 0; i < 90; ++i)
+    {
+        if (i == 5)
+        {
+            world.SetContinuousPhysics(false);
+            world.SetAllowSleeping(false);
+            world.SetManifoldReuse(true);
+            revolute->EnableMotor(true);
+            revolute->SetMaxMotorTorque(50.0f);
+            revolute->SetMotorSpeed(2.0f);
+            prismatic->EnableLimit(true);
+            prismatic->SetLimits(-1.0f, 0.5f);
+            wheel->SetStiffness(20.0f);
+        }
+        if (i == 15)
+        {
+            bodies[4]->SetGravityScale(-0.5f);
+            bodies[5]->SetBullet(true);
+            bodies[6]->SetFixedRotation(true);
+            bodies[7]->SetSleepingAllowed(false);
+            bodies[8]->SetLinearDamping(2.0f);
+            b2Filter filter;
+            filter.groupIndex = -1;
+            bodies[9]->GetFixtureList()->SetFilterData(filter);
+            bodies[10]->GetFixtureList()->SetFilterData(filter);
+            bodies[11]->GetFixtureList()->SetSensor(true);
+        }
+        if (i == 30)
+        {
+            world.SetAutoClearForces(false);
+            world.SetWarmStarting(true);
+            world.SetSubStepping(true);
+            bodies[1]->ApplyForceToCenter(b2Vec2(20.0f, 0.0f), true);
+        }
+        if (i == 40)
+        {
+            world.SetSubStepping(false);
+            world.SetTreeRefit(false);
+            revolute->SetMotorSpeed(-1.0f);
+        }
+
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    recorder.End();
+
+    b2World played(b2Vec2_zero);
+    b2ReplayPlayer player;
+    CHECK(player.Begin(&played, recorder.GetData(), recorder.GetSize()));
+    while (player.Step())
+    {
+    }
+    CHECK(player.IsDone());
+    CHECK(player.GetStepCount() == 90);
+    CHECK(played.GetWarmStarting());
+    CHECK(played.GetContinuousPhysics() == false);
+    CHECK(played.GetAllowSleeping() == false);
+    CHECK(played.GetAutoClearForces() == false);
+    CHECK(played.GetManifoldReuse());
+    CHECK(played.GetTreeRefit() == false);
+    CHECK(played.GetTreeOptimizationBudget() == 4);
+
+    // Playback repeats the simulation exactly.
+    REQUIRE(played.GetBodyCount() == world.GetBodyCount());
+    b2Body* b = world.GetBodyList();
+    for (b2Body* p = played.GetBodyList(); p; p = p->GetNext())
+    {
+        CHECK(p->GetTransform().p == b->GetTransform().p);
+        CHECK(p->GetTransform().q.s == b->GetTransform().q.s);
+        CHECK(p->GetGravityScale() == b->GetGravityScale());
+        CHECK(p->IsBullet() == b->IsBullet());
+        CHECK(p->IsFixedRotation() == b->IsFixedRotation());
+        CHECK(p->IsSleepingAllowed() == b->IsSleepingAllowed());
+        CHECK(p->GetFixtureList() == nullptr || p->GetFixtureList()->IsSensor() == b->GetFixtureList()->IsSensor());
+        b = b->GetNext();
+    }
+
+    b2Joint* j = world.GetJointList();
+    for (b2Joint* p = played.GetJointList(); p; p = p->GetNext())
+    {
+        CHECK(p->GetType() == j->GetType());
+        if (p->GetType() == e_revoluteJoint)
+        {
+            CHECK(static_cast<b2RevoluteJoint*>(p)->GetMotorSpeed() == -1.0f);
+        }
+        j = j->GetNext();
+    }
+}
+
+TEST_CASE("height field")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    // A gentle slope with many columns.
+    const std::int32_t sampleCount = 1001;
+    const float spacing = 0.5f;
+    float heights[sampleCount];
+    for (std::int32_t i = 0; i < sampleCount; ++i)
+    {
+        heights[i] = 0.01f * i;
+    }
+
+    b2HeightFieldShape heightField;
+    heightField.Create(heights, sampleCount, spacing);
+    CHECK(heightField.GetChildCount() == sampleCount - 1);
+
+    b2BodyDef groundDef;
+    groundDef.position.Set(-10.0f, 0.0f);
+    b2Body* ground = world.CreateBody(&groundDef);
+    ground->CreateFixture(&heightField, 0.0f);
+
+    // The whole height field uses one proxy.
+    CHECK(world.GetProxyCount() == 1);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    b2CircleShape circle;
+    circle.m_radius = 0.5f;
+
+    const std::int32_t bodyCount = 20;
+    b2Body* bodies[bodyCount];
+    for (std::int32_t i = 0; i < bodyCount; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(10.0f * i, 5.0f);
+        bodyDef.fixedRotation = true;
+        bodies[i] = world.CreateBody(&bodyDef);
+        if (i % 2 == 0)
+        {
+            bodies[i]->CreateFixture(&box, 1.0f);
+        }
+        else
+        {
+            bodies[i]->CreateFixture(&circle, 1.0f);
+        }
+    }
+
+    CHECK(world.GetProxyCount() == bodyCount + 1);
+
+    for (std::int32_t i = 0; i < 120; ++i)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    // Contacts only exist for the few columns under each body.
+    CHECK(world.GetContactCount() >= bodyCount);
+    CHECK(world.GetContactCount() <= 5 * bodyCount);
+
+    for (std::int32_t i = 0; i < bodyCount; ++i)
+    {
+        b2Vec2 p = bodies[i]->GetPosition();
+        float surface = 0.02f * (p.x + 10.0f);
+        CHECK(p.y > surface + 0.4f);
+        CHECK(p.y < surface + 0.6f);
+    }
+
+    // Continuous collision keeps a fast body above the surface.
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(2.2f, 3.0f);
+        bodyDef.linearVelocity.Set(0.0f, -200.0f);
+        b2Body* body = world.CreateBody(&bodyDef);
+        body->CreateFixture(&circle, 1.0f);
+
+        world.Step(1.0f / 60.0f, 8, 3);
+        world.Step(1.0f / 60.0f, 8, 3);
+        CHECK(body->GetPosition().y > 0.0f);
+    }
+
+    // Ray cast onto the surface.
+    struct RayCastCallback : public b2RayCastCallback
+    {
+        float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override
+        {
+            (void)fixture;
+            m_point = point;
+            m_normal = normal;
+            return fraction;
+        }
+
+        b2Vec2 m_point = b2Vec2(0.0f, 0.0f);
+        b2Vec2 m_normal = b2Vec2(0.0f, 0.0f);
+    };
+
+    RayCastCallback callback;
+    world.RayCast(&callback, b2Vec2(5.0f, 10.0f), b2Vec2(5.0f, -10.0f));
+    CHECK(b2Abs(callback.m_point.y - 0.3f) < 0.001f);
+    CHECK(callback.m_normal.y > 0.99f);
+}
+
+TEST_CASE("single proxy chain")
+{
+    // A long bumpy floor. The vertices run right to left so the surface faces up.
+    const std::int32_t vertexCount = 2001;
+    b2Vec2 vertices[vertexCount];
+    for (std::int32_t i = 0; i < vertexCount; ++i)
+    {
+        float x = 0.25f * (vertexCount - 1 - i) - 250.0f;
+        vertices[i].Set(x, 0.2f * sinf(0.5f * x));
+    }
+
+    b2ChainShape chain;
+    chain.CreateChain(vertices, vertexCount, vertices[0], vertices[vertexCount - 1]);
+    CHECK(chain.IsSingleProxy() == false);
+
+    b2ChainShape singleChain;
+    singleChain.CreateChain(vertices, vertexCount, vertices[0], vertices[vertexCount - 1]);
+    singleChain.SetSingleProxy(true);
+    CHECK(singleChain.IsSingleProxy());
+    CHECK(singleChain.m_nodeCount == 2 * (vertexCount - 1) - 1);
+
+    // The segment tree reports the same segments as a brute force search.
+    {
+        struct Collector : public b2ChildQueryCallback
+        {
+            bool ReportChild(std::int32_t childIndex) override
+            {
+                if (m_count < 256)
+                {
+                    m_indices[m_count++] = childIndex;
+                }
+                return true;
+            }
+
+            std::int32_t m_indices[256];
+            std::int32_t m_count = 0;
+        };
+
+        b2Transform xf(b2Vec2(1.0f, 2.0f), b2Rot(0.0f));
+        b2AABB aabb;
+        aabb.lowerBound.Set(-3.0f, -1.0f);
+        aabb.upperBound.Set(2.0f, 4.0f);
+
+        Collector fast;
+        singleChain.QueryChildren(&fast, aabb, xf);
+        Collector slow;
+        chain.QueryChildren(&slow, aabb, xf);
+
+        CHECK(fast.m_count > 0);
+        CHECK(fast.m_count < 256);
+        REQUIRE(fast.m_count == slow.m_count);
+        for (std::int32_t i = 0; i < fast.m_count; ++i)
+        {
+            CHECK(fast.m_indices[i] == slow.m_indices[i]);
+        }
+    }
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    b2CircleShape circle;
+    circle.m_radius = 0.5f;
+
+    const std::int32_t bodyCount = 10;
+    b2Vec2 positions[2][bodyCount];
+    std::int32_t contactCounts[2];
+
+    for (std::int32_t mode = 0; mode < 2; ++mode)
+    {
+        b2World world(b2Vec2(0.0f, -10.0f));
+
+        b2BodyDef groundDef;
+        b2Body* ground = world.CreateBody(&groundDef);
+        ground->CreateFixture(mode == 0 ? &chain : &singleChain, 0.0f);
+        CHECK(world.GetProxyCount() == (mode == 0 ? vertexCount - 1 : 1));
+
+        b2Body* bodies[bodyCount];
+        for (std::int32_t i = 0; i < bodyCount; ++i)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(8.0f * i - 40.0f, 3.0f);
+            bodyDef.fixedRotation = true;
+            bodies[i] = world.CreateBody(&bodyDef);
+            bodies[i]->CreateFixture(i % 2 == 0 ? (b2Shape*)&box : (b2Shape*)&circle, 1.0f);
+        }
+
+        for (std::int32_t i = 0; i < 120; ++i)
+        {
+            world.Step(1.0f / 60.0f, 8, 3);
+        }
+
+        for (std::int32_t i = 0; i < bodyCount; ++i)
+        {
+            positions[mode][i] = bodies[i]->GetPosition();
+        }
+        contactCounts[mode] = world.GetContactCount();
+    }
+
+    // Both modes create contacts for the same segments and come to rest at the same place.
+    CHECK(contactCounts[0] == contactCounts[1]);
+    for (std::int32_t i = 0; i < bodyCount; ++i)
+    {
+        CHECK(b2Distance(positions[0][i], positions[1][i]) < 0.01f);
+    }
+}
+
+TEST_CASE("capsule")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-20.0f, 0.0f), b2Vec2(0.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(10.0f, 0.5f, b2Vec2(10.0f, -0.5f), 0.0f);
+    ground->CreateFixture(&box, 0.0f);
+
+    // Upright characters on the edge and on the box, and a capsule lying on its side.
+    b2CapsuleShape capsule;
+    capsule.Set(b2Vec2(0.0f, -0.5f), b2Vec2(0.0f, 0.5f), 0.4f);
+
+    const std::int32_t characterCount = 6;
+    b2Body* characters[characterCount];
+    for (std::int32_t i = 0; i < characterCount; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(-15.0f + 6.0f * i, 2.0f);
+        bodyDef.fixedRotation = true;
+        characters[i] = world.CreateBody(&bodyDef);
+        characters[i]->CreateFixture(&capsule, 1.0f);
+    }
+
+    b2BodyDef logDef;
+    logDef.type = b2_dynamicBody;
+    logDef.position.Set(18.0f, 2.0f);
+    logDef.angle = 0.5f * b2_pi;
+    b2Body* log = world.CreateBody(&logDef);
+    log->CreateFixture(&capsule, 1.0f);
+
+    // A second capsule resting on the log.
+    b2BodyDef topDef;
+    topDef.type = b2_dynamicBody;
+    topDef.position.Set(18.0f, 3.0f);
+    topDef.angle = 0.5f * b2_pi;
+    b2Body* top = world.CreateBody(&topDef);
+    top->CreateFixture(&capsule, 1.0f);
+
+    for (std::int32_t i = 0; i < 120; ++i)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    // One fixture and one contact per touching pair.
+    CHECK(world.GetContactCount() == characterCount + 2);
+
+    for (std::int32_t i = 0; i < characterCount; ++i)
+    {
+        b2Vec2 p = characters[i]->GetPosition();
+        CHECK(b2Abs(p.y - 0.9f) < 0.02f);
+    }
+
+    CHECK(b2Abs(log->GetPosition().y - 0.4f) < 0.02f);
+    CHECK(b2Abs(log->GetAngle() - 0.5f * b2_pi) < 0.01f);
+    CHECK(b2Abs(top->GetPosition().y - 1.2f) < 0.03f);
+    CHECK(b2Abs(top->GetPosition().x - 18.0f) < 0.01f);
+}
+
+// Raycast callback that keeps the closest hit.
+class ClosestHitCallback : public b2RayCastCallback
+{
+public:
+    float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override
+    {
+        m_fixture = fixture;
+        m_point = point;
+        return fraction;
+    }
+
+    b2Fixture* m_fixture = nullptr;
+    b2Vec2 m_point;
+};
+
+TEST_CASE("compound")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-20.0f, 0.0f), b2Vec2(0.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2PolygonShape groundBox;
+    groundBox.SetAsBox(10.0f, 0.5f, b2Vec2(10.0f, -0.5f), 0.0f);
+    ground->CreateFixture(&groundBox, 0.0f);
+
+    // A table with a box top, a capsule leg and a circle foot.
+    b2PolygonShape top;
+    top.SetAsBox(1.0f, 0.1f, b2Vec2(0.0f, 1.0f), 0.0f);
+    b2CapsuleShape leg;
+    leg.Set(b2Vec2(-0.8f, 0.1f), b2Vec2(-0.8f, 0.8f), 0.1f);
+    b2CircleShape foot;
+    foot.m_p.Set(0.8f, 0.45f);
+    foot.m_radius = 0.45f;
+    const b2Shape* parts[3] = { &top, &leg, &foot };
+
+    b2CompoundShape table;
+    table.Create(parts, 3);
+    CHECK(table.GetChildCount() == 3);
+
+    std::int32_t proxyCount = world.GetProxyCount();
+
+    b2BodyDef bodyDef;
+    bodyDef.type = b2_dynamicBody;
+    bodyDef.position.Set(4.0f, 0.5f);
+    b2Body* compoundBody = world.CreateBody(&bodyDef);
+    compoundBody->CreateFixture(&table, 1.0f);
+
+    // One proxy for the whole body.
+    CHECK(world.GetProxyCount() == proxyCount + 1);
+
+    // The same table built from separate fixtures.
+    bodyDef.position.Set(12.0f, 0.5f);
+    b2Body* multiBody = world.CreateBody(&bodyDef);
+    for (std::int32_t i = 0; i < 3; ++i)
+    {
+        multiBody->CreateFixture(parts[i], 1.0f);
+    }
+
+    CHECK(world.GetProxyCount() == proxyCount + 4);
+    CHECK(b2Abs(compoundBody->GetMass() - multiBody->GetMass()) < 1.0e-5f);
+    CHECK(b2Abs(compoundBody->GetInertia() - multiBody->GetInertia()) < 1.0e-4f);
+    CHECK(b2Distance(compoundBody->GetLocalCenter(), multiBody->GetLocalCenter()) < 1.0e-5f);
+
+    // A dumbbell of two circles and a bar dropped on the compound table, and one on the edge.
+    b2CircleShape ball1, ball2;
+    ball1.m_p.Set(-0.5f, 0.0f);
+    ball1.m_radius = 0.2f;
+    ball2.m_p.Set(0.5f, 0.0f);
+    ball2.m_radius = 0.2f;
+    b2PolygonShape bar;
+    bar.SetAsBox(0.5f, 0.05f);
+    const b2Shape* dumbbellParts[3] = { &ball1, &ball2, &bar };
+
+    b2CompoundShape dumbbell;
+    dumbbell.Create(dumbbellParts, 3);
+
+    bodyDef.position.Set(4.0f, 2.0f);
+    b2Body* upper = world.CreateBody(&bodyDef);
+    upper->CreateFixture(&dumbbell, 1.0f);
+
+    bodyDef.position.Set(-10.0f, 1.0f);
+    b2Body* lower = world.CreateBody(&bodyDef);
+    lower->CreateFixture(&dumbbell, 1.0f);
+
+    for (std::int32_t i = 0; i < 120; ++i)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    // The tables settle on the ground the same way.
+    CHECK(b2Abs(compoundBody->GetPosition().y - multiBody->GetPosition().y) < 0.005f);
+    CHECK(b2Abs(compoundBody->GetAngle() - multiBody->GetAngle()) < 0.005f);
+    CHECK(b2Abs(compoundBody->GetPosition().y) < 0.01f);
+    CHECK(b2Abs(compoundBody->GetAngle()) < 0.01f);
+
+    // The dumbbells rest on the table top and on the edge.
+    CHECK(b2Abs(upper->GetPosition().y - 1.3f) < 0.02f);
+    CHECK(b2Abs(upper->GetAngle()) < 0.01f);
+    CHECK(b2Abs(lower->GetPosition().y - 0.2f) < 0.02f);
+
+    // The contact radii come from the children, so the world manifold has no overlap.
+    for (b2Contact* c = world.GetContactList(); c; c = c->GetNext())
+    {
+        if (c->IsTouching() == false)
+        {
+            continue;
+        }
+
+        b2WorldManifold worldManifold;
+        c->GetWorldManifold(&worldManifold);
+        for (std::int32_t i = 0; i < c->GetManifold()->pointCount; ++i)
+        {
+            CHECK(worldManifold.separations[i] > -2.0f * b2_linearSlop);
+        }
+    }
+
+    // Ray casts report the compound fixture at the child surface.
+    ClosestHitCallback callback;
+    world.RayCast(&callback, b2Vec2(3.15f, 5.0f), b2Vec2(3.15f, -1.0f));
+    CHECK(callback.m_fixture == compoundBody->GetFixtureList());
+    CHECK(b2Abs(callback.m_point.y - 1.1f) < 0.02f);
+
+    CHECK(compoundBody->GetFixtureList()->TestPoint(compoundBody->GetWorldPoint(b2Vec2(0.8f, 0.45f))));
+    CHECK(compoundBody->GetFixtureList()->TestPoint(compoundBody->GetWorldPoint(b2Vec2(0.0f, 0.5f))) == false);
+}
+
+// Checks that a fixture proxy is reported by a query.
+class FixtureQueryCallback : public b2QueryCallback
+{
+public:
+    bool ReportFixture(b2Fixture* fixture) override
+    {
+        if (fixture == m_fixture)
+        {
+            m_found = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    const b2Fixture* m_fixture = nullptr;
+    bool m_found = false;
+};
+
+TEST_CASE("lazy synchronization")
+{
+    b2World world(b2Vec2(0.0f, 0.0f));
+    world.SetAllowSleeping(false);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.25f, b2Vec2(1.0f, 0.0f), 0.0f);
+
+    // Slow and fast bodies. The slow ones skip most synchronizations.
+    const std::int32_t count = 6;
+    b2Body* bodies[count];
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position.Set(4.0f * i, 0.0f);
+        bodyDef.linearVelocity.Set(0.01f * i * i, -0.02f * i);
+        bodyDef.angularVelocity = 0.05f * (i - 2);
+        bodies[i] = world.CreateBody(&bodyDef);
+        bodies[i]->CreateFixture(&box, 1.0f);
+    }
+
+    // The fat AABB must contain the fixture at every step.
+    for (std::int32_t step = 0; step < 300; ++step)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            b2Fixture* fixture = bodies[i]->GetFixtureList();
+            b2AABB aabb;
+            box.ComputeAABB(&aabb, bodies[i]->GetTransform(), 0);
+
+            b2Vec2 corners[4] = { aabb.lowerBound, b2Vec2(aabb.upperBound.x, aabb.lowerBound.y),
+                                  aabb.upperBound, b2Vec2(aabb.lowerBound.x, aabb.upperBound.y) };
+            for (std::int32_t j = 0; j < 4; ++j)
+            {
+                b2AABB point;
+                point.lowerBound = corners[j];
+                point.upperBound = corners[j];
+
+                FixtureQueryCallback callback;
+                callback.m_fixture = fixture;
+                world.QueryAABB(&callback, point);
+                CHECK(callback.m_found);
+            }
+        }
+    }
+
+    // Moving a body by hand resynchronizes it.
+    bodies[0]->SetTransform(b2Vec2(-10.0f, 5.0f), 1.0f);
+    FixtureQueryCallback callback;
+    callback.m_fixture = bodies[0]->GetFixtureList();
+    b2AABB point;
+    point.lowerBound = bodies[0]->GetWorldPoint(b2Vec2(1.0f, 0.0f));
+    point.upperBound = point.lowerBound;
+    world.QueryAABB(&callback, point);
+    CHECK(callback.m_found);
+}
+
+TEST_CASE("stack growth")
+{
+    b2StackAllocator allocator;
+    CHECK(allocator.GetCapacity() == b2_stackSize);
+
+    // The second allocation does not fit and falls back to the heap. Once the
+    // stack is empty the arena grows, so the same workload fits next time.
+    for (std::int32_t i = 0; i < 3; ++i)
+    {
+        char* a = allocator.Allocate<char>(60 * 1024);
+        char* b = allocator.Allocate<char>(60 * 1024);
+        allocator.Free(b);
+        allocator.Free(a);
+    }
+    CHECK(allocator.GetHeapAllocationCount() == 1);
+    CHECK(allocator.GetCapacity() >= 120 * 1024);
+
+    allocator.Reserve(1024 * 1024);
+    CHECK(allocator.GetCapacity() == 1024 * 1024);
+
+    // A large island overflows the initial stack.
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-100.0f, 0.0f), b2Vec2(100.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    for (std::int32_t i = 0; i < 40; ++i)
+    {
+        for (std::int32_t j = 0; j < 40; ++j)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(-20.0f + 1.0f * i, 0.5f + 1.0f * j);
+            world.CreateBody(&bodyDef)->CreateFixture(&box, 1.0f);
+        }
+    }
+
+    for (std::int32_t step = 0; step < 5; ++step)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    std::size_t capacity = world.GetStackCapacity();
+    CHECK(capacity > b2_stackSize);
+
+    for (std::int32_t step = 0; step < 20; ++step)
+    {
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+    CHECK(world.GetStackCapacity() == capacity);
+
+    world.ReserveStack(4 * capacity);
+    CHECK(world.GetStackCapacity() == 4 * capacity);
+}
+
+TEST_CASE("block reserve and trim")
+{
+    b2BlockAllocator allocator;
+    b2BlockAllocatorStats stats;
+
+    // 48 bytes round up to 64 byte blocks, 256 per chunk.
+    const std::int32_t count = 1000;
+    allocator.Reserve(48, count);
+    allocator.GetStats(&stats);
+    CHECK(stats.chunkCount == 4);
+    CHECK(stats.sizes[2].blockSize == 64);
+    CHECK(stats.sizes[2].freeBlockCount >= count);
+    CHECK(stats.sizes[2].freeChunkCount == 4);
+
+    void* blocks[count];
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        blocks[i] = allocator.Allocate<char>(48);
+    }
+
+    allocator.GetStats(&stats);
+    CHECK(stats.chunkCount == 4);
+    CHECK(stats.sizes[2].liveBlockCount == count);
+    CHECK(stats.sizes[2].fragmentation < 0.05f);
+
+    void* large = allocator.Allocate<char>(1000);
+    allocator.GetStats(&stats);
+    CHECK(stats.largeCount == 1);
+    CHECK(stats.largeBytes == 1000);
+    allocator.Free((char*)large, 1000);
+
+    // Keep one block in the first chunk. The other chunks can be released.
+    for (std::int32_t i = 1; i < count; ++i)
+    {
+        allocator.Free((char*)blocks[i], 48);
+    }
+
+    allocator.GetStats(&stats);
+    CHECK(stats.sizes[2].liveBlockCount == 1);
+    CHECK(stats.sizes[2].freeChunkCount == 3);
+    CHECK(stats.sizes[2].fragmentation > 0.0f);
+
+    CHECK(allocator.Trim() == 3);
+    allocator.GetStats(&stats);
+    CHECK(stats.chunkCount == 1);
+    CHECK(stats.sizes[2].freeBlockCount == 255);
+    CHECK(stats.largeCount == 0);
+
+    // The remaining blocks are still usable.
+    for (std::int32_t i = 1; i < count; ++i)
+    {
+        blocks[i] = allocator.Allocate<char>(48);
+        memset(blocks[i], 0, 48);
+    }
+
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        allocator.Free((char*)blocks[i], 48);
+    }
+
+    CHECK(allocator.Trim() == 4);
+    allocator.GetStats(&stats);
+    CHECK(stats.chunkCount == 0);
+    CHECK(stats.sizes[2].freeBlockCount == 0);
+
+    // World level
+    b2World world(b2Vec2(0.0f, -10.0f));
+    world.ReserveBlocks(sizeof(b2Body), 500);
+    world.GetBlockStats(&stats);
+    std::int32_t chunkCount = stats.chunkCount;
+    CHECK(chunkCount > 0);
+
+    b2Body* bodies[500];
+    b2BodyDef bodyDef;
+    for (std::int32_t i = 0; i < 500; ++i)
+    {
+        bodies[i] = world.CreateBody(&bodyDef);
+    }
+
+    world.GetBlockStats(&stats);
+    CHECK(stats.chunkCount == chunkCount);
+
+    for (std::int32_t i = 0; i < 500; ++i)
+    {
+        world.DestroyBody(bodies[i]);
+    }
+
+    CHECK(world.TrimBlocks() == chunkCount);
+}
+
+TEST_CASE("allocation stats")
+{
+    b2World world(b2Vec2(0.0f, -10.0f));
+
+    const b2AllocationStats& stats = world.GetAllocationStats();
+    for (std::int32_t i = 0; i < b2_allocationCategoryCount; ++i)
+    {
+        if (i == b2_blockAllocation)
+        {
+            // No chunks until the first block is allocated.
+            continue;
+        }
+
+        CHECK(stats.categories[i].allocationCount > 0);
+        CHECK(stats.categories[i].bytes > 0);
+    }
+
+    b2BodyDef groundDef;
+    b2Body* ground = world.CreateBody(&groundDef);
+    b2EdgeShape edge;
+    edge.SetTwoSided(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+    ground->CreateFixture(&edge, 0.0f);
+
+    // Pyramid
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    const std::int32_t rowCount = 20;
+    for (std::int32_t i = 0; i < rowCount; ++i)
+    {
+        for (std::int32_t j = i; j < rowCount; ++j)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(-0.5f * rowCount + 0.5f * i + 1.0f * (j - i), 0.5f + 1.0f * i);
+            world.CreateBody(&bodyDef)->CreateFixture(&box, 1.0f);
+        }
+    }
+
+    CHECK(stats.categories[b2_blockAllocation].allocationCount > 0);
+    CHECK(stats.categories[b2_bodyAllocation].bytes >= world.GetBodyCount() * sizeof(b2Body*));
+
+    // All memory is in place after the warm-up.
+    const std::int32_t warmUpStepCount = 10;
+    world.SetStepAllocationCheck(warmUpStepCount);
+    CHECK(world.GetStepAllocationCheck() == warmUpStepCount);
+
+    std::int32_t allocationCount = 0;
+    for (std::int32_t step = 0; step < 120; ++step)
+    {
+        if (step == warmUpStepCount)
+        {
+            for (std::int32_t i = 0; i < b2_allocationCategoryCount; ++i)
+            {
+                allocationCount += stats.categories[i].allocationCount;
+            }
+        }
+
+        world.Step(1.0f / 60.0f, 8, 3);
+    }
+
+    std::int32_t totalCount = 0;
+    for (std::int32_t i = 0; i < b2_allocationCategoryCount; ++i)
+    {
+        const b2AllocationCounter& counter = stats.categories[i];
+        CHECK(counter.bytes <= counter.peakBytes);
+        CHECK(counter.peakBytes <= counter.totalBytes);
+        CHECK(counter.freeCount <= counter.allocationCount);
+        totalCount += counter.allocationCount;
+    }
+
+    CHECK(totalCount == allocationCount);
+    CHECK(stats.checkedAllocationCount == 0);
+
+    // Destroyed objects go back to the free lists. The chunks are kept.
+    std::int32_t freeCount = stats.categories[b2_blockAllocation].freeCount;
+    while (world.GetBodyList())
+    {
+        world.DestroyBody(world.GetBodyList());
+    }
+    CHECK(stats.categories[b2_blockAllocation].freeCount == freeCount);
+}
+
+// Bump allocator over a fixed buffer. Free only counts.
+class TestArena : public b2Allocator
+{
+public:
+    void* Allocate(std::size_t size) override
+    {
+        size = (size + 15) & ~std::size_t(15);
+        REQUIRE(m_offset + size <= sizeof(m_buffer));
+        void* mem = m_buffer + m_offset;
+        m_offset += size;
+        m_liveCount += 1;
+        return mem;
+    }
+
+    void Free(void* mem, std::size_t size) override
+    {
+        (void)size;
+        CHECK(m_buffer <= (char*)mem);
+        CHECK((char*)mem < m_buffer + m_offset);
+        m_liveCount -= 1;
+    }
+
+    alignas(16) char m_buffer[4 * 1024 * 1024];
+    std::size_t m_offset = 0;
+    std::int32_t m_liveCount = 0;
+};
+
+TEST_CASE("world allocator")
+{
+    TestArena* arena = new TestArena;
+
+    {
+        b2World world(b2Vec2(0.0f, -10.0f), arena);
+        CHECK(world.GetAllocator() == arena);
+        CHECK(arena->m_liveCount > 0);
+
+        b2BodyDef groundDef;
+        b2Body* ground = world.CreateBody(&groundDef);
+        b2EdgeShape edge;
+        edge.SetTwoSided(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+        ground->CreateFixture(&edge, 0.0f);
+
+        b2CircleShape circle;
+        circle.m_radius = 0.5f;
+        for (std::int32_t i = 0; i < 100; ++i)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(-25.0f + 0.5f * i, 2.0f + 0.1f * i);
+            world.CreateBody(&bodyDef)->CreateFixture(&circle, 1.0f);
+        }
+
+        for (std::int32_t step = 0; step < 60; ++step)
+        {
+            world.Step(1.0f / 60.0f, 8, 3);
+        }
+
+        CHECK(world.GetContactCount() > 0);
+
+        // Everything the world allocated came from the arena.
+        const b2AllocationStats& stats = world.GetAllocationStats();
+        std::int32_t liveCount = 0;
+        for (std::int32_t i = 0; i < b2_allocationCategoryCount; ++i)
+        {
+            liveCount += stats.categories[i].allocationCount - stats.categories[i].freeCount;
+        }
+        CHECK(arena->m_liveCount == liveCount);
+    }
+
+    // The world returned everything.
+    CHECK(arena->m_liveCount == 0);
+    delete arena;
+}
+
+TEST_CASE("shared block allocator")
+{
+    struct Object
+    {
+        std::uint8_t* data;
+        std::size_t size;
+    };
+
+    const std::int32_t threadCount = 4;
+    const std::int32_t objectCount = 500;
+
+    b2AllocationTracker tracker;
+    {
+        b2SharedBlockAllocator allocator(&tracker);
+
+        // Each thread fills its objects with its own value, so overlapping blocks
+        // are detected. Half of the objects are freed by the next thread.
+        std::vector<Object> mailboxes[threadCount];
+        std::mutex mailboxMutex;
+        bool valid[threadCount];
+
+        auto work = [&](std::int32_t threadIndex)
+        {
+            b2BlockCache cache(&allocator);
+            std::uint8_t value = std::uint8_t(threadIndex + 1);
+            valid[threadIndex] = true;
+
+            for (std::int32_t round = 0; round < 20; ++round)
+            {
+                std::vector<Object> objects;
+                for (std::int32_t i = 0; i < objectCount; ++i)
+                {
+                    std::size_t size = 8 + (i * 37 + round * 11) % 700;
+                    std::uint8_t* data = cache.Allocate<std::uint8_t>(size);
+                    memset(data, value, size);
+                    objects.push_back({data, size});
+                }
+
+                for (const Object& object : objects)
+                {
+                    for (std::size_t j = 0; j < object.size; ++j)
+                    {
+                        valid[threadIndex] = valid[threadIndex] && object.data[j] == value;
+                    }
+                }
+
+                std::vector<Object> received;
+                {
+                    std::lock_guard<std::mutex> lock(mailboxMutex);
+                    received.swap(mailboxes[threadIndex]);
+                    std::vector<Object>& next = mailboxes[(threadIndex + 1) % threadCount];
+                    next.insert(next.end(), objects.begin() + objectCount / 2, objects.end());
+                }
+
+                for (std::int32_t i = 0; i < objectCount / 2; ++i)
+                {
+                    cache.Free(objects[i].data, objects[i].size);
+                }
+
+                for (const Object& object : received)
+                {
+                    cache.Free(object.data, object.size);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::int32_t i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back(work, i);
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (std::int32_t i = 0; i < threadCount; ++i)
+        {
+            CHECK(valid[i]);
+        }
+
+        b2BlockCache cache(&allocator);
+        for (std::int32_t i = 0; i < threadCount; ++i)
+        {
+            for (const Object& object : mailboxes[i])
+            {
+                cache.Free(object.data, object.size);
+            }
+        }
+
+        CHECK(tracker.GetStats().categories[b2_blockAllocation].allocationCount > 0);
+    }
+
+    // Everything went back to the heap.
+    CHECK(tracker.GetStats().categories[b2_blockAllocation].bytes == 0);
+}
+
+TEST_CASE("world state delta")
+{
+    auto build = [](b2World* world, std::vector<b2Body*>* bodies)
+    {
+        b2BodyDef groundDef;
+        b2Body* ground = world->CreateBody(&groundDef);
+        b2EdgeShape edge;
+        edge.SetTwoSided(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+        ground->CreateFixture(&edge, 0.0f);
+        bodies->push_back(ground);
+
+        b2PolygonShape box;
+        box.SetAsBox(0.5f, 0.5f);
+        for (std::int32_t i = 0; i < 20; ++i)
+        {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_dynamicBody;
+            bodyDef.position.Set(-10.0f + 1.1f * i, 0.5f + 2.0f * (i % 4));
+            bodyDef.angle = 0.1f * i;
+            b2Body* body = world->CreateBody(&bodyDef);
+            body->CreateFixture(&box, 1.0f);
+            bodies->push_back(body);
+        }
+    };
+
+    b2World server(b2Vec2(0.0f, -10.0f));
+    std::vector<b2Body*> serverBodies;
+    build(&server, &serverBodies);
+
+    // The client does not simulate.
+    b2World client(b2Vec2_zero);
+    std::vector<b2Body*> clientBodies;
+    build(&client, &clientBodies);
+    std::int32_t count = std::int32_t(serverBodies.size());
+
+    b2WorldState state;
+    b2WorldState acked;
+    b2WorldState received;
+    b2WorldState baseline;
+    std::vector<std::uint8_t> packet;
+
+    auto send = [&](bool useBaseline) -> std::size_t
+    {
+        state.Capture(serverBodies.data(), count);
+        std::size_t size = state.EncodeDelta(useBaseline ? &acked : nullptr, nullptr, 0);
+        packet.resize(size);
+        CHECK(state.EncodeDelta(useBaseline ? &acked : nullptr, packet.data(), size) == size);
+
+        baseline.Copy(received);
+        CHECK(received.DecodeDelta(useBaseline ? &baseline : nullptr, packet.data(), size, count));
+        received.Apply(clientBodies.data(), count);
+        acked.Copy(state);
+        return size;
+    };
+
+    auto checkClient = [&]()
+    {
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            b2Body* a = serverBodies[i];
+            b2Body* b = clientBodies[i];
+            CHECK(b2Distance(a->GetPosition(), b->GetPosition()) < 1.0f / 1024.0f);
+            CHECK(b2Abs(b2Rot(a->GetAngle() - b->GetAngle()).s) < 1.0e-3f);
+            CHECK(b2Distance(a->GetLinearVelocity(), b->GetLinearVelocity()) < 1.0f / 256.0f);
+            CHECK(a->IsAwake() == b->IsAwake());
+        }
+    };
+
+    std::size_t fullSize = send(false);
+    CHECK(received.GetChangeCount() == count);
+    checkClient();
+
+    // Only the falling bodies change.
+    for (std::int32_t i = 0; i < 10; ++i)
+    {
+        server.Step(1.0f / 60.0f, 8, 3);
+    }
+    std::size_t deltaSize = send(true);
+    CHECK(deltaSize < fullSize);
+    CHECK(received.GetChangeCount() < count);
+    checkClient();
+
+    // Once everything sleeps, the next delta after the sleep change is empty.
+    for (std::int32_t i = 0; i < 600; ++i)
+    {
+        server.Step(1.0f / 60.0f, 8, 3);
+    }
+    for (std::int32_t i = 1; i < count; ++i)
+    {
+        CHECK(serverBodies[i]->IsAwake() == false);
+    }
+    send(true);
+    checkClient();
+    CHECK(send(true) == 2);
+    CHECK(received.GetChangeCount() == 0);
+
+    // A woken body is sent again.
+    serverBodies[5]->ApplyLinearImpulseToCenter(b2Vec2(0.0f, 5.0f), true);
+    server.Step(1.0f / 60.0f, 8, 3);
+    send(true);
+    CHECK(received.GetChangeCount() >= 1);
+    CHECK(clientBodies[5]->IsAwake());
+    checkClient();
+
+    // Bad data is rejected.
+    state.Capture(serverBodies.data(), count);
+    packet.resize(state.EncodeDelta(nullptr, nullptr, 0));
+    state.EncodeDelta(nullptr, packet.data(), packet.size());
+    b2WorldState bad;
+    CHECK(bad.DecodeDelta(nullptr, packet.data(), packet.size() - 1, count) == false);
+    CHECK(bad.GetBodyCount() == 0);
+    packet.push_back(0);
+    CHECK(bad.DecodeDelta(nullptr, packet.data(), packet.size(), count) == false);
+    packet.pop_back();
+    packet[1] = std::uint8_t(count + 1);
+    CHECK(bad.DecodeDelta(nullptr, packet.data(), packet.size(), count) == false);
+
+    // A body count beyond the client's bodies is rejected before anything is allocated.
+    std::uint8_t huge[] = { 0xff, 0xff, 0xff, 0x20, 0x00 };
+    CHECK(bad.DecodeDelta(nullptr, huge, sizeof(huge), count) == false);
+    CHECK(bad.GetBodyCount() == 0);
+    std::uint8_t unchanged[] = { std::uint8_t(count), 0 };
+    CHECK(bad.DecodeDelta(nullptr, unchanged, sizeof(unchanged), count));
+    CHECK(bad.DecodeDelta(nullptr, unchanged, sizeof(unchanged), count - 1) == false);
+}